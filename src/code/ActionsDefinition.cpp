@@ -42,6 +42,10 @@ ActionsDefinition::Evaluate(EvaluationContext& context)
 	if (fVariables != nullptr)
 		variables = fVariables->Evaluate(context);
 
+	// the IncludeCache can't repeat defining actions
+	if (IncludeCache* includeCache = context.EvaluatedIncludes())
+		includeCache->Untrackable();
+
 	// create and add the actions to the rule
 	Rule& rule = context.Rules().LookupOrCreate(fRuleName);
 	util::Reference<data::RuleActions> actions(
@@ -58,7 +62,7 @@ ActionsDefinition::Visit(NodeVisitor& visitor)
 	if (visitor.VisitNode(this))
 		return this;
 
-	return fVariables->Visit(visitor);
+	return fVariables != nullptr ? fVariables->Visit(visitor) : nullptr;
 }
 
 void
@@ -5,6 +5,7 @@
 
 #include "code/Assignment.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 #include "data/TargetPool.hpp"
@@ -44,61 +45,110 @@ Assignment::Evaluate(EvaluationContext& context)
 	const StringList& rhs = fRight->Evaluate(context);
 
 	if (fOnTargets != nullptr) {
-		// Set the variables on the given targets.
 		StringList targets = fOnTargets->Evaluate(context);
-		for (StringList::Iterator it = targets.GetIterator(); it.HasNext();) {
-			// get the target and its variable domain
-			data::Target* target = context.Targets().LookupOrCreate(it.Next());
-			data::VariableDomain* domain = target->Variables(true);
-
-			// set the variables
-			for (StringList::Iterator varIt = lhs.GetIterator();
-				 varIt.HasNext();) {
-				String variable = varIt.Next();
-				switch (fOperator) {
-					case ASSIGNMENT_OPERATOR_ASSIGN:
-						domain->Set(variable, rhs);
-						break;
-					case ASSIGNMENT_OPERATOR_APPEND:
-						domain->LookupOrCreate(variable).Append(rhs);
-						break;
-					case ASSIGNMENT_OPERATOR_DEFAULT:
-						if (domain->Lookup(variable) == nullptr)
-							domain->Set(variable, rhs);
-						break;
-				}
-			}
-		}
+		AssignOnTargets(context, fOperator, lhs, rhs, targets);
 	} else {
-		// No targets. If a local variable with the respective name exists, we
-		// set it, otherwise we set one in a global scope.
-		for (StringList::Iterator it = lhs.GetIterator(); it.HasNext();) {
-			String variable = it.Next();
-
-			// look for a local variable
-			StringList* data = context.LocalScope()->Lookup(variable);
-			if (data == nullptr) {
-				// no local variable -- check for a global one and create, if
-				// there isn't one yet either.
-				data = &context.GlobalVariables()->LookupOrCreate(variable);
+		Assign(context, fOperator, lhs, rhs);
+	}
+
+	return rhs;
+}
+
+/**
+ * Assigns \a value to the \a variables. If a local variable with the
+ * respective name exists, it is set, otherwise a global one.
+ */
+/*static*/ void
+Assignment::Assign(
+	EvaluationContext& context,
+	AssignmentOperator operatorType,
+	const StringList& variables,
+	const StringList& value
+)
+{
+	for (StringList::Iterator it = variables.GetIterator(); it.HasNext();) {
+		String variable = it.Next();
+
+		// look for a local variable
+		StringList* data = context.LocalScope()->Lookup(variable);
+		IncludeCache* includeCache = context.EvaluatedIncludes();
+		if (includeCache != nullptr && includeCache->IsRecording()) {
+			if (data != nullptr) {
+				includeCache->LocalVariableChanged(variable, data);
+			} else {
+				includeCache->GlobalVariableChanged(
+					context,
+					variable,
+					operatorType,
+					value
+				);
 			}
+		}
+
+		if (data == nullptr) {
+			// no local variable -- check for a global one and create, if
+			// there isn't one yet either.
+			data = &context.GlobalVariables()->LookupOrCreate(variable);
+		}
+
+		switch (operatorType) {
+			case ASSIGNMENT_OPERATOR_ASSIGN:
+				*data = value;
+				break;
+			case ASSIGNMENT_OPERATOR_APPEND:
+				data->Append(value);
+				break;
+			case ASSIGNMENT_OPERATOR_DEFAULT:
+				if (data->IsEmpty())
+					*data = value;
+				break;
+		}
+	}
+}
+
+/*static*/ void
+Assignment::AssignOnTargets(
+	EvaluationContext& context,
+	AssignmentOperator operatorType,
+	const StringList& variables,
+	const StringList& value,
+	const StringList& targets
+)
+{
+	IncludeCache* includeCache = context.EvaluatedIncludes();
+	if (includeCache != nullptr && includeCache->IsRecording()) {
+		includeCache->TargetsAssigned(
+			context,
+			operatorType,
+			variables,
+			value,
+			targets
+		);
+	}
+
+	for (StringList::Iterator it = targets.GetIterator(); it.HasNext();) {
+		// get the target and its variable domain
+		data::Target* target = context.Targets().LookupOrCreate(it.Next());
+		data::VariableDomain* domain = target->Variables(true);
 
-			switch (fOperator) {
+		// set the variables
+		for (StringList::Iterator varIt = variables.GetIterator();
+			 varIt.HasNext();) {
+			String variable = varIt.Next();
+			switch (operatorType) {
 				case ASSIGNMENT_OPERATOR_ASSIGN:
-					*data = rhs;
+					domain->Set(variable, value);
 					break;
 				case ASSIGNMENT_OPERATOR_APPEND:
-					data->Append(rhs);
+					domain->LookupOrCreate(variable).Append(value);
 					break;
 				case ASSIGNMENT_OPERATOR_DEFAULT:
-					if (data->IsEmpty())
-						*data = rhs;
+					if (domain->Lookup(variable) == nullptr)
+						domain->Set(variable, value);
 					break;
 			}
 		}
 	}
-
-	return rhs;
 }
 
 code::Node*
@@ -144,4 +194,60 @@ Assignment::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+Assignment::Compile(Compiler& compiler, Register result)
+{
+	Register variables = compiler.AllocateRegister();
+	compiler.CompileNode(fLeft, variables);
+
+	// A single literal variable known to be local is assigned via its slot.
+	uint32_t slot = Bytecode::kNoSlot;
+	String variable;
+	const StringList* constantVariables = compiler.ConstantIn(variables);
+	if (fOnTargets == nullptr && constantVariables != nullptr
+		&& constantVariables->Size() == 1) {
+		variable = constantVariables->Head();
+		slot = compiler.ResolveLocalVariable(variable);
+	}
+
+	compiler.CompileNode(fRight, result);
+
+	if (slot != Bytecode::kNoSlot) {
+		Opcode opcode = OPCODE_ASSIGN_LOCAL;
+		switch (fOperator) {
+			case ASSIGNMENT_OPERATOR_ASSIGN:
+				break;
+			case ASSIGNMENT_OPERATOR_APPEND:
+				opcode = OPCODE_ASSIGN_APPEND_LOCAL;
+				break;
+			case ASSIGNMENT_OPERATOR_DEFAULT:
+				opcode = OPCODE_ASSIGN_DEFAULT_LOCAL;
+				break;
+		}
+
+		compiler.Emit(opcode, slot, result, compiler.AddString(variable));
+		return;
+	}
+
+	Register targets = Bytecode::kNoRegister;
+	if (fOnTargets != nullptr) {
+		targets = compiler.AllocateRegister();
+		compiler.CompileNode(fOnTargets, targets);
+	}
+
+	Opcode opcode = OPCODE_ASSIGN;
+	switch (fOperator) {
+		case ASSIGNMENT_OPERATOR_ASSIGN:
+			break;
+		case ASSIGNMENT_OPERATOR_APPEND:
+			opcode = OPCODE_ASSIGN_APPEND;
+			break;
+		case ASSIGNMENT_OPERATOR_DEFAULT:
+			opcode = OPCODE_ASSIGN_DEFAULT;
+			break;
+	}
+
+	compiler.Emit(opcode, variables, result, targets);
+}
+
 } // namespace ham::code
@@ -25,6 +25,21 @@ class Assignment : public Node
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
+
+	static void Assign(
+		EvaluationContext& context,
+		AssignmentOperator operatorType,
+		const StringList& variables,
+		const StringList& value
+	);
+	static void AssignOnTargets(
+		EvaluationContext& context,
+		AssignmentOperator operatorType,
+		const StringList& variables,
+		const StringList& value,
+		const StringList& targets
+	);
 
   private:
 	Node* fLeft;
@@ -5,6 +5,7 @@
 
 #include "code/BinaryExpression.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -61,11 +62,23 @@ BinaryExpression<Operator>::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+template<typename Operator>
+void
+BinaryExpression<Operator>::Compile(Compiler& compiler, Register result)
+{
+	Register left = compiler.AllocateRegister();
+	Register right = compiler.AllocateRegister();
+	compiler.CompileNode(fLeft, left);
+	compiler.CompileNode(fRight, right);
+	compiler.Emit(Operator::kOpcode, result, left, right);
+}
+
 // define and instantiate the specializations
 
-#define HAM_DEFINE_OPERATOR_EXPRESSION(name, symbol, expression)          \
+#define HAM_DEFINE_OPERATOR_EXPRESSION(name, symbol, opcode, expression) \
 	struct name##Operator {                                               \
 		static const char* const kSymbol;                                 \
+		static const Opcode kOpcode = opcode;                             \
                                                                           \
 		static StringList Do(const StringList& a, const StringList& b)    \
 		{                                                                 \
@@ -77,18 +90,33 @@ BinaryExpression<Operator>::Dump(DumpContext& context) const
                                                                           \
 	template class BinaryExpression<name##Operator>;
 
-#define HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(name, symbol, oper) \
-	HAM_DEFINE_OPERATOR_EXPRESSION(name, symbol, a.CompareWith(b, true) oper 0)
-
-HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(Equal, =, ==)
-HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(NotEqual, !=, !=)
-HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(Less, <, <)
-HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(LessOrEqual, <=, <=)
-HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(Greater, >, >)
-HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(GreaterOrEqual, >=, >=)
-
-HAM_DEFINE_OPERATOR_EXPRESSION(And, &&, a.IsTrue() && b.IsTrue())
-HAM_DEFINE_OPERATOR_EXPRESSION(Or, ||, a.IsTrue() || b.IsTrue())
+#define HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(name, symbol, opcode, oper) \
+	HAM_DEFINE_OPERATOR_EXPRESSION(                                           \
+		name,                                                                 \
+		symbol,                                                               \
+		opcode,                                                               \
+		a.CompareWith(b, true) oper 0                                         \
+	)
+
+HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(Equal, =, OPCODE_EQUAL, ==)
+HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(NotEqual, !=, OPCODE_NOT_EQUAL, !=)
+HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(Less, <, OPCODE_LESS, <)
+HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(
+	LessOrEqual,
+	<=,
+	OPCODE_LESS_OR_EQUAL,
+	<=
+)
+HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(Greater, >, OPCODE_GREATER, >)
+HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION(
+	GreaterOrEqual,
+	>=,
+	OPCODE_GREATER_OR_EQUAL,
+	>=
+)
+
+HAM_DEFINE_OPERATOR_EXPRESSION(And, &&, OPCODE_AND, a.IsTrue() && b.IsTrue())
+HAM_DEFINE_OPERATOR_EXPRESSION(Or, ||, OPCODE_OR, a.IsTrue() || b.IsTrue())
 
 #undef HAM_DEFINE_OPERATOR_EXPRESSION
 #undef HAM_DEFINE_COMPARISON_OPERATOR_EXPRESSION
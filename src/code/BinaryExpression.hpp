@@ -20,6 +20,7 @@ class BinaryExpression : public Node
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
 
   private:
 	Node* fLeft;
@@ -5,15 +5,22 @@
 
 #include "code/Block.hpp"
 
+#include "code/Bytecode.hpp"
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
+#include "code/LocalVariableDeclaration.hpp"
+#include "code/VirtualMachine.hpp"
 
 namespace ham::code
 {
 
 Block::Block()
 	: fStatements(),
-	  fLocalVariableScopeNeeded(true)
+	  fLocalVariableScopeNeeded(true),
+	  fRuleBody(false),
+	  fRuleParameterNames(),
+	  fBytecode()
 {
 }
 
@@ -29,22 +36,32 @@ Block::~Block()
 StringList
 Block::Evaluate(EvaluationContext& context)
 {
-	if (!fLocalVariableScopeNeeded)
+	// A rule body's local variables are added to the domain of the rule call,
+	// which lives in the caller's arena frame and must not grow while a nested
+	// frame exists. So the body shares that frame.
+	if (!fLocalVariableScopeNeeded) {
+		if (context.IsBytecodeEnabled())
+			return VirtualMachine::Execute(context, _Bytecode());
 		return _Evaluate(context);
+	}
+
+	util::FrameArena::Frame frame(context.Arena());
+	if (context.IsBytecodeEnabled())
+		return VirtualMachine::Execute(context, _Bytecode());
 
 	// Push a fresh local variable scope. It inherits the old one, so, unless
 	// shadowed, already defined local variables can still be seen.
+	// Variables are only ever added to the innermost scope, so the domain can
+	// live in the frame created above.
 	data::VariableScope* oldLocalScope = context.LocalScope();
-	data::VariableDomain localVariables;
+	data::VariableDomain localVariables(&context.Arena());
 	data::VariableScope localScope(localVariables, oldLocalScope);
-	if (fLocalVariableScopeNeeded)
-		context.SetLocalScope(&localScope);
+	context.SetLocalScope(&localScope);
 
 	StringList result = _Evaluate(context);
 
 	// reinstate the old local variable scope
-	if (fLocalVariableScopeNeeded)
-		context.SetLocalScope(oldLocalScope);
+	context.SetLocalScope(oldLocalScope);
 
 	return result;
 }
@@ -81,6 +98,45 @@ Block::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+Block::Compile(Compiler& compiler, Register result)
+{
+	// The scope is only observable, if a local variable is declared in it.
+	bool pushScope = fLocalVariableScopeNeeded && _DeclaresLocalVariables();
+	if (pushScope)
+		compiler.BeginScope();
+
+	_CompileStatements(compiler, result);
+
+	if (pushScope)
+		compiler.EndScope();
+}
+
+void
+Block::CompileUnit(Compiler& compiler, Register result)
+{
+	if (fRuleBody)
+		compiler.BeginRuleBody(fRuleParameterNames);
+
+	// Evaluated code (e.g. "for" or assignments) expects a local scope, so
+	// we need one, even if it remains empty.
+	if (fLocalVariableScopeNeeded)
+		compiler.BeginScope();
+
+	_CompileStatements(compiler, result);
+
+	if (fLocalVariableScopeNeeded)
+		compiler.EndScope();
+}
+
+const Bytecode&
+Block::_Bytecode()
+{
+	if (fBytecode.Get() == nullptr)
+		fBytecode.SetTo(Compiler::Compile(this), true);
+	return *fBytecode.Get();
+}
+
 StringList
 Block::_Evaluate(EvaluationContext& context)
 {
@@ -98,4 +154,32 @@ Block::_Evaluate(EvaluationContext& context)
 	return result;
 }
 
+void
+Block::_CompileStatements(Compiler& compiler, Register result)
+{
+	if (fStatements.empty()) {
+		compiler.Emit(OPCODE_CLEAR, result);
+		return;
+	}
+
+	for (StatementList::const_iterator it = fStatements.begin();
+		 it != fStatements.end();
+		 ++it) {
+		compiler.CompileStatement(*it, result);
+	}
+}
+
+bool
+Block::_DeclaresLocalVariables() const
+{
+	for (StatementList::const_iterator it = fStatements.begin();
+		 it != fStatements.end();
+		 ++it) {
+		if (dynamic_cast<LocalVariableDeclaration*>(*it) != nullptr)
+			return true;
+	}
+
+	return false;
+}
+
 } // namespace ham::code
@@ -12,6 +12,8 @@
 namespace ham::code
 {
 
+class Bytecode;
+
 class Block : public Node
 {
   public:
@@ -19,21 +21,34 @@ class Block : public Node
 	virtual ~Block();
 
 	inline void SetLocalVariableScopeNeeded(bool localVariableScopeNeeded);
+	inline void SetRuleParameterNames(const StringList& parameterNames);
+	// marks the block as the body of a rule with the given parameters
 
 	inline void AppendKeepReference(Node* statement);
 
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
+
+	void CompileUnit(Compiler& compiler, Register result);
+	// compiles the block as the root of the compiled code
 
   private:
 	StringList _Evaluate(EvaluationContext& context);
+	const Bytecode& _Bytecode();
+	void _CompileStatements(Compiler& compiler, Register result);
+	bool _DeclaresLocalVariables() const;
 
   private:
 	typedef std::list<Node*> StatementList;
 
 	StatementList fStatements;
 	bool fLocalVariableScopeNeeded;
+	bool fRuleBody;
+	StringList fRuleParameterNames;
+	util::Reference<Bytecode> fBytecode;
+	// compiled lazily on the first evaluation
 };
 
 void
@@ -42,6 +57,13 @@ Block::SetLocalVariableScopeNeeded(bool localVariableScopeNeeded)
 	fLocalVariableScopeNeeded = localVariableScopeNeeded;
 }
 
+void
+Block::SetRuleParameterNames(const StringList& parameterNames)
+{
+	fRuleBody = true;
+	fRuleParameterNames = parameterNames;
+}
+
 void
 Block::AppendKeepReference(Node* statement)
 {
@@ -55,6 +55,11 @@ class EchoInstructions : public RuleInstructions
 		echo_string_list_list(context, parameters);
 		return StringList::False();
 	}
+
+	CallEffects GetCallEffects() const override
+	{
+		return CALL_EFFECTS_REPEATABLE;
+	}
 };
 
 class ExitInstructions : public RuleInstructions
@@ -109,6 +114,11 @@ class MatchInstructions : public RuleInstructions
 
 		return result;
 	}
+
+	CallEffects GetCallEffects() const override
+	{
+		return CALL_EFFECTS_NONE;
+	}
 };
 
 class GlobInstructions : public RuleInstructions
@@ -228,6 +238,11 @@ class DependsInstructions : public RuleInstructions
 
 		return StringList::False();
 	}
+
+	CallEffects GetCallEffects() const override
+	{
+		return CALL_EFFECTS_REPEATABLE;
+	}
 };
 
 template<uint32_t kFlags>
@@ -250,6 +265,11 @@ class AddTargetFlagsRule : public RuleInstructions
 		}
 		return StringList::False();
 	}
+
+	CallEffects GetCallEffects() const override
+	{
+		return CALL_EFFECTS_CHANGES_TARGETS;
+	}
 };
 
 /*static*/ void
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "code/Bytecode.hpp"
+
+#include "code/Node.hpp"
+
+namespace ham::code
+{
+
+Bytecode::Bytecode()
+	: fInstructions(),
+	  fConstants(),
+	  fStrings(),
+	  fNodes(),
+	  fCallSites(),
+	  fRegisterCount(0),
+	  fLoopCount(0),
+	  fSlotCount(0)
+{
+}
+
+Bytecode::~Bytecode()
+{
+	for (std::vector<Node*>::iterator it = fNodes.begin(); it != fNodes.end();
+		 ++it) {
+		(*it)->ReleaseReference();
+	}
+}
+
+} // namespace ham::code
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_CODE_BYTECODE_HPP
+#define HAM_CODE_BYTECODE_HPP
+
+#include "code/Defs.hpp"
+#include "code/RulePool.hpp"
+#include "data/StringList.hpp"
+#include "util/Referenceable.hpp"
+
+#include <vector>
+
+namespace ham::code
+{
+
+class Node;
+
+/**
+ * Instructions of the bytecode virtual machine. Operands are registers (r),
+ * indices into the pools of the Bytecode (constant, string, node), local
+ * variable slots or instruction indices (target). The result of a node is
+ * always stored in the register given to Node::Compile().
+ *
+ * A slot refers to a local variable the Compiler could resolve statically. It
+ * is bound by looking the variable up on first use and unbound again when
+ * the declaring LOCAL instruction is executed the next time.
+ */
+enum Opcode {
+	OPCODE_LOAD_CONSTANT,
+	// rA = constant B
+	OPCODE_LOAD_VARIABLE,
+	// rA = value of the variable named string B
+	OPCODE_LOAD_PARAMETER,
+	// rA = rule parameter B, if not empty, otherwise the variable named
+	// string C
+	OPCODE_LOAD_LOCAL,
+	// rA = local variable slot B, bound to the variable named string C
+	OPCODE_EXPAND,
+	// rA = Leaf::EvaluateString() of string B
+	OPCODE_CLEAR,
+	// rA = empty list
+	OPCODE_APPEND,
+	// rA += rB
+	OPCODE_RELEASE,
+	// clear C registers starting with rA
+	OPCODE_CALL,
+	// rA = call rules rB with the C arguments rB+1 ...
+	OPCODE_CALL_RULE,
+	// rA = call the literal rules of call site C with the arguments rB ...
+	OPCODE_EVALUATE,
+	// rA = node B->Evaluate()
+	OPCODE_ASSIGN,
+	OPCODE_ASSIGN_APPEND,
+	OPCODE_ASSIGN_DEFAULT,
+	// assign rB to variables rA (on targets rC, if not kNoRegister)
+	OPCODE_ASSIGN_LOCAL,
+	OPCODE_ASSIGN_APPEND_LOCAL,
+	OPCODE_ASSIGN_DEFAULT_LOCAL,
+	// assign rB to local variable slot A, bound to the variable named string C
+	OPCODE_LOCAL,
+	// declare local variables rA with value rB; they get the slots starting
+	// with C, if not kNoSlot
+	OPCODE_EQUAL,
+	OPCODE_NOT_EQUAL,
+	OPCODE_LESS,
+	OPCODE_LESS_OR_EQUAL,
+	OPCODE_GREATER,
+	OPCODE_GREATER_OR_EQUAL,
+	OPCODE_AND,
+	OPCODE_OR,
+	OPCODE_IN,
+	// rA = rB <op> rC
+	OPCODE_NOT,
+	// rA = !rB
+	OPCODE_JUMP,
+	// continue at target A
+	OPCODE_JUMP_IF_FALSE,
+	// continue at target B, if rA is false
+	OPCODE_MATCH,
+	// continue at target C, unless case node B matches rA
+	OPCODE_FOR_INIT,
+	// bind loop A to the first variable of rB; target C, if there is none
+	OPCODE_FOR_LIST,
+	// set the list loop A iterates over to rB
+	OPCODE_FOR_NEXT,
+	// assign the next element of loop A; target B, if there is none
+	OPCODE_CHECK_JUMP_CONDITION,
+	// handle a jump condition set by evaluated code: continue at target A for
+	// break, target B for continue (if not kNoTarget), otherwise exit
+	OPCODE_EXIT,
+	// set jump condition A and leave the code
+	OPCODE_PUSH_SCOPE,
+	// push a local variable scope, popped at instruction A
+	OPCODE_POP_SCOPE
+};
+
+struct Instruction {
+	Opcode fOpcode;
+	uint32_t fA;
+	uint32_t fB;
+	uint32_t fC;
+};
+
+struct CallSite {
+	StringList fFunctions;
+	uint32_t fArgumentCount;
+	RuleLookupCache fCache;
+};
+
+/**
+ * Code a Block has been compiled to by the Compiler, executed by the
+ * VirtualMachine. Register 0 holds the result of the block.
+ */
+class Bytecode : public util::Referenceable
+{
+  public:
+	static constexpr uint32_t kNoRegister = UINT32_MAX;
+	static constexpr uint32_t kNoTarget = UINT32_MAX;
+	static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+  public:
+	Bytecode();
+	virtual ~Bytecode();
+
+	const std::vector<Instruction>& Instructions() const
+	{
+		return fInstructions;
+	}
+
+	const StringList& ConstantAt(size_t index) const
+	{
+		return fConstants[index];
+	}
+
+	const String& StringAt(size_t index) const { return fStrings[index]; }
+	Node* NodeAt(size_t index) const { return fNodes[index]; }
+	CallSite& CallSiteAt(size_t index) const { return fCallSites[index]; }
+
+	uint32_t RegisterCount() const { return fRegisterCount; }
+	uint32_t LoopCount() const { return fLoopCount; }
+	uint32_t SlotCount() const { return fSlotCount; }
+
+  private:
+	friend class Compiler;
+
+  private:
+	std::vector<Instruction> fInstructions;
+	std::vector<StringList> fConstants;
+	std::vector<String> fStrings;
+	std::vector<Node*> fNodes;
+	// referenced
+	mutable std::vector<CallSite> fCallSites;
+	// the rule caches are updated on execution
+	uint32_t fRegisterCount;
+	uint32_t fLoopCount;
+	uint32_t fSlotCount;
+};
+
+} // namespace ham::code
+
+#endif // HAM_CODE_BYTECODE_HPP
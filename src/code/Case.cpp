@@ -6,6 +6,7 @@
 
 #include "code/Case.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 #include "data/RegExp.hpp"
@@ -68,4 +69,11 @@ Case::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+Case::Compile(Compiler& compiler, Register result)
+{
+	// Matching is done by the Switch.
+	compiler.CompileNode(fBlock, result);
+}
+
 } // namespace ham::code
@@ -21,6 +21,7 @@ class Case : public Node
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
 
   private:
 	String fPattern;
@@ -0,0 +1,468 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "code/Compiler.hpp"
+
+#include "code/Block.hpp"
+#include "code/Case.hpp"
+
+#include <algorithm>
+
+namespace ham::code
+{
+
+static const size_t kUnboundLabel = SIZE_MAX;
+static const size_t kNoPushInstruction = SIZE_MAX;
+
+/**
+ * Returns whether \a name is one of the built-in variables of a rule call,
+ * i.e. "<", ">" or a parameter number, and the respective parameter index.
+ */
+static bool
+parameter_index(const String& name, uint32_t& _index)
+{
+	if (name == "<" || name == ">") {
+		_index = name == "<" ? 0 : 1;
+		return true;
+	}
+
+	const char* string = name.ToCString();
+	size_t length = name.Length();
+	if (length == 0 || length > 9 || string[0] < '1' || string[0] > '9')
+		return false;
+
+	uint32_t number = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (string[i] < '0' || string[i] > '9')
+			return false;
+		number = number * 10 + (string[i] - '0');
+	}
+
+	_index = number - 1;
+	return true;
+}
+
+Compiler::Compiler(Bytecode* code)
+	: fCode(code),
+	  fNextRegister(1),
+	  fStatementRegisterEnd(1),
+	  fLabels(),
+	  fLastLabelTarget(0),
+	  fFixups(),
+	  fLoops(),
+	  fScopes(),
+	  fRuleBody(false)
+{
+	fCode->fRegisterCount = 1;
+}
+
+/*static*/ Bytecode*
+Compiler::Compile(Block* block)
+{
+	util::Reference<Bytecode> code(new Bytecode, true);
+	Compiler compiler(code.Get());
+	block->CompileUnit(compiler, 0);
+	compiler._ResolveLabels();
+	return code.Detach();
+}
+
+Register
+Compiler::AllocateRegisters(uint32_t count)
+{
+	Register first = fNextRegister;
+	fNextRegister += count;
+	fStatementRegisterEnd = std::max(fStatementRegisterEnd, fNextRegister);
+	fCode->fRegisterCount = std::max(fCode->fRegisterCount, fNextRegister);
+	return first;
+}
+
+void
+Compiler::CompileNode(Node* node, Register result)
+{
+	node->Compile(*this, result);
+}
+
+/**
+ * Compiles \a node as a statement of a block. Afterwards the temporaries
+ * allocated for it are released -- at runtime, too, so they don't keep
+ * references to variable values, which would make appending to them copy --
+ * and the jump condition is checked.
+ */
+void
+Compiler::CompileStatement(Node* node, Register result)
+{
+	Register firstTemporary = fNextRegister;
+	Register outerRegisterEnd = fStatementRegisterEnd;
+	fStatementRegisterEnd = firstTemporary;
+
+	node->Compile(*this, result);
+
+	if (fStatementRegisterEnd > firstTemporary) {
+		Emit(
+			OPCODE_RELEASE,
+			firstTemporary,
+			0,
+			fStatementRegisterEnd - firstTemporary
+		);
+	}
+
+	fNextRegister = firstTemporary;
+	fStatementRegisterEnd = std::max(outerRegisterEnd, fStatementRegisterEnd);
+
+	EmitCheckJumpCondition();
+}
+
+Compiler::Label
+Compiler::NewLabel()
+{
+	fLabels.push_back(kUnboundLabel);
+	return fLabels.size() - 1;
+}
+
+void
+Compiler::BindLabel(Label label)
+{
+	fLabels[label] = fCode->fInstructions.size();
+	fLastLabelTarget = fLabels[label];
+}
+
+void
+Compiler::Emit(Opcode opcode, uint32_t a, uint32_t b, uint32_t c)
+{
+	if (opcode == OPCODE_APPEND && _FoldConstantAppend(a, b))
+		return;
+
+	fCode->fInstructions.push_back(Instruction{opcode, a, b, c});
+}
+
+void
+Compiler::EmitJump(Label target)
+{
+	_EmitWithTarget(OPCODE_JUMP, 0, 0, 0, &Instruction::fA, target);
+}
+
+void
+Compiler::EmitJumpIfFalse(Register condition, Label target)
+{
+	_EmitWithTarget(
+		OPCODE_JUMP_IF_FALSE,
+		condition,
+		0,
+		0,
+		&Instruction::fB,
+		target
+	);
+}
+
+void
+Compiler::EmitMatch(Register value, Case* caseNode, Label noMatchTarget)
+{
+	caseNode->AcquireReference();
+	fCode->fNodes.push_back(caseNode);
+	_EmitWithTarget(
+		OPCODE_MATCH,
+		value,
+		fCode->fNodes.size() - 1,
+		0,
+		&Instruction::fC,
+		noMatchTarget
+	);
+}
+
+void
+Compiler::EmitForInit(uint32_t loop, Register variables, Label endTarget)
+{
+	_EmitWithTarget(
+		OPCODE_FOR_INIT,
+		loop,
+		variables,
+		0,
+		&Instruction::fC,
+		endTarget
+	);
+}
+
+void
+Compiler::EmitForNext(uint32_t loop, Label endTarget)
+{
+	_EmitWithTarget(OPCODE_FOR_NEXT, loop, 0, 0, &Instruction::fB, endTarget);
+}
+
+/**
+ * Emits the jump for a break, continue, return or jumptoeof statement. Break
+ * and continue inside a loop of the compiled code simply jump, everything
+ * else leaves the code with the jump condition set, to be handled by the
+ * caller.
+ */
+void
+Compiler::EmitJumpStatement(JumpCondition condition)
+{
+	if (!fLoops.empty()) {
+		if (condition == JUMP_CONDITION_BREAK) {
+			EmitJump(fLoops.back().fBreak);
+			return;
+		}
+		if (condition == JUMP_CONDITION_CONTINUE) {
+			EmitJump(fLoops.back().fContinue);
+			return;
+		}
+	}
+
+	Emit(OPCODE_EXIT, condition);
+}
+
+void
+Compiler::EmitEvaluate(Node* node, Register result)
+{
+	node->AcquireReference();
+	fCode->fNodes.push_back(node);
+	Emit(OPCODE_EVALUATE, result, fCode->fNodes.size() - 1);
+}
+
+void
+Compiler::BeginLoop(Label breakLabel, Label continueLabel)
+{
+	fLoops.push_back(LoopLabels{breakLabel, continueLabel});
+}
+
+void
+Compiler::EndLoop()
+{
+	fLoops.pop_back();
+}
+
+uint32_t
+Compiler::AllocateLoop()
+{
+	return fCode->fLoopCount++;
+}
+
+void
+Compiler::EmitCheckJumpCondition()
+{
+	if (fLoops.empty()) {
+		Emit(
+			OPCODE_CHECK_JUMP_CONDITION,
+			Bytecode::kNoTarget,
+			Bytecode::kNoTarget
+		);
+		return;
+	}
+
+	size_t index = fCode->fInstructions.size();
+	Emit(OPCODE_CHECK_JUMP_CONDITION);
+	fFixups.push_back(Fixup{index, &Instruction::fA, fLoops.back().fBreak});
+	fFixups.push_back(Fixup{index, &Instruction::fB, fLoops.back().fContinue}
+	);
+}
+
+/**
+ * Begins a region with a local variable scope of its own. Jumps must not
+ * enter the region, but may leave it.
+ */
+void
+Compiler::BeginScope()
+{
+	fScopes.push_back(Scope{fCode->fInstructions.size(), {}, false});
+	Emit(OPCODE_PUSH_SCOPE);
+}
+
+void
+Compiler::EndScope()
+{
+	fCode->fInstructions[fScopes.back().fPushInstruction].fA =
+		fCode->fInstructions.size();
+	fScopes.pop_back();
+	Emit(OPCODE_POP_SCOPE);
+}
+
+/**
+ * Begins compiling the body of a rule. The code is executed in the local
+ * variable scope set up by UserRuleInstructions, which contains the
+ * parameters, and with the rule's built-in variables.
+ */
+void
+Compiler::BeginRuleBody(const StringList& parameterNames)
+{
+	fRuleBody = true;
+	fScopes.push_back(Scope{kNoPushInstruction, {}, false});
+
+	for (StringList::Iterator it = parameterNames.GetIterator();
+		 it.HasNext();) {
+		fScopes.back().fSlots[it.Next()] = fCode->fSlotCount++;
+	}
+}
+
+/**
+ * Declares local variables in the innermost scope, as a LOCAL instruction
+ * emitted next does at runtime. \a names is null, if the names aren't known
+ * statically. Returns the first of the slots allocated for the variables, or
+ * Bytecode::kNoSlot.
+ */
+uint32_t
+Compiler::DeclareLocalVariables(const StringList* names)
+{
+	if (fScopes.empty())
+		return Bytecode::kNoSlot;
+
+	Scope& scope = fScopes.back();
+	if (names == nullptr) {
+		scope.fDynamic = true;
+		return Bytecode::kNoSlot;
+	}
+
+	uint32_t firstSlot = fCode->fSlotCount;
+	for (StringList::Iterator it = names->GetIterator();
+		 it.HasNext();) {
+		scope.fSlots[it.Next()] = fCode->fSlotCount++;
+	}
+
+	return firstSlot;
+}
+
+/**
+ * Returns the slot of the local variable a reference to \a name at the
+ * current point of the code refers to, or Bytecode::kNoSlot, if it cannot
+ * be resolved statically.
+ */
+uint32_t
+Compiler::ResolveLocalVariable(const String& name) const
+{
+	// built-in variables take precedence over local ones
+	uint32_t parameterIndex;
+	if (parameter_index(name, parameterIndex))
+		return Bytecode::kNoSlot;
+
+	for (std::vector<Scope>::const_reverse_iterator it = fScopes.rbegin();
+		 it != fScopes.rend();
+		 ++it) {
+		std::map<String, uint32_t>::const_iterator slotIt =
+			it->fSlots.find(name);
+		if (slotIt != it->fSlots.end())
+			return slotIt->second;
+		if (it->fDynamic)
+			break;
+	}
+
+	return Bytecode::kNoSlot;
+}
+
+void
+Compiler::EmitLoadVariable(const String& name, Register result)
+{
+	uint32_t parameterIndex;
+	if (fRuleBody && parameter_index(name, parameterIndex)) {
+		Emit(OPCODE_LOAD_PARAMETER, result, parameterIndex, AddString(name));
+		return;
+	}
+
+	uint32_t slot = ResolveLocalVariable(name);
+	if (slot != Bytecode::kNoSlot) {
+		Emit(OPCODE_LOAD_LOCAL, result, slot, AddString(name));
+		return;
+	}
+
+	Emit(OPCODE_LOAD_VARIABLE, result, AddString(name));
+}
+
+const StringList*
+Compiler::ConstantIn(Register value) const
+{
+	// no jump may target the current position, bypassing the instruction
+	const std::vector<Instruction>& instructions = fCode->fInstructions;
+	if (instructions.empty() || fLastLabelTarget >= instructions.size())
+		return nullptr;
+
+	const Instruction& instruction = instructions.back();
+	if (instruction.fOpcode != OPCODE_LOAD_CONSTANT || instruction.fA != value)
+		return nullptr;
+
+	return &fCode->fConstants[instruction.fB];
+}
+
+uint32_t
+Compiler::AddConstant(const StringList& constant)
+{
+	fCode->fConstants.push_back(constant);
+	return fCode->fConstants.size() - 1;
+}
+
+uint32_t
+Compiler::AddString(const String& string)
+{
+	fCode->fStrings.push_back(string);
+	return fCode->fStrings.size() - 1;
+}
+
+uint32_t
+Compiler::AddCallSite(const StringList& functions, uint32_t argumentCount)
+{
+	fCode->fCallSites.push_back(
+		CallSite{functions, argumentCount, RuleLookupCache()}
+	);
+	return fCode->fCallSites.size() - 1;
+}
+
+void
+Compiler::_EmitWithTarget(
+	Opcode opcode,
+	uint32_t a,
+	uint32_t b,
+	uint32_t c,
+	uint32_t Instruction::*targetOperand,
+	Label target
+)
+{
+	fFixups.push_back(
+		Fixup{fCode->fInstructions.size(), targetOperand, target}
+	);
+	Emit(opcode, a, b, c);
+}
+
+/**
+ * Folds appending a constant loaded into \a element to a constant loaded into
+ * \a list, as for lists of literals. Besides saving instructions, it avoids
+ * copying the shared constant data on each append at runtime.
+ */
+bool
+Compiler::_FoldConstantAppend(Register list, Register element)
+{
+	std::vector<Instruction>& instructions = fCode->fInstructions;
+	size_t count = instructions.size();
+	if (count < 2 || fLastLabelTarget + 1 >= count)
+		return false;
+	// no jump may target the element load or the append
+
+	Instruction& listLoad = instructions[count - 2];
+	Instruction& elementLoad = instructions[count - 1];
+	if (listLoad.fOpcode != OPCODE_LOAD_CONSTANT || listLoad.fA != list
+		|| elementLoad.fOpcode != OPCODE_LOAD_CONSTANT
+		|| elementLoad.fA != element) {
+		return false;
+	}
+
+	// Each constant is used by a single instruction only, so the list's can
+	// be changed in place.
+	std::vector<StringList>& constants = fCode->fConstants;
+	constants[listLoad.fB].Append(constants[elementLoad.fB]);
+	if (elementLoad.fB + 1 == constants.size())
+		constants.pop_back();
+
+	instructions.pop_back();
+	return true;
+}
+
+void
+Compiler::_ResolveLabels()
+{
+	for (std::vector<Fixup>::const_iterator it = fFixups.begin();
+		 it != fFixups.end();
+		 ++it) {
+		fCode->fInstructions[it->fInstruction].*(it->fOperand) =
+			fLabels[it->fLabel];
+	}
+}
+
+} // namespace ham::code
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_CODE_COMPILER_HPP
+#define HAM_CODE_COMPILER_HPP
+
+#include "code/Bytecode.hpp"
+
+#include <map>
+#include <vector>
+
+namespace ham::code
+{
+
+class Block;
+class Case;
+
+/**
+ * Compiles a Block -- a file or a rule body -- to Bytecode. Each node compiles
+ * itself via Node::Compile(), using the methods of this class to allocate
+ * registers and emit instructions.
+ *
+ * Statements all store their result in the register of the block, so the
+ * result of the last executed statement ends up in register 0, as the result
+ * of the compiled block. Temporaries are allocated on top of the registers in
+ * use and cleared after each statement. Jump conditions set by evaluated code
+ * are checked after each statement, like Block does.
+ *
+ * The compiler also tracks the local variable scopes and the local variables
+ * declared in them, so references to variables which at that point can only
+ * be a known local -- a rule parameter or a local variable declared with a
+ * literal name -- can use a slot instead of a lookup by name. Jam's dynamic
+ * scoping doesn't get in the way: code executed in between, e.g. a called
+ * rule, cannot add variables to the scopes of the compiled code.
+ */
+class Compiler
+{
+  public:
+	typedef size_t Label;
+
+  public:
+	static Bytecode* Compile(Block* block);
+	// returns a new reference
+
+	Register AllocateRegister() { return AllocateRegisters(1); }
+	Register AllocateRegisters(uint32_t count);
+
+	void CompileNode(Node* node, Register result);
+	void CompileStatement(Node* node, Register result);
+
+	Label NewLabel();
+	void BindLabel(Label label);
+
+	void Emit(Opcode opcode, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+	void EmitJump(Label target);
+	void EmitJumpIfFalse(Register condition, Label target);
+	void EmitMatch(Register value, Case* caseNode, Label noMatchTarget);
+	void EmitForInit(uint32_t loop, Register variables, Label endTarget);
+	void EmitForNext(uint32_t loop, Label endTarget);
+	void EmitJumpStatement(JumpCondition condition);
+	void EmitEvaluate(Node* node, Register result);
+
+	void BeginLoop(Label breakLabel, Label continueLabel);
+	void EndLoop();
+	uint32_t AllocateLoop();
+	void EmitCheckJumpCondition();
+
+	void BeginScope();
+	void EndScope();
+	void BeginRuleBody(const StringList& parameterNames);
+
+	uint32_t DeclareLocalVariables(const StringList* names);
+	uint32_t ResolveLocalVariable(const String& name) const;
+	void EmitLoadVariable(const String& name, Register result);
+
+	const StringList* ConstantIn(Register value) const;
+	// the constant the last instruction loaded into \a value, if any
+
+	uint32_t AddConstant(const StringList& constant);
+	uint32_t AddString(const String& string);
+	uint32_t AddCallSite(const StringList& functions, uint32_t argumentCount);
+
+  private:
+	struct LoopLabels {
+		Label fBreak;
+		Label fContinue;
+	};
+
+	struct Fixup {
+		size_t fInstruction;
+		uint32_t Instruction::*fOperand;
+		Label fLabel;
+	};
+
+	struct Scope {
+		size_t fPushInstruction;
+		// the PUSH_SCOPE instruction, SIZE_MAX for the scope of a rule body
+		std::map<String, uint32_t> fSlots;
+		// the local variables declared so far
+		bool fDynamic;
+		// whether variables not known statically have been declared
+	};
+
+  private:
+	Compiler(Bytecode* code);
+
+	void _EmitWithTarget(
+		Opcode opcode,
+		uint32_t a,
+		uint32_t b,
+		uint32_t c,
+		uint32_t Instruction::*targetOperand,
+		Label target
+	);
+	bool _FoldConstantAppend(Register list, Register element);
+	void _ResolveLabels();
+
+  private:
+	Bytecode* fCode;
+	Register fNextRegister;
+	Register fStatementRegisterEnd;
+	// end of the temporaries used by the current statement
+	std::vector<size_t> fLabels;
+	size_t fLastLabelTarget;
+	std::vector<Fixup> fFixups;
+	std::vector<LoopLabels> fLoops;
+	std::vector<Scope> fScopes;
+	bool fRuleBody;
+};
+
+} // namespace ham::code
+
+#endif // HAM_CODE_COMPILER_HPP
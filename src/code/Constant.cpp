@@ -5,6 +5,7 @@
 
 #include "code/Constant.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -39,4 +40,10 @@ Constant::Dump(DumpContext& context) const
 	context << "Constant(\"" << fValue << "\")\n";
 }
 
+void
+Constant::Compile(Compiler& compiler, Register result)
+{
+	compiler.Emit(OPCODE_LOAD_CONSTANT, result, compiler.AddConstant(fValue));
+}
+
 } // namespace ham::code
@@ -19,6 +19,7 @@ class Constant : public Node
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
 
   private:
 	StringList fValue;
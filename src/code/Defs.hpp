@@ -5,9 +5,14 @@
 #ifndef HAM_CODE_DEFS_HPP
 #define HAM_CODE_DEFS_HPP
 
+#include <stdint.h>
+
 namespace ham::code
 {
 
+typedef uint32_t Register;
+// register of the bytecode virtual machine
+
 enum AssignmentOperator {
 	ASSIGNMENT_OPERATOR_ASSIGN,
 	ASSIGNMENT_OPERATOR_APPEND,
@@ -11,7 +11,15 @@ namespace ham::code
 {
 
 DumpContext::DumpContext()
-	: fNodeLevel(0),
+	: fOutput(std::cout),
+	  fNodeLevel(0),
+	  fNewLine(true)
+{
+}
+
+DumpContext::DumpContext(std::ostream& output)
+	: fOutput(output),
+	  fNodeLevel(0),
 	  fNewLine(true)
 {
 }
@@ -23,7 +31,7 @@ DumpContext::PrintString(const std::string& string)
 
 	while (pos != std::string::npos && pos < string.length()) {
 		if (fNewLine)
-			std::cout << std::string(fNodeLevel * 2, ' ');
+			fOutput << std::string(fNodeLevel * 2, ' ');
 
 		size_t newLinePos = string.find('\n', pos);
 		fNewLine = newLinePos != std::string::npos;
@@ -33,7 +41,7 @@ DumpContext::PrintString(const std::string& string)
 			newLinePos++;
 		}
 
-		std::cout << std::string(string, pos, newLinePos);
+		fOutput << std::string(string, pos, newLinePos);
 
 		pos = newLinePos;
 	}
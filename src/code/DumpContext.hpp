@@ -7,6 +7,7 @@
 
 #include "data/String.hpp"
 
+#include <ostream>
 #include <sstream>
 
 namespace ham::code
@@ -16,6 +17,8 @@ class DumpContext
 {
   public:
 	DumpContext();
+	DumpContext(std::ostream& output);
+	// the default one dumps to the standard output
 
 	inline void BeginChildren();
 	inline void EndChildren();
@@ -26,6 +29,7 @@ class DumpContext
 	DumpContext& PrintString(const std::string& string);
 
   private:
+	std::ostream& fOutput;
 	int fNodeLevel;
 	bool fNewLine;
 };
@@ -19,10 +19,17 @@ EvaluationContext::EvaluationContext(
 	  fGlobalVariables(globalVariables),
 	  fLocalScope(nullptr),
 	  fBuiltInVariables(nullptr),
+	  fRuleParameters(nullptr),
 	  fTargets(targets),
 	  fJumpCondition(JUMP_CONDITION_NONE),
 	  fIncludeDepth(0),
 	  fRuleCallDepth(0),
+	  fArena(),
+	  fPrefetcher(nullptr),
+	  fParsedFiles(nullptr),
+	  fProfiler(nullptr),
+	  fEvaluatedIncludes(nullptr),
+	  fBytecodeEnabled(true),
 	  fOutput(&std::cout),
 	  fErrorOutput(&std::cerr)
 {
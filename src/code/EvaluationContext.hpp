@@ -7,8 +7,10 @@
 
 #include "behavior/Behavior.hpp"
 #include "code/Defs.hpp"
+#include "code/IncludeCache.hpp"
 #include "code/RulePool.hpp"
 #include "data/VariableScope.hpp"
+#include "util/FrameArena.hpp"
 
 #include <ostream>
 
@@ -23,6 +25,10 @@ class TargetPool;
 namespace code
 {
 
+class IncludePrefetcher;
+class ParseCache;
+class RuleProfiler;
+
 /**
  * Complete context where variables are evaluated.
  */
@@ -57,6 +63,13 @@ class EvaluationContext
 		fBuiltInVariables = variables;
 	}
 
+	const StringListList* RuleParameters() const { return fRuleParameters; }
+	void SetRuleParameters(const StringListList* parameters)
+	{
+		fRuleParameters = parameters;
+	}
+	// the parameters of the rule call the built-in variables belong to
+
 	inline const StringList* LookupVariable(const String& variable) const;
 
 	data::TargetPool& Targets() const { return fTargets; }
@@ -75,6 +88,39 @@ class EvaluationContext
 	size_t RuleCallDepth() const { return fRuleCallDepth; }
 	void SetRuleCallDepth(size_t depth) { fRuleCallDepth = depth; }
 
+	util::FrameArena& Arena() { return fArena; }
+	// for temporaries of rule calls and block evaluations
+
+	IncludePrefetcher* Prefetcher() const { return fPrefetcher; }
+	void SetPrefetcher(IncludePrefetcher* prefetcher)
+	{
+		fPrefetcher = prefetcher;
+	}
+	// parses files Include will probably get to on worker threads, optional
+
+	ParseCache* ParsedFiles() const { return fParsedFiles; }
+	void SetParsedFiles(ParseCache* parsedFiles)
+	{
+		fParsedFiles = parsedFiles;
+	}
+	// the code of files parsed earlier, e.g. by earlier builds, optional
+
+	RuleProfiler* Profiler() const { return fProfiler; }
+	void SetProfiler(RuleProfiler* profiler) { fProfiler = profiler; }
+	// measures the rule calls, optional
+
+	IncludeCache* EvaluatedIncludes() const { return fEvaluatedIncludes; }
+	void SetEvaluatedIncludes(IncludeCache* evaluatedIncludes)
+	{
+		fEvaluatedIncludes = evaluatedIncludes;
+	}
+	// records and repeats what evaluating included files does, optional
+
+	bool IsBytecodeEnabled() const { return fBytecodeEnabled; }
+	void SetBytecodeEnabled(bool enabled) { fBytecodeEnabled = enabled; }
+	// whether blocks are compiled and executed by the VirtualMachine instead
+	// of being interpreted
+
 	std::ostream& Output() const { return *fOutput; }
 	void SetOutput(std::ostream& output) { fOutput = &output; }
 	std::ostream& ErrorOutput() const { return *fErrorOutput; }
@@ -86,11 +132,18 @@ class EvaluationContext
 	data::VariableDomain& fGlobalVariables;
 	data::VariableScope* fLocalScope;
 	data::VariableDomain* fBuiltInVariables;
+	const StringListList* fRuleParameters;
 	data::TargetPool& fTargets;
 	RulePool fRules;
 	JumpCondition fJumpCondition;
 	size_t fIncludeDepth;
 	size_t fRuleCallDepth;
+	util::FrameArena fArena;
+	IncludePrefetcher* fPrefetcher;
+	ParseCache* fParsedFiles;
+	RuleProfiler* fProfiler;
+	IncludeCache* fEvaluatedIncludes;
+	bool fBytecodeEnabled;
 	std::ostream* fOutput;
 	std::ostream* fErrorOutput;
 };
@@ -108,7 +161,10 @@ EvaluationContext::LookupVariable(const String& variable) const
 			return result;
 	}
 
-	return fGlobalVariables.Lookup(variable);
+	const StringList* result = fGlobalVariables.Lookup(variable);
+	if (fEvaluatedIncludes != nullptr && fEvaluatedIncludes->IsRecording())
+		fEvaluatedIncludes->GlobalVariableRead(variable, result);
+	return result;
 }
 
 } // namespace code
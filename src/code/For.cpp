@@ -5,6 +5,7 @@
 
 #include "code/For.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -39,7 +40,8 @@ For::Evaluate(EvaluationContext& context)
 
 	// look for a local variable
 	StringList* variableValue = context.LocalScope()->Lookup(variables.Head());
-	if (variableValue == nullptr) {
+	bool isLocal = variableValue != nullptr;
+	if (!isLocal) {
 		// no local variable -- check for a global one
 		variableValue = context.GlobalVariables()->Lookup(variables.Head());
 		if (variableValue == nullptr) {
@@ -52,6 +54,21 @@ For::Evaluate(EvaluationContext& context)
 	// perform the for loop
 	StringList result;
 	const StringList& list = fList->Evaluate(context);
+	IncludeCache* includeCache = context.EvaluatedIncludes();
+	if (includeCache != nullptr && includeCache->IsRecording()
+		&& !list.IsEmpty()) {
+		if (isLocal) {
+			includeCache->LocalVariableChanged(variables.Head(), variableValue);
+		} else {
+			includeCache->GlobalVariableChanged(
+				context,
+				variables.Head(),
+				ASSIGNMENT_OPERATOR_ASSIGN,
+				list
+			);
+		}
+	}
+
 	for (StringList::Iterator it = list.GetIterator(); it.HasNext();) {
 		// assign the variable
 		variableValue->Clear();
@@ -109,4 +126,33 @@ For::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+For::Compile(Compiler& compiler, Register result)
+{
+	Compiler::Label nextLabel = compiler.NewLabel();
+	Compiler::Label endLabel = compiler.NewLabel();
+	uint32_t loop = compiler.AllocateLoop();
+
+	compiler.Emit(OPCODE_CLEAR, result);
+
+	Register variable = compiler.AllocateRegister();
+	compiler.CompileNode(fVariable, variable);
+	compiler.EmitForInit(loop, variable, endLabel);
+
+	Register list = compiler.AllocateRegister();
+	compiler.CompileNode(fList, list);
+	compiler.Emit(OPCODE_FOR_LIST, loop, list);
+
+	compiler.BindLabel(nextLabel);
+	compiler.EmitForNext(loop, endLabel);
+
+	compiler.BeginLoop(endLabel, nextLabel);
+	compiler.CompileNode(fBlock, result);
+	compiler.EmitCheckJumpCondition();
+	compiler.EndLoop();
+	compiler.EmitJump(nextLabel);
+
+	compiler.BindLabel(endLabel);
+}
+
 } // namespace ham::code
@@ -5,30 +5,57 @@
 
 #include "code/FunctionCall.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 #include "code/EvaluationException.hpp"
+#include "code/IncludeCache.hpp"
+#include "code/Leaf.hpp"
 #include "code/Rule.hpp"
 #include "code/RuleInstructions.hpp"
+#include "code/RuleProfiler.hpp"
 #include "data/TargetPool.hpp"
 #include "util/Constants.hpp"
 
 namespace ham::code
 {
 
+static bool
+is_literal(Node* node)
+{
+	Leaf* leaf = dynamic_cast<Leaf*>(node);
+	return leaf != nullptr && leaf->IsLiteral();
+}
+
 FunctionCall::FunctionCall(Node* function)
 	: fFunction(function),
-	  fArguments()
+	  fArguments(),
+	  fLiteralFunction(is_literal(function)),
+	  fLiteralFunctions(),
+	  fRuleCache()
 {
 	fFunction->AcquireReference();
+
+	if (fLiteralFunction) {
+		fLiteralFunctions =
+			StringList(static_cast<Leaf*>(fFunction)->GetString());
+	}
 }
 
 FunctionCall::FunctionCall(Node* function, const NodeList& arguments)
 	: fFunction(function),
-	  fArguments(arguments)
+	  fArguments(arguments),
+	  fLiteralFunction(is_literal(function)),
+	  fLiteralFunctions(),
+	  fRuleCache()
 {
 	fFunction->AcquireReference();
 
+	if (fLiteralFunction) {
+		fLiteralFunctions =
+			StringList(static_cast<Leaf*>(fFunction)->GetString());
+	}
+
 	for (ArgumentList::iterator it = fArguments.begin(); it != fArguments.end();
 		 ++it) {
 		(*it)->AcquireReference();
@@ -48,18 +75,16 @@ FunctionCall::~FunctionCall()
 StringList
 FunctionCall::Evaluate(EvaluationContext& context)
 {
-	// check call depth
-	size_t callDepth = context.RuleCallDepth();
-	if (callDepth >= util::kRuleCallDepthLimit) {
-		std::stringstream message;
-		message << "Reached rule call depth limit ("
-				<< util::kRuleCallDepthLimit << ")";
-		throw EvaluationException(message.str());
-	}
-	context.SetRuleCallDepth(callDepth + 1);
+	size_t callDepth = BeginCall(context);
+
+	// The temporaries of the call -- the arguments, the targets, and the
+	// variable domains of the called rules -- live in a frame of the arena.
+	// The result is a StringList and thus isn't affected.
+	util::FrameArena& arena = context.Arena();
+	util::FrameArena::Frame frame(arena);
 
 	// evaluate arguments
-	StringListList arguments;
+	StringListList arguments(&arena);
 	size_t argumentCount = fArguments.size();
 	arguments.resize(argumentCount);
 
@@ -69,18 +94,78 @@ FunctionCall::Evaluate(EvaluationContext& context)
 		arguments[argumentIndex++] = (*it)->Evaluate(context);
 	}
 
-	// Call functions with arguments and concatenate the results.
+	// A literal rule name needn't be evaluated and the rule can be cached.
+	StringList result;
+	if (fLiteralFunction) {
+		result = Call(context, fLiteralFunctions, arguments, &fRuleCache);
+	} else {
+		StringList functions = fFunction->Evaluate(context);
+		result = Call(context, functions, arguments);
+	}
+
+	// reset call depth
+	context.SetRuleCallDepth(callDepth);
+
+	return result;
+}
+
+/**
+ * Checks the rule call depth and increments it. Returns the previous depth,
+ * which the caller has to restore after the call.
+ */
+/*static*/ size_t
+FunctionCall::BeginCall(EvaluationContext& context)
+{
+	size_t callDepth = context.RuleCallDepth();
+	if (callDepth >= util::kRuleCallDepthLimit) {
+		std::stringstream message;
+		message << "Reached rule call depth limit ("
+				<< util::kRuleCallDepthLimit << ")";
+		throw EvaluationException(message.str());
+	}
+	context.SetRuleCallDepth(callDepth + 1);
+	return callDepth;
+}
+
+/**
+ * Calls the rules \a functions with \a arguments and concatenates the
+ * results. Rules with actions get respective action calls added to their
+ * targets. The call depth is left to the caller. If \a cache is given and
+ * there's a single function, the rule is looked up via the cache.
+ */
+/*static*/ StringList
+FunctionCall::Call(
+	EvaluationContext& context,
+	const StringList& functions,
+	const StringListList& arguments,
+	RuleLookupCache* cache
+)
+{
+	util::FrameArena& arena = context.Arena();
 	StringList result;
-	StringList functions = fFunction->Evaluate(context);
 	size_t functionCount = functions.Size();
+	size_t argumentCount = arguments.size();
 	RulePool& rulePool = context.Rules();
-	data::TargetList targets;
+	data::TargetList targets(&arena);
 	// lazily initialized when needed
-	data::TargetList sourceTargets;
+	data::TargetList sourceTargets(&arena);
 	// lazily initialized when needed
 
 	for (size_t i = 0; i < functionCount; i++) {
-		Rule* function = rulePool.Lookup(functions.ElementAt(i));
+		Rule* function = cache != nullptr && functionCount == 1
+			? rulePool.Lookup(functions.ElementAt(i), *cache)
+			: rulePool.Lookup(functions.ElementAt(i));
+		if (IncludeCache* includeCache = context.EvaluatedIncludes()) {
+			if (includeCache->IsRecording()) {
+				includeCache->RuleCalled(
+					context,
+					functions.ElementAt(i),
+					function,
+					arguments
+				);
+			}
+		}
+
 		if (function == nullptr) {
 			context.ErrorOutput() << "warning: unknown rule "
 								  << functions.ElementAt(i) << std::endl;
@@ -111,13 +196,15 @@ FunctionCall::Evaluate(EvaluationContext& context)
 		}
 
 		// execute rule instructions (if any)
-		if (RuleInstructions* instructions = function->Instructions())
+		if (RuleInstructions* instructions = function->Instructions()) {
+			RuleProfiler::Scope profilerScope(
+				context.Profiler(),
+				function->Name()
+			);
 			result.Append(instructions->Evaluate(context, arguments));
+		}
 	}
 
-	// reset call depth
-	context.SetRuleCallDepth(callDepth);
-
 	return result;
 }
 
@@ -158,4 +245,38 @@ FunctionCall::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+FunctionCall::Compile(Compiler& compiler, Register result)
+{
+	// The arguments are evaluated first, as in Evaluate(). Literal rules are
+	// called via a call site with a rule cache, otherwise the function
+	// register is followed by the argument registers.
+	size_t argumentCount = fArguments.size();
+	Register function = Bytecode::kNoRegister;
+	if (!fLiteralFunction)
+		function = compiler.AllocateRegisters(argumentCount + 1);
+
+	Register firstArgument = fLiteralFunction
+		? compiler.AllocateRegisters(argumentCount)
+		: function + 1;
+	Register argument = firstArgument;
+	for (ArgumentList::iterator it = fArguments.begin(); it != fArguments.end();
+		 ++it) {
+		compiler.CompileNode(*it, argument++);
+	}
+
+	if (fLiteralFunction) {
+		compiler.Emit(
+			OPCODE_CALL_RULE,
+			result,
+			firstArgument,
+			compiler.AddCallSite(fLiteralFunctions, argumentCount)
+		);
+		return;
+	}
+
+	compiler.CompileNode(fFunction, function);
+	compiler.Emit(OPCODE_CALL, result, function, argumentCount);
+}
+
 } // namespace ham::code
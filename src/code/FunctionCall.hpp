@@ -6,6 +6,7 @@
 #define HAM_CODE_FUNCTION_CALL_HPP
 
 #include "code/Node.hpp"
+#include "code/RulePool.hpp"
 
 namespace ham::code
 {
@@ -19,15 +20,35 @@ class FunctionCall : public Node
 
 	inline void AddArgument(Node* argument);
 
+	const StringList* LiteralFunctions() const
+	{
+		return fLiteralFunction ? &fLiteralFunctions : nullptr;
+	}
+	const NodeList& Arguments() const { return fArguments; }
+
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
+
+	static size_t BeginCall(EvaluationContext& context);
+	static StringList Call(
+		EvaluationContext& context,
+		const StringList& functions,
+		const StringListList& arguments,
+		RuleLookupCache* cache = nullptr
+	);
+	// cache: only for calls with the same (literal) functions each time
 
   private:
 	typedef NodeList ArgumentList;
 
 	Node* fFunction;
 	ArgumentList fArguments;
+	bool fLiteralFunction;
+	StringList fLiteralFunctions;
+	// the value of fFunction, if it is a literal
+	RuleLookupCache fRuleCache;
 };
 
 void
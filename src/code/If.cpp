@@ -5,6 +5,7 @@
 
 #include "code/If.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -69,4 +70,26 @@ If::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+If::Compile(Compiler& compiler, Register result)
+{
+	Compiler::Label elseLabel = compiler.NewLabel();
+	Compiler::Label endLabel = compiler.NewLabel();
+
+	Register condition = compiler.AllocateRegister();
+	compiler.CompileNode(fExpression, condition);
+	compiler.EmitJumpIfFalse(condition, elseLabel);
+
+	compiler.CompileNode(fBlock, result);
+	compiler.EmitJump(endLabel);
+
+	compiler.BindLabel(elseLabel);
+	if (fElseBlock != nullptr)
+		compiler.CompileNode(fElseBlock, result);
+	else
+		compiler.Emit(OPCODE_CLEAR, result);
+
+	compiler.BindLabel(endLabel);
+}
+
 } // namespace ham::code
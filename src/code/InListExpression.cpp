@@ -5,6 +5,7 @@
 
 #include "code/InListExpression.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -66,4 +67,14 @@ InListExpression::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+InListExpression::Compile(Compiler& compiler, Register result)
+{
+	Register left = compiler.AllocateRegister();
+	Register right = compiler.AllocateRegister();
+	compiler.CompileNode(fLeft, left);
+	compiler.CompileNode(fRight, right);
+	compiler.Emit(OPCODE_IN, result, left, right);
+}
+
 } // namespace ham::code
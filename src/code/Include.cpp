@@ -9,13 +9,17 @@
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 #include "code/EvaluationException.hpp"
+#include "code/IncludeCache.hpp"
+#include "code/IncludePrefetcher.hpp"
+#include "code/ParseCache.hpp"
 #include "data/FileStatus.hpp"
 #include "data/TargetBinder.hpp"
 #include "data/TargetPool.hpp"
 #include "parser/Parser.hpp"
 #include "util/Constants.hpp"
+#include "util/MappedFile.hpp"
+#include "util/Trace.hpp"
 
-#include <fstream>
 #include <memory>
 #include <sstream>
 
@@ -59,26 +63,69 @@ Include::Evaluate(EvaluationContext& context)
 			fileStatus
 		);
 
-		// open the file
-		std::ifstream file(filePath.ToCString());
-		if (file.fail()) {
-			if (target->IsIgnoreIfMissing())
-				return StringList::False();
-			throw EvaluationException(
-				std::string("include: Failed to open file \"")
-				+ filePath.ToCString() + "\""
-			);
+		IncludeCache* includeCache = context.EvaluatedIncludes();
+		if (includeCache != nullptr && includeCache->IsRecording())
+			includeCache->IncludeBound(context, target, filePath, fileStatus);
+
+		// repeat what the file has done the last time, if nothing it depends
+		// on has changed since
+		if (includeCache != nullptr && fileStatus.Exists()
+			&& includeCache->Replay(context, filePath, fileStatus)) {
+			context.SetIncludeDepth(includeDepth);
+			return StringList::False();
+		}
+
+		util::Trace::Span span("Include", "file", filePath.ToCString());
+
+		// use the file's code if it has been parsed earlier or ahead,
+		// otherwise parse it
+		ParseCache* parsedFiles = context.ParsedFiles();
+		IncludePrefetcher* prefetcher = context.Prefetcher();
+		util::Reference<code::Block> block;
+		if (parsedFiles != nullptr)
+			block.SetTo(parsedFiles->Lookup(filePath));
+		bool parsedEarlier = block.Get() != nullptr;
+		if (!parsedEarlier && prefetcher != nullptr)
+			block.SetTo(prefetcher->Take(filePath), true);
+
+		if (block.Get() == nullptr) {
+			util::MappedFile file;
+			if (!file.Open(filePath.ToCString())) {
+				if (target->IsIgnoreIfMissing())
+					return StringList::False();
+				throw EvaluationException(
+					std::string("include: Failed to open file \"")
+					+ filePath.ToCString() + "\""
+				);
+			}
+
+			parser::Parser parser;
+			parser.SetFileName(filePath.ToStlString());
+			block.SetTo(parser.Parse(file.Data(), file.End()), true);
 		}
 
-		// parse and evaluate it
-		parser::Parser parser;
-		parser.SetFileName(filePath.ToStlString());
-		util::Reference<code::Block> block(parser.Parse(file), true);
+		if (parsedFiles != nullptr && !parsedEarlier)
+			parsedFiles->Add(filePath, block.Get());
+
+		if (prefetcher != nullptr)
+			prefetcher->ScheduleIncludes(context, block.Get(), filePath);
 
-		block->Evaluate(context);
+		if (includeCache != nullptr)
+			includeCache->BeginInclude(context, filePath, fileStatus);
+
+		try {
+			block->Evaluate(context);
+		} catch (...) {
+			if (includeCache != nullptr)
+				includeCache->EndInclude(context, false);
+			throw;
+		}
 
 		if (context.GetJumpCondition() == JUMP_CONDITION_JUMP_TO_EOF)
 			context.SetJumpCondition(JUMP_CONDITION_NONE);
+
+		if (includeCache != nullptr)
+			includeCache->EndInclude(context, true);
 	}
 
 	// reset include depth
@@ -16,6 +16,8 @@ class Include : public Node
 	Include(Node* fileNames);
 	virtual ~Include();
 
+	Node* FileNames() const { return fFileNames; }
+
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
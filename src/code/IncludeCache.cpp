@@ -0,0 +1,1349 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "code/IncludeCache.hpp"
+
+#include "code/Assignment.hpp"
+#include "code/DumpContext.hpp"
+#include "code/EvaluationContext.hpp"
+#include "code/Node.hpp"
+#include "code/Rule.hpp"
+#include "code/UserRuleInstructions.hpp"
+#include "data/Path.hpp"
+#include "data/TargetBinder.hpp"
+#include "data/TargetPool.hpp"
+#include "util/MappedFile.hpp"
+#include "util/Metrics.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sstream>
+#include <typeinfo>
+
+namespace ham::code
+{
+
+static const uint32_t kFileMagic = 0x494d4148;
+// "HAMI"
+static const uint32_t kFileVersion = 1;
+
+static const uint64_t kHashStart = 0xcbf29ce484222325ull;
+static const uint64_t kHashPrime = 0x100000001b3ull;
+
+static const String kLocateVariableName("LOCATE");
+static const String kSearchVariableName("SEARCH");
+
+static util::Counter sCacheHitsMetric(
+	"ham_cache_hits",
+	"Lookups answered from a cache.",
+	"cache=\"include\""
+);
+static util::Counter sCacheMissesMetric(
+	"ham_cache_misses",
+	"Lookups a cache couldn't answer.",
+	"cache=\"include\""
+);
+
+/**
+ * Adds \a size bytes at \a data to the 64 bit FNV-1a \a hash.
+ */
+static void
+hash_bytes(uint64_t& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= kHashPrime;
+	}
+}
+
+static void
+hash_string(uint64_t& hash, const String& string)
+{
+	// the terminating null separates the string from the next one
+	hash_bytes(hash, string.ToCString(), string.Length() + 1);
+}
+
+static void
+hash_variable(uint64_t& hash, const String& variable, const StringList& value)
+{
+	hash_string(hash, variable);
+	uint64_t size = value.Size();
+	hash_bytes(hash, &size, sizeof(size));
+	for (size_t i = 0; i < size; i++)
+		hash_string(hash, value.ElementAt(i));
+}
+
+static void
+hash_domain(uint64_t& hash, const data::VariableDomain& domain)
+{
+	for (data::VariableDomain::Iterator it = domain.GetIterator();
+		 it.HasNext();) {
+		const std::pair<const String, StringList>& variable = it.Next();
+		hash_variable(hash, variable.first, variable.second);
+	}
+}
+
+static bool
+is_same_status(const data::FileStatus& status1, const data::FileStatus& status2)
+{
+	return status1.GetType() == status2.GetType()
+		&& status1.LastModifiedTime() == status2.LastModifiedTime();
+}
+
+static bool
+is_same_value(const StringList* value1, const StringList& value2)
+{
+	// for reading them, an unset variable is the same as an empty one
+	return value1 != nullptr ? *value1 == value2 : value2.IsEmpty();
+}
+
+static void
+append_uint32(std::string& buffer, uint32_t value)
+{
+	buffer.append((const char*)&value, sizeof(value));
+}
+
+static void
+append_uint64(std::string& buffer, uint64_t value)
+{
+	buffer.append((const char*)&value, sizeof(value));
+}
+
+static void
+append_string(std::string& buffer, const char* string, size_t length)
+{
+	append_uint32(buffer, length);
+	buffer.append(string, length);
+}
+
+static void
+append_string(std::string& buffer, const String& string)
+{
+	append_string(buffer, string.ToCString(), string.Length());
+}
+
+static void
+append_list(std::string& buffer, const StringList& list)
+{
+	size_t count = list.Size();
+	append_uint32(buffer, count);
+	for (size_t i = 0; i < count; i++)
+		append_string(buffer, list.ElementAt(i));
+}
+
+static void
+append_status(std::string& buffer, const data::FileStatus& status)
+{
+	const data::Time& time = status.LastModifiedTime();
+	append_uint32(buffer, status.GetType());
+	append_uint32(buffer, time.IsValid());
+	append_uint32(buffer, time.IsValid() ? time.Seconds() : 0);
+	append_uint32(buffer, time.IsValid() ? time.NanoSeconds() : 0);
+}
+
+namespace
+{
+
+/**
+ * Reads the values written by the append_*() functions from a file's data.
+ */
+class RecordReader
+{
+  public:
+	RecordReader(const char* data, const char* end)
+		: fData(data),
+		  fEnd(end)
+	{
+	}
+
+	bool IsAtEnd() const { return fData == fEnd; }
+
+	bool ReadUint32(uint32_t& _value) { return _Read(&_value, sizeof(_value)); }
+
+	bool ReadUint64(uint64_t& _value) { return _Read(&_value, sizeof(_value)); }
+
+	bool ReadString(std::string& _value)
+	{
+		uint32_t length;
+		if (!ReadUint32(length) || (size_t)(fEnd - fData) < length)
+			return false;
+		_value.assign(fData, length);
+		fData += length;
+		return true;
+	}
+
+	bool ReadString(String& _value)
+	{
+		std::string value;
+		if (!ReadString(value) || strlen(value.c_str()) != value.size())
+			return false;
+		_value = String(value.c_str());
+		return true;
+	}
+
+	bool ReadList(StringList& _value)
+	{
+		uint32_t count;
+		if (!ReadUint32(count))
+			return false;
+		_value.Clear();
+		for (uint32_t i = 0; i < count; i++) {
+			String element;
+			if (!ReadString(element))
+				return false;
+			_value.Append(element);
+		}
+		return true;
+	}
+
+	bool ReadStatus(data::FileStatus& _value)
+	{
+		uint32_t type;
+		uint32_t timeValid;
+		uint32_t seconds;
+		uint32_t nanoSeconds;
+		if (!ReadUint32(type) || type > data::FileStatus::OTHER
+			|| !ReadUint32(timeValid) || !ReadUint32(seconds)
+			|| !ReadUint32(nanoSeconds)) {
+			return false;
+		}
+		_value = data::FileStatus(
+			(data::FileStatus::Type)type,
+			timeValid ? data::Time(seconds, nanoSeconds) : data::Time()
+		);
+		return true;
+	}
+
+  private:
+	bool _Read(void* buffer, size_t size)
+	{
+		if ((size_t)(fEnd - fData) < size)
+			return false;
+		memcpy(buffer, fData, size);
+		fData += size;
+		return true;
+	}
+
+  private:
+	const char* fData;
+	const char* fEnd;
+};
+
+} // namespace
+
+IncludeCache::IncludeCache()
+	: fRecords(),
+	  fNewRecords(),
+	  fFrames(),
+	  fRecordingCount(0),
+	  fReplaying(false),
+	  fRuleFingerprints()
+{
+}
+
+IncludeCache::~IncludeCache() {}
+
+/**
+ * Loads the records saved by an earlier run with the same \a identity.
+ * Returns false and loads nothing, if there are none or the file is damaged.
+ */
+bool
+IncludeCache::Load(const char* fileName, const std::string& identity)
+{
+	fRecords.clear();
+
+	util::MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	RecordReader reader(file.Data(), file.End());
+	uint32_t magic;
+	uint32_t version;
+	std::string fileIdentity;
+	uint32_t pathCount;
+	if (!reader.ReadUint32(magic) || magic != kFileMagic
+		|| !reader.ReadUint32(version) || version != kFileVersion
+		|| !reader.ReadString(fileIdentity) || fileIdentity != identity
+		|| !reader.ReadUint32(pathCount)) {
+		return false;
+	}
+
+	RecordMap records;
+	for (uint32_t i = 0; i < pathCount; i++) {
+		std::string path;
+		uint32_t recordCount;
+		if (!reader.ReadString(path) || !reader.ReadUint32(recordCount))
+			return false;
+
+		std::vector<Record>& pathRecords = records[path];
+		for (uint32_t k = 0; k < recordCount; k++) {
+			pathRecords.push_back(Record());
+			Record& record = pathRecords.back();
+			uint32_t count;
+			if (!reader.ReadStatus(record.fStatus)
+				|| !reader.ReadUint64(record.fScopes)
+				|| !reader.ReadUint32(count)) {
+				return false;
+			}
+
+			for (uint32_t l = 0; l < count; l++) {
+				std::string filePath;
+				data::FileStatus status;
+				if (!reader.ReadString(filePath) || !reader.ReadStatus(status))
+					return false;
+				record.fFiles[filePath] = status;
+			}
+
+			if (!reader.ReadUint32(count))
+				return false;
+			for (uint32_t l = 0; l < count; l++) {
+				String variable;
+				StringList value;
+				if (!reader.ReadString(variable) || !reader.ReadList(value))
+					return false;
+				record.fVariables[variable] = value;
+			}
+
+			if (!reader.ReadUint32(count))
+				return false;
+			for (uint32_t l = 0; l < count; l++) {
+				String target;
+				TargetState state;
+				uint32_t variableCount;
+				if (!reader.ReadString(target)
+					|| !reader.ReadUint32(state.fFlags)
+					|| !reader.ReadUint32(variableCount)) {
+					return false;
+				}
+				for (uint32_t m = 0; m < variableCount; m++) {
+					String variable;
+					StringList value;
+					if (!reader.ReadString(variable) || !reader.ReadList(value))
+						return false;
+					state.fVariables[variable] = value;
+				}
+				record.fTargets[target] = state;
+			}
+
+			if (!reader.ReadUint32(count))
+				return false;
+			for (uint32_t l = 0; l < count; l++) {
+				String rule;
+				uint64_t hash;
+				if (!reader.ReadString(rule) || !reader.ReadUint64(hash))
+					return false;
+				record.fRules[rule] = hash;
+			}
+
+			if (!reader.ReadUint32(count))
+				return false;
+			for (uint32_t l = 0; l < count; l++) {
+				String variable;
+				uint32_t assigned;
+				if (!reader.ReadString(variable)
+					|| !reader.ReadUint32(assigned)) {
+					return false;
+				}
+
+				GlobalWrite& write = record.fWrites[variable];
+				write.fAssigned = assigned != 0;
+				if (write.fAssigned) {
+					if (!reader.ReadList(write.fValue))
+						return false;
+					continue;
+				}
+
+				uint32_t operationCount;
+				if (!reader.ReadUint32(operationCount))
+					return false;
+				for (uint32_t m = 0; m < operationCount; m++) {
+					uint32_t operatorType;
+					StringList value;
+					if (!reader.ReadUint32(operatorType)
+						|| operatorType > ASSIGNMENT_OPERATOR_DEFAULT
+						|| !reader.ReadList(value)) {
+						return false;
+					}
+					write.fOperations.push_back(
+						std::make_pair((AssignmentOperator)operatorType, value)
+					);
+				}
+			}
+
+			if (!reader.ReadUint32(count))
+				return false;
+			for (uint32_t l = 0; l < count; l++) {
+				String variable;
+				StringList value;
+				if (!reader.ReadString(variable) || !reader.ReadList(value))
+					return false;
+				record.fLocalWrites[variable] = value;
+			}
+
+			if (!reader.ReadUint32(count))
+				return false;
+			for (uint32_t l = 0; l < count; l++) {
+				Event event;
+				uint32_t type;
+				uint32_t operatorType;
+				uint32_t listCount;
+				if (!reader.ReadUint32(type) || type > EVENT_ACTIONS
+					|| !reader.ReadUint32(operatorType)
+					|| operatorType > ASSIGNMENT_OPERATOR_DEFAULT
+					|| !reader.ReadString(event.fName)
+					|| !reader.ReadUint32(listCount)) {
+					return false;
+				}
+				event.fType = (EventType)type;
+				event.fOperator = (AssignmentOperator)operatorType;
+				for (uint32_t m = 0; m < listCount; m++) {
+					event.fLists.push_back(StringList());
+					if (!reader.ReadList(event.fLists.back()))
+						return false;
+				}
+
+				// the events replayed directly need their lists
+				size_t minListCount = type == EVENT_ASSIGN_ON_TARGETS ? 3
+					: type == EVENT_ACTIONS                          ? 2
+																	 : 0;
+				if (event.fLists.size() < minListCount)
+					return false;
+				record.fEvents.push_back(event);
+			}
+		}
+	}
+
+	if (!reader.IsAtEnd())
+		return false;
+
+	fRecords.swap(records);
+	return true;
+}
+
+/**
+ * Saves the records of the files this run has included, replacing the file.
+ * The loaded records of the files it hasn't included, e.g. because a file
+ * including them has been repeated, are saved as well.
+ */
+bool
+IncludeCache::Save(const char* fileName, const std::string& identity) const
+{
+	RecordMap records(fNewRecords);
+	for (RecordMap::const_iterator it = fRecords.begin(); it != fRecords.end();
+		 ++it) {
+		records.insert(*it);
+	}
+
+	std::string buffer;
+	append_uint32(buffer, kFileMagic);
+	append_uint32(buffer, kFileVersion);
+	append_string(buffer, identity.c_str(), identity.size());
+	append_uint32(buffer, records.size());
+
+	for (RecordMap::const_iterator it = records.begin(); it != records.end();
+		 ++it) {
+		append_string(buffer, it->first.c_str(), it->first.size());
+		append_uint32(buffer, it->second.size());
+		for (const Record& record : it->second) {
+			append_status(buffer, record.fStatus);
+			append_uint64(buffer, record.fScopes);
+
+			append_uint32(buffer, record.fFiles.size());
+			for (std::map<std::string, data::FileStatus>::const_iterator
+					 fileIt = record.fFiles.begin();
+				 fileIt != record.fFiles.end();
+				 ++fileIt) {
+				append_string(
+					buffer,
+					fileIt->first.c_str(),
+					fileIt->first.size()
+				);
+				append_status(buffer, fileIt->second);
+			}
+
+			append_uint32(buffer, record.fVariables.size());
+			for (std::map<String, StringList>::const_iterator variableIt =
+					 record.fVariables.begin();
+				 variableIt != record.fVariables.end();
+				 ++variableIt) {
+				append_string(buffer, variableIt->first);
+				append_list(buffer, variableIt->second);
+			}
+
+			append_uint32(buffer, record.fTargets.size());
+			for (std::map<String, TargetState>::const_iterator targetIt =
+					 record.fTargets.begin();
+				 targetIt != record.fTargets.end();
+				 ++targetIt) {
+				const TargetState& state = targetIt->second;
+				append_string(buffer, targetIt->first);
+				append_uint32(buffer, state.fFlags);
+				append_uint32(buffer, state.fVariables.size());
+				for (std::map<String, StringList>::const_iterator variableIt =
+						 state.fVariables.begin();
+					 variableIt != state.fVariables.end();
+					 ++variableIt) {
+					append_string(buffer, variableIt->first);
+					append_list(buffer, variableIt->second);
+				}
+			}
+
+			append_uint32(buffer, record.fRules.size());
+			for (std::map<String, uint64_t>::const_iterator ruleIt =
+					 record.fRules.begin();
+				 ruleIt != record.fRules.end();
+				 ++ruleIt) {
+				append_string(buffer, ruleIt->first);
+				append_uint64(buffer, ruleIt->second);
+			}
+
+			append_uint32(buffer, record.fWrites.size());
+			for (std::map<String, GlobalWrite>::const_iterator writeIt =
+					 record.fWrites.begin();
+				 writeIt != record.fWrites.end();
+				 ++writeIt) {
+				const GlobalWrite& write = writeIt->second;
+				append_string(buffer, writeIt->first);
+				append_uint32(buffer, write.fAssigned);
+				if (write.fAssigned) {
+					append_list(buffer, write.fValue);
+					continue;
+				}
+
+				append_uint32(buffer, write.fOperations.size());
+				for (const std::pair<AssignmentOperator, StringList>&
+						 operation : write.fOperations) {
+					append_uint32(buffer, operation.first);
+					append_list(buffer, operation.second);
+				}
+			}
+
+			append_uint32(buffer, record.fLocalWrites.size());
+			for (std::map<String, StringList>::const_iterator localIt =
+					 record.fLocalWrites.begin();
+				 localIt != record.fLocalWrites.end();
+				 ++localIt) {
+				append_string(buffer, localIt->first);
+				append_list(buffer, localIt->second);
+			}
+
+			append_uint32(buffer, record.fEvents.size());
+			for (const Event& event : record.fEvents) {
+				append_uint32(buffer, event.fType);
+				append_uint32(buffer, event.fOperator);
+				append_string(buffer, event.fName);
+				append_uint32(buffer, event.fLists.size());
+				for (const StringList& list : event.fLists)
+					append_list(buffer, list);
+			}
+		}
+	}
+
+	// write a temporary file first, so a failure doesn't leave a damaged one
+	std::string temporaryFileName = std::string(fileName) + ".tmp";
+	FILE* file = fopen(temporaryFileName.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	bool written = fwrite(buffer.data(), 1, buffer.size(), file)
+		== buffer.size();
+	if (fclose(file) != 0)
+		written = false;
+
+	if (!written || rename(temporaryFileName.c_str(), fileName) != 0) {
+		remove(temporaryFileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Repeats what evaluating the file at \a path has done the last time, if
+ * neither the file, which has \a status now, nor anything it has read from
+ * outside has changed since. Returns false, if the file must be evaluated.
+ */
+bool
+IncludeCache::Replay(
+	EvaluationContext& context,
+	const String& path,
+	const data::FileStatus& status
+)
+{
+	RecordMap::const_iterator it = fRecords.find(path.ToStlString());
+	if (it != fRecords.end()) {
+		for (const Record& record : it->second) {
+			if (!is_same_status(record.fStatus, status)
+				|| !_IsValid(context, record)) {
+				continue;
+			}
+
+			sCacheHitsMetric.Increment();
+			_Record(context, record);
+			_Apply(context, record);
+			fNewRecords[it->first].push_back(record);
+			return true;
+		}
+	}
+
+	sCacheMissesMetric.Increment();
+	return false;
+}
+
+/**
+ * Starts recording the evaluation of the file at \a path, which has
+ * \a status. Must be followed by EndInclude().
+ */
+void
+IncludeCache::BeginInclude(
+	EvaluationContext& context,
+	const String& path,
+	const data::FileStatus& status
+)
+{
+	Frame frame;
+	frame.fPath = path.ToStlString();
+	frame.fRecord.fStatus = status;
+	frame.fRecord.fScopes = _ScopesHash(context);
+	frame.fScope = context.LocalScope();
+	frame.fTrackable = true;
+	fFrames.push_back(std::move(frame));
+	fRecordingCount++;
+}
+
+/**
+ * Finishes recording the evaluation begun last. Unless it has been
+ * \a completed and could be tracked, nothing is recorded.
+ */
+void
+IncludeCache::EndInclude(EvaluationContext& context, bool completed)
+{
+	// The file must not have left a jump, e.g. of a top level "return", to
+	// the including code.
+	if (!completed || context.GetJumpCondition() != JUMP_CONDITION_NONE)
+		_MarkUntrackable(fFrames.back());
+
+	Frame& frame = fFrames.back();
+	if (frame.fTrackable) {
+		fRecordingCount--;
+
+		data::VariableDomain* globalVariables = context.GlobalVariables();
+		for (std::map<String, GlobalWrite>::iterator it =
+				 frame.fRecord.fWrites.begin();
+			 it != frame.fRecord.fWrites.end();
+			 ++it) {
+			if (it->second.fAssigned) {
+				const StringList* value = globalVariables->Lookup(it->first);
+				it->second.fValue = value != nullptr ? *value : StringList();
+			}
+		}
+
+		for (std::map<String, StringList>::iterator it =
+				 frame.fRecord.fLocalWrites.begin();
+			 it != frame.fRecord.fLocalWrites.end();
+			 ++it) {
+			it->second = *frame.fScope->Lookup(it->first);
+		}
+
+		fNewRecords[frame.fPath].push_back(std::move(frame.fRecord));
+	}
+
+	fFrames.pop_back();
+}
+
+/**
+ * Records what binding the \a target of an include statement to \a path
+ * reads: the target, the LOCATE and SEARCH variables, and the statuses of
+ * the candidate paths up to \a path.
+ */
+void
+IncludeCache::IncludeBound(
+	EvaluationContext& context,
+	const data::Target* target,
+	const String& path,
+	const data::FileStatus& status
+)
+{
+	if (!IsRecording())
+		return;
+
+	TargetRead(target);
+
+	const data::VariableDomain& globalVariables = *context.GlobalVariables();
+	_VariableRead(
+		kLocateVariableName,
+		globalVariables.Lookup(kLocateVariableName)
+	);
+	_VariableRead(
+		kSearchVariableName,
+		globalVariables.Lookup(kSearchVariableName)
+	);
+
+	// another file appearing at an earlier candidate path would be bound
+	StringList paths;
+	data::TargetBinder::GetCandidatePaths(globalVariables, target, paths);
+	size_t pathCount = paths.Size();
+	for (size_t i = 0; i < pathCount; i++) {
+		String candidate = paths.ElementAt(i);
+		if (candidate == path)
+			break;
+
+		data::FileStatus candidateStatus;
+		data::Path::GetFileStatus(candidate.ToCString(), candidateStatus);
+		_FileRead(candidate.ToStlString(), candidateStatus);
+	}
+
+	_FileRead(path.ToStlString(), status);
+}
+
+void
+IncludeCache::GlobalVariableRead(
+	const String& variable,
+	const StringList* value
+)
+{
+	if (IsRecording())
+		_VariableRead(variable, value);
+}
+
+/**
+ * Must be called before the global \a variable is changed.
+ */
+void
+IncludeCache::GlobalVariableChanged(
+	EvaluationContext& context,
+	const String& variable,
+	AssignmentOperator operatorType,
+	const StringList& value
+)
+{
+	if (IsRecording()) {
+		_VariableChanged(
+			variable,
+			context.GlobalVariables()->Lookup(variable),
+			operatorType,
+			value
+		);
+	}
+}
+
+/**
+ * Must be called when the local \a variable, whose value is at \a data, is
+ * changed. If the variable belongs to the code including a file, its final
+ * value is recorded like that of a global one.
+ */
+void
+IncludeCache::LocalVariableChanged(
+	const String& variable,
+	const StringList* data
+)
+{
+	if (!IsRecording())
+		return;
+
+	for (Frame& frame : fFrames) {
+		if (frame.fTrackable && frame.fScope != nullptr
+			&& frame.fScope->Lookup(variable) == data) {
+			frame.fRecord.fLocalWrites.try_emplace(variable);
+		}
+	}
+}
+
+/**
+ * Must be called when the variables or flags of \a target are read. The
+ * target is created, if it doesn't exist yet.
+ */
+void
+IncludeCache::TargetRead(const data::Target* target)
+{
+	if (!IsRecording())
+		return;
+
+	_TargetRead(target->Name(), _TargetState(target));
+
+	Event event;
+	event.fType = EVENT_TARGET;
+	event.fOperator = ASSIGNMENT_OPERATOR_ASSIGN;
+	event.fName = target->Name();
+	_AddEvent(event);
+}
+
+/**
+ * Must be called before the \a variables of the \a targets are assigned.
+ */
+void
+IncludeCache::TargetsAssigned(
+	EvaluationContext& context,
+	AssignmentOperator operatorType,
+	const StringList& variables,
+	const StringList& value,
+	const StringList& targets
+)
+{
+	if (!IsRecording())
+		return;
+
+	_TargetsChanging(context, targets);
+
+	Event event;
+	event.fType = EVENT_ASSIGN_ON_TARGETS;
+	event.fOperator = operatorType;
+	event.fLists.push_back(variables);
+	event.fLists.push_back(value);
+	event.fLists.push_back(targets);
+	_AddEvent(event);
+}
+
+/**
+ * Must be called before the \a rule named \a name, nullptr if there is none,
+ * is called with \a arguments.
+ */
+void
+IncludeCache::RuleCalled(
+	EvaluationContext& context,
+	const String& name,
+	const Rule* rule,
+	const StringListList& arguments
+)
+{
+	if (!IsRecording())
+		return;
+
+	if (rule == nullptr) {
+		// the warning can't be repeated
+		Untrackable();
+		return;
+	}
+
+	_RuleRead(name, _RuleHash(rule));
+
+	if (rule->Actions() != nullptr) {
+		Event event;
+		event.fType = EVENT_ACTIONS;
+		event.fOperator = ASSIGNMENT_OPERATOR_ASSIGN;
+		event.fName = name;
+		event.fLists.push_back(
+			arguments.size() > 0 ? arguments[0] : StringList()
+		);
+		event.fLists.push_back(
+			arguments.size() > 1 ? arguments[1] : StringList()
+		);
+		_AddEvent(event);
+	}
+
+	if (RuleInstructions* instructions = rule->Instructions()) {
+		switch (instructions->GetCallEffects()) {
+			case RuleInstructions::CALL_EFFECTS_NONE:
+				break;
+			case RuleInstructions::CALL_EFFECTS_CHANGES_TARGETS:
+				if (!arguments.empty())
+					_TargetsChanging(context, arguments[0]);
+				[[fallthrough]];
+			case RuleInstructions::CALL_EFFECTS_REPEATABLE:
+			{
+				Event event;
+				event.fType = EVENT_CALL;
+				event.fOperator = ASSIGNMENT_OPERATOR_ASSIGN;
+				event.fName = name;
+				event.fLists.assign(arguments.begin(), arguments.end());
+				_AddEvent(event);
+				break;
+			}
+			case RuleInstructions::CALL_EFFECTS_UNTRACKABLE:
+				Untrackable();
+				break;
+		}
+	}
+}
+
+/**
+ * Must be called when something happens that can't be repeated, e.g. a rule
+ * definition.
+ */
+void
+IncludeCache::Untrackable()
+{
+	if (!IsRecording())
+		return;
+
+	for (Frame& frame : fFrames)
+		_MarkUntrackable(frame);
+}
+
+bool
+IncludeCache::_IsValid(EvaluationContext& context, const Record& record)
+{
+	if (record.fScopes != _ScopesHash(context))
+		return false;
+
+	for (std::map<std::string, data::FileStatus>::const_iterator it =
+			 record.fFiles.begin();
+		 it != record.fFiles.end();
+		 ++it) {
+		data::FileStatus status;
+		data::Path::GetFileStatus(it->first.c_str(), status);
+		if (!is_same_status(status, it->second))
+			return false;
+	}
+
+	data::VariableDomain* globalVariables = context.GlobalVariables();
+	for (std::map<String, StringList>::const_iterator it =
+			 record.fVariables.begin();
+		 it != record.fVariables.end();
+		 ++it) {
+		if (!is_same_value(globalVariables->Lookup(it->first), it->second))
+			return false;
+	}
+
+	for (std::map<String, TargetState>::const_iterator it =
+			 record.fTargets.begin();
+		 it != record.fTargets.end();
+		 ++it) {
+		if (!(_TargetState(context.Targets().Lookup(it->first)) == it->second))
+			return false;
+	}
+
+	for (std::map<String, uint64_t>::const_iterator it = record.fRules.begin();
+		 it != record.fRules.end();
+		 ++it) {
+		Rule* rule = context.Rules().Lookup(it->first);
+		if (rule == nullptr || _RuleHash(rule) != it->second)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Records what \a record has read and done in the files being recorded, as
+ * if the file had been evaluated. Must be done before the record is applied.
+ */
+void
+IncludeCache::_Record(EvaluationContext& context, const Record& record)
+{
+	if (!IsRecording())
+		return;
+
+	// All the record has read, including the states of the targets before it
+	// has changed them, must be recorded before its changes.
+	for (std::map<std::string, data::FileStatus>::const_iterator it =
+			 record.fFiles.begin();
+		 it != record.fFiles.end();
+		 ++it) {
+		_FileRead(it->first, it->second);
+	}
+
+	for (std::map<String, StringList>::const_iterator it =
+			 record.fVariables.begin();
+		 it != record.fVariables.end();
+		 ++it) {
+		_VariableRead(it->first, &it->second);
+	}
+
+	for (std::map<String, TargetState>::const_iterator it =
+			 record.fTargets.begin();
+		 it != record.fTargets.end();
+		 ++it) {
+		_TargetRead(it->first, it->second);
+	}
+
+	for (std::map<String, uint64_t>::const_iterator it = record.fRules.begin();
+		 it != record.fRules.end();
+		 ++it) {
+		_RuleRead(it->first, it->second);
+	}
+
+	data::VariableDomain* globalVariables = context.GlobalVariables();
+	for (std::map<String, GlobalWrite>::const_iterator it =
+			 record.fWrites.begin();
+		 it != record.fWrites.end();
+		 ++it) {
+		const StringList* oldValue = globalVariables->Lookup(it->first);
+		if (it->second.fAssigned) {
+			_VariableChanged(
+				it->first,
+				oldValue,
+				ASSIGNMENT_OPERATOR_ASSIGN,
+				it->second.fValue
+			);
+			continue;
+		}
+
+		for (const std::pair<AssignmentOperator, StringList>& operation :
+			 it->second.fOperations) {
+			_VariableChanged(
+				it->first,
+				oldValue,
+				operation.first,
+				operation.second
+			);
+		}
+	}
+
+	data::VariableScope* scope = context.LocalScope();
+	for (std::map<String, StringList>::const_iterator it =
+			 record.fLocalWrites.begin();
+		 it != record.fLocalWrites.end();
+		 ++it) {
+		LocalVariableChanged(it->first, scope->Lookup(it->first));
+	}
+
+	for (const Event& event : record.fEvents)
+		_AddEvent(event);
+}
+
+/**
+ * Does what \a record has done.
+ */
+void
+IncludeCache::_Apply(EvaluationContext& context, const Record& record)
+{
+	// The code called below mustn't record anything a second time.
+	fReplaying = true;
+
+	data::VariableDomain* globalVariables = context.GlobalVariables();
+	for (std::map<String, GlobalWrite>::const_iterator it =
+			 record.fWrites.begin();
+		 it != record.fWrites.end();
+		 ++it) {
+		if (it->second.fAssigned) {
+			globalVariables->Set(it->first, it->second.fValue);
+			continue;
+		}
+
+		StringList& data = globalVariables->LookupOrCreate(it->first);
+		for (const std::pair<AssignmentOperator, StringList>& operation :
+			 it->second.fOperations) {
+			if (operation.first == ASSIGNMENT_OPERATOR_APPEND)
+				data.Append(operation.second);
+			else if (data.IsEmpty())
+				data = operation.second;
+		}
+	}
+
+	// the scopes are the same, so the variables exist
+	data::VariableScope* scope = context.LocalScope();
+	for (std::map<String, StringList>::const_iterator it =
+			 record.fLocalWrites.begin();
+		 it != record.fLocalWrites.end();
+		 ++it) {
+		*scope->Lookup(it->first) = it->second;
+	}
+
+	data::TargetPool& targets = context.Targets();
+	for (const Event& event : record.fEvents) {
+		switch (event.fType) {
+			case EVENT_TARGET:
+				targets.LookupOrCreate(event.fName);
+				break;
+
+			case EVENT_ASSIGN_ON_TARGETS:
+				Assignment::AssignOnTargets(
+					context,
+					event.fOperator,
+					event.fLists[0],
+					event.fLists[1],
+					event.fLists[2]
+				);
+				break;
+
+			case EVENT_CALL:
+			{
+				// the rule is the one recorded, as _IsValid() has checked
+				// the frame for the rule's temporaries, like in FunctionCall
+				util::FrameArena::Frame frame(context.Arena());
+				Rule* rule = context.Rules().Lookup(event.fName);
+				StringListList arguments(
+					event.fLists.begin(),
+					event.fLists.end()
+				);
+				rule->Instructions()->Evaluate(context, arguments);
+				break;
+			}
+
+			case EVENT_ACTIONS:
+			{
+				Rule* rule = context.Rules().Lookup(event.fName);
+				data::TargetList actionsTargets;
+				data::TargetList sourceTargets;
+				if (!event.fLists[0].IsEmpty())
+					targets.LookupOrCreate(event.fLists[0], actionsTargets);
+				if (!event.fLists[1].IsEmpty())
+					targets.LookupOrCreate(event.fLists[1], sourceTargets);
+
+				util::Reference<data::RuleActionsCall> actionsCall(
+					new data::RuleActionsCall(
+						rule->Actions(),
+						actionsTargets,
+						sourceTargets
+					),
+					true
+				);
+				for (data::Target* target : actionsTargets)
+					target->AddActionsCall(actionsCall.Get());
+				break;
+			}
+		}
+	}
+
+	fReplaying = false;
+}
+
+void
+IncludeCache::_MarkUntrackable(Frame& frame)
+{
+	if (!frame.fTrackable)
+		return;
+
+	frame.fTrackable = false;
+	frame.fRecord = Record();
+	frame.fStartValues.clear();
+	fRecordingCount--;
+}
+
+void
+IncludeCache::_FileRead(
+	const std::string& path,
+	const data::FileStatus& status
+)
+{
+	for (Frame& frame : fFrames) {
+		if (frame.fTrackable)
+			frame.fRecord.fFiles.emplace(path, status);
+	}
+}
+
+/**
+ * Records that the global \a variable has been read, unless the frame has
+ * assigned it before. If it has only appended to it or defaulted it, the
+ * value read depends on the one it had at the beginning.
+ */
+void
+IncludeCache::_VariableRead(const String& variable, const StringList* value)
+{
+	for (Frame& frame : fFrames) {
+		if (!frame.fTrackable)
+			continue;
+
+		Record& record = frame.fRecord;
+		if (record.fVariables.find(variable) != record.fVariables.end())
+			continue;
+
+		std::map<String, GlobalWrite>::const_iterator it =
+			record.fWrites.find(variable);
+		if (it == record.fWrites.end()) {
+			record.fVariables[variable] =
+				value != nullptr ? *value : StringList();
+		} else if (!it->second.fAssigned) {
+			record.fVariables[variable] = frame.fStartValues[variable];
+		}
+	}
+}
+
+void
+IncludeCache::_VariableChanged(
+	const String& variable,
+	const StringList* oldValue,
+	AssignmentOperator operatorType,
+	const StringList& value
+)
+{
+	for (Frame& frame : fFrames) {
+		if (!frame.fTrackable)
+			continue;
+
+		std::pair<std::map<String, GlobalWrite>::iterator, bool> result =
+			frame.fRecord.fWrites.try_emplace(variable);
+		GlobalWrite& write = result.first->second;
+		if (result.second) {
+			frame.fStartValues[variable] =
+				oldValue != nullptr ? *oldValue : StringList();
+		}
+
+		if (operatorType == ASSIGNMENT_OPERATOR_ASSIGN) {
+			// whatever has been done before doesn't matter anymore
+			write.fAssigned = true;
+			write.fOperations.clear();
+		} else if (!write.fAssigned) {
+			if (operatorType == ASSIGNMENT_OPERATOR_APPEND
+				&& !write.fOperations.empty()
+				&& write.fOperations.back().first
+					== ASSIGNMENT_OPERATOR_APPEND) {
+				write.fOperations.back().second.Append(value);
+			} else {
+				write.fOperations.push_back(
+					std::make_pair(operatorType, value)
+				);
+			}
+		}
+	}
+}
+
+/**
+ * Records that the target named \a name has been read and was in \a state,
+ * unless the frame has read or changed it before.
+ */
+void
+IncludeCache::_TargetRead(const String& name, const TargetState& state)
+{
+	for (Frame& frame : fFrames) {
+		if (frame.fTrackable)
+			frame.fRecord.fTargets.emplace(name, state);
+	}
+}
+
+/**
+ * Must be called before the \a targets are changed. Their states before are
+ * recorded as read, so that they can be read back after the change, which,
+ * given those states, is the same each time.
+ */
+void
+IncludeCache::_TargetsChanging(
+	EvaluationContext& context,
+	const StringList& targets
+)
+{
+	data::TargetPool& targetPool = context.Targets();
+	for (StringList::Iterator it = targets.GetIterator(); it.HasNext();) {
+		String name = it.Next();
+		_TargetRead(name, _TargetState(targetPool.Lookup(name)));
+	}
+}
+
+void
+IncludeCache::_RuleRead(const String& name, uint64_t hash)
+{
+	for (Frame& frame : fFrames) {
+		if (frame.fTrackable)
+			frame.fRecord.fRules.emplace(name, hash);
+	}
+}
+
+void
+IncludeCache::_AddEvent(const Event& event)
+{
+	for (Frame& frame : fFrames) {
+		if (frame.fTrackable)
+			frame.fRecord.fEvents.push_back(event);
+	}
+}
+
+/**
+ * Returns a hash of the definition of \a rule. It is computed once per
+ * definition.
+ */
+uint64_t
+IncludeCache::_RuleHash(const Rule* rule)
+{
+	RuleInstructions* instructions = rule->Instructions();
+	data::RuleActions* actions = rule->Actions();
+
+	std::pair<std::map<const Rule*, RuleFingerprint>::iterator, bool> result =
+		fRuleFingerprints.try_emplace(rule);
+	RuleFingerprint& fingerprint = result.first->second;
+	if (!result.second && fingerprint.fInstructions == instructions
+		&& fingerprint.fActions == actions) {
+		return fingerprint.fHash;
+	}
+
+	std::stringstream definition;
+	if (instructions != nullptr) {
+		if (const UserRuleInstructions* userInstructions =
+				dynamic_cast<const UserRuleInstructions*>(instructions)) {
+			definition << "rule";
+			for (StringList::Iterator it =
+					 userInstructions->ParameterNames().GetIterator();
+				 it.HasNext();) {
+				definition << ' ' << it.Next();
+			}
+			definition << '\n';
+
+			DumpContext dumpContext(definition);
+			userInstructions->Block()->Dump(dumpContext);
+		} else {
+			definition << "built-in " << typeid(*instructions).name() << '\n';
+		}
+	}
+
+	if (actions != nullptr) {
+		definition << "actions " << actions->Flags();
+		for (StringList::Iterator it = actions->Variables().GetIterator();
+			 it.HasNext();) {
+			definition << ' ' << it.Next();
+		}
+		definition << '\n' << actions->Actions();
+	}
+
+	std::string string = definition.str();
+	fingerprint.fInstructions = instructions;
+	fingerprint.fActions = actions;
+	fingerprint.fHash = kHashStart;
+	hash_bytes(fingerprint.fHash, string.data(), string.size());
+	return fingerprint.fHash;
+}
+
+/**
+ * Returns a hash of the built-in and local variables the code evaluated in
+ * \a context sees. Local variables that are shadowed, and the nesting of the
+ * scopes, don't matter.
+ */
+/*static*/ uint64_t
+IncludeCache::_ScopesHash(const EvaluationContext& context)
+{
+	uint64_t hash = kHashStart;
+	if (const data::VariableDomain* builtInVariables =
+			context.BuiltInVariables()) {
+		hash_domain(hash, *builtInVariables);
+	}
+	hash_bytes(hash, "|", 1);
+
+	std::map<String, const StringList*> localVariables;
+	for (const data::VariableScope* scope = context.LocalScope();
+		 scope != nullptr;
+		 scope = scope->Parent()) {
+		for (data::VariableDomain::Iterator it = scope->Domain().GetIterator();
+			 it.HasNext();) {
+			const std::pair<const String, StringList>& variable = it.Next();
+			localVariables.emplace(variable.first, &variable.second);
+		}
+	}
+
+	for (std::map<String, const StringList*>::const_iterator it =
+			 localVariables.begin();
+		 it != localVariables.end();
+		 ++it) {
+		hash_variable(hash, it->first, *it->second);
+	}
+
+	return hash;
+}
+
+/**
+ * Returns the flags and variables of \a target, or those of a new target, if
+ * \a target is nullptr.
+ */
+/*static*/ IncludeCache::TargetState
+IncludeCache::_TargetState(const data::Target* target)
+{
+	TargetState state;
+	state.fFlags = 0;
+	if (target == nullptr)
+		return state;
+
+	state.fFlags = target->Flags();
+	if (const data::VariableDomain* variables = target->Variables()) {
+		for (data::VariableDomain::Iterator it = variables->GetIterator();
+			 it.HasNext();) {
+			const std::pair<const String, StringList>& variable = it.Next();
+			state.fVariables[variable.first] = variable.second;
+		}
+	}
+
+	return state;
+}
+
+} // namespace ham::code
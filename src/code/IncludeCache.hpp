@@ -0,0 +1,224 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_CODE_INCLUDE_CACHE_HPP
+#define HAM_CODE_INCLUDE_CACHE_HPP
+
+#include "code/Defs.hpp"
+#include "data/FileStatus.hpp"
+#include "data/StringList.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ham
+{
+
+namespace data
+{
+class Target;
+class VariableScope;
+} // namespace data
+
+namespace code
+{
+
+class EvaluationContext;
+class Rule;
+
+/**
+ * Records what evaluating an included file does and, when the file is
+ * included again, e.g. by the next run, repeats that instead of parsing and
+ * evaluating the file anew.
+ *
+ * A record holds what the evaluation has read from outside: the global
+ * variables, the variables and flags of targets, the rules it has called and
+ * the statuses of the files it has included in turn. It also holds what it
+ * has done: the final values of the global variables it has assigned and of
+ * the local ones of the including code it has changed, the appends and
+ * defaults it has applied to other global variables, and, in order, the
+ * changes to targets and the calls of built-in rules and actions. A record is
+ * only repeated, if the file and all of that is still the same, and so are
+ * the local and built-in variables the file sees when it is included.
+ *
+ * A file that does what can't be repeated that way isn't recorded and is
+ * always evaluated, e.g. one that defines rules or calls GLOB or EXIT. Files
+ * it includes are recorded nonetheless, so in the end only the files that
+ * have changed, those whose inputs have changed, and those that can't be
+ * recorded are evaluated.
+ *
+ * The hooks are called by the code that reads and changes the respective
+ * state, but only while the cache is set on the EvaluationContext.
+ */
+class IncludeCache
+{
+  public:
+	IncludeCache();
+	~IncludeCache();
+
+	IncludeCache(const IncludeCache&) = delete;
+	IncludeCache& operator=(const IncludeCache&) = delete;
+
+	bool Load(const char* fileName, const std::string& identity);
+	bool Save(const char* fileName, const std::string& identity) const;
+	// identity: whatever the records are only valid for, e.g. the working
+	// directory
+
+	bool Replay(
+		EvaluationContext& context,
+		const String& path,
+		const data::FileStatus& status
+	);
+	void BeginInclude(
+		EvaluationContext& context,
+		const String& path,
+		const data::FileStatus& status
+	);
+	void EndInclude(EvaluationContext& context, bool completed);
+
+	bool IsRecording() const { return fRecordingCount > 0 && !fReplaying; }
+	void IncludeBound(
+		EvaluationContext& context,
+		const data::Target* target,
+		const String& path,
+		const data::FileStatus& status
+	);
+	void GlobalVariableRead(const String& variable, const StringList* value);
+	void GlobalVariableChanged(
+		EvaluationContext& context,
+		const String& variable,
+		AssignmentOperator operatorType,
+		const StringList& value
+	);
+	void LocalVariableChanged(const String& variable, const StringList* data);
+	void TargetRead(const data::Target* target);
+	void TargetsAssigned(
+		EvaluationContext& context,
+		AssignmentOperator operatorType,
+		const StringList& variables,
+		const StringList& value,
+		const StringList& targets
+	);
+	void RuleCalled(
+		EvaluationContext& context,
+		const String& name,
+		const Rule* rule,
+		const StringListList& arguments
+	);
+	void Untrackable();
+	// hooks
+
+  private:
+	enum EventType {
+		EVENT_TARGET,
+		EVENT_ASSIGN_ON_TARGETS,
+		EVENT_CALL,
+		EVENT_ACTIONS
+	};
+
+	struct Event {
+		EventType fType;
+		AssignmentOperator fOperator;
+		String fName;
+		std::vector<StringList> fLists;
+	};
+
+	struct GlobalWrite {
+		GlobalWrite()
+			: fAssigned(false)
+		{
+		}
+
+		bool fAssigned;
+		StringList fValue;
+		// the final one, if assigned
+		std::vector<std::pair<AssignmentOperator, StringList>> fOperations;
+		// the appends and defaults, otherwise
+	};
+
+	struct TargetState {
+		uint32_t fFlags;
+		std::map<String, StringList> fVariables;
+
+		bool operator==(const TargetState& other) const
+		{
+			return fFlags == other.fFlags && fVariables == other.fVariables;
+		}
+	};
+
+	struct Record {
+		data::FileStatus fStatus;
+		uint64_t fScopes;
+		// hash of the local and built-in variables seen
+		std::map<std::string, data::FileStatus> fFiles;
+		std::map<String, StringList> fVariables;
+		std::map<String, TargetState> fTargets;
+		std::map<String, uint64_t> fRules;
+		// hash of each rule's definition
+		std::map<String, GlobalWrite> fWrites;
+		std::map<String, StringList> fLocalWrites;
+		// the final values of the including code's local variables changed
+		std::vector<Event> fEvents;
+	};
+
+	typedef std::map<std::string, std::vector<Record>> RecordMap;
+
+	struct Frame {
+		std::string fPath;
+		Record fRecord;
+		const data::VariableScope* fScope;
+		bool fTrackable;
+		std::map<String, StringList> fStartValues;
+		// of the global variables changed
+	};
+
+	struct RuleFingerprint {
+		const void* fInstructions;
+		const void* fActions;
+		uint64_t fHash;
+	};
+
+  private:
+	bool _IsValid(EvaluationContext& context, const Record& record);
+	void _Record(EvaluationContext& context, const Record& record);
+	void _Apply(EvaluationContext& context, const Record& record);
+
+	void _MarkUntrackable(Frame& frame);
+	void _FileRead(const std::string& path, const data::FileStatus& status);
+	void _VariableRead(const String& variable, const StringList* value);
+	void _VariableChanged(
+		const String& variable,
+		const StringList* oldValue,
+		AssignmentOperator operatorType,
+		const StringList& value
+	);
+	void _TargetRead(const String& name, const TargetState& state);
+	void _TargetsChanging(
+		EvaluationContext& context,
+		const StringList& targets
+	);
+	void _RuleRead(const String& name, uint64_t hash);
+	void _AddEvent(const Event& event);
+
+	uint64_t _RuleHash(const Rule* rule);
+	static uint64_t _ScopesHash(const EvaluationContext& context);
+	static TargetState _TargetState(const data::Target* target);
+
+  private:
+	RecordMap fRecords;
+	// loaded, to be replayed
+	RecordMap fNewRecords;
+	// recorded or replayed by this run, to be saved
+	std::vector<Frame> fFrames;
+	size_t fRecordingCount;
+	// of the frames still trackable
+	bool fReplaying;
+	std::map<const Rule*, RuleFingerprint> fRuleFingerprints;
+};
+
+} // namespace code
+} // namespace ham
+
+#endif // HAM_CODE_INCLUDE_CACHE_HPP
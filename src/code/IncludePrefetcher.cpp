@@ -0,0 +1,392 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "code/IncludePrefetcher.hpp"
+
+#include "code/Block.hpp"
+#include "code/EvaluationContext.hpp"
+#include "code/FunctionCall.hpp"
+#include "code/Include.hpp"
+#include "code/Leaf.hpp"
+#include "code/List.hpp"
+#include "code/ParseCache.hpp"
+#include "parser/Parser.hpp"
+#include "util/Constants.hpp"
+#include "util/MappedFile.hpp"
+#include "util/Metrics.hpp"
+#include "util/Trace.hpp"
+
+namespace ham::code
+{
+
+static const String kSubDirRuleName("SubDir");
+static const String kSubIncludeRuleName("SubInclude");
+static const String kJamfileVariableName("JAMFILE");
+
+static util::Counter sCacheHitsMetric(
+	"ham_cache_hits",
+	"Lookups answered from a cache.",
+	"cache=\"include_prefetch\""
+);
+static util::Counter sCacheMissesMetric(
+	"ham_cache_misses",
+	"Lookups a cache couldn't answer.",
+	"cache=\"include_prefetch\""
+);
+
+/**
+ * Appends the value of \a node to \a _list, if it is a list of literals.
+ */
+static bool
+literal_list(Node* node, StringList& _list)
+{
+	if (Leaf* leaf = dynamic_cast<Leaf*>(node)) {
+		if (!leaf->IsLiteral())
+			return false;
+		_list.Append(leaf->GetString());
+		return true;
+	}
+
+	if (List* list = dynamic_cast<List*>(node)) {
+		for (Node* child : list->Children()) {
+			if (!literal_list(child, _list))
+				return false;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Normalizes \a path lexically, so different spellings of a path, e.g.
+ * "./src/Jamfile" and "src/foo/../Jamfile", map to the same prefetched file.
+ */
+static std::string
+normalize_path(const std::string& path)
+{
+	std::vector<std::string> components;
+	size_t index = 0;
+	while (index < path.size()) {
+		size_t end = path.find('/', index);
+		if (end == std::string::npos)
+			end = path.size();
+
+		std::string component = path.substr(index, end - index);
+		if (component == "..") {
+			if (!components.empty() && components.back() != "..")
+				components.pop_back();
+			else
+				components.push_back(component);
+		} else if (!component.empty() && component != ".") {
+			components.push_back(component);
+		}
+
+		index = end + 1;
+	}
+
+	std::string result = !path.empty() && path[0] == '/' ? "/" : "";
+	for (size_t i = 0; i < components.size(); i++) {
+		if (i > 0)
+			result += '/';
+		result += components[i];
+	}
+
+	return result.empty() ? "." : result;
+}
+
+static bool
+is_same_file(const struct stat& status1, const struct stat& status2)
+{
+	return status1.st_dev == status2.st_dev && status1.st_ino == status2.st_ino
+		&& status1.st_size == status2.st_size
+		&& status1.st_mtim.tv_sec == status2.st_mtim.tv_sec
+		&& status1.st_mtim.tv_nsec == status2.st_mtim.tv_nsec;
+}
+
+namespace
+{
+
+/**
+ * Collects the SubDir and SubInclude calls and include statements with
+ * literal arguments.
+ */
+class IncludeCollector : public NodeVisitor
+{
+  public:
+	virtual bool VisitNode(Node* node)
+	{
+		if (FunctionCall* call = dynamic_cast<FunctionCall*>(node)) {
+			const StringList* functions = call->LiteralFunctions();
+			if (functions == nullptr || functions->Size() != 1
+				|| call->Arguments().empty()) {
+				return false;
+			}
+
+			StringList arguments;
+			if (!literal_list(call->Arguments().front(), arguments)
+				|| arguments.IsEmpty()) {
+				return false;
+			}
+
+			if (functions->Head() == kSubDirRuleName)
+				fSubDirs.insert(std::make_pair(arguments.Head(), arguments));
+			else if (functions->Head() == kSubIncludeRuleName)
+				fSubIncludes.push_back(arguments);
+		} else if (Include* include = dynamic_cast<Include*>(node)) {
+			StringList fileNames;
+			if (literal_list(include->FileNames(), fileNames)
+				&& !fileNames.IsEmpty()) {
+				fIncludes.push_back(fileNames.Head());
+			}
+		}
+
+		return false;
+	}
+
+  public:
+	std::map<String, StringList> fSubDirs;
+	// the first SubDir call per TOP variable
+	std::vector<StringList> fSubIncludes;
+	std::vector<String> fIncludes;
+};
+
+} // namespace
+
+IncludePrefetcher::IncludePrefetcher(size_t threadCount)
+	: fThreadCount(threadCount),
+	  fThreads(),
+	  fLock(),
+	  fQueueCondition(),
+	  fDoneCondition(),
+	  fQueue(),
+	  fEntries(),
+	  fQuit(false)
+{
+}
+
+IncludePrefetcher::~IncludePrefetcher()
+{
+	{
+		std::lock_guard<std::mutex> lock(fLock);
+		fQuit = true;
+	}
+	fQueueCondition.notify_all();
+
+	for (std::thread& thread : fThreads)
+		thread.join();
+
+	for (EntryMap::iterator it = fEntries.begin(); it != fEntries.end(); ++it) {
+		if (it->second.fBlock != nullptr)
+			it->second.fBlock->ReleaseReference();
+	}
+}
+
+/**
+ * Schedules the files \a block, the code of the included file \a filePath,
+ * will probably include.
+ */
+void
+IncludePrefetcher::ScheduleIncludes(
+	EvaluationContext& context,
+	Block* block,
+	const String& filePath
+)
+{
+	if (fThreadCount == 0)
+		return;
+
+	IncludeCollector collector;
+	block->Visit(collector);
+
+	// files parsed by earlier builds needn't be parsed again
+	ParseCache* parsedFiles = context.ParsedFiles();
+	auto schedule = [this, parsedFiles](const String& path) {
+		if (parsedFiles == nullptr || parsedFiles->Lookup(path) == nullptr)
+			Schedule(path);
+	};
+
+	for (const String& include : collector.fIncludes)
+		schedule(include);
+
+	if (collector.fSubIncludes.empty())
+		return;
+
+	std::string jamfile = util::kJamfileName;
+	const StringList* jamfileValue =
+		context.GlobalVariables()->Lookup(kJamfileVariableName);
+	if (jamfileValue != nullptr && !jamfileValue->IsEmpty())
+		jamfile = jamfileValue->Head().ToStlString();
+
+	std::string directory = filePath.ToStlString();
+	size_t slash = directory.rfind('/');
+	directory = slash != std::string::npos ? directory.substr(0, slash) : ".";
+
+	for (const StringList& subInclude : collector.fSubIncludes) {
+		// "SubInclude TOP d1 ... ;" includes $(TOP)/d1/.../$(JAMFILE). The
+		// file's own "SubDir TOP s1 ... ;" tells where TOP is relative to it.
+		// Failing that, use TOP's current value.
+		std::string top;
+		std::map<String, StringList>::const_iterator subDir =
+			collector.fSubDirs.find(subInclude.Head());
+		if (subDir != collector.fSubDirs.end()) {
+			top = directory;
+			for (size_t i = 1; i < subDir->second.Size(); i++)
+				top += "/..";
+		} else {
+			const StringList* topValue =
+				context.GlobalVariables()->Lookup(subInclude.Head());
+			if (topValue == nullptr || topValue->IsEmpty())
+				continue;
+			top = topValue->Head().ToStlString();
+		}
+
+		std::string path = top;
+		for (size_t i = 1; i < subInclude.Size(); i++)
+			path += "/" + subInclude.ElementAt(i).ToStlString();
+		path += "/" + jamfile;
+
+		schedule(path.c_str());
+	}
+}
+
+void
+IncludePrefetcher::Schedule(const String& filePath)
+{
+	if (fThreadCount == 0)
+		return;
+
+	std::string path = normalize_path(filePath.ToStlString());
+
+	{
+		std::lock_guard<std::mutex> lock(fLock);
+		Entry entry = {STATE_QUEUED, nullptr, {}};
+		if (!fEntries.insert(std::make_pair(path, entry)).second)
+			return;
+
+		fQueue.push_back(path);
+
+		if (fThreads.empty()) {
+			for (size_t i = 0; i < fThreadCount; i++)
+				fThreads.push_back(std::thread(&IncludePrefetcher::_Work, this));
+		}
+	}
+
+	fQueueCondition.notify_one();
+}
+
+/**
+ * Returns the Block parsed ahead for the file at \a filePath, if any. Waits
+ * for the parsing to finish, if it is in progress. Either way the file is
+ * removed from the prefetched files, so the caller must parse the file itself
+ * when nullptr is returned.
+ */
+Block*
+IncludePrefetcher::Take(const String& filePath)
+{
+	if (fThreadCount == 0)
+		return nullptr;
+
+	std::string path = normalize_path(filePath.ToStlString());
+
+	std::unique_lock<std::mutex> lock(fLock);
+	EntryMap::iterator it = fEntries.find(path);
+	if (it == fEntries.end()) {
+		sCacheMissesMetric.Increment();
+		return nullptr;
+	}
+
+	fDoneCondition.wait(lock, [it] {
+		return it->second.fState != STATE_PARSING;
+	});
+
+	Entry entry = it->second;
+	fEntries.erase(it);
+	lock.unlock();
+
+	// a queued file the workers haven't gotten to yet is just dropped
+	if (entry.fState != STATE_DONE) {
+		sCacheMissesMetric.Increment();
+		return nullptr;
+	}
+
+	util::Reference<Block> block(entry.fBlock, true);
+
+	struct stat status;
+	if (stat(filePath.ToCString(), &status) != 0
+		|| !is_same_file(status, entry.fStatus)) {
+		sCacheMissesMetric.Increment();
+		return nullptr;
+	}
+
+	sCacheHitsMetric.Increment();
+	return block.Detach();
+}
+
+void
+IncludePrefetcher::_Work()
+{
+	if (util::Trace* trace = util::Trace::Active())
+		trace->NameThread("include prefetcher");
+
+	std::unique_lock<std::mutex> lock(fLock);
+	for (;;) {
+		fQueueCondition.wait(lock, [this] {
+			return fQuit || !fQueue.empty();
+		});
+		if (fQuit)
+			return;
+
+		std::string path = fQueue.front();
+		fQueue.pop_front();
+
+		EntryMap::iterator it = fEntries.find(path);
+		if (it == fEntries.end() || it->second.fState != STATE_QUEUED)
+			continue;
+
+		// Take() waits for the entry while it is being parsed, so the
+		// iterator stays valid
+		it->second.fState = STATE_PARSING;
+		lock.unlock();
+
+		struct stat status = {};
+		Block* block;
+		{
+			util::Trace::Span span("ParseAhead", "file", path.c_str());
+			block = _Parse(path, status);
+		}
+
+		lock.lock();
+		it->second.fState = block != nullptr ? STATE_DONE : STATE_FAILED;
+		it->second.fBlock = block;
+		it->second.fStatus = status;
+		fDoneCondition.notify_all();
+	}
+}
+
+/**
+ * Parses the file at \a path. Returns a new reference to the parsed Block, or
+ * nullptr, if the file cannot be read or parsed. The error is left for
+ * Include to report, when it actually gets to the file.
+ */
+/*static*/ Block*
+IncludePrefetcher::_Parse(const std::string& path, struct stat& _status)
+{
+	try {
+		util::MappedFile file;
+		if (!file.Open(path.c_str()))
+			return nullptr;
+
+		_status = file.Status();
+
+		parser::Parser parser;
+		parser.SetFileName(path);
+		return parser.Parse(file.Data(), file.End());
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+} // namespace ham::code
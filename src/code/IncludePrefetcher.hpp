@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_CODE_INCLUDE_PREFETCHER_HPP
+#define HAM_CODE_INCLUDE_PREFETCHER_HPP
+
+#include "data/String.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+namespace ham::code
+{
+
+class Block;
+class EvaluationContext;
+
+/**
+ * Parses files that are likely to be included soon on worker threads, so that
+ * Include finds their Block ready when it gets to them.
+ *
+ * Before an included file is evaluated, ScheduleIncludes() looks through its
+ * code for "SubInclude TOP d1 ... ;" calls and include statements with literal
+ * arguments and guesses the paths they will include. Parsing has no side
+ * effects, so this doesn't change anything about evaluation, which still
+ * happens strictly in order on the calling thread: Take() only hands out a
+ * Block if it was parsed from the very file that is being included (same
+ * device, inode, size and modification time). Otherwise -- a wrong guess, a
+ * file that has changed, or a parse error -- Include parses the file itself,
+ * just as without prefetching.
+ */
+class IncludePrefetcher
+{
+  public:
+	IncludePrefetcher(size_t threadCount);
+	~IncludePrefetcher();
+
+	IncludePrefetcher(const IncludePrefetcher&) = delete;
+	IncludePrefetcher& operator=(const IncludePrefetcher&) = delete;
+
+	void ScheduleIncludes(
+		EvaluationContext& context,
+		Block* block,
+		const String& filePath
+	);
+	void Schedule(const String& filePath);
+
+	Block* Take(const String& filePath);
+	// returns a new reference or nullptr
+
+  private:
+	enum State {
+		STATE_QUEUED,
+		STATE_PARSING,
+		STATE_DONE,
+		STATE_FAILED
+	};
+
+	struct Entry {
+		State fState;
+		Block* fBlock;
+		struct stat fStatus;
+	};
+
+	typedef std::map<std::string, Entry> EntryMap;
+
+  private:
+	void _Work();
+	static Block* _Parse(const std::string& path, struct stat& _status);
+
+  private:
+	size_t fThreadCount;
+	std::vector<std::thread> fThreads;
+	std::mutex fLock;
+	std::condition_variable fQueueCondition;
+	std::condition_variable fDoneCondition;
+	std::deque<std::string> fQueue;
+	EntryMap fEntries;
+	bool fQuit;
+};
+
+} // namespace ham::code
+
+#endif // HAM_CODE_INCLUDE_PREFETCHER_HPP
@@ -5,6 +5,7 @@
 
 #include "code/Jump.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -56,15 +57,24 @@ Jump<JumpType>::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+template<typename JumpType>
+void
+Jump<JumpType>::Compile(Compiler& compiler, Register result)
+{
+	compiler.CompileNode(fResult, result);
+	compiler.EmitJumpStatement(JumpType::kCondition);
+}
+
 // define and instantiate the specializations
 
 #define HAM_DEFINE_JUMP_STATEMENT(name, condition)           \
 	struct JumpType##name {                                  \
 		static const char* const kName;                      \
+		static const JumpCondition kCondition = condition;   \
                                                              \
 		static inline void Setup(EvaluationContext& context) \
 		{                                                    \
-			context.SetJumpCondition(condition);             \
+			context.SetJumpCondition(kCondition);            \
 		}                                                    \
 	};                                                       \
                                                              \
@@ -5,9 +5,11 @@
 
 #include "code/Leaf.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 #include "data/StringListOperations.hpp"
+#include "data/StringListProduct.hpp"
 
 #include <algorithm>
 #include <limits>
@@ -45,6 +47,56 @@ Leaf::Dump(DumpContext& context) const
 	context << "Leaf(\"" << fString << "\")\n";
 }
 
+bool
+Leaf::IsLiteral() const
+{
+	static const char kExpansionStart[] = "$(";
+
+	const char* string = fString.ToCString();
+	const char* stringEnd = string + fString.Length();
+	return std::search(string, stringEnd, kExpansionStart, kExpansionStart + 2)
+		== stringEnd;
+}
+
+void
+Leaf::Compile(Compiler& compiler, Register result)
+{
+	static const char kSpecialCharacters[] = "$():[]";
+
+	const char* string = fString.ToCString();
+	const char* stringEnd = string + fString.Length();
+
+	// Literal strings and plain variable references are by far the most
+	// common cases. Compile them to instructions of their own.
+	if (IsLiteral()) {
+		compiler.Emit(
+			OPCODE_LOAD_CONSTANT,
+			result,
+			compiler.AddConstant(StringList(fString))
+		);
+		return;
+	}
+
+	const char* nameStart = string + 2;
+	const char* nameEnd = stringEnd - 1;
+	if (string[0] == '$' && string[1] == '(' && nameStart < nameEnd
+		&& *nameEnd == ')'
+		&& std::find_first_of(
+			   nameStart,
+			   nameEnd,
+			   kSpecialCharacters,
+			   kSpecialCharacters + sizeof(kSpecialCharacters) - 1
+		   ) == nameEnd) {
+		compiler.EmitLoadVariable(
+			String(nameStart, nameEnd - nameStart),
+			result
+		);
+		return;
+	}
+
+	compiler.Emit(OPCODE_EXPAND, result, compiler.AddString(fString));
+}
+
 /*static*/ StringList
 Leaf::EvaluateString(
 	EvaluationContext& context,
@@ -52,6 +104,48 @@ Leaf::EvaluateString(
 	const char* stringEnd,
 	const String* originalString
 )
+{
+	util::FrameArena::Frame frame(context.Arena());
+	StringListList resultFactors(&context.Arena());
+	_EvaluateFactors(
+		context,
+		stringStart,
+		stringEnd,
+		originalString,
+		resultFactors
+	);
+
+	// compute the result
+	return StringList::Multiply(resultFactors);
+}
+
+/*static*/ data::StringListProduct
+Leaf::EvaluateStringProduct(
+	EvaluationContext& context,
+	const char* stringStart,
+	const char* stringEnd,
+	const String* originalString
+)
+{
+	StringListList resultFactors(&context.Arena());
+	_EvaluateFactors(
+		context,
+		stringStart,
+		stringEnd,
+		originalString,
+		resultFactors
+	);
+	return data::StringListProduct(std::move(resultFactors));
+}
+
+/*static*/ void
+Leaf::_EvaluateFactors(
+	EvaluationContext& context,
+	const char* stringStart,
+	const char* stringEnd,
+	const String* originalString,
+	StringListList& resultFactors
+)
 {
 	// The string to evaluate is a alternating sequence of literal strings and
 	// variable expansion expressions. Each literal string can be considered a
@@ -60,9 +154,8 @@ Leaf::EvaluateString(
 	// the result we want to compute. We proceed accordingly, i.e. split the
 	// input string in literal strings and variable expansion expressions,
 	// evaluate the latter as we go, and finally compute the string list
-	// product. Recursive variable expansion expressions we evaluate using
-	// recursion.
-	StringListList resultFactors;
+	// product (that's left to the caller). Recursive variable expansion
+	// expressions we evaluate using recursion.
 
 	const char* literalStringStart = stringStart;
 	const char* stringRemainder = literalStringStart;
@@ -92,7 +185,7 @@ Leaf::EvaluateString(
 
 		// Find the matching closing ")". While at it also find the containing
 		// special characters (":", "[", "]") at the top level.
-		std::vector<const char*> colons;
+		std::pmr::vector<const char*> colons(&context.Arena());
 		const char* openingBracket = nullptr;
 		const char* closingBracket = nullptr;
 		bool recursive = false;
@@ -143,19 +236,27 @@ Leaf::EvaluateString(
 			closingBracket,
 			recursive
 		);
-		if (variableValue.IsEmpty())
-			return variableValue;
+		if (variableValue.IsEmpty()) {
+			resultFactors.assign(1, variableValue);
+			return;
+		}
 
 		resultFactors.push_back(variableValue);
 
 		literalStringStart = stringRemainder;
 	}
 
-	// If we haven't encountered any variable, just return the original string.
+	// If we haven't encountered any variable, the original string is the only
+	// factor.
 	if (resultFactors.empty()) {
 		if (originalString != nullptr)
-			return StringList(*originalString);
-		return StringList(String(stringStart, stringEnd - stringStart));
+			resultFactors.push_back(StringList(*originalString));
+		else {
+			resultFactors.push_back(
+				StringList(String(stringStart, stringEnd - stringStart))
+			);
+		}
+		return;
 	}
 
 	// Add the literal string segment after the last variable to the result
@@ -165,9 +266,6 @@ Leaf::EvaluateString(
 			String(literalStringStart, stringEnd - literalStringStart)
 		));
 	}
-
-	// compute the result
-	return StringList::Multiply(resultFactors);
 }
 
 /*static*/ StringList
@@ -175,7 +273,7 @@ Leaf::_EvaluateVariableExpression(
 	EvaluationContext& context,
 	const char* variableStart,
 	const char* variableEnd,
-	const std::vector<const char*>& colons,
+	const std::pmr::vector<const char*>& colons,
 	const char* openingBracket,
 	const char* closingBracket,
 	bool recursive
@@ -271,7 +369,7 @@ Leaf::_EvaluateVariableExpression(
 		if (firstColon != nullptr) {
 			data::StringListOperations operations;
 			const char* colon = firstColon;
-			std::vector<const char*>::const_iterator colonIt = colons.begin();
+			std::pmr::vector<const char*>::const_iterator colonIt = colons.begin();
 			for (;;) {
 				++colonIt;
 				const char* colonEnd =
@@ -344,7 +442,7 @@ Leaf::_EvaluateVariableExpression(
 	std::vector<data::StringListOperations> operationsList;
 	if (firstColon != nullptr) {
 		const char* segmentStart = firstColon + 1;
-		std::vector<const char*>::const_iterator colonIt = colons.begin();
+		std::pmr::vector<const char*>::const_iterator colonIt = colons.begin();
 		for (;;) {
 			++colonIt;
 			const char* segmentEnd =
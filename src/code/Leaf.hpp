@@ -13,6 +13,7 @@ namespace ham
 namespace data
 {
 class StringListOperations;
+class StringListProduct;
 }
 
 namespace code
@@ -27,6 +28,12 @@ class Leaf : public Node
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
+
+	const String& GetString() const { return fString; }
+	bool IsLiteral() const;
+	// whether the string doesn't contain any variable expansion, i.e.
+	// evaluates to itself
 
 	static StringList EvaluateString(
 		EvaluationContext& context,
@@ -34,13 +41,29 @@ class Leaf : public Node
 		const char* stringEnd,
 		const String* originalString
 	);
+	static data::StringListProduct EvaluateStringProduct(
+		EvaluationContext& context,
+		const char* stringStart,
+		const char* stringEnd,
+		const String* originalString
+	);
+	// like EvaluateString(), but doesn't concatenate the result elements; the
+	// product is allocated in the context's arena, so it must not outlive the
+	// current arena frame
 
   private:
+	static void _EvaluateFactors(
+		EvaluationContext& context,
+		const char* stringStart,
+		const char* stringEnd,
+		const String* originalString,
+		StringListList& resultFactors
+	);
 	static StringList _EvaluateVariableExpression(
 		EvaluationContext& context,
 		const char* variableStart,
 		const char* variableEnd,
-		const std::vector<const char*>& colon,
+		const std::pmr::vector<const char*>& colon,
 		const char* openingBracket,
 		const char* closingBracket,
 		bool recursive
@@ -5,6 +5,7 @@
 
 #include "code/List.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -60,4 +61,24 @@ List::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+List::Compile(Compiler& compiler, Register result)
+{
+	size_t childCount = fChildren.size();
+	if (childCount == 0) {
+		compiler.Emit(OPCODE_CLEAR, result);
+		return;
+	}
+
+	compiler.CompileNode(fChildren[0], result);
+	if (childCount == 1)
+		return;
+
+	Register element = compiler.AllocateRegister();
+	for (size_t i = 1; i < childCount; i++) {
+		compiler.CompileNode(fChildren[i], element);
+		compiler.Emit(OPCODE_APPEND, result, element);
+	}
+}
+
 } // namespace ham::code
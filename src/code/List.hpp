@@ -20,9 +20,12 @@ class List : public Node
 
 	inline void AppendKeepReference(Node* child);
 
+	const std::vector<Node*>& Children() const { return fChildren; }
+
 	virtual StringList Evaluate(EvaluationContext& context);
 	virtual Node* Visit(NodeVisitor& visitor);
 	virtual void Dump(DumpContext& context) const;
+	virtual void Compile(Compiler& compiler, Register result);
 
   private:
 	std::vector<Node*> fChildren;
@@ -5,6 +5,7 @@
 
 #include "code/LocalVariableDeclaration.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -80,4 +81,30 @@ LocalVariableDeclaration::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+LocalVariableDeclaration::Compile(Compiler& compiler, Register result)
+{
+	Register variables = compiler.AllocateRegister();
+	compiler.CompileNode(fVariables, variables);
+
+	// The names are usually literal, so the variables can get slots. They are
+	// only declared after the initializer, which may refer to variables of the
+	// same name in outer scopes.
+	const StringList* constantNames = compiler.ConstantIn(variables);
+	bool namesKnown = constantNames != nullptr;
+	StringList names = namesKnown ? *constantNames : StringList();
+
+	if (fInitializer != nullptr)
+		compiler.CompileNode(fInitializer, result);
+	else
+		compiler.Emit(OPCODE_CLEAR, result);
+
+	compiler.Emit(
+		OPCODE_LOCAL,
+		variables,
+		result,
+		compiler.DeclareLocalVariables(namesKnown ? &names : nullptr)
+	);
+}
+
 } // namespace ham::code
@@ -5,6 +5,8 @@
 
 #include "code/Node.hpp"
 
+#include "code/Compiler.hpp"
+
 namespace ham::code
 {
 
@@ -12,4 +14,10 @@ NodeVisitor::~NodeVisitor() {}
 
 Node::~Node() {}
 
+void
+Node::Compile(Compiler& compiler, Register result)
+{
+	compiler.EmitEvaluate(this, result);
+}
+
 } // namespace ham::code
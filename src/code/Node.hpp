@@ -5,6 +5,7 @@
 #ifndef HAM_CODE_CODE_HPP
 #define HAM_CODE_CODE_HPP
 
+#include "code/Defs.hpp"
 #include "data/StringList.hpp"
 #include "util/Referenceable.hpp"
 
@@ -13,6 +14,7 @@
 namespace ham::code
 {
 
+class Compiler;
 class DumpContext;
 class EvaluationContext;
 class Node;
@@ -104,6 +106,28 @@ class Node : public Referenceable
 	 * children.
 	 */
 	virtual void Dump(DumpContext& context) const = 0;
+
+	/**
+	 * Compile the current node to bytecode. The instructions emitted must
+	 * store the result Evaluate() would return in register \a result. Subnodes
+	 * are compiled via Compiler::CompileNode() into registers allocated from
+	 * the compiler.
+
+	 \code
+	 Register left = compiler.AllocateRegister();
+	 Register right = compiler.AllocateRegister();
+	 compiler.CompileNode(fLeft, left);
+	 compiler.CompileNode(fRight, right);
+	 compiler.Emit(OPCODE_EQUAL, result, left, right);
+	 \endcode
+
+	 * The default implementation emits an instruction that calls Evaluate(),
+	 * which is fine for rarely evaluated nodes.
+	 *
+	 * \param[in] compiler Compiler to emit the instructions with.
+	 * \param[in] result Register to store the result in.
+	 */
+	virtual void Compile(Compiler& compiler, Register result);
 };
 
 typedef std::list<Node*> NodeList;
@@ -5,6 +5,7 @@
 
 #include "code/NotExpression.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -47,4 +48,12 @@ NotExpression::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+NotExpression::Compile(Compiler& compiler, Register result)
+{
+	Register child = compiler.AllocateRegister();
+	compiler.CompileNode(fChild, child);
+	compiler.Emit(OPCODE_NOT, result, child);
+}
+
 } // namespace ham::code
@@ -37,6 +37,10 @@ OnExpression::Evaluate(EvaluationContext& context)
 	// get the first of the targets and push a copy of its variable domain as a
 	// new local scope
 	data::Target* target = context.Targets().LookupOrCreate(objects.Head());
+	IncludeCache* includeCache = context.EvaluatedIncludes();
+	if (includeCache != nullptr && includeCache->IsRecording())
+		includeCache->TargetRead(target);
+
 	data::VariableDomain localVariables(*target->Variables(true));
 	data::VariableScope localScope(localVariables, context.LocalScope());
 	context.SetLocalScope(&localScope);
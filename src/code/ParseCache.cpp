@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "code/ParseCache.hpp"
+
+#include "code/Block.hpp"
+#include "util/Metrics.hpp"
+
+namespace ham::code
+{
+
+static util::Counter sCacheHitsMetric(
+	"ham_cache_hits",
+	"Lookups answered from a cache.",
+	"cache=\"parse\""
+);
+static util::Counter sCacheMissesMetric(
+	"ham_cache_misses",
+	"Lookups a cache couldn't answer.",
+	"cache=\"parse\""
+);
+
+ParseCache::ParseCache()
+	: fDirectory(),
+	  fBlocks(),
+	  fAddedPaths()
+{
+}
+
+ParseCache::~ParseCache() { Clear(); }
+
+Block*
+ParseCache::Lookup(const String& path) const
+{
+	BlockMap::const_iterator it = fBlocks.find(_AbsolutePath(path));
+	if (it == fBlocks.end()) {
+		sCacheMissesMetric.Increment();
+		return nullptr;
+	}
+
+	sCacheHitsMetric.Increment();
+	return it->second;
+}
+
+void
+ParseCache::Add(const String& path, Block* block)
+{
+	std::string absolutePath = _AbsolutePath(path);
+	Remove(absolutePath);
+
+	block->AcquireReference();
+	fBlocks[absolutePath] = block;
+	fAddedPaths.insert(absolutePath);
+}
+
+void
+ParseCache::Remove(const std::string& path)
+{
+	BlockMap::iterator it = fBlocks.find(path);
+	if (it == fBlocks.end())
+		return;
+
+	it->second->ReleaseReference();
+	fBlocks.erase(it);
+	fAddedPaths.erase(path);
+}
+
+void
+ParseCache::Clear()
+{
+	for (BlockMap::iterator it = fBlocks.begin(); it != fBlocks.end(); ++it)
+		it->second->ReleaseReference();
+	fBlocks.clear();
+	fAddedPaths.clear();
+}
+
+std::string
+ParseCache::_AbsolutePath(const String& path) const
+{
+	if (path.ToCString()[0] == '/' || fDirectory.empty())
+		return path.ToStlString();
+	return fDirectory + '/' + path.ToCString();
+}
+
+} // namespace ham::code
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_CODE_PARSE_CACHE_HPP
+#define HAM_CODE_PARSE_CACHE_HPP
+
+#include "data/String.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace ham::code
+{
+
+class Block;
+
+/**
+ * Maps the absolute paths of parsed files to their code, so a file needn't be
+ * parsed again, e.g. by the next build the daemon runs. Relative paths are
+ * looked up in the cache's directory.
+ *
+ * The cache doesn't notice when a file changes; whoever keeps it around must
+ * remove changed files. The files added since ClearAddedPaths() are tracked,
+ * so they can be told to whoever does.
+ */
+class ParseCache
+{
+  public:
+	ParseCache();
+	~ParseCache();
+
+	ParseCache(const ParseCache&) = delete;
+	ParseCache& operator=(const ParseCache&) = delete;
+
+	const std::string& Directory() const { return fDirectory; }
+	void SetDirectory(const std::string& directory)
+	{
+		fDirectory = directory;
+	}
+
+	Block* Lookup(const String& path) const;
+	// doesn't return a new reference
+	void Add(const String& path, Block* block);
+	void Remove(const std::string& path);
+	void Clear();
+
+	const std::set<std::string>& AddedPaths() const { return fAddedPaths; }
+	void ClearAddedPaths() { fAddedPaths.clear(); }
+
+  private:
+	typedef std::map<std::string, Block*> BlockMap;
+
+  private:
+	std::string _AbsolutePath(const String& path) const;
+
+  private:
+	std::string fDirectory;
+	BlockMap fBlocks;
+	// each holds a reference
+	std::set<std::string> fAddedPaths;
+};
+
+} // namespace ham::code
+
+#endif // HAM_CODE_PARSE_CACHE_HPP
@@ -20,6 +20,7 @@ class Rule
 	inline Rule();
 	inline ~Rule();
 
+	const String& Name() const { return fName; }
 	void SetName(const String& name) { fName = name; }
 
 	RuleInstructions* Instructions() const { return fInstructions; }
@@ -29,6 +29,7 @@ RuleDefinition::RuleDefinition(
 	// UserRuleInstructions::Evaluate() already sets up a new local variable
 	// scope, so the block doesn't need to do that.
 	fBlock->SetLocalVariableScopeNeeded(false);
+	fBlock->SetRuleParameterNames(fParameterNames);
 
 	fInstructions = new UserRuleInstructions(fParameterNames, fBlock);
 }
@@ -42,6 +43,10 @@ RuleDefinition::~RuleDefinition()
 StringList
 RuleDefinition::Evaluate(EvaluationContext& context)
 {
+	// rule definitions can't be repeated by the IncludeCache
+	if (IncludeCache* includeCache = context.EvaluatedIncludes())
+		includeCache->Untrackable();
+
 	Rule& rule = context.Rules().LookupOrCreate(fRuleName);
 	rule.SetInstructions(fInstructions);
 	return StringList::False();
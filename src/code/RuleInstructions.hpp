@@ -15,11 +15,31 @@ class EvaluationContext;
 
 class RuleInstructions : public util::Referenceable
 {
+  public:
+	enum CallEffects {
+		CALL_EFFECTS_NONE,
+		// none besides the result, or only those of the code it evaluates
+		CALL_EFFECTS_REPEATABLE,
+		// depend on the parameters only, e.g. printing them or adding
+		// dependencies
+		CALL_EFFECTS_CHANGES_TARGETS,
+		// like the former, but change the flags or variables of the targets
+		// named by the first parameter
+		CALL_EFFECTS_UNTRACKABLE
+		// depend on something else, e.g. the file system
+	};
+
   public:
 	virtual ~RuleInstructions();
 
 	virtual StringList
 	Evaluate(EvaluationContext& context, const StringListList& parameters) = 0;
+
+	virtual CallEffects GetCallEffects() const
+	{
+		return CALL_EFFECTS_UNTRACKABLE;
+	}
+	// what an IncludeCache must know about the effects of a call
 };
 
 } // namespace ham::code
@@ -7,25 +7,54 @@
 
 #include "code/Rule.hpp"
 
+#include <atomic>
 #include <map>
 
 namespace ham::code
 {
 
+/**
+ * Caches the rule a call site with a literal rule name resolves to. It remains
+ * valid as long as the generation of the RulePool doesn't change.
+ */
+struct RuleLookupCache {
+	RuleLookupCache()
+		: fRule(nullptr),
+		  fGeneration(0)
+	{
+	}
+
+	Rule* fRule;
+	size_t fGeneration;
+};
+
 class RulePool
 {
   public:
-	RulePool() {}
+	RulePool()
+		: fRules(),
+		  fGeneration(++sLastGeneration)
+	{
+	}
 	~RulePool() {}
 
 	inline Rule* Lookup(const String& name);
+	inline Rule* Lookup(const String& name, RuleLookupCache& cache);
 	inline Rule& LookupOrCreate(const String& name);
 
+	size_t Generation() const { return fGeneration; }
+	// changes whenever a rule is added; unique among all pools, so a cache
+	// can't mistake another pool's rule for one of this pool
+
   private:
 	typedef std::map<String, Rule> RuleMap;
 
   private:
 	RuleMap fRules;
+	size_t fGeneration;
+
+	inline static std::atomic<size_t> sLastGeneration = 0;
+	// pools are created and changed by several threads, e.g. by the daemon
 };
 
 Rule*
@@ -35,6 +64,20 @@ RulePool::Lookup(const String& name)
 	return it == fRules.end() ? nullptr : &it->second;
 }
 
+Rule*
+RulePool::Lookup(const String& name, RuleLookupCache& cache)
+{
+	// Rules are never removed and a redefinition only changes the existing
+	// Rule object, so a cached result -- including a failed lookup -- only
+	// becomes stale when a rule is added.
+	if (cache.fGeneration != fGeneration) {
+		cache.fRule = Lookup(name);
+		cache.fGeneration = fGeneration;
+	}
+
+	return cache.fRule;
+}
+
 Rule&
 RulePool::LookupOrCreate(const String& name)
 {
@@ -44,6 +87,7 @@ RulePool::LookupOrCreate(const String& name)
 		return it->second;
 
 	// no rule yet -- create one
+	fGeneration = ++sLastGeneration;
 	Rule& rule = fRules[name];
 	rule.SetName(name);
 	return rule;
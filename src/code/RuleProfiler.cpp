@@ -0,0 +1,160 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "code/RuleProfiler.hpp"
+
+#include "util/AllocationCount.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ham::code
+{
+
+RuleProfiler::RuleProfiler()
+	: fRules(),
+	  fRoot{nullptr, 0, {}},
+	  fStack(),
+	  fOwnAllocations(0)
+{
+}
+
+RuleProfiler::~RuleProfiler() {}
+
+void
+RuleProfiler::BeginCall(const String& rule)
+{
+	size_t allocations = util::AllocationCount();
+
+	StackNode* parent = fStack.empty() ? &fRoot : fStack.back().fNode;
+	std::unique_ptr<StackNode>& node = parent->fChildren[rule];
+	if (node == nullptr) {
+		RuleStatistics& statistics =
+			fRules.try_emplace(rule, RuleStatistics{rule, 0, 0, 0, 0, 0, 0})
+				.first->second;
+		node.reset(new StackNode{&statistics, 0, {}});
+	}
+
+	node->fRule->fCalls++;
+	node->fRule->fActiveCalls++;
+
+	// start measuring only after the bookkeeping, whose allocations don't
+	// count at all
+	fStack.push_back({node.get(), Clock::time_point(), 0, 0, 0});
+	fOwnAllocations += util::AllocationCount() - allocations;
+	Frame& frame = fStack.back();
+	frame.fStartAllocations = _AllocationCount();
+	frame.fStart = Clock::now();
+}
+
+void
+RuleProfiler::EndCall()
+{
+	Clock::time_point end = Clock::now();
+	size_t allocations = _AllocationCount();
+
+	Frame frame = fStack.back();
+	fStack.pop_back();
+
+	int64_t time =
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end - frame.fStart)
+			.count();
+	size_t callAllocations = allocations - frame.fStartAllocations;
+
+	RuleStatistics* rule = frame.fNode->fRule;
+	rule->fSelfTime += time - frame.fChildTime;
+	rule->fSelfAllocations += callAllocations - frame.fChildAllocations;
+	frame.fNode->fSelfTime += time - frame.fChildTime;
+
+	if (--rule->fActiveCalls == 0) {
+		rule->fInclusiveTime += time;
+		rule->fInclusiveAllocations += callAllocations;
+	}
+
+	if (!fStack.empty()) {
+		fStack.back().fChildTime += time;
+		fStack.back().fChildAllocations += callAllocations;
+	}
+}
+
+/**
+ * Prints a table of the rules, the most expensive ones by self time first.
+ */
+void
+RuleProfiler::PrintReport(std::ostream& output) const
+{
+	std::vector<const RuleStatistics*> rules;
+	for (const auto& [name, statistics] : fRules)
+		rules.push_back(&statistics);
+	std::stable_sort(
+		rules.begin(),
+		rules.end(),
+		[](const RuleStatistics* a, const RuleStatistics* b) {
+			return a->fSelfTime > b->fSelfTime;
+		}
+	);
+
+	output << "...rule profile (times in milliseconds)...\n"
+		   << "     calls   inclusive        self   allocations  "
+			  "self allocs  rule\n";
+
+	for (const RuleStatistics* rule : rules) {
+		char line[128];
+		snprintf(
+			line,
+			sizeof(line),
+			"%10zu %11.3f %11.3f %13zu %12zu  ",
+			rule->fCalls,
+			rule->fInclusiveTime / 1e6,
+			rule->fSelfTime / 1e6,
+			rule->fInclusiveAllocations,
+			rule->fSelfAllocations
+		);
+		output << line << rule->fName << '\n';
+	}
+
+	output.flush();
+}
+
+/**
+ * Writes a line "rule1;rule2;...;ruleN <microseconds>" for every call stack
+ * with the self time of its innermost rule, as flamegraph.pl and similar tools
+ * expect.
+ */
+void
+RuleProfiler::WriteCollapsedStacks(std::ostream& output) const
+{
+	_WriteCollapsedStacks(output, fRoot, std::string());
+	output.flush();
+}
+
+/**
+ * Returns the allocations of the thread, not counting the profiler's own.
+ */
+size_t
+RuleProfiler::_AllocationCount() const
+{
+	return util::AllocationCount() - fOwnAllocations;
+}
+
+void
+RuleProfiler::_WriteCollapsedStacks(
+	std::ostream& output,
+	const StackNode& node,
+	const std::string& path
+) const
+{
+	if (node.fRule != nullptr && node.fSelfTime >= 1000)
+		output << path << ' ' << node.fSelfTime / 1000 << '\n';
+
+	for (const auto& [name, child] : node.fChildren) {
+		std::string childPath = path.empty()
+			? name.ToStlString()
+			: path + ';' + name.ToStlString();
+		_WriteCollapsedStacks(output, *child, childPath);
+	}
+}
+
+} // namespace ham::code
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_CODE_RULE_PROFILER_HPP
+#define HAM_CODE_RULE_PROFILER_HPP
+
+#include "data/String.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace ham::code
+{
+
+/**
+ * Measures where evaluating the Jam code spends its time, per rule: how often
+ * each rule is called, the time spent in it including and excluding the rules
+ * it calls, and likewise the heap allocations.
+ *
+ * FunctionCall reports every call of a rule with instructions (built-in ones
+ * included) via a Scope. Besides the per-rule report, the call tree is kept,
+ * which WriteCollapsedStacks() writes in the format flame graph tools read.
+ * A recursive rule's inclusive time only counts its outermost calls.
+ */
+class RuleProfiler
+{
+  public:
+	class Scope;
+
+  public:
+	RuleProfiler();
+	~RuleProfiler();
+
+	RuleProfiler(const RuleProfiler&) = delete;
+	RuleProfiler& operator=(const RuleProfiler&) = delete;
+
+	void BeginCall(const String& rule);
+	void EndCall();
+
+	void PrintReport(std::ostream& output) const;
+	void WriteCollapsedStacks(std::ostream& output) const;
+
+  private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct RuleStatistics {
+		String fName;
+		size_t fCalls;
+		int64_t fInclusiveTime;
+		// in nanoseconds
+		int64_t fSelfTime;
+		size_t fInclusiveAllocations;
+		size_t fSelfAllocations;
+		size_t fActiveCalls;
+		// calls currently on the stack, for recursive rules
+	};
+
+	struct StackNode {
+		RuleStatistics* fRule;
+		int64_t fSelfTime;
+		std::map<String, std::unique_ptr<StackNode>> fChildren;
+	};
+
+	struct Frame {
+		StackNode* fNode;
+		Clock::time_point fStart;
+		size_t fStartAllocations;
+		int64_t fChildTime;
+		size_t fChildAllocations;
+	};
+
+  private:
+	size_t _AllocationCount() const;
+	void _WriteCollapsedStacks(
+		std::ostream& output,
+		const StackNode& node,
+		const std::string& path
+	) const;
+
+  private:
+	std::map<String, RuleStatistics> fRules;
+	StackNode fRoot;
+	std::vector<Frame> fStack;
+	size_t fOwnAllocations;
+	// done by the profiler itself
+};
+
+/**
+ * Scope guard reporting a rule call to a profiler, if given.
+ */
+class RuleProfiler::Scope
+{
+  public:
+	Scope(RuleProfiler* profiler, const String& rule)
+		: fProfiler(profiler)
+	{
+		if (fProfiler != nullptr)
+			fProfiler->BeginCall(rule);
+	}
+
+	~Scope()
+	{
+		if (fProfiler != nullptr)
+			fProfiler->EndCall();
+	}
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+  private:
+	RuleProfiler* fProfiler;
+};
+
+} // namespace ham::code
+
+#endif // HAM_CODE_RULE_PROFILER_HPP
@@ -5,6 +5,7 @@
 
 #include "code/Switch.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -80,4 +81,25 @@ Switch::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+Switch::Compile(Compiler& compiler, Register result)
+{
+	Compiler::Label endLabel = compiler.NewLabel();
+
+	Register argument = compiler.AllocateRegister();
+	compiler.CompileNode(fArgument, argument);
+
+	for (CaseList::const_iterator it = fCases.begin(); it != fCases.end();
+		 ++it) {
+		Compiler::Label nextCaseLabel = compiler.NewLabel();
+		compiler.EmitMatch(argument, *it, nextCaseLabel);
+		compiler.CompileNode(*it, result);
+		compiler.EmitJump(endLabel);
+		compiler.BindLabel(nextCaseLabel);
+	}
+
+	compiler.Emit(OPCODE_CLEAR, result);
+	compiler.BindLabel(endLabel);
+}
+
 } // namespace ham::code
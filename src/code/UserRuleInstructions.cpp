@@ -35,8 +35,9 @@ UserRuleInstructions::Evaluate(
 )
 {
 	// create a variable domain for the built-in variables (the numbered ones
-	// and "<" and ">")
-	data::VariableDomain builtInVariables;
+	// and "<" and ">"). Like the local variables domain, it is allocated in
+	// the arena frame of the calling FunctionCall.
+	data::VariableDomain builtInVariables(&context.Arena());
 
 	// set the number parameters ($(1) ... $(n))
 	size_t parameterCount = parameters.size();
@@ -57,7 +58,7 @@ UserRuleInstructions::Evaluate(
 
 	// prepare the local variable scope (for the named parameters)
 	data::VariableScope* oldLocalScope = context.LocalScope();
-	data::VariableDomain localVariables;
+	data::VariableDomain localVariables(&context.Arena());
 	data::VariableScope localScope(localVariables, oldLocalScope);
 	// TODO: This is jam compatible behavior. It would be more logical to
 	// have a null parent for the new scope, so the previous local variables
@@ -79,6 +80,8 @@ UserRuleInstructions::Evaluate(
 
 	data::VariableDomain* oldBuiltInVariables = context.BuiltInVariables();
 	context.SetBuiltInVariables(&builtInVariables);
+	const StringListList* oldParameters = context.RuleParameters();
+	context.SetRuleParameters(&parameters);
 
 	// execute the rule block
 	StringList result = fBlock->Evaluate(context);
@@ -89,6 +92,7 @@ UserRuleInstructions::Evaluate(
 	// reinstate the old local variable scope and the built-in variables
 	context.SetLocalScope(oldLocalScope);
 	context.SetBuiltInVariables(oldBuiltInVariables);
+	context.SetRuleParameters(oldParameters);
 
 	return result;
 }
@@ -21,6 +21,11 @@ class UserRuleInstructions : public RuleInstructions
 	virtual StringList
 	Evaluate(EvaluationContext& context, const StringListList& parameters);
 
+	CallEffects GetCallEffects() const override { return CALL_EFFECTS_NONE; }
+
+	const StringList& ParameterNames() const { return fParameterNames; }
+	Node* Block() const { return fBlock; }
+
   private:
 	StringList fParameterNames;
 	Node* fBlock;
@@ -0,0 +1,509 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "code/VirtualMachine.hpp"
+
+#include "code/Assignment.hpp"
+#include "code/Case.hpp"
+#include "code/EvaluationContext.hpp"
+#include "code/FunctionCall.hpp"
+#include "code/Leaf.hpp"
+
+namespace ham::code
+{
+
+static const size_t kLeave = SIZE_MAX;
+
+static inline const StringList&
+boolean_list(bool value)
+{
+	return value ? StringList::True() : StringList::False();
+}
+
+VirtualMachine::VirtualMachine(
+	EvaluationContext& context,
+	const Bytecode& code
+)
+	: fContext(context),
+	  fCode(code),
+	  fRegisters(code.RegisterCount(), &context.Arena()),
+	  fLoops(
+		  code.LoopCount(),
+		  Loop{nullptr, StringList(), 0, String()},
+		  &context.Arena()
+	  ),
+	  fSlots(code.SlotCount(), nullptr, &context.Arena()),
+	  fParameters(context.RuleParameters())
+{
+}
+
+/*static*/ StringList
+VirtualMachine::Execute(EvaluationContext& context, const Bytecode& code)
+{
+	VirtualMachine machine(context, code);
+	machine._Run(0, code.Instructions().size());
+	return machine.fRegisters[0];
+}
+
+size_t
+VirtualMachine::_Run(size_t start, size_t end)
+{
+	const Instruction* instructions = fCode.Instructions().data();
+	StringList* registers = fRegisters.data();
+
+	size_t index = start;
+	while (index >= start && index < end) {
+		const Instruction& instruction = instructions[index++];
+		switch (instruction.fOpcode) {
+			case OPCODE_LOAD_CONSTANT:
+				registers[instruction.fA] = fCode.ConstantAt(instruction.fB);
+				break;
+
+			case OPCODE_LOAD_VARIABLE:
+			{
+				const StringList* value =
+					fContext.LookupVariable(fCode.StringAt(instruction.fB));
+				if (value != nullptr)
+					registers[instruction.fA] = *value;
+				else
+					registers[instruction.fA].Clear();
+				break;
+			}
+
+			case OPCODE_LOAD_PARAMETER:
+			{
+				// Like the built-in variable, an empty parameter doesn't hide
+				// other variables of the same name.
+				if (fParameters != nullptr
+					&& instruction.fB < fParameters->size()
+					&& !(*fParameters)[instruction.fB].IsEmpty()) {
+					registers[instruction.fA] = (*fParameters)[instruction.fB];
+					break;
+				}
+
+				const StringList* value =
+					fContext.LookupVariable(fCode.StringAt(instruction.fC));
+				if (value != nullptr)
+					registers[instruction.fA] = *value;
+				else
+					registers[instruction.fA].Clear();
+				break;
+			}
+
+			case OPCODE_LOAD_LOCAL:
+			{
+				StringList* value = _Slot(instruction.fB, instruction.fC);
+				if (value != nullptr)
+					registers[instruction.fA] = *value;
+				else
+					registers[instruction.fA].Clear();
+				break;
+			}
+
+			case OPCODE_EXPAND:
+			{
+				const String& string = fCode.StringAt(instruction.fB);
+				const char* stringStart = string.ToCString();
+				registers[instruction.fA] = Leaf::EvaluateString(
+					fContext,
+					stringStart,
+					stringStart + string.Length(),
+					&string
+				);
+				break;
+			}
+
+			case OPCODE_CLEAR:
+				registers[instruction.fA].Clear();
+				break;
+
+			case OPCODE_APPEND:
+				registers[instruction.fA].Append(registers[instruction.fB]);
+				break;
+
+			case OPCODE_RELEASE:
+				for (uint32_t i = 0; i < instruction.fC; i++)
+					registers[instruction.fA + i].Clear();
+				break;
+
+			case OPCODE_CALL:
+				_Call(
+					instruction.fA,
+					registers[instruction.fB],
+					instruction.fB + 1,
+					instruction.fC,
+					nullptr
+				);
+				break;
+
+			case OPCODE_CALL_RULE:
+			{
+				CallSite& callSite = fCode.CallSiteAt(instruction.fC);
+				_Call(
+					instruction.fA,
+					callSite.fFunctions,
+					instruction.fB,
+					callSite.fArgumentCount,
+					&callSite.fCache
+				);
+				break;
+			}
+
+			case OPCODE_EVALUATE:
+				registers[instruction.fA] =
+					fCode.NodeAt(instruction.fB)->Evaluate(fContext);
+				break;
+
+			case OPCODE_ASSIGN:
+			case OPCODE_ASSIGN_APPEND:
+			case OPCODE_ASSIGN_DEFAULT:
+			{
+				AssignmentOperator operatorType = ASSIGNMENT_OPERATOR_ASSIGN;
+				if (instruction.fOpcode == OPCODE_ASSIGN_APPEND)
+					operatorType = ASSIGNMENT_OPERATOR_APPEND;
+				else if (instruction.fOpcode == OPCODE_ASSIGN_DEFAULT)
+					operatorType = ASSIGNMENT_OPERATOR_DEFAULT;
+
+				if (instruction.fC != Bytecode::kNoRegister) {
+					Assignment::AssignOnTargets(
+						fContext,
+						operatorType,
+						registers[instruction.fA],
+						registers[instruction.fB],
+						registers[instruction.fC]
+					);
+				} else {
+					Assignment::Assign(
+						fContext,
+						operatorType,
+						registers[instruction.fA],
+						registers[instruction.fB]
+					);
+				}
+				break;
+			}
+
+			case OPCODE_ASSIGN_LOCAL:
+			case OPCODE_ASSIGN_APPEND_LOCAL:
+			case OPCODE_ASSIGN_DEFAULT_LOCAL:
+			{
+				const StringList& value = registers[instruction.fB];
+				StringList* data = _Slot(instruction.fA, instruction.fC);
+				if (data == nullptr) {
+					const String& variable = fCode.StringAt(instruction.fC);
+					IncludeCache* includeCache = fContext.EvaluatedIncludes();
+					if (includeCache != nullptr
+						&& includeCache->IsRecording()) {
+						AssignmentOperator operatorType =
+							ASSIGNMENT_OPERATOR_ASSIGN;
+						if (instruction.fOpcode == OPCODE_ASSIGN_APPEND_LOCAL)
+							operatorType = ASSIGNMENT_OPERATOR_APPEND;
+						else if (instruction.fOpcode != OPCODE_ASSIGN_LOCAL)
+							operatorType = ASSIGNMENT_OPERATOR_DEFAULT;
+
+						includeCache->GlobalVariableChanged(
+							fContext,
+							variable,
+							operatorType,
+							value
+						);
+					}
+					data = &fContext.GlobalVariables()->LookupOrCreate(
+						variable
+					);
+				}
+
+				if (instruction.fOpcode == OPCODE_ASSIGN_LOCAL)
+					*data = value;
+				else if (instruction.fOpcode == OPCODE_ASSIGN_APPEND_LOCAL)
+					data->Append(value);
+				else if (data->IsEmpty())
+					*data = value;
+				break;
+			}
+
+			case OPCODE_LOCAL:
+			{
+				const StringList& value = registers[instruction.fB];
+				const StringList& variables = registers[instruction.fA];
+				for (StringList::Iterator it = variables.GetIterator();
+					 it.HasNext();) {
+					fContext.LocalScope()->Set(it.Next(), value);
+				}
+
+				// the variables are new, so rebind their slots on next use
+				if (instruction.fC != Bytecode::kNoSlot) {
+					size_t count = variables.Size();
+					for (size_t i = 0; i < count; i++)
+						fSlots[instruction.fC + i] = nullptr;
+				}
+				break;
+			}
+
+			case OPCODE_EQUAL:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB]
+						.CompareWith(registers[instruction.fC], true)
+					== 0
+				);
+				break;
+
+			case OPCODE_NOT_EQUAL:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB]
+						.CompareWith(registers[instruction.fC], true)
+					!= 0
+				);
+				break;
+
+			case OPCODE_LESS:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB]
+						.CompareWith(registers[instruction.fC], true)
+					< 0
+				);
+				break;
+
+			case OPCODE_LESS_OR_EQUAL:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB]
+						.CompareWith(registers[instruction.fC], true)
+					<= 0
+				);
+				break;
+
+			case OPCODE_GREATER:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB]
+						.CompareWith(registers[instruction.fC], true)
+					> 0
+				);
+				break;
+
+			case OPCODE_GREATER_OR_EQUAL:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB]
+						.CompareWith(registers[instruction.fC], true)
+					>= 0
+				);
+				break;
+
+			case OPCODE_AND:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB].IsTrue()
+					&& registers[instruction.fC].IsTrue()
+				);
+				break;
+
+			case OPCODE_OR:
+				registers[instruction.fA] = boolean_list(
+					registers[instruction.fB].IsTrue()
+					|| registers[instruction.fC].IsTrue()
+				);
+				break;
+
+			case OPCODE_IN:
+			{
+				const StringList& left = registers[instruction.fB];
+				const StringList& right = registers[instruction.fC];
+				bool contained = true;
+				for (StringList::Iterator it = left.GetIterator();
+					 contained && it.HasNext();) {
+					contained = right.Contains(it.Next());
+				}
+				registers[instruction.fA] = boolean_list(contained);
+				break;
+			}
+
+			case OPCODE_NOT:
+				registers[instruction.fA] =
+					boolean_list(!registers[instruction.fB].IsTrue());
+				break;
+
+			case OPCODE_JUMP:
+				index = instruction.fA;
+				break;
+
+			case OPCODE_JUMP_IF_FALSE:
+				if (!registers[instruction.fA].IsTrue())
+					index = instruction.fB;
+				break;
+
+			case OPCODE_MATCH:
+			{
+				Case* caseNode = static_cast<Case*>(fCode.NodeAt(instruction.fB));
+				if (!caseNode->Matches(fContext, registers[instruction.fA]))
+					index = instruction.fC;
+				break;
+			}
+
+			case OPCODE_FOR_INIT:
+			{
+				// we ignore all but the first element of the variable list
+				const StringList& variables = registers[instruction.fB];
+				if (variables.IsEmpty()) {
+					index = instruction.fC;
+					break;
+				}
+
+				// look for a local variable, then for a global one, and create
+				// a global one, if there's none either
+				String variable = variables.Head();
+				StringList* value = fContext.LocalScope()->Lookup(variable);
+				Loop& loop = fLoops[instruction.fA];
+				loop.fGlobalName = String();
+				IncludeCache* includeCache = fContext.EvaluatedIncludes();
+				if (includeCache != nullptr && includeCache->IsRecording()) {
+					// a global variable is recorded once the list is known
+					if (value != nullptr)
+						includeCache->LocalVariableChanged(variable, value);
+					else
+						loop.fGlobalName = variable;
+				}
+
+				if (value == nullptr)
+					value = &fContext.GlobalVariables()->LookupOrCreate(variable);
+
+				loop.fVariable = value;
+				break;
+			}
+
+			case OPCODE_FOR_LIST:
+			{
+				Loop& loop = fLoops[instruction.fA];
+				loop.fList = registers[instruction.fB];
+				loop.fIndex = 0;
+
+				if (!loop.fGlobalName.IsEmpty() && !loop.fList.IsEmpty()) {
+					IncludeCache* includeCache = fContext.EvaluatedIncludes();
+					if (includeCache != nullptr
+						&& includeCache->IsRecording()) {
+						includeCache->GlobalVariableChanged(
+							fContext,
+							loop.fGlobalName,
+							ASSIGNMENT_OPERATOR_ASSIGN,
+							loop.fList
+						);
+					}
+				}
+				break;
+			}
+
+			case OPCODE_FOR_NEXT:
+			{
+				Loop& loop = fLoops[instruction.fA];
+				if (loop.fIndex >= loop.fList.Size()) {
+					loop.fList.Clear();
+					index = instruction.fB;
+					break;
+				}
+
+				loop.fVariable->Clear();
+				loop.fVariable->Append(loop.fList.ElementAt(loop.fIndex++));
+				break;
+			}
+
+			case OPCODE_CHECK_JUMP_CONDITION:
+				switch (fContext.GetJumpCondition()) {
+					case JUMP_CONDITION_NONE:
+						break;
+					case JUMP_CONDITION_BREAK:
+						if (instruction.fA == Bytecode::kNoTarget)
+							return kLeave;
+						fContext.SetJumpCondition(JUMP_CONDITION_NONE);
+						index = instruction.fA;
+						break;
+					case JUMP_CONDITION_CONTINUE:
+						if (instruction.fB == Bytecode::kNoTarget)
+							return kLeave;
+						fContext.SetJumpCondition(JUMP_CONDITION_NONE);
+						index = instruction.fB;
+						break;
+					case JUMP_CONDITION_RETURN:
+					case JUMP_CONDITION_JUMP_TO_EOF:
+					case JUMP_CONDITION_EXIT:
+						return kLeave;
+				}
+				break;
+
+			case OPCODE_EXIT:
+				fContext.SetJumpCondition((JumpCondition)instruction.fA);
+				return kLeave;
+
+			case OPCODE_PUSH_SCOPE:
+				index = _PushScope(index, instruction.fA);
+				break;
+
+			case OPCODE_POP_SCOPE:
+				// only reached by the nested _Run() of _PushScope()
+				break;
+		}
+	}
+
+	return index;
+}
+
+/**
+ * Executes the instructions from \a index up to the POP_SCOPE at \a end in a
+ * fresh local variable scope. Like in Block::Evaluate(), the scope inherits
+ * the old one and its domain lives in an arena frame of its own.
+ */
+size_t
+VirtualMachine::_PushScope(size_t index, size_t end)
+{
+	util::FrameArena::Frame frame(fContext.Arena());
+	data::VariableScope* oldLocalScope = fContext.LocalScope();
+	data::VariableDomain localVariables(&fContext.Arena());
+	data::VariableScope localScope(localVariables, oldLocalScope);
+	fContext.SetLocalScope(&localScope);
+
+	size_t next = _Run(index, end);
+
+	fContext.SetLocalScope(oldLocalScope);
+
+	return next == end ? end + 1 : next;
+}
+
+/**
+ * Returns the variable bound to \a slot, binding it to the variable named
+ * string \a name first, if necessary. The Compiler guarantees that a lookup
+ * at this point finds the local variable the slot stands for.
+ */
+inline StringList*
+VirtualMachine::_Slot(uint32_t slot, uint32_t name)
+{
+	StringList*& value = fSlots[slot];
+	if (value == nullptr)
+		value = fContext.LocalScope()->Lookup(fCode.StringAt(name));
+	return value;
+}
+
+void
+VirtualMachine::_Call(
+	Register result,
+	const StringList& functions,
+	Register firstArgument,
+	size_t argumentCount,
+	RuleLookupCache* cache
+)
+{
+	size_t callDepth = FunctionCall::BeginCall(fContext);
+
+	util::FrameArena& arena = fContext.Arena();
+	util::FrameArena::Frame frame(arena);
+
+	StringListList arguments(
+		fRegisters.begin() + firstArgument,
+		fRegisters.begin() + firstArgument + argumentCount,
+		&arena
+	);
+
+	fRegisters[result] =
+		FunctionCall::Call(fContext, functions, arguments, cache);
+
+	fContext.SetRuleCallDepth(callDepth);
+}
+
+} // namespace ham::code
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_CODE_VIRTUAL_MACHINE_HPP
+#define HAM_CODE_VIRTUAL_MACHINE_HPP
+
+#include "code/Bytecode.hpp"
+
+#include <memory_resource>
+#include <vector>
+
+namespace ham::code
+{
+
+class EvaluationContext;
+
+/**
+ * Executes Bytecode. The registers and loop states live in the innermost frame
+ * of the context's arena, which the caller provides. Local variable scopes are
+ * pushed recursively, so they are popped again however the code leaves the
+ * scope's instructions.
+ */
+class VirtualMachine
+{
+  public:
+	static StringList Execute(EvaluationContext& context, const Bytecode& code);
+
+  private:
+	struct Loop {
+		StringList* fVariable;
+		StringList fList;
+		size_t fIndex;
+		String fGlobalName;
+		// of the variable, if global and an include is being recorded
+	};
+
+  private:
+	VirtualMachine(EvaluationContext& context, const Bytecode& code);
+
+	size_t _Run(size_t start, size_t end);
+	// returns the index of the instruction to continue with, or SIZE_MAX, if
+	// the code shall be left
+	size_t _PushScope(size_t index, size_t end);
+	inline StringList* _Slot(uint32_t slot, uint32_t name);
+	void _Call(
+		Register result,
+		const StringList& functions,
+		Register firstArgument,
+		size_t argumentCount,
+		RuleLookupCache* cache
+	);
+
+  private:
+	EvaluationContext& fContext;
+	const Bytecode& fCode;
+	std::pmr::vector<StringList> fRegisters;
+	std::pmr::vector<Loop> fLoops;
+	std::pmr::vector<StringList*> fSlots;
+	const StringListList* fParameters;
+};
+
+} // namespace ham::code
+
+#endif // HAM_CODE_VIRTUAL_MACHINE_HPP
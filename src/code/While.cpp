@@ -5,6 +5,7 @@
 
 #include "code/While.hpp"
 
+#include "code/Compiler.hpp"
 #include "code/DumpContext.hpp"
 #include "code/EvaluationContext.hpp"
 
@@ -79,4 +80,26 @@ While::Dump(DumpContext& context) const
 	context << ")\n";
 }
 
+void
+While::Compile(Compiler& compiler, Register result)
+{
+	Compiler::Label conditionLabel = compiler.NewLabel();
+	Compiler::Label endLabel = compiler.NewLabel();
+
+	compiler.Emit(OPCODE_CLEAR, result);
+
+	compiler.BindLabel(conditionLabel);
+	Register condition = compiler.AllocateRegister();
+	compiler.CompileNode(fExpression, condition);
+	compiler.EmitJumpIfFalse(condition, endLabel);
+
+	compiler.BeginLoop(endLabel, conditionLabel);
+	compiler.CompileNode(fBlock, result);
+	compiler.EmitCheckJumpCondition();
+	compiler.EndLoop();
+	compiler.EmitJump(conditionLabel);
+
+	compiler.BindLabel(endLabel);
+}
+
 } // namespace ham::code
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "data/FileStatusCache.hpp"
+
+#include "data/Path.hpp"
+#include "util/Metrics.hpp"
+
+namespace ham::data
+{
+
+static util::Counter sCacheHitsMetric(
+	"ham_cache_hits",
+	"Lookups answered from a cache.",
+	"cache=\"file_status\""
+);
+static util::Counter sCacheMissesMetric(
+	"ham_cache_misses",
+	"Lookups a cache couldn't answer.",
+	"cache=\"file_status\""
+);
+
+FileStatusCache::FileStatusCache()
+	: fStatuses(),
+	  fBase(nullptr),
+	  fBaseDirectory()
+{
+}
+
+void
+FileStatusCache::SetBase(
+	const FileStatusCache* base,
+	const std::string& directory
+)
+{
+	fBase = base;
+	fBaseDirectory = directory;
+}
+
+void
+FileStatusCache::Add(const std::string& path, const FileStatus& status)
+{
+	fStatuses[path] = status;
+}
+
+/**
+ * Removes all statuses and the base cache.
+ */
+void
+FileStatusCache::Clear()
+{
+	fStatuses.clear();
+	fBase = nullptr;
+	fBaseDirectory.clear();
+}
+
+/**
+ * Like Path::GetFileStatus(), but returns the cached status of \a path, if
+ * there is one, and caches the status otherwise. Must only be called by one
+ * thread at a time.
+ */
+bool
+FileStatusCache::GetFileStatus(const char* path, FileStatus& _status) const
+{
+	if (GetCachedFileStatus(path, _status))
+		return _status.Exists();
+
+	sCacheMissesMetric.Increment();
+	bool exists = Path::GetFileStatus(path, _status);
+	fStatuses[path] = _status;
+	return exists;
+}
+
+/**
+ * Gets the cached status of \a path from this cache or its base. Returns false,
+ * if there is none. May be called by several threads at a time, as long as the
+ * caches aren't changed meanwhile.
+ */
+bool
+FileStatusCache::GetCachedFileStatus(const char* path, FileStatus& _status)
+	const
+{
+	StatusMap::const_iterator it = fStatuses.find(path);
+	if (it == fStatuses.end()) {
+		if (fBase == nullptr)
+			return false;
+
+		std::string basePath =
+			path[0] == '/' ? std::string(path) : fBaseDirectory + '/' + path;
+		it = fBase->fStatuses.find(basePath);
+		if (it == fBase->fStatuses.end())
+			return false;
+	}
+
+	sCacheHitsMetric.Increment();
+	_status = it->second;
+	return true;
+}
+
+} // namespace ham::data
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_DATA_FILE_STATUS_CACHE_HPP
+#define HAM_DATA_FILE_STATUS_CACHE_HPP
+
+#include "data/FileStatus.hpp"
+
+#include <string>
+#include <unordered_map>
+
+namespace ham::data
+{
+
+/**
+ * Maps paths to the file status they had when they were looked up earlier.
+ * Paths not in the cache are looked up in the file system and added.
+ *
+ * A cache may have a base cache, e.g. one kept from earlier builds, that is
+ * consulted when a path isn't in the cache itself. The base cache is keyed by
+ * absolute paths, relative paths are looked up in the given directory.
+ */
+class FileStatusCache
+{
+  public:
+	typedef std::unordered_map<std::string, FileStatus> StatusMap;
+
+  public:
+	FileStatusCache();
+
+	void SetBase(const FileStatusCache* base, const std::string& directory);
+
+	void Add(const std::string& path, const FileStatus& status);
+	void Remove(const std::string& path) { fStatuses.erase(path); }
+	void Clear();
+
+	bool GetFileStatus(const char* path, FileStatus& _status) const;
+	bool GetCachedFileStatus(const char* path, FileStatus& _status) const;
+
+	const StatusMap& Statuses() const { return fStatuses; }
+
+  private:
+	mutable StatusMap fStatuses;
+	// also gets the statuses looked up in the file system
+	const FileStatusCache* fBase;
+	std::string fBaseDirectory;
+};
+
+} // namespace ham::data
+
+#endif // HAM_DATA_FILE_STATUS_CACHE_HPP
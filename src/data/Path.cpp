@@ -6,12 +6,18 @@
 #include "data/Path.hpp"
 
 #include "data/FileStatus.hpp"
+#include "util/Metrics.hpp"
 
 #include <sys/stat.h>
 
 namespace ham::data
 {
 
+static util::Counter sFileStatsMetric(
+	"ham_file_stats",
+	"File statuses looked up on disk."
+);
+
 static const char*
 find_grist_end(const StringPart& path)
 {
@@ -73,6 +79,8 @@ Path::Exists(const char* path)
 /*static*/ bool
 Path::GetFileStatus(const char* path, FileStatus& _status)
 {
+	sFileStatsMetric.Increment();
+
 	// TODO: Platform specific!
 	struct stat st;
 	if (lstat(path, &st) != 0) {
@@ -25,8 +25,10 @@ class RuleActions : public util::Referenceable
 		QUIETLY = 0x08,
 		PIECEMEAL = 0x10,
 		EXISTING = 0x20,
-		FLAG_MASK = 0x3f,
-		MAX_LINE_FACTOR = 0x40
+		RESPONSE = 0x40,
+		RESTAT = 0x80,
+		FLAG_MASK = 0xff,
+		MAX_LINE_FACTOR = 0x100
 	};
 
   public:
@@ -49,6 +51,8 @@ class RuleActions : public util::Referenceable
 	bool IsQuietly() const { return fFlags & QUIETLY; }
 	bool IsPiecemeal() const { return fFlags & PIECEMEAL; }
 	bool IsExisting() const { return fFlags & EXISTING; }
+	bool IsResponse() const { return fFlags & RESPONSE; }
+	bool IsRestat() const { return fFlags & RESTAT; }
 
 	std::uint32_t MaxLine() const { return fFlags / MAX_LINE_FACTOR; }
 
@@ -6,6 +6,7 @@
 #define HAM_DATA_STRING_HPP
 
 #include "data/StringPart.hpp"
+#include "util/AllocationCount.hpp"
 #include "util/Referenceable.hpp"
 
 #include <list>
@@ -68,6 +69,7 @@ class String
 
   private:
 	friend class StringList;
+	friend class StringListProduct;
 
 	class Buffer
 	{
@@ -77,6 +79,7 @@ class String
 			void* memory = malloc(sizeof(Buffer) + length);
 			if (memory == nullptr)
 				throw std::bad_alloc();
+			util::CountAllocation();
 			return new (memory) Buffer(length);
 		}
 
@@ -5,6 +5,8 @@
 
 #include "StringList.hpp"
 
+#include "data/StringListProduct.hpp"
+
 #include <algorithm>
 #include <vector>
 
@@ -240,58 +242,11 @@ StringList::Multiply(const StringListList& listList)
 	if (listList.empty())
 		return StringList();
 
-	size_t listCount = listList.size();
-	if (listCount == 1)
+	if (listList.size() == 1)
 		return listList.front();
 
-	// Determine result size.
-	size_t resultSize = 1;
-	std::vector<const StringList*> lists(listCount);
-	size_t listIndex = 0;
-	for (StringListList::const_iterator it = listList.begin();
-		 it != listList.end();
-		 ++it) {
-		resultSize *= it->Size();
-		lists[listIndex++] = &*it;
-	}
-	if (resultSize == 0)
-		return StringList();
-
-	// Compute the result. We traverse the factor tree
-	StringList resultList(resultSize);
-	StringList factorList(listCount);
-	std::vector<size_t> indexes(listCount, 0);
-	listIndex = 0;
-	size_t resultIndex = 0;
-	for (;;) {
-		// back-track, if through with the current list
-		if (indexes[listIndex] == lists[listIndex]->Size()) {
-			if (listIndex == 0)
-				break;
-			listIndex--;
-			indexes[listIndex]++;
-			continue;
-		}
-
-		factorList.SetElementAt(
-			listIndex,
-			lists[listIndex]->ElementAt(indexes[listIndex])
-		);
-
-		// descend
-		if (listIndex < listCount - 1) {
-			listIndex++;
-			indexes[listIndex] = 0;
-			continue;
-		}
-
-		// add element
-		resultList.SetElementAt(resultIndex++, factorList.Join());
-
-		indexes[listIndex]++;
-	}
-
-	return resultList;
+	// Each result element is built directly into a buffer of the right size.
+	return StringListProduct(listList).ToStringList();
 }
 
 bool
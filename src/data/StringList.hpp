@@ -6,8 +6,10 @@
 #define HAM_DATA_STRING_LIST_HPP
 
 #include "data/String.hpp"
+#include "util/AllocationCount.hpp"
 #include "util/Referenceable.hpp"
 
+#include <memory_resource>
 #include <new>
 #include <stdlib.h>
 #include <vector>
@@ -18,7 +20,7 @@ namespace data
 {
 
 class StringList;
-typedef std::vector<StringList> StringListList;
+typedef std::pmr::vector<StringList> StringListList;
 
 // TODO: Should be replaced with ranges and std::string
 class StringList
@@ -89,6 +91,7 @@ class StringList
 			void* memory = malloc(sizeof(Data) + sizeof(String) * capacity);
 			if (memory == nullptr)
 				throw std::bad_alloc();
+			util::CountAllocation();
 			return new (memory) Data(capacity);
 		}
 
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "data/StringListProduct.hpp"
+
+#include <utility>
+
+namespace ham::data
+{
+
+StringListProduct::StringListProduct(StringListList factors)
+	: fFactors(std::move(factors)),
+	  fSize(fFactors.empty() ? 0 : 1),
+	  fTotalLength(0)
+{
+	for (const StringList& factor : fFactors)
+		fSize *= factor.Size();
+
+	if (fSize == 0)
+		return;
+
+	// Each element of a factor occurs in fSize / factor.Size() elements of the
+	// product.
+	for (const StringList& factor : fFactors) {
+		size_t factorLength = 0;
+		for (StringList::Iterator it = factor.GetIterator(); it.HasNext();)
+			factorLength += it.Next().Length();
+		fTotalLength += factorLength * (fSize / factor.Size());
+	}
+}
+
+String
+StringListProduct::ElementAt(size_t index) const
+{
+	if (index >= fSize)
+		return String();
+
+	// Decode the factor indexes. The last factor varies fastest.
+	size_t count = fFactors.size();
+	std::pmr::vector<String> parts(count, fFactors.get_allocator());
+	size_t length = 0;
+	for (size_t i = count; i-- > 0;) {
+		const StringList& factor = fFactors[i];
+		parts[i] = factor.ElementAt(index % factor.Size());
+		index /= factor.Size();
+		length += parts[i].Length();
+	}
+
+	String::Buffer* buffer = String::Buffer::Create(length);
+	char* destination = buffer->fString;
+	for (const String& part : parts) {
+		memcpy(destination, part.ToCString(), part.Length());
+		destination += part.Length();
+	}
+
+	return String(buffer);
+}
+
+String
+StringListProduct::Join(const StringPart& separator) const
+{
+	if (fSize == 0)
+		return String();
+	if (fFactors.size() == 1)
+		return fFactors.front().Join(separator);
+
+	size_t separatorLength = separator.Length();
+	String::Buffer* buffer =
+		String::Buffer::Create(fTotalLength + (fSize - 1) * separatorLength);
+	char* destination = buffer->fString;
+	bool first = true;
+
+	auto visitor = [&](const std::pmr::vector<StringPart>& parts, size_t) {
+		if (!first) {
+			memcpy(destination, separator.Start(), separatorLength);
+			destination += separatorLength;
+		}
+		first = false;
+
+		for (const StringPart& part : parts) {
+			memcpy(destination, part.Start(), part.Length());
+			destination += part.Length();
+		}
+	};
+	_ForEachElement(visitor);
+
+	return String(buffer);
+}
+
+StringList
+StringListProduct::ToStringList() const
+{
+	if (fSize == 0)
+		return StringList();
+	if (fFactors.size() == 1)
+		return fFactors.front();
+
+	StringList result(fSize);
+	size_t resultIndex = 0;
+
+	auto visitor = [&](const std::pmr::vector<StringPart>& parts,
+					   size_t length) {
+		String::Buffer* buffer = String::Buffer::Create(length);
+		char* destination = buffer->fString;
+		for (const StringPart& part : parts) {
+			memcpy(destination, part.Start(), part.Length());
+			destination += part.Length();
+		}
+		result.SetElementAt(resultIndex++, String(buffer));
+	};
+	_ForEachElement(visitor);
+
+	return result;
+}
+
+/**
+ * Calls \a visitor for each element of the product, in order. The visitor is
+ * passed the parts of the element (one per factor) and the element's total
+ * length, which is maintained incrementally.
+ *
+ * Must only be called, if the product is not empty. The parts refer to the
+ * string buffers owned by the factors.
+ */
+template<typename Visitor>
+void
+StringListProduct::_ForEachElement(Visitor& visitor) const
+{
+	size_t count = fFactors.size();
+	std::pmr::vector<size_t> indexes(count, 0, fFactors.get_allocator());
+	std::pmr::vector<StringPart> parts(count, fFactors.get_allocator());
+	size_t length = 0;
+	for (size_t i = 0; i < count; i++) {
+		parts[i] = fFactors[i].ElementAt(0);
+		length += parts[i].Length();
+	}
+
+	for (;;) {
+		visitor(parts, length);
+
+		// advance to the next element, carrying over to the previous factors
+		size_t i = count;
+		for (;;) {
+			if (i == 0)
+				return;
+			i--;
+
+			const StringList& factor = fFactors[i];
+			length -= parts[i].Length();
+			if (++indexes[i] == factor.Size())
+				indexes[i] = 0;
+			parts[i] = factor.ElementAt(indexes[i]);
+			length += parts[i].Length();
+
+			if (indexes[i] != 0)
+				break;
+		}
+	}
+}
+
+} // namespace ham::data
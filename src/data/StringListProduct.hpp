@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_DATA_STRING_LIST_PRODUCT_HPP
+#define HAM_DATA_STRING_LIST_PRODUCT_HPP
+
+#include "data/StringList.hpp"
+
+namespace ham::data
+{
+
+/**
+ * Lazy view of the product of a list of string lists, i.e. the list of all
+ * concatenations of one element from each factor. The order of the elements
+ * is the same as for StringList::Multiply(): the last factor varies fastest.
+ *
+ * Elements are only concatenated when requested. Join() computes the total
+ * result length up front and writes the whole product into a single buffer, so
+ * a product that is only consumed as a joined string (e.g. "-I$(HDRS)" in a
+ * command line) never materializes the individual elements.
+ *
+ * The factors and the scratch storage of the element iteration use the
+ * allocator of the given factors list.
+ */
+class StringListProduct
+{
+  public:
+	StringListProduct(StringListList factors);
+
+	size_t Size() const { return fSize; }
+	bool IsEmpty() const { return fSize == 0; }
+
+	String ElementAt(size_t index) const;
+
+	String Join(const StringPart& separator) const;
+	StringList ToStringList() const;
+
+  private:
+	template<typename Visitor>
+	void _ForEachElement(Visitor& visitor) const;
+
+  private:
+	StringListList fFactors;
+	size_t fSize;
+	size_t fTotalLength;
+	// sum of the lengths of all elements
+};
+
+} // namespace ham::data
+
+#endif // HAM_DATA_STRING_LIST_PRODUCT_HPP
@@ -6,6 +6,7 @@
 #include "data/TargetBinder.hpp"
 
 #include "data/FileStatus.hpp"
+#include "data/FileStatusCache.hpp"
 #include "data/Path.hpp"
 #include "data/Target.hpp"
 #include "data/VariableDomain.hpp"
@@ -23,13 +24,45 @@ static const String kSearchVariableName("SEARCH");
  * \param[in] target Target to bind.
  * \param[out] _boundPath Filesystem path of target.
  * \param[out] _fileStatus File status of bound path.
+ * \param[in] cache File statuses looked up ahead, or nullptr.
  */
 /*static*/ void
 TargetBinder::Bind(
 	const VariableDomain& globalVariables,
 	const Target* target,
 	String& _boundPath,
-	FileStatus& _fileStatus
+	FileStatus& _fileStatus,
+	const FileStatusCache* cache
+)
+{
+	// The target is bound to the first candidate path that refers to an
+	// existing entry, or, if none does, to the last one.
+	StringList paths;
+	GetCandidatePaths(globalVariables, target, paths);
+
+	size_t pathCount = paths.Size();
+	for (size_t i = 0; i < pathCount; i++) {
+		_boundPath = paths.ElementAt(i);
+		bool exists = cache != nullptr
+			? cache->GetFileStatus(_boundPath.ToCString(), _fileStatus)
+			: Path::GetFileStatus(_boundPath.ToCString(), _fileStatus);
+		if (exists)
+			return;
+	}
+}
+
+/**
+ * Get the paths a target may be bound to, in the order they are tried.
+ *
+ * \param[in] globalVariables Global variable domain.
+ * \param[in] target Target to bind.
+ * \param[out] _paths Candidate paths, at least one.
+ */
+/*static*/ void
+TargetBinder::GetCandidatePaths(
+	const VariableDomain& globalVariables,
+	const Target* target,
+	StringList& _paths
 )
 {
 	// If the target name is an absolute path, that's also the bound path (minus
@@ -37,8 +70,7 @@ TargetBinder::Bind(
 	// TODO: This isn't a valid path since it doesn't strip member archives.
 	StringPart targetPath(Path::RemoveGrist(target->Name()));
 	if (Path::IsAbsolute(targetPath)) {
-		_boundPath = targetPath;
-		Path::GetFileStatus(_boundPath.ToCString(), _fileStatus);
+		_paths.Append(String(targetPath));
 		return;
 	}
 
@@ -56,8 +88,7 @@ TargetBinder::Bind(
 
 	if (locatePaths != nullptr && !locatePaths->IsEmpty()) {
 		// prepend the LOCATE path
-		_boundPath = Path::Make(locatePaths->Head(), targetPath);
-		Path::GetFileStatus(_boundPath.ToCString(), _fileStatus);
+		_paths.Append(Path::Make(locatePaths->Head(), targetPath));
 		return;
 	}
 
@@ -74,19 +105,12 @@ TargetBinder::Bind(
 
 	if (searchPaths != nullptr && !searchPaths->IsEmpty()) {
 		size_t pathCount = searchPaths->Size();
-		for (size_t i = 0; i < pathCount; i++) {
-			// prepend the LOCATE path
-			String path = Path::Make(searchPaths->ElementAt(i), targetPath);
-			if (Path::GetFileStatus(path.ToCString(), _fileStatus)) {
-				_boundPath = path;
-				return;
-			}
-		}
+		for (size_t i = 0; i < pathCount; i++)
+			_paths.Append(Path::Make(searchPaths->ElementAt(i), targetPath));
 	}
 
 	// Not found -- use the target name.
-	_boundPath = targetPath;
-	Path::GetFileStatus(_boundPath.ToCString(), _fileStatus);
+	_paths.Append(String(targetPath));
 }
 
 } // namespace ham::data
@@ -5,12 +5,13 @@
 #ifndef HAM_DATA_TARGET_BINDER_HPP
 #define HAM_DATA_TARGET_BINDER_HPP
 
-#include "data/String.hpp"
+#include "data/StringList.hpp"
 
 namespace ham::data
 {
 
 class FileStatus;
+class FileStatusCache;
 class Target;
 class VariableDomain;
 
@@ -21,7 +22,14 @@ class TargetBinder
 		const VariableDomain& globalVariables,
 		const Target* target,
 		String& _boundPath,
-		FileStatus& _fileStatus
+		FileStatus& _fileStatus,
+		const FileStatusCache* cache = nullptr
+	);
+
+	static void GetCandidatePaths(
+		const VariableDomain& globalVariables,
+		const Target* target,
+		StringList& _paths
 	);
 };
 
@@ -7,13 +7,16 @@
 
 #include "util/SequentialSet.hpp"
 
+#include <memory_resource>
+#include <vector>
+
 namespace ham::data
 {
 
 class Target;
 
 typedef util::SequentialSet<Target*> TargetSet;
-typedef std::vector<Target*> TargetList;
+typedef std::pmr::vector<Target*> TargetList;
 
 } // namespace ham::data
 
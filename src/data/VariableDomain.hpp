@@ -8,6 +8,7 @@
 #include "StringList.hpp"
 
 #include <map>
+#include <memory_resource>
 
 namespace ham::data
 {
@@ -15,7 +16,12 @@ namespace ham::data
 class VariableDomain
 {
   public:
-	inline VariableDomain();
+	class Iterator;
+
+  public:
+	inline VariableDomain(
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+	);
 
 	inline const StringList* Lookup(const String& variable) const;
 	inline StringList* Lookup(const String& variable);
@@ -23,14 +29,40 @@ class VariableDomain
 	inline void Set(const String& variable, const StringList& value);
 	inline void Unset(const String& variable);
 
+	inline Iterator GetIterator() const;
+
   private:
-	typedef std::map<String, StringList> VariableMap;
+	typedef std::pmr::map<String, StringList> VariableMap;
 
   private:
 	VariableMap fVariables;
 };
 
-VariableDomain::VariableDomain() {}
+/**
+ * Iterates through the variables of a domain in the order of their names.
+ */
+class VariableDomain::Iterator
+{
+  public:
+	Iterator(const VariableDomain& domain)
+		: fIterator(domain.fVariables.begin()),
+		  fEnd(domain.fVariables.end())
+	{
+	}
+
+	bool HasNext() const { return fIterator != fEnd; }
+
+	const std::pair<const String, StringList>& Next() { return *fIterator++; }
+
+  private:
+	VariableMap::const_iterator fIterator;
+	VariableMap::const_iterator fEnd;
+};
+
+VariableDomain::VariableDomain(std::pmr::memory_resource* resource)
+	: fVariables(resource)
+{
+}
 
 const StringList*
 VariableDomain::Lookup(const String& variable) const
@@ -64,6 +96,12 @@ VariableDomain::Unset(const String& variable)
 	fVariables[variable] = nullptr;
 }
 
+VariableDomain::Iterator
+VariableDomain::GetIterator() const
+{
+	return Iterator(*this);
+}
+
 } // namespace ham::data
 
 #endif // HAM_DATA_VARIABLE_DOMAIN_HPP
@@ -16,6 +16,7 @@ class VariableScope
 	inline VariableScope(VariableDomain& domain, VariableScope* parent);
 
 	VariableScope* Parent() const { return fParent; }
+	const VariableDomain& Domain() const { return fDomain; }
 
 	StringList* Lookup(const String& variable) const;
 	inline void Set(const String& variable, const StringList& value);
@@ -4,20 +4,41 @@
  * Distributed under the terms of the MIT License.
  */
 
+#include "make/BuildCache.hpp"
+#include "make/Daemon.hpp"
 #include "make/MakeException.hpp"
 #include "make/Options.hpp"
 #include "make/Processor.hpp"
 #include "util/OptionIterator.hpp"
 #include "util/TextFileException.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
 #include <ostream>
 #include <string.h>
+#include <thread>
 #include <unistd.h>
 
 using namespace ham;
 
+static const size_t kMaxPrepareThreads = 8;
+
+// option values for options without a short option
+enum {
+	OPTION_TRACE = 256,
+	OPTION_RULE_STACKS,
+	OPTION_METRICS_FILE,
+	OPTION_METRICS_SOCKET,
+	OPTION_INCLUDE_CACHE,
+	OPTION_DEPENDENCY_LOG,
+	OPTION_DAEMON,
+	OPTION_CONNECT
+};
+
 static void
 print_usage(const char* programName, bool error)
 {
@@ -27,6 +48,10 @@ print_usage(const char* programName, bool error)
 		   "Options:\n"
 		   "  -a, --all\n"
 		   "      Build all targets, even the ones that are up-to-date.\n"
+		   "  -b, --built-in-commands\n"
+		   "      Execute commands that only call mkdir, rm -f, cp, touch,\n"
+		   "      ln, or chmod with a numeric mode in a thread instead of a\n"
+		   "      shell. Only used with the default JAMSHELL.\n"
 		   "  -c <version>, --compatibility <version>\n"
 		   "      Behave compatible to <version>, which is one of:\n"
 		   "      - \"ham\" (Ham, the default)\n"
@@ -38,6 +63,8 @@ print_usage(const char* programName, bool error)
 		   "      c     -  Print the causes\n"
 		   "      d     -  Print the dependencies\n"
 		   "      m     -  Print the make tree\n"
+		   "      p     -  Print a profile of the rules' evaluation\n"
+		   "      u     -  Print the job slots' utilization\n"
 		   "      x     -  Print the make commands\n"
 		   "      0..9  -  Set debug level.\n"
 		   "  -f <file>, --ruleset <file>\n"
@@ -46,15 +73,30 @@ print_usage(const char* programName, bool error)
 		   "      Build from the newest sources first.\n"
 		   "  -h, --help\n"
 		   "      Print this usage message.\n"
+		   "  -i, --interpret\n"
+		   "      Interpret the Jam code instead of compiling it to bytecode.\n"
 		   "  -j <jobs>, --jobs <jobs>\n"
 		   "      Use up to <jobs> number of concurrent shell processes.\n"
+		   "      The job slots are shared with make via its job server.\n"
 		   "  -k, --keep-going\n"
 		   "      Keep going when target fails. "
 		   "Default in -cjam and -cboost mode.\n"
+		   "  -l <load>, --max-load <load>\n"
+		   "      Don't start commands while the load average is at least\n"
+		   "      <load>, unless no command is running.\n"
+		   "  -m <megabytes>, --memory-budget <megabytes>\n"
+		   "      Don't start commands while the memory the running ones\n"
+		   "      are expected to use would exceed <megabytes>. Default is\n"
+		   "      the memory available at the start. A command is expected\n"
+		   "      to use JOBMEMORY (in megabytes) or else as much as the\n"
+		   "      earlier commands of its actions have used at most.\n"
 		   "  -n, --dry-run\n"
 		   "      Print actions and commands, but don't run them.\n"
 		   "  -o <file>, --output-actions <file>\n"
 		   "      Write the actions to <file>.\n"
+		   "  -p <threads>, --prepare-threads <threads>\n"
+		   "      Look up and scan the targets' files with up to <threads>\n"
+		   "      threads. Default is the number of CPUs, but at most 8.\n"
 		   "  -q, --quit-on-error\n"
 		   "      Quit immediately when a target fails. Default in -cham "
 		   "mode.\n"
@@ -65,6 +107,44 @@ print_usage(const char* programName, bool error)
 		   "      Rebuild target <target>, even if it is up-to-date.\n"
 		   "  -v, --version\n"
 		   "      Print the Ham version and exit.\n"
+		   "  -w, --shell-workers\n"
+		   "      Run the commands in long-lived shells, one per job slot,\n"
+		   "      instead of starting a shell for each. Only used with the\n"
+		   "      default JAMSHELL and for targets without FRESHSHELL.\n"
+		   "  --trace <file>\n"
+		   "      Write a trace of where the time goes -- parsing,\n"
+		   "      evaluation, preparing the targets, and the commands per\n"
+		   "      job slot -- to <file>, in the Chrome trace event format\n"
+		   "      (for Perfetto or chrome://tracing).\n"
+		   "  --rule-stacks <file>\n"
+		   "      Write the call stacks of the rules with the time spent in\n"
+		   "      them to <file>, in the collapsed format flame graph tools\n"
+		   "      like flamegraph.pl read.\n"
+		   "  --metrics-file <file>\n"
+		   "      Write metrics of the build -- targets updated and failed,\n"
+		   "      stats, headers scanned, cache hits, job slot usage, and\n"
+		   "      phase durations -- to <file> at exit, in the OpenMetrics\n"
+		   "      text format.\n"
+		   "  --metrics-socket <path>\n"
+		   "      Serve the metrics over HTTP on a Unix domain socket at\n"
+		   "      <path> while the build runs, for Prometheus compatible\n"
+		   "      scrapers.\n"
+		   "  --include-cache <file>\n"
+		   "      Record what evaluating each included Jamfile does in\n"
+		   "      <file> and, in the next run, repeat it instead of\n"
+		   "      evaluating the files, whose inputs haven't changed.\n"
+		   "  --dependency-log <file>\n"
+		   "      Record the headers listed in the depfiles (the DEPFILE\n"
+		   "      variable on a target) of successful commands in <file>\n"
+		   "      and use them instead of scanning unchanged sources.\n"
+		   "  --daemon <socket>\n"
+		   "      Serve builds on the Unix domain socket <socket>, keeping\n"
+		   "      the parsed Jamfiles, file statuses and header scans\n"
+		   "      between them and watching for changes with inotify.\n"
+		   "      Other options are ignored.\n"
+		   "  --connect <socket>\n"
+		   "      Have the daemon serving on <socket> do the build, or do\n"
+		   "      it without one, if there is none.\n"
 		<< std::endl;
 }
 
@@ -100,8 +180,12 @@ set_external_variable(
 	return true;
 }
 
-int
-main(int argc, const char* const* argv)
+/**
+ * Does the build \a argv describes, starting from \a cache, if run by the
+ * daemon. Returns the exit code.
+ */
+static int
+run_build(int argc, const char* const* argv, make::BuildCache* cache)
 {
 	const char* programName = argc >= 1 ? argv[0] : "ham";
 
@@ -129,8 +213,27 @@ main(int argc, const char* const* argv)
 	bool compatibilitySpecified = false;
 	bool buildFromNewest = false;
 	int jobCount = 1;
+	double maxLoad = 0;
+	size_t memoryBudget = 0;
+	size_t prepareThreadCount = std::min(
+		(size_t)std::thread::hardware_concurrency(),
+		kMaxPrepareThreads
+	);
 	bool dryRun = false;
 	bool quitOnError = false;
+	bool bytecode = true;
+	bool shellWorkers = false;
+	bool builtInCommands = false;
+	std::string traceFile;
+	std::string ruleStacksFile;
+	std::string metricsFile;
+	std::string metricsSocket;
+	std::string includeCacheFile;
+	std::string dependencyLogFile;
+	std::string daemonSocket;
+	std::string connectSocket;
+	bool printRuleProfile = false;
+	bool printJobSlotUtilization = false;
 	bool printMakeTree = false;
 	bool printActions = true;
 	bool printQuietActions = false;
@@ -143,19 +246,33 @@ main(int argc, const char* const* argv)
 		argv,
 		util::OptionSpecification()
 			.Add('a', "--all")
+			.Add('b', "--built-in-commands")
 			.Add('c', "--compatibility", true)
 			.Add('d', "--debug", true)
 			.Add('f', "--ruleset", true)
 			.Add('g', "--from-newest")
 			.Add('h', "--help")
+			.Add('i', "--interpret")
 			.Add('j', "--jobs", true)
 			.Add('k', "--keep-going")
+			.Add('l', "--max-load", true)
+			.Add('m', "--memory-budget", true)
 			.Add('n', "--dry-run")
 			.Add('o', "--output-actions", true)
+			.Add('p', "--prepare-threads", true)
 			.Add('q', "--quit-on-error")
 			.Add('s', "--set", true)
 			.Add('t', "--target", true)
 			.Add('v', "--version")
+			.Add('w', "--shell-workers")
+			.Add(OPTION_TRACE, "--trace", true)
+			.Add(OPTION_RULE_STACKS, "--rule-stacks", true)
+			.Add(OPTION_METRICS_FILE, "--metrics-file", true)
+			.Add(OPTION_METRICS_SOCKET, "--metrics-socket", true)
+			.Add(OPTION_INCLUDE_CACHE, "--include-cache", true)
+			.Add(OPTION_DEPENDENCY_LOG, "--dependency-log", true)
+			.Add(OPTION_DAEMON, "--daemon", true)
+			.Add(OPTION_CONNECT, "--connect", true)
 	);
 
 	while (optionIterator.HasNext()) {
@@ -167,6 +284,10 @@ main(int argc, const char* const* argv)
 					"Building all targets",
 					"https://github.com/dominicm00/ham/issues/35"
 				);
+			case 'b':
+				builtInCommands = true;
+				break;
+
 			case 'c': {
 				if (argument == "jam") {
 					compatibility = behavior::COMPATIBILITY_JAM;
@@ -222,6 +343,12 @@ main(int argc, const char* const* argv)
 						case 'm':
 							printMakeTree = true;
 							break;
+						case 'p':
+							printRuleProfile = true;
+							break;
+						case 'u':
+							printJobSlotUtilization = true;
+							break;
 						case 'x':
 							printCommands = true;
 							break;
@@ -286,11 +413,17 @@ main(int argc, const char* const* argv)
 			case 'h':
 				print_usage_end_exit(programName, false);
 
+			case 'i':
+				bytecode = false;
+				break;
+
 			case 'j': {
 				char* end;
-				jobCount = strtol(argument.c_str(), &end, 0);
-				if (*end != '\0')
+				errno = 0;
+				long count = strtol(argument.c_str(), &end, 0);
+				if (*end != '\0' || errno == ERANGE || count > INT_MAX)
 					print_usage_end_exit(programName, true);
+				jobCount = (int)count;
 				break;
 			}
 
@@ -298,6 +431,29 @@ main(int argc, const char* const* argv)
 				quitOnError = false;
 				break;
 
+			case 'l': {
+				char* end;
+				errno = 0;
+				maxLoad = strtod(argument.c_str(), &end);
+				if (*end != '\0' || errno == ERANGE)
+					print_usage_end_exit(programName, true);
+				break;
+			}
+
+			case 'm': {
+				// in MiB
+				const size_t kMiB = 1024 * 1024;
+				char* end;
+				errno = 0;
+				unsigned long megabytes = strtoul(argument.c_str(), &end, 0);
+				if (*end != '\0' || errno == ERANGE
+					|| megabytes > SIZE_MAX / kMiB) {
+					print_usage_end_exit(programName, true);
+				}
+				memoryBudget = megabytes * kMiB;
+				break;
+			}
+
 			case 'n':
 				dryRun = true;
 				break;
@@ -307,6 +463,15 @@ main(int argc, const char* const* argv)
 				actionsOutputFileSpecified = true;
 				break;
 
+			case 'p': {
+				char* end;
+				errno = 0;
+				prepareThreadCount = strtoul(argument.c_str(), &end, 0);
+				if (*end != '\0' || errno == ERANGE)
+					print_usage_end_exit(programName, true);
+				break;
+			}
+
 			case 'q':
 				quitOnError = true;
 				break;
@@ -328,6 +493,42 @@ main(int argc, const char* const* argv)
 						  << std::endl;
 				exit(0);
 
+			case 'w':
+				shellWorkers = true;
+				break;
+
+			case OPTION_TRACE:
+				traceFile = argument;
+				break;
+
+			case OPTION_RULE_STACKS:
+				ruleStacksFile = argument;
+				break;
+
+			case OPTION_METRICS_FILE:
+				metricsFile = argument;
+				break;
+
+			case OPTION_METRICS_SOCKET:
+				metricsSocket = argument;
+				break;
+
+			case OPTION_INCLUDE_CACHE:
+				includeCacheFile = argument;
+				break;
+
+			case OPTION_DEPENDENCY_LOG:
+				dependencyLogFile = argument;
+				break;
+
+			case OPTION_DAEMON:
+				daemonSocket = argument;
+				break;
+
+			case OPTION_CONNECT:
+				connectSocket = argument;
+				break;
+
 			default:
 				print_usage_end_exit(programName, true);
 		}
@@ -336,6 +537,30 @@ main(int argc, const char* const* argv)
 	if (optionIterator.ErrorOccurred())
 		print_usage_end_exit(programName, true);
 
+	if (!daemonSocket.empty()) {
+		if (cache != nullptr) {
+			std::cerr << "Error: a daemon can't start another one" << std::endl;
+			return 1;
+		}
+
+		make::Daemon daemon;
+		if (!daemon.Init(daemonSocket.c_str())) {
+			std::cerr << "Error: failed to serve builds on \"" << daemonSocket
+					  << "\": " << strerror(errno) << std::endl;
+			return 1;
+		}
+		return daemon.Run(&run_build);
+	}
+
+	// The daemon's build gets the same arguments, so it gets here, too.
+	if (!connectSocket.empty() && cache == nullptr) {
+		int exitCode;
+		if (make::Daemon::Connect(connectSocket.c_str(), argc, argv, exitCode))
+			return exitCode;
+		std::cerr << "Warning: failed to connect to the daemon at \""
+				  << connectSocket << "\", building without it" << std::endl;
+	}
+
 	// get targets to be made
 	StringList primaryTargets;
 	for (int i = optionIterator.Index(); i < argc; i++)
@@ -380,15 +605,31 @@ main(int argc, const char* const* argv)
 		options.SetRulesetFile(rulesetFile.c_str());
 	options.SetBuildFromNewest(buildFromNewest);
 	options.SetJobCount(jobCount);
+	options.SetMaxLoad(maxLoad);
+	options.SetMemoryBudget(memoryBudget);
+	options.SetPrepareThreadCount(prepareThreadCount);
 	options.SetDryRun(dryRun);
 	options.SetPrintMakeTree(printMakeTree);
 	options.SetPrintActions(printActions);
 	options.SetPrintQuietActions(printQuietActions);
 	options.SetPrintCommands(printCommands);
+	options.SetPrintRuleProfile(printRuleProfile);
+	options.SetPrintJobSlotUtilization(printJobSlotUtilization);
 	if (actionsOutputFileSpecified)
 		options.SetActionsOutputFile(actionsOutputFile.c_str());
 	options.SetQuitOnError(quitOnError);
+	options.SetBytecode(bytecode);
+	options.SetShellWorkers(shellWorkers);
+	options.SetBuiltInCommands(builtInCommands);
+	options.SetTraceFile(traceFile.c_str());
+	options.SetRuleStacksFile(ruleStacksFile.c_str());
+	options.SetMetricsFile(metricsFile.c_str());
+	options.SetMetricsSocket(metricsSocket.c_str());
+	options.SetIncludeCacheFile(includeCacheFile.c_str());
+	options.SetDependencyLogFile(dependencyLogFile.c_str());
 	processor.SetOptions(options);
+	if (cache != nullptr)
+		processor.SetBuildCache(cache);
 
 	processor.SetPrimaryTargets(primaryTargets);
 
@@ -419,3 +660,9 @@ main(int argc, const char* const* argv)
 
 	return 0;
 }
+
+int
+main(int argc, const char* const* argv)
+{
+	return run_build(argc, argv, nullptr);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "make/AdmissionControl.hpp"
+
+#include "data/RuleActions.hpp"
+#include "make/Command.hpp"
+#include "make/Options.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace ham::make
+{
+
+AdmissionControl::AdmissionControl(const Options& options)
+	: fMaxLoad(options.MaxLoad()),
+	  fMemoryBudget(options.MemoryBudget()),
+	  fReservedMemory(0),
+	  fPeakMemory()
+{
+	if (fMemoryBudget == 0 && !options.IsDryRun())
+		GetAvailableMemory(fMemoryBudget);
+}
+
+/**
+ * Returns the memory \a command is expected to use, 0 if unknown.
+ */
+size_t
+AdmissionControl::EstimateMemory(const Command* command) const
+{
+	if (command->MemoryEstimate() > 0)
+		return command->MemoryEstimate();
+
+	auto it = fPeakMemory.find(
+		command->Actions()->Actions()->RuleName().ToStlString()
+	);
+	return it != fPeakMemory.end() ? it->second : 0;
+}
+
+/**
+ * Returns whether a command expected to use \a memory can be launched while
+ * \a runningCount commands are running.
+ */
+bool
+AdmissionControl::CanLaunch(size_t memory, size_t runningCount) const
+{
+	if (runningCount == 0)
+		return true;
+
+	double load;
+	if (fMaxLoad > 0 && GetLoadAverage(load) && load >= fMaxLoad)
+		return false;
+
+	if (memory == 0)
+		return true;
+
+	if (fMemoryBudget > 0 && fReservedMemory + memory > fMemoryBudget)
+		return false;
+
+	// Other processes may have taken the memory meanwhile.
+	size_t availableMemory;
+	return !GetAvailableMemory(availableMemory) || memory <= availableMemory;
+}
+
+void
+AdmissionControl::CommandLaunched(size_t memory)
+{
+	fReservedMemory += memory;
+}
+
+/**
+ * Releases the \a memory reserved for \a command and learns how much commands
+ * of its actions use from the \a peakMemory it has used.
+ */
+void
+AdmissionControl::CommandFinished(
+	const Command* command,
+	size_t memory,
+	size_t peakMemory
+)
+{
+	fReservedMemory -= memory;
+
+	if (peakMemory > 0) {
+		std::string actionsName =
+			command->Actions()->Actions()->RuleName().ToStlString();
+		size_t& knownPeakMemory = fPeakMemory[actionsName];
+		if (peakMemory > knownPeakMemory)
+			knownPeakMemory = peakMemory;
+	}
+}
+
+/*static*/ bool
+AdmissionControl::GetLoadAverage(double& _load)
+{
+	// TODO: Platform specific!
+	return getloadavg(&_load, 1) == 1;
+}
+
+/*static*/ bool
+AdmissionControl::GetAvailableMemory(size_t& _memory)
+{
+	// TODO: Platform specific!
+	FILE* file = fopen("/proc/meminfo", "r");
+	if (file == nullptr)
+		return false;
+
+	bool found = false;
+	char line[256];
+	while (fgets(line, sizeof(line), file) != nullptr) {
+		unsigned long long kiloBytes;
+		if (sscanf(line, "MemAvailable: %llu kB", &kiloBytes) == 1) {
+			_memory = (size_t)kiloBytes * 1024;
+			found = true;
+			break;
+		}
+	}
+
+	fclose(file);
+	return found;
+}
+
+} // namespace ham::make
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_ADMISSION_CONTROL_HPP
+#define HAM_MAKE_ADMISSION_CONTROL_HPP
+
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+
+namespace ham::make
+{
+
+class Command;
+class Options;
+
+/**
+ * Decides whether a command may be launched now, besides there being a job
+ * slot for it.
+ *
+ * With a maximum load (-l), no command is launched while the system load
+ * average is at least that high. Commands that are expected to use a lot of
+ * memory are only launched when the memory expected to be used by all running
+ * commands stays within the budget (-m, or else the memory available when the
+ * build started) and the system still has the memory available. A command is
+ * expected to use the memory JOBMEMORY on its target declares or else as much
+ * as any earlier command of the same actions has used at its peak.
+ *
+ * When no command is running, one is always launched, so the build can't get
+ * stuck.
+ */
+class AdmissionControl
+{
+  public:
+	AdmissionControl(const Options& options);
+
+	size_t EstimateMemory(const Command* command) const;
+
+	bool CanLaunch(size_t memory, size_t runningCount) const;
+	void CommandLaunched(size_t memory);
+	void CommandFinished(
+		const Command* command,
+		size_t memory,
+		size_t peakMemory
+	);
+
+	size_t MemoryBudget() const { return fMemoryBudget; }
+	size_t ReservedMemory() const { return fReservedMemory; }
+
+	static bool GetLoadAverage(double& _load);
+	static bool GetAvailableMemory(size_t& _memory);
+
+  private:
+	double fMaxLoad;
+	size_t fMemoryBudget;
+	size_t fReservedMemory;
+	std::unordered_map<std::string, size_t> fPeakMemory;
+	// by actions name
+};
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_ADMISSION_CONTROL_HPP
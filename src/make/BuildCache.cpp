@@ -0,0 +1,490 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "make/BuildCache.hpp"
+
+#include "code/Block.hpp"
+#include "data/Path.hpp"
+#include "parser/Parser.hpp"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <vector>
+
+// TODO: Platform specific!
+
+namespace ham::make
+{
+
+static const uint32_t kWatchMask = IN_ONLYDIR | IN_CREATE | IN_DELETE
+	| IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO
+	| IN_DELETE_SELF | IN_MOVE_SELF;
+
+static bool
+write_all(int fd, const void* buffer, size_t size)
+{
+	const char* remainder = (const char*)buffer;
+	while (size > 0) {
+		ssize_t written = write(fd, remainder, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		remainder += written;
+		size -= written;
+	}
+	return true;
+}
+
+/**
+ * Reads exactly \a size bytes. Returns false on error or end of file.
+ */
+static bool
+read_all(int fd, void* buffer, size_t size)
+{
+	char* remainder = (char*)buffer;
+	while (size > 0) {
+		ssize_t bytesRead = read(fd, remainder, size);
+		if (bytesRead < 0 && errno == EINTR)
+			continue;
+		if (bytesRead <= 0)
+			return false;
+		remainder += bytesRead;
+		size -= bytesRead;
+	}
+	return true;
+}
+
+static void
+append_uint32(std::string& buffer, uint32_t value)
+{
+	buffer.append((const char*)&value, sizeof(value));
+}
+
+static void
+append_string(std::string& buffer, const std::string& string)
+{
+	append_uint32(buffer, string.size());
+	buffer += string;
+}
+
+static std::string
+absolute_path(const std::string& path, const std::string& directory)
+{
+	return !path.empty() && path[0] == '/' ? path : directory + '/' + path;
+}
+
+/**
+ * Returns whether \a path is spelled so that the paths the watches report
+ * changes of match it, i.e. it is absolute and has no empty components.
+ */
+static bool
+is_watchable_path(const std::string& path)
+{
+	return !path.empty() && path[0] == '/' && path.back() != '/'
+		&& path.find("//") == std::string::npos;
+}
+
+static bool
+is_same_status(const data::FileStatus& status1, const data::FileStatus& status2)
+{
+	return status1.GetType() == status2.GetType()
+		&& status1.LastModifiedTime() == status2.LastModifiedTime();
+}
+
+namespace
+{
+
+/**
+ * Reads the records of a report.
+ */
+class ReportReader
+{
+  public:
+	ReportReader(const std::string& report)
+		: fReport(report),
+		  fOffset(0)
+	{
+	}
+
+	bool HasNext() const { return fOffset < fReport.size(); }
+
+	bool ReadChar(char& _value)
+	{
+		if (fOffset >= fReport.size())
+			return false;
+		_value = fReport[fOffset++];
+		return true;
+	}
+
+	bool ReadUint32(uint32_t& _value)
+	{
+		if (fReport.size() - fOffset < sizeof(_value))
+			return false;
+		memcpy(&_value, fReport.data() + fOffset, sizeof(_value));
+		fOffset += sizeof(_value);
+		return true;
+	}
+
+	bool ReadString(std::string& _value)
+	{
+		uint32_t size;
+		if (!ReadUint32(size) || fReport.size() - fOffset < size)
+			return false;
+		_value = fReport.substr(fOffset, size);
+		fOffset += size;
+		return true;
+	}
+
+  private:
+	const std::string& fReport;
+	size_t fOffset;
+};
+
+} // namespace
+
+BuildCache::BuildCache()
+	: fFiles(),
+	  fParsedFiles(),
+	  fInotifyFd(-1),
+	  fDirectories(),
+	  fWatches(),
+	  fPaths(),
+	  fReportFd(-1)
+{
+}
+
+BuildCache::~BuildCache()
+{
+	if (fInotifyFd >= 0)
+		close(fInotifyFd);
+}
+
+/**
+ * Sets up the watches. Returns false, if inotify isn't available.
+ */
+bool
+BuildCache::Init()
+{
+	fInotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	return fInotifyFd >= 0;
+}
+
+/**
+ * Removes everything that has changed according to the watches' pending
+ * events.
+ */
+void
+BuildCache::ProcessEvents()
+{
+	alignas(struct inotify_event) char buffer[65536];
+	for (;;) {
+		ssize_t bytesRead = read(fInotifyFd, buffer, sizeof(buffer));
+		if (bytesRead < 0 && errno == EINTR)
+			continue;
+		if (bytesRead <= 0)
+			return;
+
+		for (ssize_t offset = 0; offset < bytesRead;) {
+			const struct inotify_event* event =
+				(const struct inotify_event*)(buffer + offset);
+			offset += sizeof(struct inotify_event) + event->len;
+
+			if ((event->mask & IN_Q_OVERFLOW) != 0) {
+				// events are lost, so nothing can be trusted anymore
+				fFiles.Clear();
+				fParsedFiles.Clear();
+				fPaths.clear();
+				continue;
+			}
+
+			DirectoryMap::iterator it = fDirectories.find(event->wd);
+			if (it == fDirectories.end())
+				continue;
+
+			// A change in a directory changes the directory's status, the
+			// changed entry, and, if it is a directory, everything below it.
+			bool directoryGone = (event->mask
+									 & (IN_DELETE_SELF | IN_MOVE_SELF
+										| IN_IGNORED))
+				!= 0;
+			for (const std::string& directory : it->second) {
+				_Invalidate(directory, directoryGone);
+				if (event->len > 0 && event->name[0] != '\0') {
+					std::string path = directory == "/" ? "" : directory;
+					_Invalidate(path + '/' + event->name, true);
+				}
+			}
+
+			// The watch of a moved directory would report the changes under
+			// the old paths, so it is dropped. The next build watches anew.
+			if (directoryGone) {
+				if ((event->mask & IN_IGNORED) == 0)
+					inotify_rm_watch(fInotifyFd, event->wd);
+				for (const std::string& directory : it->second)
+					fWatches.erase(directory);
+				fDirectories.erase(it);
+			}
+		}
+	}
+}
+
+/**
+ * Handles the next report the build on the other end of \a fd sends. Returns
+ * false, if the build has closed its end or the connection fails.
+ */
+bool
+BuildCache::ReceiveReport(int fd)
+{
+	uint32_t size;
+	if (!read_all(fd, &size, sizeof(size)))
+		return false;
+
+	std::string report(size, '\0');
+	if (!read_all(fd, report.data(), size) || !_ApplyReport(report))
+		return false;
+
+	char ack = 0;
+	return write_all(fd, &ack, 1);
+}
+
+/**
+ * Reports the file statuses and header scans \a prefetcher has, with relative
+ * paths being relative to \a directory, and the files that have been parsed
+ * to the daemon. Waits until the daemon has added them, so their changes by
+ * the build are noticed. Does nothing, if not built by a daemon.
+ */
+void
+BuildCache::TargetsPrepared(
+	const TargetPrefetcher& prefetcher,
+	const std::string& directory
+)
+{
+	if (fReportFd < 0)
+		return;
+
+	std::string report;
+	const data::FileStatusCache::StatusMap& statuses =
+		prefetcher.FileStatuses().Statuses();
+	for (data::FileStatusCache::StatusMap::const_iterator it =
+			 statuses.begin();
+		 it != statuses.end();
+		 ++it) {
+		const data::FileStatus& status = it->second;
+		const data::Time& time = status.LastModifiedTime();
+		report += 'S';
+		append_string(report, absolute_path(it->first, directory));
+		report += (char)status.GetType();
+		report += time.IsValid() ? 1 : 0;
+		append_uint32(report, time.IsValid() ? time.Seconds() : 0);
+		append_uint32(report, time.IsValid() ? time.NanoSeconds() : 0);
+	}
+
+	const TargetPrefetcher::ScanResultMap& scans = prefetcher.ScanResults();
+	for (TargetPrefetcher::ScanResultMap::const_iterator it = scans.begin();
+		 it != scans.end();
+		 ++it) {
+		report += 'H';
+		append_string(report, absolute_path(it->first.first, directory));
+		append_string(report, it->first.second);
+		report += it->second.fOpened ? 1 : 0;
+		append_uint32(report, it->second.fHeaders.size());
+		for (const std::string& header : it->second.fHeaders)
+			append_string(report, header);
+	}
+
+	for (const std::string& path : fParsedFiles.AddedPaths()) {
+		report += 'P';
+		append_string(report, path);
+	}
+	fParsedFiles.ClearAddedPaths();
+
+	uint32_t size = report.size();
+	char ack;
+	if (!write_all(fReportFd, &size, sizeof(size))
+		|| !write_all(fReportFd, report.data(), report.size())
+		|| !read_all(fReportFd, &ack, 1)) {
+		close(fReportFd);
+		fReportFd = -1;
+	}
+}
+
+/**
+ * Adds what a build has reported, as far as it can be watched and hasn't
+ * changed since the build has looked at it.
+ */
+bool
+BuildCache::_ApplyReport(const std::string& report)
+{
+	ProcessEvents();
+
+	ReportReader reader(report);
+	while (reader.HasNext()) {
+		char type;
+		std::string path;
+		if (!reader.ReadChar(type) || !reader.ReadString(path))
+			return false;
+
+		switch (type) {
+			case 'S': {
+				char fileType;
+				char timeValid;
+				uint32_t seconds;
+				uint32_t nanoSeconds;
+				if (!reader.ReadChar(fileType) || !reader.ReadChar(timeValid)
+					|| !reader.ReadUint32(seconds)
+					|| !reader.ReadUint32(nanoSeconds)) {
+					return false;
+				}
+
+				// Only statuses that are still the same once the path is
+				// watched can be trusted. Those already cached are watched.
+				const data::FileStatusCache::StatusMap& statuses =
+					fFiles.FileStatuses().Statuses();
+				if (statuses.find(path) != statuses.end()
+					|| !is_watchable_path(path) || !_Watch(path)) {
+					break;
+				}
+
+				data::FileStatus reported(
+					(data::FileStatus::Type)fileType,
+					timeValid ? data::Time(seconds, nanoSeconds) : data::Time()
+				);
+				data::FileStatus status;
+				data::Path::GetFileStatus(path.c_str(), status);
+				if (is_same_status(status, reported)) {
+					fFiles.AddFileStatus(path, status);
+					_Index(path);
+				}
+				break;
+			}
+
+			case 'H': {
+				std::string pattern;
+				char opened;
+				uint32_t headerCount;
+				if (!reader.ReadString(pattern) || !reader.ReadChar(opened)
+					|| !reader.ReadUint32(headerCount)) {
+					return false;
+				}
+
+				TargetPrefetcher::ScanResult result;
+				result.fOpened = opened != 0;
+				for (uint32_t i = 0; i < headerCount; i++) {
+					std::string header;
+					if (!reader.ReadString(header))
+						return false;
+					result.fHeaders.push_back(header);
+				}
+
+				// The statuses come first. A scan is only as good as the
+				// status of the file.
+				const data::FileStatusCache::StatusMap& statuses =
+					fFiles.FileStatuses().Statuses();
+				if (statuses.find(path) != statuses.end())
+					fFiles.AddScanResult(path, pattern, result);
+				break;
+			}
+
+			case 'P': {
+				// The build's code may have changed since it was parsed, so
+				// parse the file anew now that it is watched.
+				if (!is_watchable_path(path) || !_Watch(path))
+					break;
+
+				try {
+					parser::Parser parser;
+					parser.SetFileName(path);
+					util::Reference<code::Block> block(
+						parser.ParseFile(path.c_str()),
+						true
+					);
+					fParsedFiles.Add(path.c_str(), block.Get());
+					_Index(path);
+				} catch (...) {
+					// leave it to the next build to report the error
+				}
+				break;
+			}
+
+			default:
+				return false;
+		}
+	}
+
+	fParsedFiles.ClearAddedPaths();
+	return true;
+}
+
+/**
+ * Watches the directories on the way to \a path and, if it is a directory,
+ * \a path itself. Returns false, if a directory that exists can't be watched.
+ */
+bool
+BuildCache::_Watch(const std::string& path)
+{
+	std::vector<std::string> directories(1, "/");
+	for (size_t slash = path.find('/', 1); slash != std::string::npos;
+		 slash = path.find('/', slash + 1)) {
+		directories.push_back(path.substr(0, slash));
+	}
+	directories.push_back(path);
+
+	for (const std::string& directory : directories) {
+		if (fWatches.find(directory) != fWatches.end())
+			continue;
+
+		int watch =
+			inotify_add_watch(fInotifyFd, directory.c_str(), kWatchMask);
+		if (watch < 0) {
+			// Nothing exists below a missing directory. The watch of its
+			// parent notices when it is created.
+			return errno == ENOENT || errno == ENOTDIR;
+		}
+
+		fWatches[directory] = watch;
+		fDirectories[watch].insert(directory);
+	}
+
+	return true;
+}
+
+/**
+ * Removes \a path and, if requested, everything below it from the cache.
+ */
+void
+BuildCache::_Invalidate(const std::string& path, bool withDescendants)
+{
+	std::set<std::string>::iterator it = fPaths.find(path);
+	if (it != fPaths.end()) {
+		fFiles.Remove(path);
+		fParsedFiles.Remove(path);
+		fPaths.erase(it);
+	}
+
+	if (!withDescendants)
+		return;
+
+	std::string prefix = path == "/" ? path : path + '/';
+	it = fPaths.lower_bound(prefix);
+	while (it != fPaths.end() && it->compare(0, prefix.size(), prefix) == 0) {
+		fFiles.Remove(*it);
+		fParsedFiles.Remove(*it);
+		it = fPaths.erase(it);
+	}
+}
+
+void
+BuildCache::_Index(const std::string& path)
+{
+	fPaths.insert(path);
+}
+
+} // namespace ham::make
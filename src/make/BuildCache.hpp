@@ -0,0 +1,78 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_BUILD_CACHE_HPP
+#define HAM_MAKE_BUILD_CACHE_HPP
+
+#include "code/ParseCache.hpp"
+#include "make/TargetPrefetcher.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace ham::make
+{
+
+/**
+ * What the daemon keeps from one build to the next: the code of the parsed
+ * Jamfiles, the file statuses, and the header scan results, all keyed by
+ * absolute paths. inotify watches the directories of all paths, so whatever
+ * changes is removed before the next build.
+ *
+ * The builds run in forked processes, which use the cache as the daemon had
+ * it when forking. Once the targets are prepared, a build reports what it has
+ * looked up and parsed in addition via TargetsPrepared(). The daemon watches
+ * those paths, verifies that they haven't changed meanwhile and adds them in
+ * ReceiveReport(), before the build goes on to change any files.
+ */
+class BuildCache
+{
+  public:
+	BuildCache();
+	~BuildCache();
+
+	BuildCache(const BuildCache&) = delete;
+	BuildCache& operator=(const BuildCache&) = delete;
+
+	bool Init();
+
+	const TargetPrefetcher& Files() const { return fFiles; }
+	code::ParseCache& ParsedFiles() { return fParsedFiles; }
+
+	void ProcessEvents();
+	bool ReceiveReport(int fd);
+	// daemon side
+
+	void SetReportFd(int fd) { fReportFd = fd; }
+	void TargetsPrepared(
+		const TargetPrefetcher& prefetcher,
+		const std::string& directory
+	);
+	// build side
+
+  private:
+	typedef std::map<int, std::set<std::string>> DirectoryMap;
+
+  private:
+	bool _ApplyReport(const std::string& report);
+	bool _Watch(const std::string& path);
+	void _Invalidate(const std::string& path, bool withDescendants);
+	void _Index(const std::string& path);
+
+  private:
+	TargetPrefetcher fFiles;
+	code::ParseCache fParsedFiles;
+	int fInotifyFd;
+	DirectoryMap fDirectories;
+	// the spellings of the directories per watch
+	std::map<std::string, int> fWatches;
+	std::set<std::string> fPaths;
+	// of everything cached, for invalidating a directory's descendants
+	int fReportFd;
+};
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_BUILD_CACHE_HPP
@@ -7,6 +7,9 @@
 #include "make/Command.hpp"
 
 #include "data/RuleActions.hpp"
+#include "process/BuiltInCommand.hpp"
+
+#include <unistd.h>
 
 namespace ham::make
 {
@@ -20,11 +23,45 @@ Command::Command(
 	  fCommandLine(commandLine),
 	  fBoundTargetPaths(boundTargetPaths),
 	  fState(NOT_EXECUTED),
+	  fMemoryEstimate(0),
+	  fNeedsFreshShell(false),
+	  fBuiltInCommand(nullptr),
+	  fResponseFile(),
 	  fWaitingBuildInfos()
 {
 	fActions->AcquireReference();
 }
 
-Command::~Command() { fActions->ReleaseReference(); }
+Command::~Command()
+{
+	RemoveResponseFile();
+	delete fBuiltInCommand;
+	fActions->ReleaseReference();
+}
+
+/**
+ * Sets the \a command to execute instead of the command line, taking over its
+ * ownership.
+ */
+void
+Command::SetBuiltInCommand(process::BuiltInCommand* command)
+{
+	delete fBuiltInCommand;
+	fBuiltInCommand = command;
+}
+
+/**
+ * Removes the response file, once the command is done with it.
+ */
+void
+Command::RemoveResponseFile()
+{
+	if (fResponseFile.IsEmpty())
+		return;
+
+	// TODO: Platform specific!
+	unlink(fResponseFile.ToCString());
+	fResponseFile = String();
+}
 
 } // namespace ham::make
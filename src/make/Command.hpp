@@ -17,6 +17,11 @@ namespace data
 class RuleActionsCall;
 }
 
+namespace process
+{
+class BuiltInCommand;
+}
+
 namespace make
 {
 
@@ -48,6 +53,24 @@ class Command : public util::Referenceable
 	State GetState() const { return fState; }
 	void SetState(State state) { fState = state; }
 
+	size_t MemoryEstimate() const { return fMemoryEstimate; }
+	void SetMemoryEstimate(size_t estimate) { fMemoryEstimate = estimate; }
+	// bytes, 0 if not declared
+
+	bool NeedsFreshShell() const { return fNeedsFreshShell; }
+	void SetNeedsFreshShell(bool needs) { fNeedsFreshShell = needs; }
+
+	const process::BuiltInCommand* GetBuiltInCommand() const
+	{
+		return fBuiltInCommand;
+	}
+	void SetBuiltInCommand(process::BuiltInCommand* command);
+	// null if the command line needs a shell
+
+	const String& ResponseFile() const { return fResponseFile; }
+	void SetResponseFile(const String& path) { fResponseFile = path; }
+	void RemoveResponseFile();
+
 	const std::vector<TargetBuildInfo*>& WaitingBuildInfos() const
 	{
 		return fWaitingBuildInfos;
@@ -63,6 +86,11 @@ class Command : public util::Referenceable
 	String fCommandLine;
 	StringList fBoundTargetPaths;
 	State fState;
+	size_t fMemoryEstimate;
+	bool fNeedsFreshShell;
+	process::BuiltInCommand* fBuiltInCommand;
+	String fResponseFile;
+	// the path of the file the command line refers to, empty if none
 	std::vector<TargetBuildInfo*> fWaitingBuildInfos;
 };
 
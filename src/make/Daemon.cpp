@@ -0,0 +1,471 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "make/Daemon.hpp"
+
+#include "util/Metrics.hpp"
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// TODO: Platform specific!
+
+namespace ham::make
+{
+
+static const size_t kMaxRequestSize = 16 * 1024 * 1024;
+static const int kRequestTimeout = 1000;
+// milliseconds to wait for the rest of a client's request
+
+static volatile sig_atomic_t sQuit = 0;
+
+static void
+quit_handler(int /* signal */)
+{
+	sQuit = 1;
+}
+
+static bool
+write_all(int fd, const void* buffer, size_t size)
+{
+	const char* remainder = (const char*)buffer;
+	while (size > 0) {
+		ssize_t written = send(fd, remainder, size, MSG_NOSIGNAL);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		remainder += written;
+		size -= written;
+	}
+	return true;
+}
+
+/**
+ * Reads exactly \a size bytes. Returns false on error or end of file.
+ */
+static bool
+read_all(int fd, void* buffer, size_t size)
+{
+	char* remainder = (char*)buffer;
+	while (size > 0) {
+		ssize_t bytesRead = read(fd, remainder, size);
+		if (bytesRead < 0 && errno == EINTR)
+			continue;
+		if (bytesRead <= 0)
+			return false;
+		remainder += bytesRead;
+		size -= bytesRead;
+	}
+	return true;
+}
+
+static bool
+socket_address(const char* path, struct sockaddr_un& _address)
+{
+	if (strlen(path) >= sizeof(_address.sun_path)) {
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	memset(&_address, 0, sizeof(_address));
+	_address.sun_family = AF_UNIX;
+	strcpy(_address.sun_path, path);
+	return true;
+}
+
+Daemon::Daemon()
+	: fPath(),
+	  fSocket(-1),
+	  fCache()
+{
+}
+
+Daemon::~Daemon()
+{
+	if (fSocket >= 0) {
+		close(fSocket);
+		unlink(fPath.c_str());
+	}
+}
+
+/**
+ * Creates the socket at \a socketPath, replacing one an earlier daemon has
+ * left behind, and sets up the cache. Returns false on error.
+ */
+bool
+Daemon::Init(const char* socketPath)
+{
+	struct sockaddr_un address;
+	if (!socket_address(socketPath, address) || !fCache.Init())
+		return false;
+
+	struct stat st;
+	if (lstat(socketPath, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(socketPath);
+
+	fSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fSocket < 0)
+		return false;
+
+	if (bind(fSocket, (struct sockaddr*)&address, sizeof(address)) != 0
+		|| listen(fSocket, 8) != 0) {
+		int error = errno;
+		close(fSocket);
+		fSocket = -1;
+		errno = error;
+		return false;
+	}
+
+	fPath = socketPath;
+	return true;
+}
+
+/**
+ * Serves the clients' builds with \a build, one at a time, until the daemon
+ * is interrupted or terminated. Returns the daemon's exit code.
+ */
+int
+Daemon::Run(BuildFunction build)
+{
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = quit_handler;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("...serving builds on %s...\n", fPath.c_str());
+	fflush(stdout);
+
+	while (!sQuit) {
+		int client = accept4(fSocket, nullptr, nullptr, SOCK_CLOEXEC);
+		if (client < 0)
+			continue;
+
+		Request request;
+		if (_ReceiveRequest(client, request)) {
+			int32_t exitCode = _Build(client, request, build);
+			for (int fd : request.fFds)
+				close(fd);
+			write_all(client, &exitCode, sizeof(exitCode));
+		}
+
+		close(client);
+	}
+
+	return 0;
+}
+
+/**
+ * Has the daemon listening on \a socketPath do the build \a argv describes,
+ * in the current directory and environment, with the standard input, output
+ * and error of this process. Returns false, if there is no daemon to connect
+ * to, otherwise \a _exitCode is set to the exit code of the build.
+ */
+/*static*/ bool
+Daemon::Connect(
+	const char* socketPath,
+	int argc,
+	const char* const* argv,
+	int& _exitCode
+)
+{
+	struct sockaddr_un address;
+	if (!socket_address(socketPath, address))
+		return false;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return false;
+
+	if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		close(fd);
+		return false;
+	}
+
+	// The request is the argument and environment counts, followed by the
+	// working directory, the arguments and the environment, null-terminated.
+	char directory[PATH_MAX];
+	if (getcwd(directory, sizeof(directory)) == nullptr) {
+		close(fd);
+		return false;
+	}
+
+	uint32_t environmentCount = 0;
+	while (environ[environmentCount] != nullptr)
+		environmentCount++;
+
+	std::string payload;
+	payload.append((const char*)&argc, sizeof(uint32_t));
+	payload.append((const char*)&environmentCount, sizeof(uint32_t));
+	payload.append(directory, strlen(directory) + 1);
+	for (int i = 0; i < argc; i++)
+		payload.append(argv[i], strlen(argv[i]) + 1);
+	for (uint32_t i = 0; i < environmentCount; i++)
+		payload.append(environ[i], strlen(environ[i]) + 1);
+
+	// pass the standard file descriptors with the size
+	uint32_t size = payload.size();
+	struct iovec vector = {&size, sizeof(size)};
+	int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+	alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &vector;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+	header->cmsg_level = SOL_SOCKET;
+	header->cmsg_type = SCM_RIGHTS;
+	header->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+	ssize_t sent;
+	while ((sent = sendmsg(fd, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR)
+		;
+	if (sent < 0) {
+		close(fd);
+		return false;
+	}
+
+	int32_t exitCode;
+	if (!write_all(fd, (char*)&size + sent, sizeof(size) - sent)
+		|| !write_all(fd, payload.data(), payload.size())
+		|| !read_all(fd, &exitCode, sizeof(exitCode))) {
+		fprintf(stderr, "Error: lost the connection to the build daemon\n");
+		exitCode = 1;
+	}
+
+	close(fd);
+	_exitCode = exitCode;
+	return true;
+}
+
+/*static*/ bool
+Daemon::_ReceiveRequest(int fd, Request& _request)
+{
+	struct timeval timeout = {kRequestTimeout / 1000, 0};
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	uint32_t size;
+	struct iovec vector = {&size, sizeof(size)};
+	alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(_request.fFds))];
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &vector;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t received;
+	while ((received = recvmsg(fd, &message, MSG_CMSG_CLOEXEC)) < 0
+		&& errno == EINTR) {
+	}
+	if (received <= 0)
+		return false;
+
+	size_t fdCount = 0;
+	for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+		 header = CMSG_NXTHDR(&message, header)) {
+		if (header->cmsg_level != SOL_SOCKET
+			|| header->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+		fdCount = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		if (fdCount <= 3)
+			memcpy(_request.fFds, CMSG_DATA(header), fdCount * sizeof(int));
+	}
+	if (fdCount != 3) {
+		for (size_t i = 0; i < fdCount && i < 3; i++)
+			close(_request.fFds[i]);
+		return false;
+	}
+
+	// read the rest of the size and the payload
+	std::string payload;
+	bool ok = read_all(fd, (char*)&size + received, sizeof(size) - received)
+		&& size >= 2 * sizeof(uint32_t) && size <= kMaxRequestSize;
+	if (ok) {
+		payload.resize(size);
+		ok = read_all(fd, payload.data(), size) && payload.back() == '\0';
+	}
+
+	if (ok) {
+		uint32_t argumentCount;
+		uint32_t environmentCount;
+		memcpy(&argumentCount, payload.data(), sizeof(uint32_t));
+		memcpy(
+			&environmentCount,
+			payload.data() + sizeof(uint32_t),
+			sizeof(uint32_t)
+		);
+
+		std::vector<std::string> strings;
+		for (size_t offset = 2 * sizeof(uint32_t); offset < payload.size();) {
+			strings.push_back(payload.c_str() + offset);
+			offset += strings.back().size() + 1;
+		}
+
+		ok = strings.size() == 1 + argumentCount + environmentCount;
+		if (ok) {
+			_request.fDirectory = strings[0];
+			_request.fArguments.assign(
+				strings.begin() + 1,
+				strings.begin() + 1 + argumentCount
+			);
+			_request.fEnvironment.assign(
+				strings.begin() + 1 + argumentCount,
+				strings.end()
+			);
+		}
+	}
+
+	if (!ok) {
+		for (int requestFd : _request.fFds)
+			close(requestFd);
+	}
+	return ok;
+}
+
+/**
+ * Does the build in a forked process, adding what it reports to the cache.
+ * Returns its exit code.
+ */
+int
+Daemon::_Build(int client, const Request& request, BuildFunction build)
+{
+	int report[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, report) != 0) {
+		dprintf(request.fFds[2], "Error: failed to start the build\n");
+		return 1;
+	}
+
+	// the changes since the last build
+	fCache.ProcessEvents();
+
+	fflush(nullptr);
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(report[0]);
+		close(report[1]);
+		dprintf(request.fFds[2], "Error: failed to start the build\n");
+		return 1;
+	}
+
+	if (pid == 0) {
+		close(report[0]);
+		_RunBuild(request, report[1], build);
+	}
+
+	// The build and its commands get a process group of their own, so they
+	// can be terminated together.
+	setpgid(pid, pid);
+	close(report[1]);
+
+	bool reporting = true;
+	bool clientConnected = true;
+	while (reporting) {
+		struct pollfd fds[2] = {
+			{report[0], POLLIN, 0},
+			{client, (short)(clientConnected ? POLLIN : 0), 0}
+		};
+		if (poll(fds, 2, -1) < 0) {
+			if (errno != EINTR)
+				break;
+			if (sQuit)
+				kill(-pid, SIGTERM);
+			continue;
+		}
+
+		// The client doesn't send anything more, so it must be gone.
+		if (fds[1].revents != 0) {
+			kill(-pid, SIGTERM);
+			clientConnected = false;
+		}
+
+		if (fds[0].revents != 0 && !fCache.ReceiveReport(report[0]))
+			reporting = false;
+	}
+	close(report[0]);
+
+	int status;
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			return 1;
+	}
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+/**
+ * Sets up the forked process like the client's, and does the build.
+ */
+void
+Daemon::_RunBuild(const Request& request, int reportFd, BuildFunction build)
+{
+	setpgid(0, 0);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGPIPE, SIG_DFL);
+	close(fSocket);
+
+	for (int i = 0; i < 3; i++) {
+		if (request.fFds[i] != i)
+			dup2(request.fFds[i], i);
+	}
+	for (int fd : request.fFds) {
+		if (fd > STDERR_FILENO)
+			close(fd);
+	}
+
+	if (chdir(request.fDirectory.c_str()) != 0) {
+		fprintf(
+			stderr,
+			"Error: failed to change to directory \"%s\": %s\n",
+			request.fDirectory.c_str(),
+			strerror(errno)
+		);
+		_exit(1);
+	}
+
+	clearenv();
+	for (const std::string& variable : request.fEnvironment) {
+		size_t equalSign = variable.find('=');
+		if (equalSign != std::string::npos) {
+			setenv(
+				variable.substr(0, equalSign).c_str(),
+				variable.c_str() + equalSign + 1,
+				1
+			);
+		}
+	}
+
+	// the metrics are the build's own
+	util::Metric::ResetAll();
+
+	fCache.SetReportFd(reportFd);
+
+	std::vector<const char*> arguments;
+	for (const std::string& argument : request.fArguments)
+		arguments.push_back(argument.c_str());
+	arguments.push_back(nullptr);
+
+	exit(build(request.fArguments.size(), arguments.data(), &fCache));
+}
+
+} // namespace ham::make
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_DAEMON_HPP
+#define HAM_MAKE_DAEMON_HPP
+
+#include "make/BuildCache.hpp"
+
+#include <string>
+#include <vector>
+
+namespace ham::make
+{
+
+/**
+ * Serves builds on a Unix domain socket, keeping a BuildCache warm between
+ * them, so that a build doesn't parse the Jamfiles, look up the file statuses
+ * and scan the headers anew each time.
+ *
+ * A client -- Connect() -- passes its standard input, output and error, its
+ * working directory, arguments and environment. The daemon forks a process
+ * that does the build as if the client had done it itself, with the cache
+ * as its starting point, and passes its exit code back. The builds run one at
+ * a time. If the client goes away, e.g. because it was interrupted, the build
+ * is terminated.
+ */
+class Daemon
+{
+  public:
+	typedef int (*BuildFunction)(
+		int argc,
+		const char* const* argv,
+		BuildCache* cache
+	);
+
+  public:
+	Daemon();
+	~Daemon();
+
+	Daemon(const Daemon&) = delete;
+	Daemon& operator=(const Daemon&) = delete;
+
+	bool Init(const char* socketPath);
+	int Run(BuildFunction build);
+	// until SIGINT or SIGTERM
+
+	static bool Connect(
+		const char* socketPath,
+		int argc,
+		const char* const* argv,
+		int& _exitCode
+	);
+
+  private:
+	struct Request {
+		int fFds[3];
+		// standard input, output and error
+		std::string fDirectory;
+		std::vector<std::string> fArguments;
+		std::vector<std::string> fEnvironment;
+	};
+
+  private:
+	static bool _ReceiveRequest(int fd, Request& _request);
+	int _Build(int client, const Request& request, BuildFunction build);
+	[[noreturn]] void _RunBuild(
+		const Request& request,
+		int reportFd,
+		BuildFunction build
+	);
+
+  private:
+	std::string fPath;
+	int fSocket;
+	BuildCache fCache;
+};
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_DAEMON_HPP
@@ -0,0 +1,514 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "make/DependencyLog.hpp"
+
+#include "util/MappedFile.hpp"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <unordered_set>
+
+namespace ham::make
+{
+
+static const uint32_t kFileMagic = 0x444d4148;
+// "HAMD"
+static const uint32_t kFileVersion = 1;
+
+static const uint32_t kPathRecord = 0;
+static const uint32_t kEntryRecord = 1;
+
+static const size_t kMinCompactionRecordCount = 1000;
+static const size_t kCompactionRatio = 3;
+
+static void
+append_uint32(std::string& buffer, uint32_t value)
+{
+	buffer.append((const char*)&value, sizeof(value));
+}
+
+static bool
+read_uint32(const char*& data, const char* end, uint32_t& _value)
+{
+	if ((size_t)(end - data) < sizeof(_value))
+		return false;
+	memcpy(&_value, data, sizeof(_value));
+	data += sizeof(_value);
+	return true;
+}
+
+static bool
+read_string(const char*& data, const char* end, std::string& _value)
+{
+	uint32_t length;
+	if (!read_uint32(data, end, length) || (size_t)(end - data) < length)
+		return false;
+	_value.assign(data, length);
+	data += length;
+	return !_value.empty() && strlen(_value.c_str()) == _value.size();
+}
+
+/**
+ * Returns the ID of \a path in \a paths. A path that isn't there yet gets the
+ * next one, and its record is appended to \a buffer.
+ */
+static uint32_t
+add_path(
+	std::vector<std::string>& paths,
+	std::unordered_map<std::string, uint32_t>& pathIds,
+	const std::string& path,
+	std::string& buffer
+)
+{
+	std::unordered_map<std::string, uint32_t>::const_iterator it =
+		pathIds.find(path);
+	if (it != pathIds.end())
+		return it->second;
+
+	uint32_t id = paths.size();
+	pathIds[path] = id;
+	paths.push_back(path);
+
+	append_uint32(buffer, kPathRecord);
+	append_uint32(buffer, path.size());
+	buffer.append(path);
+	return id;
+}
+
+static void
+append_entry(
+	std::string& buffer,
+	uint32_t source,
+	const data::Time& sourceTime,
+	const std::vector<uint32_t>& headers
+)
+{
+	append_uint32(buffer, kEntryRecord);
+	append_uint32(buffer, source);
+	append_uint32(buffer, sourceTime.Seconds());
+	append_uint32(buffer, sourceTime.NanoSeconds());
+	append_uint32(buffer, headers.size());
+	for (uint32_t header : headers)
+		append_uint32(buffer, header);
+}
+
+static bool
+is_space(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static bool
+is_line_end(char c)
+{
+	return c == '\n' || c == '\r';
+}
+
+DependencyLog::DependencyLog()
+	: fFileName(),
+	  fFile(nullptr),
+	  fPaths(),
+	  fPathIds(),
+	  fEntries(),
+	  fEntryRecordCount(0)
+{
+}
+
+DependencyLog::~DependencyLog()
+{
+	Close();
+}
+
+/**
+ * Loads the entries from the log file \a fileName and opens it for recording.
+ * A missing or unreadable file is started anew.
+ */
+bool
+DependencyLog::Open(const char* fileName)
+{
+	Close();
+	fFileName = fileName;
+
+	bool valid = false;
+	size_t fileSize = 0;
+	size_t validSize = 0;
+	util::MappedFile file;
+	if (file.Open(fileName)) {
+		const char* data = file.Data();
+		const char* end = file.End();
+		fileSize = file.Size();
+
+		uint32_t magic;
+		uint32_t version;
+		valid = read_uint32(data, end, magic) && magic == kFileMagic
+			&& read_uint32(data, end, version) && version == kFileVersion;
+		validSize = data - file.Data();
+
+		// Read the records up to the first damaged one.
+		while (valid && data != end) {
+			uint32_t type;
+			if (!read_uint32(data, end, type))
+				break;
+
+			if (type == kPathRecord) {
+				std::string path;
+				if (!read_string(data, end, path) || fPathIds.count(path) != 0)
+					break;
+				fPathIds[path] = fPaths.size();
+				fPaths.push_back(path);
+			} else if (type == kEntryRecord) {
+				uint32_t source;
+				uint32_t seconds;
+				uint32_t nanoSeconds;
+				uint32_t count;
+				if (!read_uint32(data, end, source) || source >= fPaths.size()
+					|| !read_uint32(data, end, seconds)
+					|| !read_uint32(data, end, nanoSeconds)
+					|| nanoSeconds >= data::Time::kNanoFactor
+					|| !read_uint32(data, end, count)
+					|| (size_t)(end - data) / sizeof(uint32_t) < count) {
+					break;
+				}
+
+				Entry entry;
+				entry.fSourceTime = data::Time(seconds, nanoSeconds);
+				uint32_t header = 0;
+				for (uint32_t i = 0; i < count; i++) {
+					read_uint32(data, end, header);
+					if (header >= fPaths.size())
+						break;
+					entry.fHeaders.push_back(header);
+				}
+				if (entry.fHeaders.size() != count)
+					break;
+
+				fEntries[source] = std::move(entry);
+				fEntryRecordCount++;
+			} else {
+				break;
+			}
+
+			validSize = data - file.Data();
+		}
+
+		file.Close();
+	}
+
+	if (!valid
+		|| (fEntryRecordCount >= kMinCompactionRecordCount
+			&& fEntryRecordCount > kCompactionRatio * fEntries.size())) {
+		return _Rewrite();
+	}
+
+	// Drop a damaged last record, so the new ones follow the valid ones.
+	if (validSize < fileSize && truncate(fileName, validSize) != 0)
+		return false;
+
+	fFile = fopen(fileName, "ab");
+	return fFile != nullptr;
+}
+
+/**
+ * Closes the log file and forgets all entries.
+ */
+void
+DependencyLog::Close()
+{
+	if (fFile != nullptr) {
+		fclose(fFile);
+		fFile = nullptr;
+	}
+
+	fPaths.clear();
+	fPathIds.clear();
+	fEntries.clear();
+	fEntryRecordCount = 0;
+}
+
+/**
+ * Returns whether there is an entry for the source file at \a sourcePath,
+ * that is valid for its modification time \a sourceTime.
+ */
+bool
+DependencyLog::HasEntry(
+	const std::string& sourcePath,
+	const data::Time& sourceTime
+) const
+{
+	return _FindEntry(sourcePath, sourceTime) != nullptr;
+}
+
+/**
+ * Gets the headers recorded for the source file at \a sourcePath. Returns
+ * false, if there is no entry or it was recorded for a different
+ * modification time than \a sourceTime.
+ */
+bool
+DependencyLog::Lookup(
+	const std::string& sourcePath,
+	const data::Time& sourceTime,
+	std::vector<std::string>& _headers
+) const
+{
+	const Entry* entry = _FindEntry(sourcePath, sourceTime);
+	if (entry == nullptr)
+		return false;
+
+	_headers.clear();
+	for (uint32_t header : entry->fHeaders)
+		_headers.push_back(fPaths[header]);
+	return true;
+}
+
+/**
+ * Records \a headers for the source file at \a sourcePath, which has the
+ * modification time \a sourceTime. If the current entry is for the same time,
+ * the headers are added to it, since a source compiled several times, e.g.
+ * with different defines, may include different headers each time. Otherwise
+ * the entry is replaced. Returns false and leaves errno set, if the log file
+ * cannot be written. The log doesn't record anything anymore afterwards.
+ */
+bool
+DependencyLog::Record(
+	const std::string& sourcePath,
+	const data::Time& sourceTime,
+	const std::vector<std::string>& headers
+)
+{
+	if (fFile == nullptr) {
+		errno = EBADF;
+		return false;
+	}
+
+	std::string buffer;
+	uint32_t source =
+		add_path(fPaths, fPathIds, NormalizedPath(sourcePath), buffer);
+	Entry entry;
+	entry.fSourceTime = sourceTime;
+	EntryMap::const_iterator it = fEntries.find(source);
+	bool merge = it != fEntries.end() && it->second.fSourceTime == sourceTime;
+	if (merge)
+		entry.fHeaders = it->second.fHeaders;
+	std::unordered_set<uint32_t> known(
+		entry.fHeaders.begin(),
+		entry.fHeaders.end()
+	);
+	for (const std::string& header : headers) {
+		uint32_t id = add_path(fPaths, fPathIds, header, buffer);
+		if (known.insert(id).second)
+			entry.fHeaders.push_back(id);
+	}
+
+	if (merge && it->second.fHeaders == entry.fHeaders && buffer.empty())
+		return true;
+
+	append_entry(buffer, source, sourceTime, entry.fHeaders);
+	fEntries[source] = std::move(entry);
+	fEntryRecordCount++;
+
+	if (fwrite(buffer.data(), 1, buffer.size(), fFile) != buffer.size()
+		|| fflush(fFile) != 0) {
+		// The paths are known by ID now, but may not have been written.
+		int error = errno;
+		fclose(fFile);
+		fFile = nullptr;
+		errno = error;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Returns \a path without redundant "." and ".." components and separators.
+ */
+/*static*/ std::string
+DependencyLog::NormalizedPath(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().string();
+}
+
+/**
+ * Gets the prerequisites of all rules in the Makefile-style depfile contents
+ * \a data, in order and without duplicates. Returns false, if the contents
+ * aren't a depfile.
+ */
+/*static*/ bool
+DependencyLog::ParseDepfile(
+	const char* data,
+	size_t size,
+	std::vector<std::string>& _prerequisites
+)
+{
+	_prerequisites.clear();
+	std::unordered_set<std::string> known;
+
+	std::string word;
+	bool inPrerequisites = false;
+	bool hasTargets = false;
+	auto finishWord = [&]() {
+		if (word.empty())
+			return;
+		if (inPrerequisites) {
+			if (known.insert(word).second)
+				_prerequisites.push_back(word);
+		} else {
+			hasTargets = true;
+		}
+		word.clear();
+	};
+
+	const char* end = data + size;
+	for (const char* p = data; p != end; p++) {
+		char c = *p;
+		char next = p + 1 != end ? p[1] : '\0';
+
+		if (c == '\\') {
+			// line continuations and the escapes GCC writes
+			if (next == '\n'
+				|| (next == '\r' && p + 2 != end && p[2] == '\n')) {
+				finishWord();
+				p += next == '\n' ? 1 : 2;
+				continue;
+			}
+			if (next == ' ' || next == '#') {
+				word += next;
+				p++;
+				continue;
+			}
+		} else if (c == '$' && next == '$') {
+			word += c;
+			p++;
+			continue;
+		} else if (is_space(c)) {
+			finishWord();
+			continue;
+		} else if (is_line_end(c)) {
+			finishWord();
+			if (hasTargets && !inPrerequisites)
+				return false;
+			inPrerequisites = false;
+			hasTargets = false;
+			continue;
+		} else if (c == ':'
+			&& (next == '\0' || is_space(next) || is_line_end(next))) {
+			// A colon not followed by a space belongs to the word, like in a
+			// Windows drive letter.
+			finishWord();
+			if (inPrerequisites || !hasTargets)
+				return false;
+			inPrerequisites = true;
+			continue;
+		}
+
+		word += c;
+	}
+
+	finishWord();
+	return !hasTargets || inPrerequisites;
+}
+
+/**
+ * Like ParseDepfile(), but reads the depfile \a fileName. Returns false and
+ * leaves errno set, if the file cannot be read.
+ */
+/*static*/ bool
+DependencyLog::ReadDepfile(
+	const char* fileName,
+	std::vector<std::string>& _prerequisites
+)
+{
+	util::MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	if (!ParseDepfile(file.Data(), file.Size(), _prerequisites)) {
+		errno = EINVAL;
+		return false;
+	}
+
+	return true;
+}
+
+const DependencyLog::Entry*
+DependencyLog::_FindEntry(
+	const std::string& sourcePath,
+	const data::Time& sourceTime
+) const
+{
+	PathIdMap::const_iterator pathIt =
+		fPathIds.find(NormalizedPath(sourcePath));
+	if (pathIt == fPathIds.end())
+		return nullptr;
+
+	EntryMap::const_iterator it = fEntries.find(pathIt->second);
+	if (it == fEntries.end() || it->second.fSourceTime != sourceTime)
+		return nullptr;
+
+	return &it->second;
+}
+
+/**
+ * Replaces the log file with one that only contains the current entries and
+ * the paths they refer to, and opens it for recording.
+ */
+bool
+DependencyLog::_Rewrite()
+{
+	std::vector<std::string> paths;
+	PathIdMap pathIds;
+	EntryMap entries;
+	std::string buffer;
+	append_uint32(buffer, kFileMagic);
+	append_uint32(buffer, kFileVersion);
+
+	for (EntryMap::const_iterator it = fEntries.begin(); it != fEntries.end();
+		 ++it) {
+		uint32_t source =
+			add_path(paths, pathIds, fPaths[it->first], buffer);
+		Entry entry;
+		entry.fSourceTime = it->second.fSourceTime;
+		for (uint32_t header : it->second.fHeaders) {
+			entry.fHeaders.push_back(
+				add_path(paths, pathIds, fPaths[header], buffer)
+			);
+		}
+
+		append_entry(buffer, source, entry.fSourceTime, entry.fHeaders);
+		entries[source] = std::move(entry);
+	}
+
+	fPaths.swap(paths);
+	fPathIds.swap(pathIds);
+	fEntries.swap(entries);
+	fEntryRecordCount = fEntries.size();
+
+	// write a temporary file first, so a failure doesn't leave a damaged one
+	std::string temporaryFileName = fFileName + ".tmp";
+	FILE* file = fopen(temporaryFileName.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	bool written = fwrite(buffer.data(), 1, buffer.size(), file)
+		== buffer.size();
+	if (fclose(file) != 0)
+		written = false;
+
+	if (!written || rename(temporaryFileName.c_str(), fFileName.c_str()) != 0) {
+		int error = errno;
+		remove(temporaryFileName.c_str());
+		errno = error;
+		return false;
+	}
+
+	fFile = fopen(fFileName.c_str(), "ab");
+	return fFile != nullptr;
+}
+
+} // namespace ham::make
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_DEPENDENCY_LOG_HPP
+#define HAM_MAKE_DEPENDENCY_LOG_HPP
+
+#include "data/Time.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ham::make
+{
+
+/**
+ * Remembers the headers the compiler has reported for source files, so the
+ * next run can add them as includes of the sources instead of scanning the
+ * sources for headers.
+ *
+ * The headers come from the Makefile-style depfiles compilers write with
+ * -MD/-MF. An entry is only valid for the modification time the source had
+ * when it was recorded. It holds the headers of all compiles of the source
+ * since then, so a source compiled into several objects, e.g. with different
+ * defines, depends on the headers any of them included. Source paths are compared in their NormalizedPath()
+ * form, since compilers write e.g. "./foo.c" as "foo.c".
+ *
+ * The log file is a sequence of records that is only appended to, one record
+ * per new path and one per new or changed entry, so recording after each
+ * command is cheap. When most of the records have been superseded, Open()
+ * rewrites the file with just the current entries. A damaged or truncated
+ * last record, e.g. from an interrupted run, is dropped.
+ */
+class DependencyLog
+{
+  public:
+	DependencyLog();
+	~DependencyLog();
+
+	DependencyLog(const DependencyLog&) = delete;
+	DependencyLog& operator=(const DependencyLog&) = delete;
+
+	bool Open(const char* fileName);
+	// returns false and leaves errno set, if the file cannot be written
+	void Close();
+
+	size_t EntryCount() const { return fEntries.size(); }
+
+	bool HasEntry(const std::string& sourcePath, const data::Time& sourceTime)
+		const;
+	bool Lookup(
+		const std::string& sourcePath,
+		const data::Time& sourceTime,
+		std::vector<std::string>& _headers
+	) const;
+	// may be called by several threads at a time, as long as nothing is
+	// recorded meanwhile
+
+	bool Record(
+		const std::string& sourcePath,
+		const data::Time& sourceTime,
+		const std::vector<std::string>& headers
+	);
+
+	static std::string NormalizedPath(const std::string& path);
+
+	static bool ParseDepfile(
+		const char* data,
+		size_t size,
+		std::vector<std::string>& _prerequisites
+	);
+	static bool ReadDepfile(
+		const char* fileName,
+		std::vector<std::string>& _prerequisites
+	);
+
+  private:
+	struct Entry {
+		data::Time fSourceTime;
+		std::vector<uint32_t> fHeaders;
+		// path IDs
+	};
+
+	typedef std::unordered_map<std::string, uint32_t> PathIdMap;
+	typedef std::unordered_map<uint32_t, Entry> EntryMap;
+	// by the path ID of the source
+
+  private:
+	const Entry* _FindEntry(
+		const std::string& sourcePath,
+		const data::Time& sourceTime
+	) const;
+	bool _Rewrite();
+
+  private:
+	std::string fFileName;
+	FILE* fFile;
+	std::vector<std::string> fPaths;
+	PathIdMap fPathIds;
+	EntryMap fEntries;
+	size_t fEntryRecordCount;
+	// in the file, including superseded ones
+};
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_DEPENDENCY_LOG_HPP
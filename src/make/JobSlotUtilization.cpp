@@ -0,0 +1,196 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "make/JobSlotUtilization.hpp"
+
+#include "util/Metrics.hpp"
+
+#include <cstdio>
+
+namespace ham::make
+{
+
+static const char* const kIdleTimeMetricName = "ham_job_slot_idle_seconds";
+static const char* const kIdleTimeMetricHelp =
+	"Time job slots spent idle, summed over the slots, by reason.";
+static util::Counter sIdleTimeMetrics[JobSlotUtilization::kIdleReasonCount] = {
+	{kIdleTimeMetricName,
+	 kIdleTimeMetricHelp,
+	 "reason=\"no_ready_targets\"",
+	 1e-9},
+	{kIdleTimeMetricName, kIdleTimeMetricHelp, "reason=\"throttled\"", 1e-9},
+	{kIdleTimeMetricName,
+	 kIdleTimeMetricHelp,
+	 "reason=\"main_thread_busy\"",
+	 1e-9},
+};
+
+static int64_t
+nanoseconds(JobSlotUtilization::Clock::duration duration)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+		.count();
+}
+
+static double
+percent(int64_t time, int64_t total)
+{
+	return total > 0 ? 100.0 * time / total : 0;
+}
+
+JobSlotUtilization::JobSlotUtilization(
+	size_t slotCount,
+	Clock::time_point start
+)
+	: fSlots(slotCount, Slot{false, 0, 0, {}}),
+	  fStart(start),
+	  fLastTime(start),
+	  fIdleReason(IDLE_MAIN_THREAD_BUSY),
+	  fWaitStart(),
+	  fWaitTime(0),
+	  fCommandExpansionTime(0)
+{
+}
+
+void
+JobSlotUtilization::SlotBusy(size_t slot, Clock::time_point time)
+{
+	_Advance(time);
+	fSlots[slot].fBusy = true;
+	fSlots[slot].fCommands++;
+}
+
+void
+JobSlotUtilization::SlotIdle(size_t slot, Clock::time_point time)
+{
+	_Advance(time);
+	fSlots[slot].fBusy = false;
+}
+
+/**
+ * Notes that the main thread starts waiting for a command to finish, with the
+ * idle slots being idle for \a reason.
+ */
+void
+JobSlotUtilization::MainThreadWaiting(IdleReason reason, Clock::time_point time)
+{
+	_Advance(time);
+	fIdleReason = reason;
+	fWaitStart = time;
+}
+
+void
+JobSlotUtilization::MainThreadBusy(Clock::time_point time)
+{
+	_Advance(time);
+	if (fIdleReason != IDLE_MAIN_THREAD_BUSY) {
+		fWaitTime += nanoseconds(time - fWaitStart);
+		fIdleReason = IDLE_MAIN_THREAD_BUSY;
+	}
+}
+
+/**
+ * Adds to the time the main thread has spent expanding commands, which is
+ * part of its busy time.
+ */
+void
+JobSlotUtilization::AddCommandExpansionTime(Clock::duration duration)
+{
+	fCommandExpansionTime += nanoseconds(duration);
+}
+
+void
+JobSlotUtilization::Finish(Clock::time_point time)
+{
+	MainThreadBusy(time);
+}
+
+void
+JobSlotUtilization::PrintSummary(std::ostream& output) const
+{
+	int64_t elapsed = nanoseconds(fLastTime - fStart);
+	int64_t totalBusy = 0;
+	int64_t totalIdle[kIdleReasonCount] = {};
+	for (const Slot& slot : fSlots) {
+		totalBusy += slot.fBusyTime;
+		for (int i = 0; i < kIdleReasonCount; i++)
+			totalIdle[i] += slot.fIdleTime[i];
+	}
+	int64_t total = elapsed * (int64_t)fSlots.size();
+
+	char line[160];
+	output << "...job slot utilization...\n";
+	snprintf(
+		line,
+		sizeof(line),
+		"%zu job slot(s) over %.3f s, %.1f%% busy\n"
+		"idle: %.1f%% for lack of ready targets, %.1f%% throttled, %.1f%% "
+		"with the main thread busy\n",
+		fSlots.size(),
+		elapsed / 1e9,
+		percent(totalBusy, total),
+		percent(totalIdle[IDLE_NO_READY_TARGETS], total),
+		percent(totalIdle[IDLE_THROTTLED], total),
+		percent(totalIdle[IDLE_MAIN_THREAD_BUSY], total)
+	);
+	output << line;
+	snprintf(
+		line,
+		sizeof(line),
+		"main thread: %.3f s expanding commands, %.3f s otherwise busy, "
+		"%.3f s waiting for commands\n",
+		fCommandExpansionTime / 1e9,
+		(elapsed - fWaitTime - fCommandExpansionTime) / 1e9,
+		fWaitTime / 1e9
+	);
+	output << line
+		   << "  slot  commands     busy  no ready  throttled  main busy\n";
+
+	for (size_t i = 0; i < fSlots.size(); i++) {
+		const Slot& slot = fSlots[i];
+		snprintf(
+			line,
+			sizeof(line),
+			"%6zu %9zu %7.1f%% %8.1f%% %9.1f%% %9.1f%%\n",
+			i + 1,
+			slot.fCommands,
+			percent(slot.fBusyTime, elapsed),
+			percent(slot.fIdleTime[IDLE_NO_READY_TARGETS], elapsed),
+			percent(slot.fIdleTime[IDLE_THROTTLED], elapsed),
+			percent(slot.fIdleTime[IDLE_MAIN_THREAD_BUSY], elapsed)
+		);
+		output << line;
+	}
+
+	output.flush();
+}
+
+/**
+ * Accounts the time since the last event to the slots according to their
+ * current state.
+ */
+void
+JobSlotUtilization::_Advance(Clock::time_point time)
+{
+	int64_t duration = nanoseconds(time - fLastTime);
+	if (duration <= 0)
+		return;
+	fLastTime = time;
+
+	int64_t idleTime = 0;
+	for (Slot& slot : fSlots) {
+		if (slot.fBusy) {
+			slot.fBusyTime += duration;
+		} else {
+			slot.fIdleTime[fIdleReason] += duration;
+			idleTime += duration;
+		}
+	}
+
+	if (idleTime > 0)
+		sIdleTimeMetrics[fIdleReason].Increment(idleTime);
+}
+
+} // namespace ham::make
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_JOB_SLOT_UTILIZATION_HPP
+#define HAM_MAKE_JOB_SLOT_UTILIZATION_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <stddef.h>
+#include <vector>
+
+namespace ham::make
+{
+
+/**
+ * Accounts for how the job slots spend the build: running a command or idle,
+ * and why they are idle.
+ *
+ * A slot is idle because no target is ready to be built, i.e. due to the
+ * dependency structure, because ready targets may not be started (job server
+ * tokens, load or memory limits, or targets waiting for a command another
+ * target runs), or because the main thread is busy -- expanding commands,
+ * propagating finished targets -- instead of waiting for a command to finish
+ * and feeding the slots. The main thread tells which of those applies when it
+ * starts waiting; whenever it isn't waiting, it is busy.
+ *
+ * Idle time is also exported as the ham_job_slot_idle_seconds metric.
+ */
+class JobSlotUtilization
+{
+  public:
+	typedef std::chrono::steady_clock Clock;
+
+	enum IdleReason {
+		IDLE_NO_READY_TARGETS,
+		IDLE_THROTTLED,
+		IDLE_MAIN_THREAD_BUSY,
+
+		kIdleReasonCount
+	};
+
+  public:
+	JobSlotUtilization(size_t slotCount, Clock::time_point start);
+
+	void SlotBusy(size_t slot, Clock::time_point time);
+	void SlotIdle(size_t slot, Clock::time_point time);
+
+	void MainThreadWaiting(IdleReason reason, Clock::time_point time);
+	void MainThreadBusy(Clock::time_point time);
+	void AddCommandExpansionTime(Clock::duration duration);
+
+	void Finish(Clock::time_point time);
+
+	int64_t BusyTime(size_t slot) const { return fSlots[slot].fBusyTime; }
+	int64_t IdleTime(size_t slot, IdleReason reason) const
+	{
+		return fSlots[slot].fIdleTime[reason];
+	}
+	// in nanoseconds
+	size_t CommandCount(size_t slot) const { return fSlots[slot].fCommands; }
+
+	void PrintSummary(std::ostream& output) const;
+
+  private:
+	struct Slot {
+		bool fBusy;
+		size_t fCommands;
+		int64_t fBusyTime;
+		int64_t fIdleTime[kIdleReasonCount];
+		// in nanoseconds
+	};
+
+  private:
+	void _Advance(Clock::time_point time);
+
+  private:
+	std::vector<Slot> fSlots;
+	Clock::time_point fStart;
+	Clock::time_point fLastTime;
+	// up to which the slots' times have been accounted for
+	IdleReason fIdleReason;
+	// why idle slots are idle right now
+	Clock::time_point fWaitStart;
+	int64_t fWaitTime;
+	int64_t fCommandExpansionTime;
+	// of the main thread, in nanoseconds
+};
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_JOB_SLOT_UTILIZATION_HPP
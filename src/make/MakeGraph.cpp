@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "make/MakeGraph.hpp"
+
+#include "make/MakeException.hpp"
+
+namespace ham::make
+{
+
+MakeGraph::MakeGraph()
+	: fDependencyOffsets(1, 0),
+	  fDependencies(),
+	  fParentOffsets(1, 0),
+	  fParents()
+{
+}
+
+/**
+ * Builds the graph from \a targets, whose edges must be complete. The targets
+ * are assigned their index in the graph and their own edges are released.
+ * Targets created afterwards have no edges.
+ */
+void
+MakeGraph::Build(const MakeTargetMap& targets)
+{
+	size_t dependencyCount = 0;
+	size_t parentCount = 0;
+	for (const auto& [target, makeTarget] : targets) {
+		dependencyCount += makeTarget->Dependencies().size();
+		parentCount += makeTarget->Parents().size();
+	}
+
+	if (targets.size() >= MakeTarget::kNoGraphIndex
+		|| dependencyCount > UINT32_MAX || parentCount > UINT32_MAX) {
+		throw MakeException("Too many targets or dependencies");
+	}
+
+	fDependencyOffsets.clear();
+	fDependencyOffsets.reserve(targets.size() + 1);
+	fDependencies.clear();
+	fDependencies.reserve(dependencyCount);
+	fParentOffsets.clear();
+	fParentOffsets.reserve(targets.size() + 1);
+	fParents.clear();
+	fParents.reserve(parentCount);
+
+	uint32_t index = 0;
+	for (const auto& [target, makeTarget] : targets) {
+		fDependencyOffsets.push_back(fDependencies.size());
+		fDependencies.insert(
+			fDependencies.end(),
+			makeTarget->Dependencies().begin(),
+			makeTarget->Dependencies().end()
+		);
+
+		fParentOffsets.push_back(fParents.size());
+		fParents.insert(
+			fParents.end(),
+			makeTarget->Parents().begin(),
+			makeTarget->Parents().end()
+		);
+
+		makeTarget->SetGraphIndex(index++);
+		makeTarget->ReleaseEdges();
+	}
+
+	fDependencyOffsets.push_back(fDependencies.size());
+	fParentOffsets.push_back(fParents.size());
+}
+
+} // namespace ham::make
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_MAKE_GRAPH_HPP
+#define HAM_MAKE_MAKE_GRAPH_HPP
+
+#include "make/MakeTarget.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ham::make
+{
+
+using MakeTargetSpan = std::span<MakeTarget* const>;
+
+/**
+ * Compact, immutable form of the dependency graph of the make targets.
+ *
+ * While the targets are prepared, each MakeTarget collects its edges in
+ * vectors of its own. Once the graph is complete, Build() copies the edges of
+ * all targets into two contiguous arrays, one for the dependencies and one for
+ * the parents, in which the edges of a target are the slice between its offset
+ * and the next target's (compressed sparse row format). The targets' vectors
+ * are freed.
+ */
+class MakeGraph
+{
+  public:
+	MakeGraph();
+
+	void Build(const MakeTargetMap& targets);
+
+	inline MakeTargetSpan Dependencies(const MakeTarget* target) const;
+	inline MakeTargetSpan Parents(const MakeTarget* target) const;
+
+	size_t TargetCount() const { return fDependencyOffsets.size() - 1; }
+	size_t EdgeCount() const { return fDependencies.size(); }
+
+  private:
+	static inline MakeTargetSpan _Slice(
+		const std::vector<uint32_t>& offsets,
+		const std::vector<MakeTarget*>& edges,
+		uint32_t index
+	);
+
+  private:
+	std::vector<uint32_t> fDependencyOffsets;
+	std::vector<MakeTarget*> fDependencies;
+	std::vector<uint32_t> fParentOffsets;
+	std::vector<MakeTarget*> fParents;
+};
+
+/**
+ * Returns the dependencies of \a target, including those it gets from the
+ * includes of its dependencies.
+ */
+MakeTargetSpan
+MakeGraph::Dependencies(const MakeTarget* target) const
+{
+	return _Slice(fDependencyOffsets, fDependencies, target->GraphIndex());
+}
+
+MakeTargetSpan
+MakeGraph::Parents(const MakeTarget* target) const
+{
+	return _Slice(fParentOffsets, fParents, target->GraphIndex());
+}
+
+/*static*/ MakeTargetSpan
+MakeGraph::_Slice(
+	const std::vector<uint32_t>& offsets,
+	const std::vector<MakeTarget*>& edges,
+	uint32_t index
+)
+{
+	// targets created after Build() have no index
+	if (index >= offsets.size() - 1)
+		return MakeTargetSpan();
+
+	return MakeTargetSpan(
+		edges.data() + offsets[index],
+		offsets[index + 1] - offsets[index]
+	);
+}
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_MAKE_GRAPH_HPP
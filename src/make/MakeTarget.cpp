@@ -17,13 +17,18 @@ MakeTarget::MakeTarget(data::Target* target)
 	  fLeafTime(),
 	  fFileExists(false),
 	  fDependencies(),
+	  fDependencySet(),
 	  fIncludes(),
 	  fParents(),
+	  fGraphIndex(kNoGraphIndex),
 	  fProcessingState(UNPROCESSED),
 	  fState(UP_TO_DATE),
 	  fFate(KEEP),
 	  fMakeState(PENDING),
-	  fPendingDependencyCount(0)
+	  fQueued(false),
+	  fPendingDependencyCount(0),
+	  fPrunable(false),
+	  fDependencyChanged(false)
 {
 }
 
@@ -36,4 +41,13 @@ MakeTarget::SetFileStatus(const data::FileStatus& fileStatus)
 	fOriginalTime = fFileExists ? fileStatus.LastModifiedTime() : data::Time();
 }
 
+void
+MakeTarget::ReleaseEdges()
+{
+	MakeTargetList().swap(fDependencies);
+	fDependencySet.reset();
+	MakeTargetList().swap(fIncludes);
+	MakeTargetList().swap(fParents);
+}
+
 } // namespace ham::make
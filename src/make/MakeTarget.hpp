@@ -9,12 +9,21 @@
 #include "data/FileStatus.hpp"
 #include "data/Target.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
 namespace ham::make
 {
 
 class MakeTarget;
 
 typedef util::SequentialSet<MakeTarget*> MakeTargetSet;
+typedef std::vector<MakeTarget*> MakeTargetList;
+typedef std::map<data::Target*, MakeTarget*> MakeTargetMap;
 
 class MakeTarget
 {
@@ -58,6 +67,9 @@ class MakeTarget
 		SKIPPED
 	};
 
+  public:
+	static constexpr uint32_t kNoGraphIndex = UINT32_MAX;
+
   public:
 	MakeTarget(data::Target* target);
 	~MakeTarget();
@@ -82,20 +94,27 @@ class MakeTarget
 	bool FileExists() const { return fFileExists; }
 	void SetFileStatus(const data::FileStatus& fileStatus);
 
-	const MakeTargetSet& Dependencies() const { return fDependencies; }
-	void AddDependency(MakeTarget* dependency)
-	{
-		fDependencies.Append(dependency);
-	}
-	inline void AddDependencies(const MakeTargetSet& dependencies);
-	bool IsLeaf() const { return fDependencies.IsEmpty(); }
+	/**
+	 * The edges of the target while the graph is built. Afterwards they are
+	 * released and the MakeGraph has them.
+	 */
+	const MakeTargetList& Dependencies() const { return fDependencies; }
+	inline bool AddDependency(MakeTarget* dependency);
+	inline void AddDependencies(const MakeTargetList& dependencies);
+	bool IsLeaf() const { return fDependencies.empty(); }
+
+	const MakeTargetList& Includes() const { return fIncludes; }
+	void AddInclude(MakeTarget* include) { fIncludes.push_back(include); }
+	// each include must be added only once
 
-	const MakeTargetSet& Includes() const { return fIncludes; }
-	void AddInclude(MakeTarget* include) { fIncludes.Append(include); }
-	inline void AddIncludes(const MakeTargetSet& includes);
+	const MakeTargetList& Parents() const { return fParents; }
+	void AddParent(MakeTarget* parent) { fParents.push_back(parent); }
+	// each parent must be added only once
 
-	const MakeTargetSet& Parents() const { return fParents; }
-	void AddParent(MakeTarget* parent) { fParents.Append(parent); }
+	void ReleaseEdges();
+
+	uint32_t GraphIndex() const { return fGraphIndex; }
+	void SetGraphIndex(uint32_t index) { fGraphIndex = index; }
 
 	ProcessingState GetProcessingState() const { return fProcessingState; }
 	void SetProcessingState(ProcessingState state) { fProcessingState = state; }
@@ -109,12 +128,29 @@ class MakeTarget
 	MakeState GetMakeState() const { return fMakeState; }
 	void SetMakeState(MakeState state) { fMakeState = state; }
 
+	bool IsQueued() const { return fQueued; }
+	void SetQueued(bool queued) { fQueued = queued; }
+
 	size_t PendingDependenciesCount() const { return fPendingDependencyCount; }
 	void SetPendingDependenciesCount(size_t count)
 	{
 		fPendingDependencyCount = count;
 	}
 
+	/**
+	 * Whether the target is only made because a dependency is made. If none
+	 * of those dependencies actually changes (see the \c restat actions
+	 * modifier), the target is kept after all.
+	 */
+	bool IsPrunable() const { return fPrunable; }
+	void SetPrunable(bool prunable) { fPrunable = prunable; }
+
+	bool HasChangedDependency() const { return fDependencyChanged; }
+	void SetDependencyChanged() { fDependencyChanged = true; }
+
+  private:
+	static constexpr size_t kMaxSearchedDependencies = 16;
+
   private:
 	data::Target* fTarget;
 	String fBoundPath;
@@ -127,28 +163,54 @@ class MakeTarget
 	// == fTime, if leaf, otherwise the time of
 	// the newest leaf dependency
 	bool fFileExists;
-	MakeTargetSet fDependencies;
-	MakeTargetSet fIncludes;
-	MakeTargetSet fParents;
+	MakeTargetList fDependencies;
+	std::unique_ptr<std::unordered_set<MakeTarget*>> fDependencySet;
+	// only for targets with many dependencies
+	MakeTargetList fIncludes;
+	MakeTargetList fParents;
+	uint32_t fGraphIndex;
 	ProcessingState fProcessingState;
 	State fState;
 	Fate fFate;
 	MakeState fMakeState;
+	bool fQueued;
+	// whether in the Processor's ReadyQueue
 	size_t fPendingDependencyCount;
+	bool fPrunable;
+	bool fDependencyChanged;
+	// whether a dependency made in this build has changed
 };
 
-void
-MakeTarget::AddDependencies(const MakeTargetSet& dependencies)
+/**
+ * Adds \a dependency, unless the target already has it. Returns whether it
+ * was added. Short dependency lists are searched, longer ones get a set.
+ */
+bool
+MakeTarget::AddDependency(MakeTarget* dependency)
 {
-	for (MakeTargetSet::Iterator it = dependencies.GetIterator(); it.HasNext();)
-		AddDependency(it.Next());
+	if (fDependencySet != nullptr) {
+		if (!fDependencySet->insert(dependency).second)
+			return false;
+	} else if (std::find(fDependencies.begin(), fDependencies.end(), dependency)
+			   != fDependencies.end()) {
+		return false;
+	} else if (fDependencies.size() >= kMaxSearchedDependencies) {
+		fDependencySet.reset(new std::unordered_set<MakeTarget*>(
+			fDependencies.begin(),
+			fDependencies.end()
+		));
+		fDependencySet->insert(dependency);
+	}
+
+	fDependencies.push_back(dependency);
+	return true;
 }
 
 void
-MakeTarget::AddIncludes(const MakeTargetSet& includes)
+MakeTarget::AddDependencies(const MakeTargetList& dependencies)
 {
-	for (MakeTargetSet::Iterator it = includes.GetIterator(); it.HasNext();)
-		AddInclude(it.Next());
+	for (MakeTarget* dependency : dependencies)
+		AddDependency(dependency);
 }
 
 } // namespace ham::make
@@ -17,9 +17,23 @@ Options::Options()
 	  fPrintActions(false),
 	  fPrintQuietActions(false),
 	  fPrintCommands(false),
+	  fPrintRuleProfile(false),
+	  fPrintJobSlotUtilization(false),
 	  fJobCount(1),
+	  fPrepareThreadCount(1),
+	  fMaxLoad(0),
+	  fMemoryBudget(0),
 	  fBuildFromNewest(false),
-	  fQuitOnError(false)
+	  fQuitOnError(false),
+	  fBytecode(true),
+	  fShellWorkers(false),
+	  fBuiltInCommands(false),
+	  fTraceFile(),
+	  fRuleStacksFile(),
+	  fMetricsFile(),
+	  fMetricsSocket(),
+	  fIncludeCacheFile(),
+	  fDependencyLogFile()
 {
 }
 
@@ -40,9 +40,30 @@ class Options
 	bool IsPrintCommands() const { return fPrintCommands; }
 	void SetPrintCommands(bool print) { fPrintCommands = print; }
 
+	bool IsPrintRuleProfile() const { return fPrintRuleProfile; }
+	void SetPrintRuleProfile(bool print) { fPrintRuleProfile = print; }
+
+	bool IsPrintJobSlotUtilization() const
+	{
+		return fPrintJobSlotUtilization;
+	}
+	void SetPrintJobSlotUtilization(bool print)
+	{
+		fPrintJobSlotUtilization = print;
+	}
+
 	int JobCount() const { return fJobCount; }
 	void SetJobCount(int count) { fJobCount = count; }
 
+	size_t PrepareThreadCount() const { return fPrepareThreadCount; }
+	void SetPrepareThreadCount(size_t count) { fPrepareThreadCount = count; }
+
+	double MaxLoad() const { return fMaxLoad; }
+	void SetMaxLoad(double load) { fMaxLoad = load; }
+
+	size_t MemoryBudget() const { return fMemoryBudget; }
+	void SetMemoryBudget(size_t budget) { fMemoryBudget = budget; }
+
 	bool IsBuildFromNewest() const { return fBuildFromNewest; }
 	void SetBuildFromNewest(bool buildFromNewest)
 	{
@@ -52,6 +73,45 @@ class Options
 	bool IsQuitOnError() const { return fQuitOnError; }
 	void SetQuitOnError(bool quitOnError) { fQuitOnError = quitOnError; }
 
+	bool IsBytecode() const { return fBytecode; }
+	void SetBytecode(bool bytecode) { fBytecode = bytecode; }
+
+	bool IsShellWorkers() const { return fShellWorkers; }
+	void SetShellWorkers(bool shellWorkers) { fShellWorkers = shellWorkers; }
+
+	bool IsBuiltInCommands() const { return fBuiltInCommands; }
+	void SetBuiltInCommands(bool builtInCommands)
+	{
+		fBuiltInCommands = builtInCommands;
+	}
+
+	String TraceFile() const { return fTraceFile; }
+	void SetTraceFile(const String& fileName) { fTraceFile = fileName; }
+
+	String RuleStacksFile() const { return fRuleStacksFile; }
+	void SetRuleStacksFile(const String& fileName)
+	{
+		fRuleStacksFile = fileName;
+	}
+
+	String MetricsFile() const { return fMetricsFile; }
+	void SetMetricsFile(const String& fileName) { fMetricsFile = fileName; }
+
+	String MetricsSocket() const { return fMetricsSocket; }
+	void SetMetricsSocket(const String& path) { fMetricsSocket = path; }
+
+	String IncludeCacheFile() const { return fIncludeCacheFile; }
+	void SetIncludeCacheFile(const String& fileName)
+	{
+		fIncludeCacheFile = fileName;
+	}
+
+	String DependencyLogFile() const { return fDependencyLogFile; }
+	void SetDependencyLogFile(const String& fileName)
+	{
+		fDependencyLogFile = fileName;
+	}
+
   public:
 	String fRulesetFile;
 	String fActionsOutputFile;
@@ -60,9 +120,23 @@ class Options
 	bool fPrintActions;
 	bool fPrintQuietActions;
 	bool fPrintCommands;
+	bool fPrintRuleProfile;
+	bool fPrintJobSlotUtilization;
 	int fJobCount;
+	size_t fPrepareThreadCount;
+	double fMaxLoad;
+	size_t fMemoryBudget;
 	bool fBuildFromNewest;
 	bool fQuitOnError;
+	bool fBytecode;
+	bool fShellWorkers;
+	bool fBuiltInCommands;
+	String fTraceFile;
+	String fRuleStacksFile;
+	String fMetricsFile;
+	String fMetricsSocket;
+	String fIncludeCacheFile;
+	String fDependencyLogFile;
 };
 
 } // namespace ham::make
@@ -24,7 +24,8 @@ Piecemeal::Words(
 	const std::string& actionName,
 	const std::vector<std::pair<std::string_view, std::string_view>>& words,
 	const StringList& boundSources,
-	std::size_t maxLine
+	std::size_t maxLine,
+	std::vector<bool>& _sourceWords
 )
 {
 	/* Calculate the size of the command with a given source list to split
@@ -106,9 +107,13 @@ Piecemeal::Words(
 	};
 
 	// Calculate basic word info
-	std::vector<std::tuple<std::size_t, std::size_t>> wordInfo{};
 	std::size_t baseCommandSize = 0;
-	for (const auto& [word, space] : words) {
+	std::size_t wordCount = 0;
+	std::size_t sourceBaseLength = 0;
+	std::size_t sourceMultiplicity = 0;
+	_sourceWords.assign(words.size(), false);
+	for (std::size_t i = 0; i < words.size(); i++) {
+		const auto& [word, space] = words[i];
 		const std::size_t singleLength = getLength({"a"}, word);
 		const std::size_t longLength = getLength({"ab"}, word);
 		const std::size_t dualLength = getLength({"a", "b"}, word);
@@ -139,50 +144,73 @@ Piecemeal::Words(
 		if (power == 0) {
 			baseCommandSize += baseLength - 1;
 		} else {
-			wordInfo.push_back({baseLength, multiplicity});
+			// Every source grows the command by the sum of the word group
+			// lengths plus the sum of the multiplicities times its length.
+			wordCount++;
+			sourceBaseLength += baseLength;
+			sourceMultiplicity += multiplicity;
 		}
+
+		// A word with a power of 0 may still differ between the chunks, e.g.
+		// `$(>[1])`, so the syntax decides whether it can be reused.
+		_sourceWords[i] = ReferencesSources(word);
 	}
 
-	// Piecemeal sources
-	StringList sources{};
-	double averageLength = 0;
+	// Piecemeal sources in a single pass, cutting off a chunk when the next
+	// source wouldn't fit anymore. Each (non-constant) word has a trailing
+	// space that is included for the incremental length calculation, but is
+	// not included in the final command.
+	const std::size_t sourceCount = boundSources.Size();
+	std::size_t chunkStart = 0;
 	std::size_t commandSize = baseCommandSize;
-	for (std::size_t i = 0; i < boundSources.Size(); i++) {
-		auto source = boundSources.ElementAt(i);
-
-		// Calculate size of added source
-		for (const auto& [baseLength, multiplicity] : wordInfo) {
-			commandSize += baseLength + multiplicity * source.Length();
-		}
+	for (std::size_t i = 0; i < sourceCount; i++) {
+		const std::size_t sourceSize = sourceBaseLength
+			+ sourceMultiplicity * boundSources.ElementAt(i).Length();
+
+		if (commandSize + sourceSize - wordCount > maxLine) {
+			if (i > chunkStart) {
+				piecemealSources.push_back(boundSources.SubList(chunkStart, i));
+				chunkStart = i;
+				commandSize = baseCommandSize;
+			}
 
-		// Each (non-constant) word has a trailing space that is included for
-		// the incremental length calculation, but is not included in the final
-		// command.
-		if (commandSize - wordInfo.size() > maxLine) {
-			if (sources.IsEmpty()) {
+			if (commandSize + sourceSize - wordCount > maxLine) {
 				std::stringstream error;
 				error << "maxline of " << maxLine
 					  << " is too small; unable to add source "
-					  << source.ToStlString();
+					  << boundSources.ElementAt(i).ToStlString();
 				throw MakeException(error.str());
 			}
-
-			piecemealSources.push_back(sources);
-			sources = {};
-			averageLength = 0;
-			commandSize = baseCommandSize;
-			i--; // redo calculation with current source
-		} else {
-			averageLength = (sources.Size() * averageLength + source.Length())
-				/ (sources.Size() + 1);
-			sources.Append(source);
 		}
+
+		commandSize += sourceSize;
 	}
 
-	if (!sources.IsEmpty())
-		piecemealSources.push_back(sources);
+	if (chunkStart < sourceCount) {
+		piecemealSources.push_back(
+			boundSources.SubList(chunkStart, sourceCount)
+		);
+	}
 
 	return piecemealSources;
 }
 
+/*static*/ bool
+Piecemeal::ReferencesSources(std::string_view word)
+{
+	for (std::size_t i = word.find("$("); i != std::string_view::npos;
+		 i = word.find("$(", i + 2)) {
+		std::string_view name = word.substr(i + 2);
+		if (name.empty() || name[0] == '$')
+			return true;
+		if ((name[0] == '2' || name[0] == '>')
+			&& (name.size() == 1 || name[1] == ')' || name[1] == '['
+				|| name[1] == ':')) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 } // namespace ham::make
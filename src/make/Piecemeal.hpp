@@ -19,14 +19,24 @@ class Piecemeal
   public:
 	/**
 	 * Piecemeal a list of words based on a source list and max line length.
+	 * \a _sourceWords is set to whether each word may refer to the sources
+	 * (see ReferencesSources()); the others expand the same for every chunk.
 	 */
 	static data::StringListList Words(
 		code::EvaluationContext& externalContext,
 		const std::string& actionName,
 		const std::vector<std::pair<std::string_view, std::string_view>>& words,
 		const StringList& boundSources,
-		std::size_t maxLine
+		std::size_t maxLine,
+		std::vector<bool>& _sourceWords
 	);
+
+	/**
+	 * Returns whether \a word may expand differently for different sources,
+	 * i.e. whether it references `$(2)`/`$(>)` in any form, including
+	 * subscripts and modifiers, or a variable whose name is computed.
+	 */
+	static bool ReferencesSources(std::string_view word);
 };
 
 } // namespace ham::make
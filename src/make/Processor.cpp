@@ -13,30 +13,43 @@
 #include "code/Defs.hpp"
 #include "code/EvaluationContext.hpp"
 #include "code/FunctionCall.hpp"
+#include "code/IncludeCache.hpp"
 #include "code/Leaf.hpp"
 #include "code/OnExpression.hpp"
+#include "code/ParseCache.hpp"
+#include "data/Path.hpp"
 #include "data/RegExp.hpp"
 #include "data/RuleActions.hpp"
 #include "data/StringBuffer.hpp"
 #include "data/StringList.hpp"
+#include "data/StringListProduct.hpp"
 #include "data/TargetBinder.hpp"
 #include "data/TargetContainers.hpp"
 #include "data/VariableDomain.hpp"
+#include "make/BuildCache.hpp"
 #include "make/Command.hpp"
+#include "make/DependencyLog.hpp"
+#include "make/JobSlotUtilization.hpp"
 #include "make/MakeException.hpp"
 #include "make/MakeTarget.hpp"
 #include "make/Piecemeal.hpp"
 #include "make/TargetBuildInfo.hpp"
 #include "make/TargetBuilder.hpp"
 #include "parser/Parser.hpp"
+#include "process/BuiltInCommand.hpp"
+#include "process/Process.hpp"
 #include "ruleset/HamRuleset.hpp"
 #include "ruleset/JamRuleset.hpp"
+#include "util/Metrics.hpp"
 
 #include <algorithm>
 #include <cctype>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -47,7 +60,9 @@
 #include <sstream>
 #include <stdarg.h>
 #include <string_view>
+#include <thread>
 #include <tuple>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 
@@ -59,30 +74,188 @@ using std::unique_ptr;
 
 static const String kHeaderScanVariableName("HDRSCAN");
 static const String kHeaderRuleVariableName("HDRRULE");
+static const String kDepfileVariableName("DEPFILE");
+static const String kFreshShellVariableName("FRESHSHELL");
 static const String kJamShellVariableName("JAMSHELL");
+static const String kJobMemoryVariableName("JOBMEMORY");
 static const String kTargetVariableName("JAM_TARGETS");
 
-// TODO: This should be determined dynamically
-static const size_t kMaxCommandLength = 8'000;
+static const size_t kMaxIncludePrefetchThreads = 4;
+
+static util::Gauge sTargetsFoundMetric(
+	"ham_targets_found",
+	"Targets found when preparing the build."
+);
+static util::Gauge sTargetsToUpdateMetric(
+	"ham_targets_to_update",
+	"Targets found out of date."
+);
+static util::Counter sTargetsUpdatedMetric(
+	"ham_targets_updated",
+	"Targets updated successfully."
+);
+static util::Counter sTargetsFailedMetric(
+	"ham_targets_failed",
+	"Targets whose commands failed."
+);
+static util::Counter sTargetsSkippedMetric(
+	"ham_targets_skipped",
+	"Targets skipped since a dependency couldn't be updated."
+);
+static util::Counter sTargetsKeptMetric(
+	"ham_targets_kept",
+	"Targets kept since their updated dependencies didn't change."
+);
+static util::Counter sDependencyLogHitsMetric(
+	"ham_cache_hits",
+	"Lookups answered from a cache.",
+	"cache=\"dependency_log\""
+);
+static util::Counter sDependencyLogMissesMetric(
+	"ham_cache_misses",
+	"Lookups a cache couldn't answer.",
+	"cache=\"dependency_log\""
+);
+
+static const char* const kPhaseDurationMetricName =
+	"ham_phase_duration_seconds";
+static const char* const kPhaseDurationMetricHelp =
+	"Wall time of the build's phases.";
+static util::Gauge sProcessRulesetDurationMetric(
+	kPhaseDurationMetricName,
+	kPhaseDurationMetricHelp,
+	"phase=\"ProcessRuleset\"",
+	1e-9
+);
+static util::Gauge sPrepareTargetsDurationMetric(
+	kPhaseDurationMetricName,
+	kPhaseDurationMetricHelp,
+	"phase=\"PrepareTargets\"",
+	1e-9
+);
+static util::Gauge sBuildTargetsDurationMetric(
+	kPhaseDurationMetricName,
+	kPhaseDurationMetricHelp,
+	"phase=\"BuildTargets\"",
+	1e-9
+);
+
+/**
+ * Writes \a sources to a new temporary response file, one per line and
+ * quoted like GCC and the binutils expect it, and returns its path.
+ */
+static String
+create_response_file(const StringList& sources)
+{
+	// TODO: Platform specific!
+	const char* temporaryDirectory = getenv("TMPDIR");
+	if (temporaryDirectory == nullptr || *temporaryDirectory == '\0')
+		temporaryDirectory = "/tmp";
+
+	std::string path = std::string(temporaryDirectory) + "/hamXXXXXX";
+	int fd = mkstemp(path.data());
+	if (fd < 0) {
+		throw MakeException(
+			"Failed to create response file \"" + path
+			+ "\": " + strerror(errno)
+		);
+	}
+
+	std::string content;
+	for (StringList::Iterator it = sources.GetIterator(); it.HasNext();) {
+		String source = it.Next();
+		for (const char* c = source.ToCString(); *c != '\0'; c++) {
+			if (std::isspace((unsigned char)*c) || *c == '\'' || *c == '"'
+				|| *c == '\\') {
+				content += '\\';
+			}
+			content += *c;
+		}
+		content += '\n';
+	}
+
+	const char* remainder = content.data();
+	size_t remainderSize = content.size();
+	while (remainderSize > 0) {
+		ssize_t bytesWritten = write(fd, remainder, remainderSize);
+		if (bytesWritten < 0) {
+			if (errno == EINTR)
+				continue;
+
+			int error = errno;
+			close(fd);
+			unlink(path.c_str());
+			throw MakeException(
+				"Failed to write response file \"" + path
+				+ "\": " + strerror(error)
+			);
+		}
+
+		remainder += bytesWritten;
+		remainderSize -= bytesWritten;
+	}
+
+	close(fd);
+	return String(path.c_str());
+}
 
 Processor::Processor()
 	: fGlobalVariables(),
 	  fTargets(),
 	  fEvaluationContext(fGlobalVariables, fTargets),
+	  fIncludePrefetcher(new code::IncludePrefetcher(std::min(
+		  (size_t)std::thread::hardware_concurrency(),
+		  kMaxIncludePrefetchThreads
+	  ))),
 	  fOptions(),
 	  fPrimaryTargets(),
 	  fMakeTargets(),
+	  fMakeGraph(),
+	  fTargetPrefetcher(),
+	  fBuildCache(nullptr),
+	  fDirectory(),
 	  fMakeLevel(0),
 	  fMakableTargets(),
 	  fCommands(),
 	  fTargetBuildInfos(),
-	  fTargetsToUpdateCount(0)
+	  fTargetsToUpdateCount(0),
+	  fTargetsKeptCount(0),
+	  fMaxCommandLength(process::Process::MaxCommandLineLength()),
+	  fTrace(),
+	  fRuleProfiler(),
+	  fMetricsServer(),
+	  fIncludeCache(),
+	  fDependencyLog()
 {
 	code::BuiltInRules::RegisterRules(fEvaluationContext.Rules());
+	fEvaluationContext.SetPrefetcher(fIncludePrefetcher.get());
 }
 
 Processor::~Processor()
 {
+	// Let the prefetching threads finish before their events are written.
+	fIncludePrefetcher.reset();
+	fEvaluationContext.SetPrefetcher(nullptr);
+
+	if (fTrace != nullptr
+		&& !fTrace->WriteFile(fOptions.TraceFile().ToCString())) {
+		fprintf(
+			stderr,
+			"Error: failed to write trace file \"%s\"\n",
+			fOptions.TraceFile().ToCString()
+		);
+	}
+
+	fMetricsServer.reset();
+	if (!fOptions.MetricsFile().IsEmpty()
+		&& !util::Metric::WriteAllToFile(fOptions.MetricsFile().ToCString())) {
+		fprintf(
+			stderr,
+			"Error: failed to write metrics file \"%s\"\n",
+			fOptions.MetricsFile().ToCString()
+		);
+	}
+
 	for (TargetBuildInfoSet::iterator it = fTargetBuildInfos.begin();
 		 it != fTargetBuildInfos.end();
 		 ++it) {
@@ -106,6 +279,46 @@ void
 Processor::SetOptions(const Options& options)
 {
 	fOptions = options;
+	fEvaluationContext.SetBytecodeEnabled(fOptions.IsBytecode());
+
+	if (!fOptions.TraceFile().IsEmpty() && fTrace == nullptr) {
+		fTrace.reset(new util::Trace);
+		fTrace->NameThread("main");
+		util::Trace::SetActive(fTrace.get());
+	}
+
+	if ((fOptions.IsPrintRuleProfile() || !fOptions.RuleStacksFile().IsEmpty())
+		&& fRuleProfiler == nullptr) {
+		fRuleProfiler.reset(new code::RuleProfiler);
+		fEvaluationContext.SetProfiler(fRuleProfiler.get());
+	}
+
+	if (!fOptions.MetricsSocket().IsEmpty() && fMetricsServer == nullptr) {
+		fMetricsServer.reset(new util::MetricsServer);
+		if (!fMetricsServer->Start(fOptions.MetricsSocket().ToCString())) {
+			fprintf(
+				stderr,
+				"Warning: failed to serve metrics on \"%s\": %s\n",
+				fOptions.MetricsSocket().ToCString(),
+				strerror(errno)
+			);
+		}
+	}
+}
+
+/**
+ * Makes the processor start from what \a cache has kept: the parsed files,
+ * the file statuses and the header scans. Once the targets are prepared, what
+ * has been added is reported to the cache.
+ */
+void
+Processor::SetBuildCache(BuildCache* cache)
+{
+	fBuildCache = cache;
+	fDirectory = std::filesystem::current_path().string();
+	fTargetPrefetcher.SetBase(&cache->Files(), fDirectory);
+	cache->ParsedFiles().SetDirectory(fDirectory);
+	fEvaluationContext.SetParsedFiles(&cache->ParsedFiles());
 }
 
 void
@@ -147,6 +360,9 @@ Processor::SetForceUpdateTargets(const StringList& /* targets */)
 bool
 Processor::ProcessRuleset()
 {
+	util::Trace::Span span("ProcessRuleset");
+	util::Gauge::Timer timer(sProcessRulesetDurationMetric);
+
 	// parse code
 	parser::Parser parser;
 
@@ -172,20 +388,68 @@ Processor::ProcessRuleset()
 
 		block.SetTo(parser.Parse(ruleset), true);
 	} else {
-		parser.SetFileName(fOptions.RulesetFile().ToStlString());
-		block.SetTo(parser.ParseFile(fOptions.RulesetFile().ToCString()), true);
+		code::ParseCache* parsedFiles = fEvaluationContext.ParsedFiles();
+		if (parsedFiles != nullptr)
+			block.SetTo(parsedFiles->Lookup(fOptions.RulesetFile()));
+
+		if (block.Get() == nullptr) {
+			parser.SetFileName(fOptions.RulesetFile().ToStlString());
+			block.SetTo(
+				parser.ParseFile(fOptions.RulesetFile().ToCString()),
+				true
+			);
+			if (parsedFiles != nullptr)
+				parsedFiles->Add(fOptions.RulesetFile(), block.Get());
+		}
+	}
+
+	// The records of the included files are only valid for the same
+	// compatibility mode and working directory, as the paths are relative.
+	std::string includeCacheIdentity;
+	if (!fOptions.IncludeCacheFile().IsEmpty()) {
+		includeCacheIdentity =
+			std::to_string(fEvaluationContext.GetCompatibility()) + "\n"
+			+ std::filesystem::current_path().string();
+		fIncludeCache.reset(new code::IncludeCache);
+		fIncludeCache->Load(
+			fOptions.IncludeCacheFile().ToCString(),
+			includeCacheIdentity
+		);
+		fEvaluationContext.SetEvaluatedIncludes(fIncludeCache.get());
 	}
 
 	// execute the code
 	block->Evaluate(fEvaluationContext);
+	fEvaluationContext.SetEvaluatedIncludes(nullptr);
 
 	// TODO: Warn on top-level break/continue
-	return fEvaluationContext.GetJumpCondition() != code::JUMP_CONDITION_EXIT;
+	if (fEvaluationContext.GetJumpCondition() == code::JUMP_CONDITION_EXIT) {
+		_ReportRuleProfile();
+		return false;
+	}
+
+	if (fIncludeCache != nullptr
+		&& !fIncludeCache->Save(
+			fOptions.IncludeCacheFile().ToCString(),
+			includeCacheIdentity
+		)) {
+		fprintf(
+			stderr,
+			"Warning: failed to write include cache \"%s\": %s\n",
+			fOptions.IncludeCacheFile().ToCString(),
+			strerror(errno)
+		);
+	}
+
+	return true;
 }
 
 void
 Processor::PrepareTargets()
 {
+	util::Trace::Span span("PrepareTargets");
+	util::Gauge::Timer timer(sPrepareTargetsDurationMetric);
+
 	fNow = Time::Now();
 	// TODO: Not used yet!
 
@@ -208,16 +472,53 @@ Processor::PrepareTargets()
 		_GetMakeTarget(target, true);
 	}
 
+	if (!fOptions.DependencyLogFile().IsEmpty()) {
+		fDependencyLog.reset(new DependencyLog);
+		if (!fDependencyLog->Open(fOptions.DependencyLogFile().ToCString())) {
+			fprintf(
+				stderr,
+				"Warning: failed to open dependency log \"%s\": %s\n",
+				fOptions.DependencyLogFile().ToCString(),
+				strerror(errno)
+			);
+			fDependencyLog.reset();
+		}
+		fTargetPrefetcher.SetDependencyLog(fDependencyLog.get());
+	}
+
+	// Look up the file statuses and scan the files of the targets on worker
+	// threads, so the sequential pass below mostly finds the results ready.
+	if (fOptions.PrepareThreadCount() > 1) {
+		util::Trace::Span prefetchSpan("PrefetchTargets");
+		std::vector<Target*> roots;
+		for (size_t i = 0; i < primaryTargetCount; i++)
+			roots.push_back(fTargets.Lookup(primaryTargetNames.ElementAt(i)));
+		fTargetPrefetcher.Prefetch(
+			fOptions.PrepareThreadCount(),
+			*fEvaluationContext.GlobalVariables(),
+			roots
+		);
+	}
+
 	// Bind the targets and their dependencies recursively and decide their
 	// fate tentatively -- e.g. for temporary targets a second pass is needed.
 	fMakeLevel = 0;
 
-	for (size_t i = 0; i < primaryTargetCount; i++) {
-		String targetName = primaryTargetNames.ElementAt(i);
-		Target* target = fTargets.Lookup(targetName);
-		MakeTarget* makeTarget = _GetMakeTarget(target, false);
-		fPrimaryTargets.Append(makeTarget);
-		_PrepareTargetRecursively(makeTarget);
+	{
+		util::Trace::Span bindSpan("BindTargets");
+		for (size_t i = 0; i < primaryTargetCount; i++) {
+			String targetName = primaryTargetNames.ElementAt(i);
+			Target* target = fTargets.Lookup(targetName);
+			MakeTarget* makeTarget = _GetMakeTarget(target, false);
+			fPrimaryTargets.Append(makeTarget);
+			_PrepareTarget(makeTarget);
+		}
+	}
+
+	// The graph is complete now.
+	{
+		util::Trace::Span graphSpan("BuildMakeGraph");
+		fMakeGraph.Build(fMakeTargets);
 	}
 
 	// Decide the targets' fate for good.
@@ -230,17 +531,31 @@ Processor::PrepareTargets()
 
 	fMakeLevel = 0;
 
+	util::Trace::Span sealSpan("SealTargetFates");
 	for (MakeTargetSet::Iterator it = fPrimaryTargets.GetIterator();
 		 it.HasNext();) {
 		MakeTarget* makeTarget = it.Next();
-		_SealTargetFateRecursively(makeTarget, Time::MIN, true);
+		_SealTargetFate(makeTarget);
 	}
+
+	// Building changes the files, so the file statuses would get stale. Let
+	// the daemon keep them, while it can still tell.
+	if (fBuildCache != nullptr)
+		fBuildCache->TargetsPrepared(fTargetPrefetcher, fDirectory);
+	fTargetPrefetcher.Clear();
+
+	// Building doesn't evaluate any rules anymore.
+	_ReportRuleProfile();
 }
 
 void
 Processor::BuildTargets()
 {
+	util::Trace::Span span("BuildTargets");
+	util::Gauge::Timer timer(sBuildTargetsDurationMetric);
+
 	printf("...found %zu target(s)...\n", fMakeTargets.size());
+	sTargetsFoundMetric.Set(fMakeTargets.size());
 
 	// Reset the processing state.
 	for (MakeTargetMap::const_iterator it = fMakeTargets.begin();
@@ -254,6 +569,8 @@ Processor::BuildTargets()
 		_CollectMakableTargets(it.Next());
 	}
 
+	sTargetsToUpdateMetric.Set(fTargetsToUpdateCount);
+
 	if (fMakableTargets.IsEmpty())
 		return;
 
@@ -280,33 +597,61 @@ Processor::BuildTargets()
 
 	while (!fMakableTargets.IsEmpty() || builder.HasPendingBuildInfos()) {
 		while (TargetBuildInfo* buildInfo = builder.NextFinishedBuildInfo(
-				   !builder.HasSpareJobSlots() || fMakableTargets.IsEmpty()
+				   !builder.HasSpareJobSlots() || fMakableTargets.IsEmpty(),
+				   !fMakableTargets.IsEmpty()
 			   )) {
+			size_t skipped;
 			if (buildInfo->HasFailed()) {
 				targetsFailed++;
-				targetsSkipped +=
-					_TargetMade(buildInfo->GetTarget(), MakeTarget::FAILED);
+				sTargetsFailedMetric.Increment();
+				skipped = _TargetMade(
+					buildInfo->GetTarget(),
+					MakeTarget::FAILED,
+					true
+				);
 			} else {
 				targetsUpdated++;
-				targetsSkipped +=
-					_TargetMade(buildInfo->GetTarget(), MakeTarget::DONE);
+				sTargetsUpdatedMetric.Increment();
+				if (fDependencyLog != nullptr && !fOptions.IsDryRun())
+					_LogDependencies(buildInfo->GetTarget());
+				skipped = _TargetMade(
+					buildInfo->GetTarget(),
+					MakeTarget::DONE,
+					_HasTargetChanged(buildInfo->GetTarget())
+				);
 			}
+			targetsSkipped += skipped;
+			sTargetsSkippedMetric.Increment(skipped);
 		}
 
 		while (builder.HasSpareJobSlots() && !fMakableTargets.IsEmpty()) {
-			MakeTarget* makeTarget = fMakableTargets.Head();
-			fMakableTargets.RemoveAt(0);
-			if (TargetBuildInfo* buildInfo = _MakeTarget(makeTarget))
+			MakeTarget* makeTarget = fMakableTargets.PopFront();
+			JobSlotUtilization::Clock::time_point start =
+				JobSlotUtilization::Clock::now();
+			TargetBuildInfo* buildInfo = _MakeTarget(makeTarget);
+			builder.Utilization().AddCommandExpansionTime(
+				JobSlotUtilization::Clock::now() - start
+			);
+			if (buildInfo != nullptr)
 				builder.AddBuildInfo(buildInfo);
 		}
 	}
 
+	builder.Utilization().Finish(JobSlotUtilization::Clock::now());
+
 	if (targetsFailed > 0)
 		printf("...failed updating %zu target(s)...\n", targetsFailed);
 	if (targetsSkipped > 0)
 		printf("...skipped %zu target(s)...\n", targetsSkipped);
+	if (fTargetsKeptCount > 0)
+		printf("...kept %zu unchanged target(s)...\n", fTargetsKeptCount);
 	if (targetsUpdated > 0)
 		printf("...updated %zu target(s)...\n", targetsUpdated);
+
+	if (fOptions.IsPrintJobSlotUtilization()) {
+		fflush(stdout);
+		builder.Utilization().PrintSummary(fEvaluationContext.Output());
+	}
 }
 
 MakeTarget*
@@ -353,20 +698,54 @@ Processor::_IsMakeableTarget(const MakeTarget* makeTarget) const
 }
 
 void
-Processor::_PrepareTargetRecursively(MakeTarget* makeTarget)
+Processor::_PrepareTarget(MakeTarget* root)
+{
+	std::vector<PrepareFrame> stack;
+	if (!_StartPreparingTarget(root, stack))
+		return;
+
+	while (!stack.empty()) {
+		PrepareFrame& frame = stack.back();
+		MakeTarget* makeTarget = frame.fTarget;
+
+		// Continue with the next dependency. The list grows while we iterate,
+		// as the includes of the dependencies are appended.
+		if (frame.fIndex < makeTarget->Dependencies().size()) {
+			MakeTarget* dependency = makeTarget->Dependencies()[frame.fIndex];
+			dependency->AddParent(makeTarget);
+
+			fMakeLevel++;
+			if (!_StartPreparingTarget(dependency, stack)) {
+				fMakeLevel--;
+				_DependencyPrepared(stack.back());
+			}
+			continue;
+		}
+
+		_FinishPreparingTarget(frame);
+		stack.pop_back();
+
+		if (!stack.empty()) {
+			fMakeLevel--;
+			_DependencyPrepared(stack.back());
+		}
+	}
+}
+
+bool
+Processor::_StartPreparingTarget(
+	MakeTarget* makeTarget,
+	std::vector<PrepareFrame>& stack
+)
 {
 	// Check whether the target has already been processed (also detect cycles)
 	// and mark in-progress.
 	if (makeTarget->GetProcessingState() != MakeTarget::UNPROCESSED) {
-		if (makeTarget->GetProcessingState() == MakeTarget::PROCESSING) {
-			throw MakeException(
-				std::string("Target \"") + makeTarget->Name().ToCString()
-				+ "\" depends on itself"
-			);
-		}
+		if (makeTarget->GetProcessingState() == MakeTarget::PROCESSING)
+			_ThrowDependencyCycle(stack, makeTarget);
 
 		// already done
-		return;
+		return false;
 	}
 
 	makeTarget->SetProcessingState(MakeTarget::PROCESSING);
@@ -384,51 +763,75 @@ Processor::_PrepareTargetRecursively(MakeTarget* makeTarget)
 		time = Time::MIN;
 
 	// add make targets for dependencies
-	const Target* target = makeTarget->GetTarget();
-	const TargetSet& dependencies = target->Dependencies();
+	const TargetSet& dependencies = makeTarget->GetTarget()->Dependencies();
 	for (TargetSet::Iterator it = dependencies.GetIterator(); it.HasNext();)
 		makeTarget->AddDependency(_GetMakeTarget(it.Next(), true));
 
-	// recursively process the target's dependencies
-	Time newestDependencyTime = Time::MIN;
-	Time newestLeafTime = Time::MIN;
-	bool dependencyUpdated = false;
-	bool cantMake = false;
-	for (size_t i = 0; i < makeTarget->Dependencies().Size(); i++) {
-		MakeTarget* dependency = makeTarget->Dependencies().ElementAt(i);
-		dependency->AddParent(makeTarget);
-
-		fMakeLevel++;
-		_PrepareTargetRecursively(dependency);
-		fMakeLevel--;
-
-		// Add the dependency's includes as the target's dependencies. This
-		// will also take care of recursive includes in a breadth first manner
-		// as we keep appending the newly found includes at the end of our
-		// dependency list.
-		makeTarget->AddDependencies(dependency->Includes());
-
-		// track times
-		newestDependencyTime =
-			std::max(newestDependencyTime, dependency->GetTime());
-		newestLeafTime = std::max(newestLeafTime, dependency->LeafTime());
-
-		switch (dependency->GetFate()) {
-			case MakeTarget::KEEP:
-				break;
-			case MakeTarget::MAKE_IF_NEEDED:
-				break;
-			case MakeTarget::MAKE:
-				if (_IsMakeableTarget(dependency)
-					&& (!target->DependsOnLeaves() || dependency->IsLeaf())) {
-					dependencyUpdated = true;
-				}
-				break;
-			case MakeTarget::CANT_MAKE:
-				cantMake = true;
-				break;
-		}
+	PrepareFrame frame;
+	frame.fTarget = makeTarget;
+	frame.fIndex = 0;
+	frame.fIsPseudoTarget = isPseudoTarget;
+	frame.fTime = time;
+	frame.fNewestDependencyTime = Time::MIN;
+	frame.fNewestLeafTime = Time::MIN;
+	frame.fNewestUnchangedDependencyTime = Time::MIN;
+	frame.fDependencyUpdated = false;
+	frame.fCantMake = false;
+	stack.push_back(frame);
+	return true;
+}
+
+void
+Processor::_DependencyPrepared(PrepareFrame& frame)
+{
+	MakeTarget* makeTarget = frame.fTarget;
+	MakeTarget* dependency = makeTarget->Dependencies()[frame.fIndex++];
+
+	// Add the dependency's includes as the target's dependencies. This will
+	// also take care of recursive includes in a breadth first manner as we
+	// keep appending the newly found includes at the end of our dependency
+	// list.
+	makeTarget->AddDependencies(dependency->Includes());
+
+	// track times
+	frame.fNewestDependencyTime =
+		std::max(frame.fNewestDependencyTime, dependency->GetTime());
+	frame.fNewestLeafTime =
+		std::max(frame.fNewestLeafTime, dependency->LeafTime());
+	frame.fNewestUnchangedDependencyTime = std::max(
+		frame.fNewestUnchangedDependencyTime,
+		dependency->GetFate() == MakeTarget::MAKE
+				&& _IsMakeableTarget(dependency)
+			? dependency->GetOriginalTime()
+			: dependency->GetTime()
+	);
+
+	switch (dependency->GetFate()) {
+		case MakeTarget::KEEP:
+			break;
+		case MakeTarget::MAKE_IF_NEEDED:
+			break;
+		case MakeTarget::MAKE:
+			if (_IsMakeableTarget(dependency)
+				&& (!makeTarget->GetTarget()->DependsOnLeaves()
+					|| dependency->IsLeaf())) {
+				frame.fDependencyUpdated = true;
+			}
+			break;
+		case MakeTarget::CANT_MAKE:
+			frame.fCantMake = true;
+			break;
 	}
+}
+
+void
+Processor::_FinishPreparingTarget(PrepareFrame& frame)
+{
+	MakeTarget* makeTarget = frame.fTarget;
+	const Target* target = makeTarget->GetTarget();
+	bool isPseudoTarget = frame.fIsPseudoTarget;
+	Time time = frame.fTime;
+	Time newestDependencyTime = frame.fNewestDependencyTime;
 
 	// header scanning
 	if (makeTarget->FileExists())
@@ -441,7 +844,7 @@ Processor::_PrepareTargetRecursively(MakeTarget* makeTarget)
 
 	// For depends-on-leaves targets consider only the leaf times.
 	if (target->DependsOnLeaves())
-		newestDependencyTime = newestLeafTime;
+		newestDependencyTime = frame.fNewestLeafTime;
 
 	// Consider a "don't update" target very old, so targets depending on it
 	// won't be remade unnecessarily. Forced updates take precedence over "don't
@@ -463,14 +866,14 @@ Processor::_PrepareTargetRecursively(MakeTarget* makeTarget)
 			fate = MakeTarget::MAKE;
 	} else {
 		state = MakeTarget::UP_TO_DATE;
-		if (dependencyUpdated)
+		if (frame.fDependencyUpdated)
 			fate = MakeTarget::MAKE;
 	}
 
 	if (target->IsBuildAlways())
 		fate = MakeTarget::MAKE;
 
-	if (fate == MakeTarget::MAKE && cantMake)
+	if (fate == MakeTarget::MAKE && frame.fCantMake)
 		fate = MakeTarget::CANT_MAKE;
 
 	if (fate == MakeTarget::MAKE) {
@@ -501,8 +904,15 @@ Processor::_PrepareTargetRecursively(MakeTarget* makeTarget)
 	time = std::max(time, newestDependencyTime);
 	makeTarget->SetState(state);
 	makeTarget->SetFate(fate);
+	makeTarget->SetPrunable(
+		state != MakeTarget::MISSING && !target->IsBuildAlways()
+		&& (target->DependsOnLeaves()
+				? state == MakeTarget::UP_TO_DATE
+				: frame.fNewestUnchangedDependencyTime
+					<= makeTarget->GetOriginalTime())
+	);
 	makeTarget->SetTime(time);
-	makeTarget->SetLeafTime(makeTarget->IsLeaf() ? time : newestLeafTime);
+	makeTarget->SetLeafTime(makeTarget->IsLeaf() ? time : frame.fNewestLeafTime);
 	makeTarget->SetProcessingState(MakeTarget::PROCESSED);
 
 	// TODO: Support:
@@ -512,25 +922,60 @@ Processor::_PrepareTargetRecursively(MakeTarget* makeTarget)
 }
 
 void
-Processor::_SealTargetFateRecursively(
+Processor::_SealTargetFate(MakeTarget* root)
+{
+	std::vector<SealFrame> stack;
+	if (!_StartSealingTargetFate(root, Time::MIN, true, stack))
+		return;
+
+	while (!stack.empty()) {
+		SealFrame& frame = stack.back();
+		MakeTarget* makeTarget = frame.fTarget;
+
+		MakeTargetSpan dependencies = fMakeGraph.Dependencies(makeTarget);
+		if (frame.fIndex < dependencies.size()) {
+			MakeTarget* dependency = dependencies[frame.fIndex++];
+			fMakeLevel++;
+			if (!_StartSealingTargetFate(
+					dependency,
+					makeTarget->GetOriginalTime(),
+					makeTarget->GetFate() == MakeTarget::MAKE
+						&& _IsMakeableTarget(makeTarget),
+					stack
+				)) {
+				fMakeLevel--;
+			}
+			continue;
+		}
+
+		makeTarget->SetProcessingState(MakeTarget::PROCESSED);
+
+		if (fOptions.IsPrintMakeTree())
+			_PrintMakeTreeState(makeTarget, frame.fParentTime);
+
+		stack.pop_back();
+		if (!stack.empty())
+			fMakeLevel--;
+	}
+}
+
+bool
+Processor::_StartSealingTargetFate(
 	MakeTarget* makeTarget,
 	data::Time parentTime,
-	bool makeParent
+	bool makeParent,
+	std::vector<SealFrame>& stack
 )
 {
 	// Check whether the target has already been processed (also detect cycles)
 	// and mark in-progress.
 	if (makeTarget->GetProcessingState() != MakeTarget::UNPROCESSED) {
-		if (makeTarget->GetProcessingState() == MakeTarget::PROCESSING) {
-			throw MakeException(
-				std::string("Target \"") + makeTarget->Name().ToCString()
-				+ "\" depends on itself"
-			);
-		}
+		if (makeTarget->GetProcessingState() == MakeTarget::PROCESSING)
+			_ThrowDependencyCycle(stack, makeTarget);
 
 		// Already done, though we process it again, if its fate will change.
 		if (makeTarget->GetFate() != MakeTarget::MAKE_IF_NEEDED || !makeParent)
-			return;
+			return false;
 	}
 
 	makeTarget->SetProcessingState(MakeTarget::PROCESSING);
@@ -546,22 +991,8 @@ Processor::_SealTargetFateRecursively(
 		_PrintMakeTreeBinding(makeTarget);
 	}
 
-	for (size_t i = 0; i < makeTarget->Dependencies().Size(); i++) {
-		MakeTarget* dependency = makeTarget->Dependencies().ElementAt(i);
-		fMakeLevel++;
-		_SealTargetFateRecursively(
-			dependency,
-			makeTarget->GetOriginalTime(),
-			makeTarget->GetFate() == MakeTarget::MAKE
-				&& _IsMakeableTarget(makeTarget)
-		);
-		fMakeLevel--;
-	}
-
-	makeTarget->SetProcessingState(MakeTarget::PROCESSED);
-
-	if (fOptions.IsPrintMakeTree())
-		_PrintMakeTreeState(makeTarget, parentTime);
+	stack.push_back(SealFrame{makeTarget, parentTime, 0});
+	return true;
 }
 
 void
@@ -578,7 +1009,8 @@ Processor::_BindTarget(MakeTarget* makeTarget)
 		*fEvaluationContext.GlobalVariables(),
 		target,
 		boundPath,
-		fileStatus
+		fileStatus,
+		&fTargetPrefetcher.FileStatuses()
 	);
 	makeTarget->SetBoundPath(boundPath);
 	makeTarget->SetFileStatus(fileStatus);
@@ -591,6 +1023,10 @@ Processor::_ScanForHeaders(MakeTarget* makeTarget)
 	// Note: We're not getting the global variables, if the on-target ones
 	// aren't defined, since it really doesn't make much sense to define them
 	// globally.
+	// The headers the compiler has reported are exact, prefer them.
+	if (fDependencyLog != nullptr && _AddLoggedIncludes(makeTarget))
+		return;
+
 	const Target* target = makeTarget->GetTarget();
 	const data::VariableDomain* variables = target->Variables();
 	if (variables == nullptr)
@@ -604,37 +1040,23 @@ Processor::_ScanForHeaders(MakeTarget* makeTarget)
 		return;
 	}
 
-	// prepare the grep regular expression
-	data::RegExp regExp(scanPattern->ElementAt(0).ToCString());
+	String boundPath = makeTarget->BoundPath();
+	util::Trace::Span span("ScanForHeaders", "file", boundPath.ToCString());
 
-	// open the file
-	std::ifstream file(makeTarget->BoundPath().ToCString());
-	if (file.fail()) {
+	// scan the file, unless that has been done ahead
+	std::vector<std::string> headers;
+	if (!fTargetPrefetcher.ScanForHeaders(
+			boundPath.ToCString(),
+			scanPattern->ElementAt(0),
+			headers
+		)) {
 		// TODO: Error/warning!
 		return;
 	}
 
-	// scan it
 	StringList headersFound;
-	std::string line;
-	while (std::getline(file, line)) {
-		data::RegExp::MatchResult result = regExp.Match(line.c_str());
-		if (result.HasMatched()) {
-			size_t groupCount = result.GroupCount();
-			for (size_t i = 0; i < groupCount; i++) {
-				size_t startOffset = result.GroupStartOffsetAt(i);
-				size_t endOffset = result.GroupEndOffsetAt(i);
-				String headerName(
-					line.c_str() + startOffset,
-					endOffset - startOffset
-				);
-				if (!headerName.IsEmpty())
-					headersFound.Append(headerName);
-			}
-		}
-	}
-
-	file.close();
+	for (const std::string& header : headers)
+		headersFound.Append(String(header.c_str(), header.size()));
 
 	// If anything was found, call the HDRRULE.
 	if (!headersFound.IsEmpty()) {
@@ -661,18 +1083,168 @@ Processor::_ScanForHeaders(MakeTarget* makeTarget)
 }
 
 bool
-Processor::_CollectMakableTargets(MakeTarget* makeTarget)
+Processor::_AddLoggedIncludes(MakeTarget* makeTarget)
 {
-	// If make target was already collected return
-	if (makeTarget->GetProcessingState() != MakeTarget::UNPROCESSED) {
-		if (makeTarget->GetProcessingState() == MakeTarget::PROCESSING) {
-			throw MakeException(
-				"Target \"" + makeTarget->Name().ToStlString()
-				+ "\" depends on itself"
+	std::vector<std::string> headers;
+	if (!fDependencyLog->Lookup(
+			makeTarget->BoundPath().ToStlString(),
+			makeTarget->GetOriginalTime(),
+			headers
+		)) {
+		sDependencyLogMissesMetric.Increment();
+		return false;
+	}
+
+	// A header that has been removed may not be included anymore either.
+	for (const std::string& header : headers) {
+		data::FileStatus fileStatus;
+		if (!fTargetPrefetcher.FileStatuses().GetFileStatus(
+				header.c_str(),
+				fileStatus
+			)) {
+			sDependencyLogMissesMetric.Increment();
+			return false;
+		}
+	}
+
+	sDependencyLogHitsMetric.Increment();
+
+	// The headers are named by their absolute paths, so they are bound to
+	// them. NOCARE them like HDRRULE does, in case one is removed later.
+	Target* target = makeTarget->GetTarget();
+	for (const std::string& header : headers) {
+		Target* include = fTargets.LookupOrCreate(String(header.c_str()));
+		include->AddFlags(Target::IGNORE_IF_MISSING);
+		target->AddInclude(include);
+	}
+
+	return true;
+}
+
+void
+Processor::_LogDependencies(MakeTarget* makeTarget)
+{
+	const Target* target = makeTarget->GetTarget();
+	const data::VariableDomain* variables = target->Variables();
+	const StringList* depfile = variables != nullptr
+		? variables->Lookup(kDepfileVariableName)
+		: nullptr;
+	if (depfile == nullptr || depfile->IsEmpty())
+		return;
+
+	// _MakeTarget() has removed the depfile, so it can't be a stale one.
+	String depfilePath = depfile->Head();
+	std::vector<std::string> prerequisites;
+	if (!DependencyLog::ReadDepfile(depfilePath.ToCString(), prerequisites)) {
+		std::stringstream warning{};
+		warning << "failed to read depfile " << depfilePath.ToCString()
+				<< " of " << target->Name().ToCString() << ": "
+				<< strerror(errno);
+		_PrintWarning(warning.str());
+		return;
+	}
+
+	// Find the sources the depfile lists. Everything else it lists is a
+	// header of each of them.
+	std::set<std::string> listed;
+	for (const std::string& prerequisite : prerequisites)
+		listed.insert(DependencyLog::NormalizedPath(prerequisite));
+	std::set<std::string> sources;
+	for (data::RuleActionsCall* actionsCall : target->ActionsCalls()) {
+		for (Target* source : actionsCall->SourceTargets()) {
+			MakeTarget* makeSource = _GetMakeTarget(source, false);
+			if (makeSource == nullptr || !makeSource->IsBound())
+				continue;
+			std::string sourcePath = DependencyLog::NormalizedPath(
+				makeSource->BoundPath().ToStlString()
 			);
+			if (listed.count(sourcePath) != 0)
+				sources.insert(sourcePath);
 		}
+	}
 
-		return makeTarget->GetFate() == MakeTarget::MAKE;
+	std::vector<std::string> headers;
+	for (const std::string& prerequisite : prerequisites) {
+		if (sources.count(DependencyLog::NormalizedPath(prerequisite)) == 0) {
+			headers.push_back(std::filesystem::absolute(prerequisite)
+								  .lexically_normal()
+								  .string());
+		}
+	}
+
+	for (const std::string& source : sources) {
+		// The source may have been generated by this build, so stat it anew.
+		data::FileStatus fileStatus;
+		if (!data::Path::GetFileStatus(source.c_str(), fileStatus))
+			continue;
+
+		if (!fDependencyLog->Record(
+				source,
+				fileStatus.LastModifiedTime(),
+				headers
+			)) {
+			fprintf(
+				stderr,
+				"Warning: failed to write dependency log \"%s\": %s\n",
+				fOptions.DependencyLogFile().ToCString(),
+				strerror(errno)
+			);
+			fDependencyLog.reset();
+			return;
+		}
+	}
+}
+
+void
+Processor::_CollectMakableTargets(MakeTarget* root)
+{
+	std::vector<CollectFrame> stack;
+	bool needToMake;
+	_StartCollectingTarget(root, stack, needToMake);
+
+	while (!stack.empty()) {
+		CollectFrame& frame = stack.back();
+		MakeTarget* makeTarget = frame.fTarget;
+
+		MakeTargetSpan dependencies = fMakeGraph.Dependencies(makeTarget);
+		if (frame.fIndex < dependencies.size()) {
+			MakeTarget* dependency = dependencies[frame.fIndex++];
+			bool needToMake;
+			if (!_StartCollectingTarget(dependency, stack, needToMake)
+				&& needToMake) {
+				frame.fPendingDependencyCount++;
+			}
+			continue;
+		}
+
+		makeTarget->SetPendingDependenciesCount(frame.fPendingDependencyCount);
+
+		if (frame.fPendingDependencyCount == 0 && frame.fNeedToMake)
+			fMakableTargets.PushBack(makeTarget);
+
+		makeTarget->SetProcessingState(MakeTarget::PROCESSED);
+
+		needToMake = frame.fNeedToMake;
+		stack.pop_back();
+		if (needToMake && !stack.empty())
+			stack.back().fPendingDependencyCount++;
+	}
+}
+
+bool
+Processor::_StartCollectingTarget(
+	MakeTarget* makeTarget,
+	std::vector<CollectFrame>& stack,
+	bool& _needToMake
+)
+{
+	// If make target was already collected return
+	if (makeTarget->GetProcessingState() != MakeTarget::UNPROCESSED) {
+		if (makeTarget->GetProcessingState() == MakeTarget::PROCESSING)
+			_ThrowDependencyCycle(stack, makeTarget);
+
+		_needToMake = makeTarget->GetFate() == MakeTarget::MAKE;
+		return false;
 	}
 
 	makeTarget->SetProcessingState(MakeTarget::PROCESSING);
@@ -700,20 +1272,8 @@ Processor::_CollectMakableTargets(MakeTarget* makeTarget)
 			break;
 	}
 
-	size_t pendingDependencyCount = 0;
-	for (MakeTargetSet::Iterator it = makeTarget->Dependencies().GetIterator();
-		 it.HasNext();) {
-		if (_CollectMakableTargets(it.Next()))
-			pendingDependencyCount++;
-	}
-
-	makeTarget->SetPendingDependenciesCount(pendingDependencyCount);
-
-	if (pendingDependencyCount == 0 && needToMake)
-		fMakableTargets.Append(makeTarget);
-
-	makeTarget->SetProcessingState(MakeTarget::PROCESSED);
-	return needToMake;
+	stack.push_back(CollectFrame{makeTarget, 0, 0, needToMake});
+	return true;
 }
 
 CommandList
@@ -778,29 +1338,145 @@ Processor::_MakeTarget(MakeTarget* makeTarget)
 {
 	Target* target = makeTarget->GetTarget();
 	if (!_IsMakeableTarget(makeTarget) || target->ActionsCalls().empty()) {
-		_TargetMade(makeTarget, MakeTarget::DONE);
+		_TargetMade(
+			makeTarget,
+			MakeTarget::DONE,
+			_IsMakeableTarget(makeTarget)
+		);
 		return nullptr;
 	}
 
 	unique_ptr<TargetBuildInfo> buildInfo(new TargetBuildInfo(makeTarget));
 
+	bool started = false;
 	auto commands = _MakeCommands(target);
 	for (auto command : commands) {
-		if (command != nullptr)
+		if (command != nullptr) {
 			buildInfo->AddCommand(command);
+			started |= command->GetState() != Command::NOT_EXECUTED;
+		}
+	}
+
+	// Remove the target's depfile, so one the commands don't write isn't
+	// mistaken for a new one.
+	if (fDependencyLog != nullptr && !fOptions.IsDryRun() && !started) {
+		const data::VariableDomain* variables = target->Variables();
+		const StringList* depfile = variables != nullptr
+			? variables->Lookup(kDepfileVariableName)
+			: nullptr;
+		if (depfile != nullptr && !depfile->IsEmpty())
+			unlink(depfile->Head().ToCString());
 	}
 
 	return buildInfo.release();
 }
 
+bool
+Processor::_HasTargetChanged(MakeTarget* makeTarget) const
+{
+	if (fOptions.IsDryRun() || !makeTarget->FileExists())
+		return true;
+
+	bool restat = false;
+	for (data::RuleActionsCall* actionsCall :
+		 makeTarget->GetTarget()->ActionsCalls()) {
+		restat |= actionsCall->Actions()->IsRestat();
+	}
+	if (!restat)
+		return true;
+
+	// Bypass any file status cache, the commands may have written the file.
+	data::FileStatus fileStatus;
+	if (!data::Path::GetFileStatus(
+			makeTarget->BoundPath().ToCString(),
+			fileStatus
+		)) {
+		return true;
+	}
+
+	return fileStatus.LastModifiedTime() != makeTarget->GetOriginalTime();
+}
+
 size_t
-Processor::_TargetMade(MakeTarget* makeTarget, MakeTarget::MakeState state)
+Processor::_TargetMade(
+	MakeTarget* makeTarget,
+	MakeTarget::MakeState state,
+	bool changed
+)
+{
+	size_t skippedCount = 0;
+	std::vector<MadeFrame> stack;
+	_StartTargetMade(makeTarget, state, changed, stack, skippedCount);
+
+	while (!stack.empty()) {
+		MadeFrame& frame = stack.back();
+
+		// propagate the event to the target's parents
+		MakeTargetSpan parents = fMakeGraph.Parents(frame.fTarget);
+		if (frame.fIndex == parents.size()) {
+			stack.pop_back();
+			continue;
+		}
+
+		MakeTarget* parent = parents[frame.fIndex++];
+		size_t pendingDependencyCount = parent->PendingDependenciesCount() - 1;
+		parent->SetPendingDependenciesCount(pendingDependencyCount);
+
+		if (frame.fState != MakeTarget::DONE)
+			parent->SetMakeState(MakeTarget::SKIPPED);
+
+		// As when preparing, a depends-on-leaves target only considers its
+		// leaf dependencies.
+		if (frame.fChanged
+			&& (!parent->GetTarget()->DependsOnLeaves()
+				|| fMakeGraph.Dependencies(frame.fTarget).empty())) {
+			parent->SetDependencyChanged();
+		}
+
+		if (pendingDependencyCount == 0) {
+			if (parent->GetMakeState() == MakeTarget::PENDING
+				&& parent->IsPrunable() && !parent->HasChangedDependency()) {
+				// None of the dependencies that made the target outdated has
+				// actually changed, so keep it.
+				parent->SetFate(MakeTarget::KEEP);
+				fTargetsKeptCount++;
+				sTargetsKeptMetric.Increment();
+				_StartTargetMade(
+					parent,
+					MakeTarget::DONE,
+					false,
+					stack,
+					skippedCount
+				);
+			} else if (parent->GetMakeState() == MakeTarget::PENDING) {
+				fMakableTargets.PushFront(parent);
+			} else {
+				_StartTargetMade(
+					parent,
+					parent->GetMakeState(),
+					true,
+					stack,
+					skippedCount
+				);
+			}
+		}
+	}
+
+	return skippedCount;
+}
+
+void
+Processor::_StartTargetMade(
+	MakeTarget* makeTarget,
+	MakeTarget::MakeState state,
+	bool changed,
+	std::vector<MadeFrame>& stack,
+	size_t& _skippedCount
+)
 {
 	if (makeTarget->GetMakeState() == MakeTarget::PENDING)
 		makeTarget->SetMakeState(state);
 
-	size_t skippedCount = 0;
-
 	switch (state) {
 		case MakeTarget::DONE:
 			break;
@@ -813,10 +1489,8 @@ Processor::_TargetMade(MakeTarget* makeTarget, MakeTarget::MakeState state)
 		case MakeTarget::SKIPPED: {
 			// get the first dependency that couldn't be made
 			MakeTarget* lackingDependency = nullptr;
-			for (MakeTargetSet::Iterator it =
-					 makeTarget->Dependencies().GetIterator();
-				 it.HasNext();) {
-				MakeTarget* dependency = it.Next();
+			for (MakeTarget* dependency :
+				 fMakeGraph.Dependencies(makeTarget)) {
 				if (dependency->GetMakeState() == MakeTarget::FAILED
 					|| dependency->GetMakeState() == MakeTarget::SKIPPED) {
 					lackingDependency = dependency;
@@ -830,30 +1504,41 @@ Processor::_TargetMade(MakeTarget* makeTarget, MakeTarget::MakeState state)
 					? lackingDependency->Name().ToCString()
 					: "???"
 			);
-			skippedCount++;
+			_skippedCount++;
 			break;
 		}
 	}
 
-	// propagate the event to the target's parents
-	for (MakeTargetSet::Iterator it = makeTarget->Parents().GetIterator();
-		 it.HasNext();) {
-		MakeTarget* parent = it.Next();
-		size_t pendingDependencyCount = parent->PendingDependenciesCount() - 1;
-		parent->SetPendingDependenciesCount(pendingDependencyCount);
-
-		if (state != MakeTarget::DONE)
-			parent->SetMakeState(MakeTarget::SKIPPED);
-
-		if (pendingDependencyCount == 0) {
-			if (parent->GetMakeState() == MakeTarget::PENDING)
-				fMakableTargets.Insert(parent, 0);
-			else
-				skippedCount += _TargetMade(parent, parent->GetMakeState());
-		}
-	}
+	stack.push_back(MadeFrame{makeTarget, state, changed, 0});
+}
 
-	return skippedCount;
+/**
+ * Throws a MakeException for the dependency cycle found when reaching
+ * \a makeTarget, which is still being processed, from the top of \a stack.
+ * The message lists the targets along the cycle.
+ */
+template<typename Frame>
+/*static*/ void
+Processor::_ThrowDependencyCycle(
+	const std::vector<Frame>& stack,
+	const MakeTarget* makeTarget
+)
+{
+	size_t index = stack.size();
+	while (index > 0 && stack[index - 1].fTarget != makeTarget)
+		index--;
+	if (index > 0)
+		index--;
+
+	std::string cycle;
+	for (; index < stack.size(); index++)
+		cycle += stack[index].fTarget->Name().ToStlString() + " -> ";
+	cycle += makeTarget->Name().ToStlString();
+
+	throw MakeException(
+		"Target \"" + makeTarget->Name().ToStlString()
+		+ "\" depends on itself: " + cycle
+	);
 }
 
 void
@@ -1042,47 +1727,117 @@ Processor::_BuildCommands(
 		wordEnd = remainder - 1;
 	words.push_back({{wordStart, wordEnd}, {wordEnd, remainder - 1}});
 
+	// JOBMEMORY declares the memory the commands use at most, in megabytes
+	size_t memoryEstimate = 0;
+	const StringList* jobMemory =
+		fEvaluationContext.LookupVariable(kJobMemoryVariableName);
+	if (jobMemory != nullptr && !jobMemory->IsEmpty()) {
+		size_t megaBytes = strtoull(jobMemory->Head().ToCString(), nullptr, 10);
+		memoryEstimate = megaBytes * 1024 * 1024;
+	}
+
+	// FRESHSHELL keeps the commands from being run by a shell worker
+	const StringList* freshShell =
+		fEvaluationContext.LookupVariable(kFreshShellVariableName);
+	bool needsFreshShell = freshShell != nullptr && freshShell->IsTrue();
+
+	// A response file makes splitting the sources unnecessary.
 	data::StringListList sources{};
-	if (actions->IsPiecemeal() && !boundSourceTargets.IsEmpty()) {
+	std::vector<bool> sourceWords(words.size(), true);
+	if (actions->IsPiecemeal() && !actions->IsResponse()
+		&& !boundSourceTargets.IsEmpty()) {
 		std::uint32_t maxLine =
-			actions->MaxLine() > 0 ? actions->MaxLine() : kMaxCommandLength;
+			actions->MaxLine() > 0 ? actions->MaxLine() : fMaxCommandLength;
 
 		sources = Piecemeal::Words(
 			fEvaluationContext,
 			actions->RuleName().ToStlString(),
-			std::move(words),
+			words,
 			boundSourceTargets,
-			maxLine
+			maxLine,
+			sourceWords
 		);
 	} else {
 		sources.push_back(boundSourceTargets);
 	}
 
-	for (StringList commandSources : sources) {
+	// Words that can't refer to the sources expand the same for each chunk of
+	// a piecemeal action, so they are only evaluated once.
+	std::vector<String> constantWords(words.size());
+	std::vector<bool> hasConstantWord(words.size(), false);
+	const auto expandCommandLine = [&](const StringList& commandSources) {
 		data::VariableDomain builtInWithSources{builtInVariables};
 		builtInWithSources.Set("2", commandSources);
 		builtInWithSources.Set(">", commandSources);
 		fEvaluationContext.SetBuiltInVariables(&builtInWithSources);
 
-		// Build command
 		data::String commandLine{};
-		for (auto& [word, space] : words) {
-			auto evaluatedWord = code::Leaf::EvaluateString(
-				fEvaluationContext,
-				word.cbegin(),
-				word.cend(),
-				nullptr
-			);
-			const StringPart separator{" "};
+		for (std::size_t i = 0; i < words.size(); i++) {
+			const auto& [word, space] = words[i];
+			if (sourceWords[i] || !hasConstantWord[i]) {
+				// The word is only needed joined, so don't materialize the
+				// individual elements of the product.
+				util::FrameArena::Frame frame(fEvaluationContext.Arena());
+				auto evaluatedWord = code::Leaf::EvaluateStringProduct(
+					fEvaluationContext,
+					word.cbegin(),
+					word.cend(),
+					nullptr
+				);
+				const StringPart separator{" "};
 
-			commandLine = commandLine + evaluatedWord.Join(separator)
-				+ std::string{space}.c_str();
+				String expandedWord =
+					evaluatedWord.Join(separator) + std::string{space}.c_str();
+				if (sourceWords[i]) {
+					commandLine = commandLine + expandedWord;
+					continue;
+				}
+
+				constantWords[i] = expandedWord;
+				hasConstantWord[i] = true;
+			}
+
+			commandLine = commandLine + constantWords[i];
 		}
-		commands.push_back(new Command(
+
+		fEvaluationContext.SetBuiltInVariables(&builtInVariables);
+		return commandLine;
+	};
+
+	for (StringList commandSources : sources) {
+		// Build command
+		data::String commandLine = expandCommandLine(commandSources);
+
+		// If the command line is too long, let "@file" stand in for the
+		// sources.
+		String responseFile;
+		if (actions->IsResponse() && !fOptions.IsDryRun()
+			&& commandLine.Length() > fMaxCommandLength) {
+			responseFile = create_response_file(commandSources);
+			commandLine = expandCommandLine(
+				StringList().Append(String("@") + responseFile)
+			);
+		}
+
+		Command* command = new Command(
 			actionsCall,
 			std::move(commandLine),
 			std::move(boundTargets)
-		));
+		);
+		command->SetMemoryEstimate(memoryEstimate);
+		command->SetNeedsFreshShell(needsFreshShell);
+		command->SetResponseFile(responseFile);
+
+		// recognize command lines we can execute ourselves
+		if (fOptions.IsBuiltInCommands() && !fOptions.IsDryRun()) {
+			process::BuiltInCommand* builtInCommand =
+				new process::BuiltInCommand;
+			if (builtInCommand->Parse(command->CommandLine().ToCString()))
+				command->SetBuiltInCommand(builtInCommand);
+			else
+				delete builtInCommand;
+		}
+		commands.push_back(command);
 	}
 
 	// reinstate the old local variable scope and the built-in variables
@@ -1195,4 +1950,27 @@ Processor::_PrintWarning(std::string warning)
 	std::cerr << "...warning: " << warning << "..." << std::endl;
 }
 
+void
+Processor::_ReportRuleProfile()
+{
+	if (fRuleProfiler == nullptr)
+		return;
+
+	if (fOptions.IsPrintRuleProfile())
+		fRuleProfiler->PrintReport(fEvaluationContext.Output());
+
+	if (!fOptions.RuleStacksFile().IsEmpty()) {
+		std::ofstream file(fOptions.RuleStacksFile().ToCString());
+		if (file)
+			fRuleProfiler->WriteCollapsedStacks(file);
+		if (!file) {
+			fprintf(
+				stderr,
+				"Error: failed to write rule stacks file \"%s\"\n",
+				fOptions.RuleStacksFile().ToCString()
+			);
+		}
+	}
+}
+
 } // namespace ham::make
@@ -7,13 +7,20 @@
 #define HAM_MAKE_PROCESSOR_HPP
 
 #include "code/EvaluationContext.hpp"
+#include "code/IncludePrefetcher.hpp"
+#include "code/RuleProfiler.hpp"
 #include "data/RuleActions.hpp"
 #include "data/StringList.hpp"
 #include "data/TargetContainers.hpp"
 #include "data/TargetPool.hpp"
 #include "data/VariableDomain.hpp"
+#include "make/MakeGraph.hpp"
 #include "make/MakeTarget.hpp"
 #include "make/Options.hpp"
+#include "make/ReadyQueue.hpp"
+#include "make/TargetPrefetcher.hpp"
+#include "util/MetricsServer.hpp"
+#include "util/Trace.hpp"
 
 #include <map>
 #include <memory>
@@ -27,21 +34,62 @@ using data::StringList;
 using data::Target;
 using data::TargetSet;
 
+class BuildCache;
 class Command;
+class DependencyLog;
 class TargetBuildInfo;
 
-using MakeTargetMap = std::map<Target*, MakeTarget*>;
 using CommandList = std::vector<Command*>;
 using CommandMap = std::map<Target*, CommandList>;
 using TargetBuildInfoSet = std::set<TargetBuildInfo*>;
 
 class Processor
 {
+  private:
+	// State of a target being visited by one of the graph traversals. They
+	// keep an explicit stack of these instead of recursing, so a long
+	// dependency chain can't overflow the call stack.
+	struct PrepareFrame {
+		MakeTarget* fTarget;
+		size_t fIndex;
+		// of the next dependency
+		bool fIsPseudoTarget;
+		data::Time fTime;
+		data::Time fNewestDependencyTime;
+		data::Time fNewestLeafTime;
+		data::Time fNewestUnchangedDependencyTime;
+		// as if the dependencies to be made didn't change
+		bool fDependencyUpdated;
+		bool fCantMake;
+	};
+
+	struct SealFrame {
+		MakeTarget* fTarget;
+		data::Time fParentTime;
+		size_t fIndex;
+	};
+
+	struct CollectFrame {
+		MakeTarget* fTarget;
+		size_t fIndex;
+		size_t fPendingDependencyCount;
+		bool fNeedToMake;
+	};
+
+	struct MadeFrame {
+		MakeTarget* fTarget;
+		MakeTarget::MakeState fState;
+		bool fChanged;
+		size_t fIndex;
+		// of the next parent
+	};
+
   public:
 	Processor();
 	~Processor();
 
 	void SetOptions(const Options& options);
+	void SetBuildCache(BuildCache* cache);
 
 	void SetCompatibility(behavior::Compatibility compatibility);
 	// resets behavior as well
@@ -106,20 +154,55 @@ class Processor
 	/**
 	 * Binds and sets a tentative fate for a target and all of its dependencies.
 	 */
-	void _PrepareTargetRecursively(MakeTarget* makeTarget);
+	void _PrepareTarget(MakeTarget* root);
+
+	/**
+	 * Binds a target and pushes it on the stack, unless it has been prepared
+	 * already.
+	 *
+	 * \return true if the target was pushed, false otherwise
+	 */
+	bool _StartPreparingTarget(
+		MakeTarget* makeTarget,
+		std::vector<PrepareFrame>& stack
+	);
+
+	/**
+	 * Accounts for the dependency at the frame's index, after it has been
+	 * prepared, and advances the index.
+	 */
+	void _DependencyPrepared(PrepareFrame& frame);
+
+	/**
+	 * Scans for headers and decides the tentative fate of a target whose
+	 * dependencies have all been prepared.
+	 */
+	void _FinishPreparingTarget(PrepareFrame& frame);
 
 	/**
 	 * Updates MakeTarget::MAKE_IF_NEEDED targets if one of their dependents is
 	 * going to be made.
 	 *
+	 * \param[in] root
+	 */
+	void _SealTargetFate(MakeTarget* root);
+
+	/**
+	 * Pushes a target on the stack, unless it has been processed already and
+	 * its fate doesn't change.
+	 *
 	 * \param[in] makeTarget
 	 * \param[in] parentTime
 	 * \param[in] makeParent
+	 * \param[in,out] stack
+	 *
+	 * \return true if the target was pushed, false otherwise
 	 */
-	void _SealTargetFateRecursively(
+	bool _StartSealingTargetFate(
 		MakeTarget* makeTarget,
 		data::Time parentTime,
-		bool makeParent
+		bool makeParent,
+		std::vector<SealFrame>& stack
 	);
 
 	/**
@@ -139,15 +222,48 @@ class Processor
 	 */
 	void _ScanForHeaders(MakeTarget* makeTarget);
 
+	/**
+	 * Adds the headers the dependency log has for the file of a target as
+	 * includes of the target. Returns false, if there is no valid entry, e.g.
+	 * because the file has changed or a header doesn't exist anymore.
+	 *
+	 * \param[in] makeTarget
+	 */
+	bool _AddLoggedIncludes(MakeTarget* makeTarget);
+
+	/**
+	 * Records the headers the depfile of a target, whose commands have
+	 * succeeded, lists in the dependency log, for each of the target's sources
+	 * the depfile lists as well.
+	 *
+	 * \param[in] makeTarget
+	 */
+	void _LogDependencies(MakeTarget* makeTarget);
+
 	/**
 	 * Sets the MakeTarget::MakeState of a target and all its transitive
 	 * dependencies.
 	 *
+	 * \param[in] root
+	 */
+	void _CollectMakableTargets(MakeTarget* root);
+
+	/**
+	 * Sets the MakeTarget::MakeState of a target and pushes it on the stack,
+	 * unless it has been collected already.
+	 *
 	 * \param[in] makeTarget
+	 * \param[in,out] stack
+	 * \param[out] _needToMake whether the already collected target needs to
+	 * be made
 	 *
-	 * \return true if any targets need to be made, false otherwise
+	 * \return true if the target was pushed, false otherwise
 	 */
-	bool _CollectMakableTargets(MakeTarget* makeTarget);
+	bool _StartCollectingTarget(
+		MakeTarget* makeTarget,
+		std::vector<CollectFrame>& stack,
+		bool& _needToMake
+	);
 
 	/**
 	 * Make commands for a certain target.
@@ -164,16 +280,55 @@ class Processor
 	 */
 	TargetBuildInfo* _MakeTarget(MakeTarget* makeTarget);
 
+	/**
+	 * Returns whether the file of a target whose commands succeeded has
+	 * changed. Only targets with \c restat actions are checked, all others
+	 * are assumed to have changed.
+	 *
+	 * \param[in] makeTarget
+	 */
+	bool _HasTargetChanged(MakeTarget* makeTarget) const;
+
 	/**
 	 * Indicate a target has completed building with some MakeState, and
-	 * propagate the change to dependents.
+	 * propagate the change to dependents. Dependents that are only made
+	 * because of dependencies that haven't changed are kept.
 	 *
 	 * \param[in] makeTarget target that has completed
 	 * \param[in] state completed state, cannot be MakeTarget::Pending
+	 * \param[in] changed whether the target counts as updated for dependents
 	 *
 	 * \return the number of targets skipped as a result of the completion.
 	 */
-	size_t _TargetMade(MakeTarget* makeTarget, MakeTarget::MakeState state);
+	size_t _TargetMade(
+		MakeTarget* makeTarget,
+		MakeTarget::MakeState state,
+		bool changed
+	);
+
+	/**
+	 * Sets the MakeState of a target that has completed and pushes it on the
+	 * stack, so the completion is propagated to its parents.
+	 *
+	 * \param[in] makeTarget
+	 * \param[in] state
+	 * \param[in] changed
+	 * \param[in,out] stack
+	 * \param[in,out] _skippedCount incremented if the target is skipped
+	 */
+	void _StartTargetMade(
+		MakeTarget* makeTarget,
+		MakeTarget::MakeState state,
+		bool changed,
+		std::vector<MadeFrame>& stack,
+		size_t& _skippedCount
+	);
+
+	template<typename Frame>
+	[[noreturn]] static void _ThrowDependencyCycle(
+		const std::vector<Frame>& stack,
+		const MakeTarget* makeTarget
+	);
 
 	/**
 	 * Create a list of bound paths from an actions targets. Depending on action
@@ -190,7 +345,9 @@ class Processor
 	);
 
 	/**
-	 * Create a runnable Command from an actions call.
+	 * Create a runnable Command from an actions call. The sources of a
+	 * "response" action are passed in a response file, when the command line
+	 * would be too long otherwise.
 	 *
 	 * \param[in] actionsCall
 	 * \param[out] commands CommandList to add actions to
@@ -209,21 +366,43 @@ class Processor
 		...
 	);
 	void _PrintWarning(std::string warning);
+	void _ReportRuleProfile();
 
   private:
 	data::VariableDomain fGlobalVariables;
 	data::TargetPool fTargets;
 	code::EvaluationContext fEvaluationContext;
+	std::unique_ptr<code::IncludePrefetcher> fIncludePrefetcher;
 	Options fOptions;
 	MakeTargetSet fPrimaryTargets;
 	MakeTargetSet fTemporaryTargets;
 	MakeTargetMap fMakeTargets;
+	MakeGraph fMakeGraph;
+	TargetPrefetcher fTargetPrefetcher;
+	BuildCache* fBuildCache;
+	// kept from earlier builds by the daemon, optional
+	std::string fDirectory;
+	// the working directory, if there is a build cache
 	data::Time fNow;
 	int fMakeLevel;
-	MakeTargetSet fMakableTargets;
+	ReadyQueue fMakableTargets;
 	CommandMap fCommands;
 	TargetBuildInfoSet fTargetBuildInfos;
 	size_t fTargetsToUpdateCount;
+	size_t fTargetsKeptCount;
+	// made unnecessary by restat actions
+	size_t fMaxCommandLength;
+	// the longest command line the shell can be passed
+	std::unique_ptr<util::Trace> fTrace;
+	// recording if a trace file has been requested
+	std::unique_ptr<code::RuleProfiler> fRuleProfiler;
+	// measuring the rule calls if a profile has been requested
+	std::unique_ptr<util::MetricsServer> fMetricsServer;
+	// serving the metrics if a socket has been requested
+	std::unique_ptr<code::IncludeCache> fIncludeCache;
+	// repeating the evaluation of included files if a cache file is given
+	std::unique_ptr<DependencyLog> fDependencyLog;
+	// replacing header scans if a log file is given
 };
 
 } // namespace ham::make
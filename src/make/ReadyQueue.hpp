@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_READY_QUEUE_HPP
+#define HAM_MAKE_READY_QUEUE_HPP
+
+#include "make/MakeTarget.hpp"
+
+#include <deque>
+
+namespace ham::make
+{
+
+/**
+ * Queue of the targets whose dependencies have all been made, so they can be
+ * made next. All operations are O(1). Whether a target is queued is recorded
+ * in the target itself, so no target is queued twice.
+ */
+class ReadyQueue
+{
+  public:
+	ReadyQueue()
+		: fTargets()
+	{
+	}
+
+	bool PushFront(MakeTarget* target)
+	{
+		if (target->IsQueued())
+			return false;
+		fTargets.push_front(target);
+		target->SetQueued(true);
+		return true;
+	}
+
+	bool PushBack(MakeTarget* target)
+	{
+		if (target->IsQueued())
+			return false;
+		fTargets.push_back(target);
+		target->SetQueued(true);
+		return true;
+	}
+
+	MakeTarget* PopFront()
+	{
+		MakeTarget* target = fTargets.front();
+		fTargets.pop_front();
+		target->SetQueued(false);
+		return target;
+	}
+
+	size_t Size() const { return fTargets.size(); }
+
+	bool IsEmpty() const { return fTargets.empty(); }
+
+  private:
+	std::deque<MakeTarget*> fTargets;
+};
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_READY_QUEUE_HPP
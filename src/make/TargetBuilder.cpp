@@ -10,24 +10,70 @@
 #include "make/Command.hpp"
 #include "make/Options.hpp"
 #include "make/TargetBuildInfo.hpp"
+#include "process/BuiltInCommand.hpp"
 #include "process/ChildInfo.hpp"
+#include "util/Metrics.hpp"
+#include "util/Trace.hpp"
 
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
 
 namespace ham::make
 {
 
+static const int kProcessPollInterval = 10; // milliseconds
+
+static util::Gauge sJobSlotsMetric("ham_job_slots", "Job slots available.");
+static util::Gauge sBusyJobSlotsMetric(
+	"ham_job_slots_busy",
+	"Job slots running a command."
+);
+static util::Counter sJobSlotBusyTimeMetric(
+	"ham_job_slot_busy_seconds",
+	"Time job slots spent running commands, summed over the slots. Its rate "
+	"divided by ham_job_slots is the utilization.",
+	nullptr,
+	1e-9
+);
+static util::Counter sCommandsMetric("ham_commands", "Commands run.");
+static util::Counter sCommandsFailedMetric(
+	"ham_commands_failed",
+	"Commands that failed."
+);
+
 class TargetBuilder::JobSlot
 {
   public:
 	process::Process fProcess;
+	process::ShellWorker fWorker;
+	std::thread fThread;
 	Command* fCommand;
+	size_t fMemory;
+	// reserved for the command
+	bool fUsesWorker;
+	// whether the command is executed by fWorker instead of fProcess
+	bool fUsesThread;
+	// whether the command is a built-in one executed by fThread
+	int fThreadExitCode;
+	util::Trace::Clock::time_point fLaunchTime;
 
 	JobSlot()
 		: fProcess(),
-		  fCommand(nullptr)
+		  fWorker(),
+		  fThread(),
+		  fCommand(nullptr),
+		  fMemory(0),
+		  fUsesWorker(false),
+		  fUsesThread(false),
+		  fThreadExitCode(0),
+		  fLaunchTime()
 	{
 	}
 };
@@ -39,16 +85,63 @@ TargetBuilder::TargetBuilder(const Options& options, const StringList& jamShell)
 	  fBuildInfos(),
 	  fFinishedBuildInfos(),
 	  fFinishedCommands(),
-	  fJobSlots(new JobSlot[fMaxJobCount])
+	  fJobSlots(new JobSlot[fMaxJobCount]),
+	  fJobServer(),
+	  fAdmissionControl(options),
+	  fDelayedCommands(),
+	  fUtilization(fMaxJobCount, JobSlotUtilization::Clock::now()),
+	  fShellWorkerPath(),
+	  fThreadDoneFds{-1, -1}
 {
+	sJobSlotsMetric.Set(fMaxJobCount);
+
+	// Shell workers and built-in commands can only stand in for a POSIX shell
+	// run with "-c".
+	bool isPosixShell = jamShell.Size() == 3 && jamShell.ElementAt(1) == "-c"
+		&& jamShell.ElementAt(2) == "%";
+	if (options.IsShellWorkers() && !options.IsDryRun() && isPosixShell)
+		fShellWorkerPath = jamShell.ElementAt(0);
+
+	// TODO: Platform specific!
+	if (options.IsBuiltInCommands() && !options.IsDryRun() && isPosixShell
+		&& pipe2(fThreadDoneFds, O_CLOEXEC) != 0) {
+		fThreadDoneFds[0] = fThreadDoneFds[1] = -1;
+	}
+
+	// Share the job slots with a make we have been invoked from or else with
+	// the makes our commands invoke.
+	if (fMaxJobCount > 1 && !options.IsDryRun()) {
+		const char* makeFlags =
+			getenv(process::JobServer::kMakeFlagsVariableName);
+		if (!fJobServer.Connect(makeFlags))
+			fJobServer.Create(fMaxJobCount);
+	}
 }
 
-TargetBuilder::~TargetBuilder() { delete[] fJobSlots; }
+TargetBuilder::~TargetBuilder()
+{
+	for (size_t i = 0; i < fMaxJobCount; i++) {
+		if (fJobSlots[i].fThread.joinable())
+			fJobSlots[i].fThread.join();
+	}
+
+	delete[] fJobSlots;
+
+	if (fThreadDoneFds[0] >= 0) {
+		close(fThreadDoneFds[0]);
+		close(fThreadDoneFds[1]);
+	}
+}
 
+/**
+ * Returns whether another target can be built now. Besides -j, a job server
+ * limits the number of running commands, but its tokens are only taken when
+ * launching a command (cf. _CanLaunch()).
+ */
 bool
-TargetBuilder::HasSpareJobSlots() const
+TargetBuilder::HasSpareJobSlots()
 {
-	return fMaxJobCount > fBuildInfos.size();
+	return fMaxJobCount > fBuildInfos.size() && fDelayedCommands.empty();
 }
 
 void
@@ -59,8 +152,14 @@ TargetBuilder::AddBuildInfo(TargetBuildInfo* buildInfo)
 	_ExecuteNextCommand(buildInfo);
 }
 
+/**
+ * Returns the next target whose commands are done, if any. With \a canWait
+ * it waits for running commands to finish until one is. \a hasReadyTargets
+ * tells whether the caller has targets it would start, if it could, which
+ * accounts for the job slots being idle meanwhile.
+ */
 TargetBuildInfo*
-TargetBuilder::NextFinishedBuildInfo(bool canWait)
+TargetBuilder::NextFinishedBuildInfo(bool canWait, bool hasReadyTargets)
 {
 	for (;;) {
 		// handle finished commands
@@ -134,20 +233,57 @@ TargetBuilder::NextFinishedBuildInfo(bool canWait)
 		if (!canWait || fBuildInfos.empty())
 			return nullptr;
 
+		// Don't hold on to tokens while waiting, so other processes can use
+		// them.
+		_ReleaseSpareTokens();
+
 		// wait for some running command to finish
+		fUtilization.MainThreadWaiting(
+			hasReadyTargets ? JobSlotUtilization::IDLE_THROTTLED
+							: JobSlotUtilization::IDLE_NO_READY_TARGETS,
+			JobSlotUtilization::Clock::now()
+		);
 		process::ChildInfo processInfo;
-		if (!process::Process::WaitForChild(processInfo)
-			|| !processInfo.fExited) {
+		int jobSlot = _WaitForCommand(processInfo);
+		fUtilization.MainThreadBusy(JobSlotUtilization::Clock::now());
+		if (jobSlot < 0) {
+			// a job server token may have become available meanwhile
+			_LaunchDelayedCommands();
 			continue;
 		}
 
-		int jobSlot = _FindJobSlot(processInfo.fId);
-		if (jobSlot < 0)
-			continue;
-
 		Command* command = fJobSlots[jobSlot].fCommand;
+		command->RemoveResponseFile();
+		util::Trace::Clock::time_point finishTime = util::Trace::Clock::now();
+		sBusyJobSlotsMetric.Add(-1);
+		fUtilization.SlotIdle(jobSlot, finishTime);
+		sJobSlotBusyTimeMetric.Increment(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				finishTime - fJobSlots[jobSlot].fLaunchTime
+			)
+				.count()
+		);
+		if (util::Trace* trace = util::Trace::Active()) {
+			String targets = command->BoundTargetPaths().Join(StringPart(" "));
+			trace->AddSpan(
+				command->Actions()->Actions()->RuleName().ToCString(),
+				fJobSlots[jobSlot].fLaunchTime,
+				finishTime,
+				"targets",
+				targets.ToCString(),
+				jobSlot
+			);
+		}
+		fAdmissionControl.CommandFinished(
+			command,
+			fJobSlots[jobSlot].fMemory,
+			processInfo.fPeakMemory
+		);
 		fJobSlots[jobSlot].fCommand = nullptr;
+		fJobSlots[jobSlot].fMemory = 0;
 		fJobSlots[jobSlot].fProcess.Unset();
+		fJobSlots[jobSlot].fUsesWorker = false;
+		fJobSlots[jobSlot].fUsesThread = false;
 
 		fFinishedCommands.push_back(command);
 		Command::State state = processInfo.fExitCode == 0
@@ -155,6 +291,8 @@ TargetBuilder::NextFinishedBuildInfo(bool canWait)
 			? Command::SUCCEEDED
 			: Command::FAILED;
 		command->SetState(state);
+		if (state == Command::FAILED)
+			sCommandsFailedMetric.Increment();
 
 		// TODO: This lets new commands enter the queue before quitting. Make
 		// this quit immediately.
@@ -165,12 +303,31 @@ TargetBuilder::NextFinishedBuildInfo(bool canWait)
 			printf("%s\n", command->CommandLine().ToCString());
 			printf("...waiting for commands to exit...\n");
 			// Wait for children
+			for (size_t i = 0; i < fMaxJobCount; i++) {
+				fJobSlots[i].fWorker.Stop();
+				if (fJobSlots[i].fThread.joinable())
+					fJobSlots[i].fThread.join();
+			}
 			while (process::Process::WaitForChild(processInfo))
 				;
+			_RemoveResponseFiles();
 			printf("...children done, exiting...\n");
 
+			fJobServer.ReleaseTokens();
+
+			// exit() skips the Processor, which would write the trace and
+			// the metrics
+			if (util::Trace* trace = util::Trace::Active())
+				trace->WriteFile(fOptions.TraceFile().ToCString());
+			String metricsFile = fOptions.MetricsFile();
+			if (!metricsFile.IsEmpty())
+				util::Metric::WriteAllToFile(metricsFile.ToCString());
+
 			exit(exitCode);
 		}
+
+		_LaunchDelayedCommands();
+		_ReleaseSpareTokens();
 	}
 }
 
@@ -221,34 +378,84 @@ TargetBuilder::_ExecuteNextCommand(TargetBuildInfo* buildInfo)
 void
 TargetBuilder::_ExecuteCommand(Command* command)
 {
-	if (fOptions.IsPrintActions()) {
-		data::RuleActionsCall* actions = command->Actions();
-
-		if (fOptions.IsPrintQuietActions()
-			|| !(actions->Actions()->IsQuietly())) {
-			printf(
-				"%s %s\n",
-				actions->Actions()->RuleName().ToCString(),
-				command->BoundTargetPaths().Join(StringPart(" ")).ToCString()
-			);
-		}
-	}
-
-	if (fOptions.IsPrintCommands()) {
-		printf("%s\n", command->CommandLine().ToCString());
-	}
-
 	if (fOptions.IsDryRun()) {
+		_PrintCommand(command);
 		command->SetState(Command::SUCCEEDED);
 		fFinishedCommands.push_back(command);
 		return;
 	}
 
+	// Commands waiting for a build info wait for this one, too.
+	command->SetState(Command::IN_PROGRESS);
+
+	size_t memory = fAdmissionControl.EstimateMemory(command);
+	if (!_CanLaunch(memory)) {
+		fDelayedCommands.push_back(command);
+		return;
+	}
+
+	_LaunchCommand(command, memory);
+}
+
+/**
+ * Returns whether a command needing \a memory can be launched now. Every
+ * running command but the first one needs a job server token, which is taken
+ * here when needed, without waiting for one.
+ */
+bool
+TargetBuilder::_CanLaunch(size_t memory)
+{
+	size_t runningCount = _RunningCommandCount();
+	if (!fAdmissionControl.CanLaunch(memory, runningCount))
+		return false;
+
+	return !fJobServer.IsValid() || runningCount < fJobServer.TokenCount() + 1
+		|| fJobServer.AcquireToken();
+}
+
+void
+TargetBuilder::_LaunchCommand(Command* command, size_t memory)
+{
+	_PrintCommand(command);
+
 	int jobSlot = _FindFreeJobSlot();
 	// TODO:...
 	if (jobSlot < 0) {
 		throw std::logic_error("Could not find job slot for command");
 	}
+
+	bool useThread =
+		fThreadDoneFds[0] >= 0 && command->GetBuiltInCommand() != nullptr;
+	bool useWorker = !useThread && !fShellWorkerPath.IsEmpty()
+		&& !command->NeedsFreshShell();
+	bool launched;
+	if (useThread)
+		launched = _LaunchInThread(command, jobSlot);
+	else if (useWorker)
+		launched = _LaunchInWorker(command, jobSlot);
+	else
+		launched = _LaunchProcess(command, jobSlot);
+	if (!launched) {
+		command->RemoveResponseFile();
+		command->SetState(Command::FAILED);
+		fFinishedCommands.push_back(command);
+		return;
+	}
+
+	fJobSlots[jobSlot].fCommand = command;
+	fJobSlots[jobSlot].fMemory = memory;
+	fJobSlots[jobSlot].fLaunchTime = util::Trace::Clock::now();
+	fUtilization.SlotBusy(jobSlot, fJobSlots[jobSlot].fLaunchTime);
+	fJobSlots[jobSlot].fUsesWorker = useWorker;
+	fJobSlots[jobSlot].fUsesThread = useThread;
+	fAdmissionControl.CommandLaunched(memory);
+	sCommandsMetric.Increment();
+	sBusyJobSlotsMetric.Add(1);
+}
+
+bool
+TargetBuilder::_LaunchProcess(Command* command, int jobSlot)
+{
 	char slotString[16];
 	snprintf(slotString, sizeof(slotString), "%d", jobSlot + 1);
 
@@ -285,14 +492,185 @@ TargetBuilder::_ExecuteCommand(Command* command)
 
 	delete[] arguments;
 
-	if (!launched) {
-		command->SetState(Command::FAILED);
-		fFinishedCommands.push_back(command);
-		return;
+	return launched;
+}
+
+bool
+TargetBuilder::_LaunchInWorker(Command* command, int jobSlot)
+{
+	// Start the worker on first use. If it is gone, e.g. because a command
+	// has killed it, start a new one.
+	process::ShellWorker& worker = fJobSlots[jobSlot].fWorker;
+	const char* commandLine = command->CommandLine().ToCString();
+	if (worker.IsRunning() && worker.Execute(commandLine))
+		return true;
+
+	worker.Stop();
+	return worker.Start(fShellWorkerPath.ToCString())
+		&& worker.Execute(commandLine);
+}
+
+bool
+TargetBuilder::_LaunchInThread(Command* command, int jobSlot)
+{
+	JobSlot& slot = fJobSlots[jobSlot];
+	const process::BuiltInCommand* builtInCommand =
+		command->GetBuiltInCommand();
+	int doneFd = fThreadDoneFds[1];
+	try {
+		slot.fThread = std::thread([&slot, builtInCommand, jobSlot, doneFd]() {
+			slot.fThreadExitCode = builtInCommand->Execute();
+			while (write(doneFd, &jobSlot, sizeof(jobSlot)) < 0
+				   && errno == EINTR)
+				;
+		});
+	} catch (const std::system_error& error) {
+		fprintf(stderr, "Error: failed to start thread: %s\n", error.what());
+		return false;
 	}
 
-	command->SetState(Command::IN_PROGRESS);
-	fJobSlots[jobSlot].fCommand = command;
+	return true;
+}
+
+/**
+ * Waits for a running command to finish and returns its job slot, -1 if none
+ * has.
+ */
+int
+TargetBuilder::_WaitForCommand(process::ChildInfo& _processInfo)
+{
+	std::vector<process::ShellWorker*> workers;
+	std::vector<int> workerJobSlots;
+	bool processesRunning = false;
+	bool threadsRunning = false;
+	for (size_t i = 0; i < fMaxJobCount; i++) {
+		if (fJobSlots[i].fCommand == nullptr)
+			continue;
+
+		if (fJobSlots[i].fUsesWorker) {
+			workers.push_back(&fJobSlots[i].fWorker);
+			workerJobSlots.push_back((int)i);
+		} else if (fJobSlots[i].fUsesThread)
+			threadsRunning = true;
+		else
+			processesRunning = true;
+	}
+
+	// Commands waiting for a job server token are retried after a while, as
+	// other processes may return tokens meanwhile.
+	bool waitingForToken = fJobServer.IsValid() && !fDelayedCommands.empty();
+	if (workers.empty() && !threadsRunning && !waitingForToken) {
+		if (!process::Process::WaitForChild(_processInfo)
+			|| !_processInfo.fExited) {
+			return -1;
+		}
+
+		return _FindJobSlot(_processInfo.fId);
+	}
+
+	for (;;) {
+		if (processesRunning
+			&& process::Process::WaitForChild(_processInfo, false)) {
+			int jobSlot = _FindJobSlot(_processInfo.fId);
+			if (jobSlot >= 0 && _processInfo.fExited)
+				return jobSlot;
+			continue;
+		}
+
+		// An exiting process doesn't interrupt the wait, so don't wait long
+		// while there are some.
+		int index = process::ShellWorker::Wait(
+			workers.data(),
+			workers.size(),
+			threadsRunning ? fThreadDoneFds[0] : -1,
+			processesRunning || waitingForToken ? kProcessPollInterval : -1
+		);
+		if (index < 0) {
+			if (waitingForToken)
+				return -1;
+			continue;
+		}
+
+		if ((size_t)index == workers.size()) {
+			// a thread is done with its built-in command
+			int jobSlot;
+			if (read(fThreadDoneFds[0], &jobSlot, sizeof(jobSlot))
+				!= (ssize_t)sizeof(jobSlot)) {
+				continue;
+			}
+
+			fJobSlots[jobSlot].fThread.join();
+			_processInfo.fId = -1;
+			_processInfo.fExited = true;
+			_processInfo.fExitCode = fJobSlots[jobSlot].fThreadExitCode;
+			_processInfo.fPeakMemory = 0;
+			return jobSlot;
+		}
+
+		process::ShellWorker* worker = workers[index];
+		_processInfo.fId = worker->GetId();
+		_processInfo.fExited = true;
+		_processInfo.fPeakMemory = 0;
+		if (!worker->ReadExitCode(_processInfo.fExitCode)) {
+			// the worker is gone, and the command with it
+			worker->Stop();
+			_processInfo.fExitCode = 1;
+		}
+		return workerJobSlots[index];
+	}
+}
+
+/**
+ * Launches the delayed commands that can be launched now, in order. Smaller
+ * commands may overtake a large one that has to wait for memory.
+ */
+void
+TargetBuilder::_LaunchDelayedCommands()
+{
+	for (auto it = fDelayedCommands.begin(); it != fDelayedCommands.end();) {
+		Command* command = *it;
+		size_t memory = fAdmissionControl.EstimateMemory(command);
+		if (!_CanLaunch(memory)) {
+			++it;
+			continue;
+		}
+
+		it = fDelayedCommands.erase(it);
+		_LaunchCommand(command, memory);
+	}
+}
+
+void
+TargetBuilder::_PrintCommand(Command* command)
+{
+	if (fOptions.IsPrintActions()) {
+		data::RuleActionsCall* actions = command->Actions();
+
+		if (fOptions.IsPrintQuietActions()
+			|| !(actions->Actions()->IsQuietly())) {
+			printf(
+				"%s %s\n",
+				actions->Actions()->RuleName().ToCString(),
+				command->BoundTargetPaths().Join(StringPart(" ")).ToCString()
+			);
+		}
+	}
+
+	if (fOptions.IsPrintCommands()) {
+		printf("%s\n", command->CommandLine().ToCString());
+	}
+}
+
+size_t
+TargetBuilder::_RunningCommandCount() const
+{
+	size_t count = 0;
+	for (size_t i = 0; i < fMaxJobCount; i++) {
+		if (fJobSlots[i].fCommand != nullptr)
+			count++;
+	}
+
+	return count;
 }
 
 int
@@ -319,4 +697,33 @@ TargetBuilder::_FindJobSlot(process::Process::Id id) const
 	return -1;
 }
 
+/**
+ * Returns the job server tokens the running commands don't need to the job
+ * server.
+ */
+void
+TargetBuilder::_ReleaseSpareTokens()
+{
+	size_t runningCount = _RunningCommandCount();
+	size_t neededTokens = runningCount == 0 ? 0 : runningCount - 1;
+	while (fJobServer.TokenCount() > neededTokens)
+		fJobServer.ReleaseToken();
+}
+
+/**
+ * Removes the response files of all commands of the pending targets,
+ * including the commands that haven't been launched yet.
+ */
+void
+TargetBuilder::_RemoveResponseFiles()
+{
+	for (const std::vector<TargetBuildInfo*>* buildInfos :
+		 {&fBuildInfos, &fFinishedBuildInfos}) {
+		for (TargetBuildInfo* buildInfo : *buildInfos) {
+			for (Command* command : buildInfo->Commands())
+				command->RemoveResponseFile();
+		}
+	}
+}
+
 } // namespace ham::make
@@ -6,8 +6,13 @@
 #define HAM_MAKE_TARGET_BUILDER_HPP
 
 #include "data/StringList.hpp"
+#include "make/AdmissionControl.hpp"
+#include "make/JobSlotUtilization.hpp"
+#include "process/JobServer.hpp"
 #include "process/Process.hpp"
+#include "process/ShellWorker.hpp"
 
+#include <deque>
 #include <stddef.h>
 #include <vector>
 
@@ -24,21 +29,34 @@ class TargetBuilder
 	TargetBuilder(const Options& options, const StringList& jamShell);
 	~TargetBuilder();
 
-	bool HasSpareJobSlots() const;
+	bool HasSpareJobSlots();
 
 	void AddBuildInfo(TargetBuildInfo* buildInfo);
 
-	TargetBuildInfo* NextFinishedBuildInfo(bool canWait);
+	TargetBuildInfo* NextFinishedBuildInfo(bool canWait, bool hasReadyTargets);
 	bool HasPendingBuildInfos() const;
 
+	JobSlotUtilization& Utilization() { return fUtilization; }
+
   private:
 	class JobSlot;
 
   private:
 	void _ExecuteNextCommand(TargetBuildInfo* buildInfo);
 	void _ExecuteCommand(Command* command);
+	bool _CanLaunch(size_t memory);
+	void _LaunchCommand(Command* command, size_t memory);
+	bool _LaunchProcess(Command* command, int jobSlot);
+	bool _LaunchInWorker(Command* command, int jobSlot);
+	bool _LaunchInThread(Command* command, int jobSlot);
+	int _WaitForCommand(process::ChildInfo& _processInfo);
+	void _LaunchDelayedCommands();
+	void _PrintCommand(Command* command);
+	size_t _RunningCommandCount() const;
 	int _FindFreeJobSlot() const;
 	int _FindJobSlot(process::Process::Id id) const;
+	void _ReleaseSpareTokens();
+	void _RemoveResponseFiles();
 
   private:
 	const Options& fOptions;
@@ -48,6 +66,16 @@ class TargetBuilder
 	std::vector<TargetBuildInfo*> fFinishedBuildInfos;
 	std::vector<Command*> fFinishedCommands;
 	JobSlot* fJobSlots;
+	process::JobServer fJobServer;
+	AdmissionControl fAdmissionControl;
+	std::deque<Command*> fDelayedCommands;
+	// waiting for memory, the load or a job server token
+	JobSlotUtilization fUtilization;
+	String fShellWorkerPath;
+	// the shell to use for workers, empty if not using workers
+	int fThreadDoneFds[2];
+	// the threads executing built-in commands write their job slot to this
+	// pipe when done, -1 if not executing built-in commands
 };
 
 } // namespace ham::make
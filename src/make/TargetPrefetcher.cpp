@@ -0,0 +1,324 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "make/TargetPrefetcher.hpp"
+
+#include "data/Path.hpp"
+#include "data/TargetBinder.hpp"
+#include "make/DependencyLog.hpp"
+#include "util/Metrics.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+namespace ham::make
+{
+
+static const data::String kHeaderScanVariableName("HDRSCAN");
+static const data::String kHeaderRuleVariableName("HDRRULE");
+
+static util::Counter sHeadersScannedMetric(
+	"ham_headers_scanned",
+	"Files scanned for headers."
+);
+static util::Counter sCacheHitsMetric(
+	"ham_cache_hits",
+	"Lookups answered from a cache.",
+	"cache=\"header_scan\""
+);
+static util::Counter sCacheMissesMetric(
+	"ham_cache_misses",
+	"Lookups a cache couldn't answer.",
+	"cache=\"header_scan\""
+);
+
+TargetPrefetcher::TargetPrefetcher()
+	: fFileStatuses(),
+	  fScanResults(),
+	  fBase(nullptr),
+	  fBaseDirectory(),
+	  fDependencyLog(nullptr)
+{
+}
+
+void
+TargetPrefetcher::SetBase(
+	const TargetPrefetcher* base,
+	const std::string& directory
+)
+{
+	fBase = base;
+	fBaseDirectory = directory;
+	fFileStatuses.SetBase(
+		base != nullptr ? &base->fFileStatuses : nullptr,
+		directory
+	);
+}
+
+/**
+ * Looks up the file statuses and scans the files of the targets reachable
+ * from \a roots, using \a threadCount threads. Returns when all is done.
+ */
+void
+TargetPrefetcher::Prefetch(
+	size_t threadCount,
+	const data::VariableDomain& globalVariables,
+	const std::vector<data::Target*>& roots
+)
+{
+	// Collect the targets and what there is to do for them. The targets and
+	// variables are only touched here, on the calling thread.
+	std::vector<Task> tasks;
+	std::map<std::string, std::unique_ptr<data::RegExp>> regExps;
+	std::unordered_set<const data::Target*> visited;
+	std::vector<const data::Target*> stack(roots.begin(), roots.end());
+	while (!stack.empty()) {
+		const data::Target* target = stack.back();
+		stack.pop_back();
+		if (!visited.insert(target).second)
+			continue;
+
+		for (data::TargetSet::Iterator it =
+				 target->Dependencies().GetIterator();
+			 it.HasNext();) {
+			stack.push_back(it.Next());
+		}
+		for (data::TargetSet::Iterator it = target->Includes().GetIterator();
+			 it.HasNext();) {
+			stack.push_back(it.Next());
+		}
+
+		Task task;
+		task.fRegExp = nullptr;
+		task.fScanned = false;
+		task.fOpened = false;
+
+		data::StringList paths;
+		data::TargetBinder::GetCandidatePaths(globalVariables, target, paths);
+		for (size_t i = 0; i < paths.Size(); i++)
+			task.fPaths.push_back(paths.ElementAt(i).ToStlString());
+
+		const data::VariableDomain* variables = target->Variables();
+		const data::StringList* scanPattern = variables != nullptr
+			? variables->Lookup(kHeaderScanVariableName)
+			: nullptr;
+		const data::StringList* scanRule = variables != nullptr
+			? variables->Lookup(kHeaderRuleVariableName)
+			: nullptr;
+		if (scanPattern != nullptr && scanRule != nullptr
+			&& !scanPattern->IsEmpty() && !scanRule->IsEmpty()) {
+			std::string pattern = scanPattern->Head().ToStlString();
+			std::unique_ptr<data::RegExp>& regExp = regExps[pattern];
+			if (regExp == nullptr) {
+				try {
+					regExp.reset(new data::RegExp(pattern.c_str()));
+				} catch (...) {
+					// leave it to the sequential scan to report the error
+				}
+			}
+			task.fPattern = pattern;
+			task.fRegExp = regExp.get();
+		}
+
+		tasks.push_back(std::move(task));
+	}
+
+	// Run the tasks. Each thread takes the next task that hasn't been taken.
+	std::atomic<size_t> nextTask(0);
+	auto work = [this, &tasks, &nextTask]() {
+		for (;;) {
+			size_t index = nextTask.fetch_add(1);
+			if (index >= tasks.size())
+				return;
+			_RunTask(tasks[index]);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < threadCount && i < tasks.size(); i++)
+		threads.push_back(std::thread(work));
+	work();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	// Make the results available.
+	for (const Task& task : tasks) {
+		for (size_t i = 0; i < task.fStatuses.size(); i++)
+			fFileStatuses.Add(task.fPaths[i], task.fStatuses[i]);
+
+		if (task.fScanned) {
+			ScanResult& result = fScanResults[ScanKey(
+				task.fPaths[task.fStatuses.size() - 1],
+				task.fPattern
+			)];
+			result.fOpened = task.fOpened;
+			result.fHeaders = task.fHeaders;
+		}
+	}
+}
+
+/**
+ * Removes all results, the base and the dependency log.
+ */
+void
+TargetPrefetcher::Clear()
+{
+	fFileStatuses.Clear();
+	fScanResults.clear();
+	fBase = nullptr;
+	fBaseDirectory.clear();
+	fDependencyLog = nullptr;
+}
+
+/**
+ * Gets the headers the HDRSCAN \a pattern finds in the file at \a path, one
+ * per matching group per line. Returns false, if the file cannot be opened.
+ */
+bool
+TargetPrefetcher::ScanForHeaders(
+	const char* path,
+	const data::String& pattern,
+	std::vector<std::string>& _headers
+)
+{
+	std::string patternString = pattern.ToStlString();
+	if (const ScanResult* result = _CachedScanResult(path, patternString)) {
+		sCacheHitsMetric.Increment();
+		_headers = result->fHeaders;
+		return result->fOpened;
+	}
+
+	sCacheMissesMetric.Increment();
+	data::RegExp regExp(pattern.ToCString());
+	ScanResult& result = fScanResults[ScanKey(path, patternString)];
+	result.fOpened = _ScanFile(path, regExp, result.fHeaders);
+	_headers = result.fHeaders;
+	return result.fOpened;
+}
+
+void
+TargetPrefetcher::AddScanResult(
+	const std::string& path,
+	const std::string& pattern,
+	const ScanResult& result
+)
+{
+	fScanResults[ScanKey(path, pattern)] = result;
+}
+
+/**
+ * Removes the file status of \a path and the results of scanning it.
+ */
+void
+TargetPrefetcher::Remove(const std::string& path)
+{
+	fFileStatuses.Remove(path);
+
+	ScanResultMap::iterator it =
+		fScanResults.lower_bound(ScanKey(path, std::string()));
+	while (it != fScanResults.end() && it->first.first == path)
+		it = fScanResults.erase(it);
+}
+
+/**
+ * Binds the target of \a task like TargetBinder::Bind() and scans the file it
+ * is bound to, if it exists and there is a pattern. Runs on a worker thread.
+ */
+void
+TargetPrefetcher::_RunTask(Task& task) const
+{
+	try {
+		for (const std::string& path : task.fPaths) {
+			data::FileStatus status;
+			if (!fFileStatuses.GetCachedFileStatus(path.c_str(), status))
+				data::Path::GetFileStatus(path.c_str(), status);
+			task.fStatuses.push_back(status);
+			if (status.Exists())
+				break;
+		}
+
+		const data::FileStatus& status = task.fStatuses.back();
+		const std::string& path = task.fPaths[task.fStatuses.size() - 1];
+		bool logged = fDependencyLog != nullptr
+			&& fDependencyLog->HasEntry(path, status.LastModifiedTime());
+		if (task.fRegExp != nullptr && status.Exists() && !logged) {
+			if (const ScanResult* result =
+					_CachedScanResult(path, task.fPattern)) {
+				task.fOpened = result->fOpened;
+				task.fHeaders = result->fHeaders;
+			} else {
+				task.fOpened =
+					_ScanFile(path.c_str(), *task.fRegExp, task.fHeaders);
+			}
+			task.fScanned = true;
+		}
+	} catch (...) {
+		// the sequential pass will run into the problem again
+		task.fStatuses.clear();
+		task.fScanned = false;
+	}
+}
+
+/**
+ * Returns the result of scanning the file at \a path with \a pattern, if it
+ * is known already.
+ */
+const TargetPrefetcher::ScanResult*
+TargetPrefetcher::_CachedScanResult(
+	const std::string& path,
+	const std::string& pattern
+) const
+{
+	ScanResultMap::const_iterator it =
+		fScanResults.find(ScanKey(path, pattern));
+	if (it != fScanResults.end())
+		return &it->second;
+
+	if (fBase == nullptr)
+		return nullptr;
+
+	std::string basePath =
+		path[0] == '/' ? path : fBaseDirectory + '/' + path;
+	it = fBase->fScanResults.find(ScanKey(basePath, pattern));
+	return it != fBase->fScanResults.end() ? &it->second : nullptr;
+}
+
+/*static*/ bool
+TargetPrefetcher::_ScanFile(
+	const char* path,
+	const data::RegExp& regExp,
+	std::vector<std::string>& _headers
+)
+{
+	sHeadersScannedMetric.Increment();
+
+	std::ifstream file(path);
+	if (file.fail())
+		return false;
+
+	std::string line;
+	while (std::getline(file, line)) {
+		data::RegExp::MatchResult result = regExp.Match(line.c_str());
+		if (result.HasMatched()) {
+			size_t groupCount = result.GroupCount();
+			for (size_t i = 0; i < groupCount; i++) {
+				size_t startOffset = result.GroupStartOffsetAt(i);
+				size_t endOffset = result.GroupEndOffsetAt(i);
+				if (endOffset > startOffset) {
+					_headers.push_back(
+						line.substr(startOffset, endOffset - startOffset)
+					);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+} // namespace ham::make
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_MAKE_TARGET_PREFETCHER_HPP
+#define HAM_MAKE_TARGET_PREFETCHER_HPP
+
+#include "data/FileStatusCache.hpp"
+#include "data/RegExp.hpp"
+#include "data/Target.hpp"
+#include "data/VariableDomain.hpp"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ham::make
+{
+
+class DependencyLog;
+
+/**
+ * Does the file system work of preparing the targets -- looking up the file
+ * status of the paths they may be bound to and scanning their files for
+ * headers -- ahead on worker threads.
+ *
+ * Prefetch() walks the targets reachable from the primary targets and
+ * computes the paths and header scan patterns from the current variables.
+ * The results are only used to answer the same questions later: the file
+ * status of a path and the headers found in a file with a pattern. Everything
+ * that evaluates Jam code, in particular HDRRULE, still happens sequentially
+ * when the targets are prepared, so the outcome is the same as without
+ * prefetching. When a guess is wrong, e.g. because an HDRRULE has changed the
+ * SEARCH path of a target, the lookup simply misses and is done on the spot.
+ * Lookups done on the spot are added, too.
+ *
+ * A base prefetcher, like the one the daemon keeps the results of earlier
+ * builds in, is consulted before doing anything. Its results are keyed by
+ * absolute paths, relative paths are looked up in the given directory.
+ *
+ * Files the dependency log has valid headers for aren't scanned, since the
+ * sequential pass uses those instead.
+ */
+class TargetPrefetcher
+{
+  public:
+	struct ScanResult {
+		bool fOpened;
+		std::vector<std::string> fHeaders;
+	};
+
+	typedef std::pair<std::string, std::string> ScanKey;
+	// path and pattern
+	typedef std::map<ScanKey, ScanResult> ScanResultMap;
+
+  public:
+	TargetPrefetcher();
+
+	void SetBase(const TargetPrefetcher* base, const std::string& directory);
+	void SetDependencyLog(const DependencyLog* log) { fDependencyLog = log; }
+
+	void Prefetch(
+		size_t threadCount,
+		const data::VariableDomain& globalVariables,
+		const std::vector<data::Target*>& roots
+	);
+	void Clear();
+
+	const data::FileStatusCache& FileStatuses() const { return fFileStatuses; }
+	const ScanResultMap& ScanResults() const { return fScanResults; }
+
+	bool ScanForHeaders(
+		const char* path,
+		const data::String& pattern,
+		std::vector<std::string>& _headers
+	);
+
+	void AddFileStatus(const std::string& path, const data::FileStatus& status)
+	{
+		fFileStatuses.Add(path, status);
+	}
+	void AddScanResult(
+		const std::string& path,
+		const std::string& pattern,
+		const ScanResult& result
+	);
+	void Remove(const std::string& path);
+
+  private:
+	struct Task {
+		std::vector<std::string> fPaths;
+		std::string fPattern;
+		const data::RegExp* fRegExp;
+		// the compiled HDRSCAN pattern, if any
+		std::vector<data::FileStatus> fStatuses;
+		// of the paths looked up, the last one is the bound path
+		bool fScanned;
+		bool fOpened;
+		std::vector<std::string> fHeaders;
+	};
+
+  private:
+	void _RunTask(Task& task) const;
+	const ScanResult* _CachedScanResult(
+		const std::string& path,
+		const std::string& pattern
+	) const;
+	static bool _ScanFile(
+		const char* path,
+		const data::RegExp& regExp,
+		std::vector<std::string>& _headers
+	);
+
+  private:
+	data::FileStatusCache fFileStatuses;
+	ScanResultMap fScanResults;
+	const TargetPrefetcher* fBase;
+	std::string fBaseDirectory;
+	const DependencyLog* fDependencyLog;
+};
+
+} // namespace ham::make
+
+#endif // HAM_MAKE_TARGET_PREFETCHER_HPP
@@ -0,0 +1,279 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "parser/Lexer.hpp"
+
+#include <ctype.h>
+#include <string.h>
+#include <string_view>
+
+namespace ham::parser
+{
+
+static inline bool
+is_space(char c)
+{
+	return isspace((unsigned char)c) != 0;
+}
+
+size_t
+Lexer::StringPartHash::operator()(const data::StringPart& string) const
+{
+	return std::hash<std::string_view>()(
+		std::string_view(string.Start(), string.Length())
+	);
+}
+
+Lexer::Lexer()
+	: fPosition(nullptr),
+	  fEnd(nullptr),
+	  fLineStart(nullptr),
+	  fLinesCountedEnd(nullptr),
+	  fLine(0),
+	  fCurrentToken(),
+	  fIdentifiers(),
+	  fFilePosition()
+{
+	_AddKeyword(";", TOKEN_SEMICOLON);
+	_AddKeyword(":", TOKEN_COLON);
+	_AddKeyword("[", TOKEN_LEFT_BRACKET);
+	_AddKeyword("]", TOKEN_RIGHT_BRACKET);
+	_AddKeyword("{", TOKEN_LEFT_BRACE);
+	_AddKeyword("}", TOKEN_RIGHT_BRACE);
+	_AddKeyword("(", TOKEN_LEFT_PARENTHESIS);
+	_AddKeyword(")", TOKEN_RIGHT_PARENTHESIS);
+	_AddKeyword("=", TOKEN_ASSIGN);
+	_AddKeyword("+=", TOKEN_ASSIGN_PLUS);
+	_AddKeyword("?=", TOKEN_ASSIGN_DEFAULT);
+	_AddKeyword("|", TOKEN_OR);
+	_AddKeyword("||", TOKEN_OR);
+	_AddKeyword("&", TOKEN_AND);
+	_AddKeyword("&&", TOKEN_AND);
+	_AddKeyword("!=", TOKEN_NOT_EQUAL);
+	_AddKeyword("<", TOKEN_LESS);
+	_AddKeyword("<=", TOKEN_LESS_OR_EQUAL);
+	_AddKeyword(">", TOKEN_GREATER);
+	_AddKeyword(">=", TOKEN_GREATER_OR_EQUAL);
+	_AddKeyword("!", TOKEN_NOT);
+
+	_AddKeyword("actions", TOKEN_ACTIONS);
+	_AddKeyword("bind", TOKEN_BIND);
+	_AddKeyword("break", TOKEN_BREAK);
+	_AddKeyword("case", TOKEN_CASE);
+	_AddKeyword("continue", TOKEN_CONTINUE);
+	_AddKeyword("else", TOKEN_ELSE);
+	_AddKeyword("for", TOKEN_FOR);
+	_AddKeyword("if", TOKEN_IF);
+	_AddKeyword("in", TOKEN_IN);
+	_AddKeyword("include", TOKEN_INCLUDE);
+	_AddKeyword("jumptoeof", TOKEN_JUMPTOEOF);
+	_AddKeyword("local", TOKEN_LOCAL);
+	_AddKeyword("on", TOKEN_ON);
+	_AddKeyword("return", TOKEN_RETURN);
+	_AddKeyword("rule", TOKEN_RULE);
+	_AddKeyword("switch", TOKEN_SWITCH);
+	_AddKeyword("while", TOKEN_WHILE);
+}
+
+void
+Lexer::Init(const char* start, const char* end)
+{
+	fPosition = start;
+	fEnd = end;
+	fLineStart = start;
+	fLinesCountedEnd = start;
+	fLine = 0;
+
+	fFilePosition.SetTo(0, 0);
+
+	_ReadNextToken();
+}
+
+data::String
+Lexer::ScanActions()
+{
+	// read until we find an unmatched closing brace
+	// TODO: This algorithm needs to be improved! We don't recognize braces
+	// in comments, strings, or quoted braces.
+	const char* start = fPosition;
+	int braces = 0;
+	for (; fPosition != fEnd; ++fPosition) {
+		char c = *fPosition;
+		if (c == '{') {
+			braces++;
+		} else if (c == '}') {
+			if (--braces < 0)
+				break;
+		}
+	}
+
+	if (braces >= 0)
+		throw LexException("Unterminated actions", fFilePosition);
+
+	return data::String(start, fPosition - start);
+}
+
+void
+Lexer::_AddKeyword(const char* keyword, TokenID id)
+{
+	data::String string(keyword);
+	fIdentifiers.emplace(string, Identifier{string, id});
+}
+
+/**
+ * Returns the identifier for \a string, adding it, if it hasn't been seen
+ * before. The key of the entry refers to the identifier's string, so it
+ * remains valid after the input buffer is gone.
+ */
+const Lexer::Identifier&
+Lexer::_Intern(const data::StringPart& string)
+{
+	IdentifierMap::iterator it = fIdentifiers.find(string);
+	if (it != fIdentifiers.end())
+		return it->second;
+
+	data::String value(string);
+	return fIdentifiers.emplace(value, Identifier{value, TOKEN_STRING})
+		.first->second;
+}
+
+void
+Lexer::_SkipWhiteSpace()
+{
+	while (true) {
+		// skip whitespace
+		while (fPosition != fEnd && is_space(*fPosition))
+			++fPosition;
+
+		if (fPosition == fEnd || *fPosition != '#')
+			break;
+
+		// skip comment
+		fPosition = (const char*)memchr(fPosition, '\n', fEnd - fPosition);
+		if (fPosition == nullptr)
+			fPosition = fEnd;
+	}
+}
+
+/**
+ * Sets the file position to the current position. Lines are counted lazily,
+ * only when a token starts, so scanning doesn't have to check each character
+ * for a line break.
+ */
+void
+Lexer::_UpdateFilePosition()
+{
+	while (const char* lineEnd = (const char*)memchr(
+			   fLinesCountedEnd,
+			   '\n',
+			   fPosition - fLinesCountedEnd
+		   )) {
+		fLine++;
+		fLineStart = lineEnd + 1;
+		fLinesCountedEnd = fLineStart;
+	}
+	fLinesCountedEnd = fPosition;
+
+	fFilePosition.SetTo(fLine, fPosition - fLineStart);
+}
+
+void
+Lexer::_ReadNextToken()
+{
+	_SkipWhiteSpace();
+	_UpdateFilePosition();
+
+	if (fPosition == fEnd) {
+		fCurrentToken.SetTo(TOKEN_EOF, data::String());
+		return;
+	}
+
+	const char* start = fPosition;
+	while (fPosition != fEnd) {
+		char c = *fPosition;
+		if (is_space(c))
+			break;
+
+		if (c == '\\' || c == '"') {
+			_ReadQuotedOrEscapedToken(start);
+			return;
+		}
+
+		++fPosition;
+	}
+
+	const Identifier& identifier = _Intern(data::StringPart(start, fPosition));
+	fCurrentToken.SetTo(identifier.fID, identifier.fString);
+}
+
+/**
+ * Reads the rest of a token starting at \a start, which contains a quoted
+ * substring or an escaped character at the current position. Such a token is
+ * never a keyword.
+ */
+void
+Lexer::_ReadQuotedOrEscapedToken(const char* start)
+{
+	data::StringBuffer token;
+	token.Append(start, fPosition - start);
+
+	while (fPosition != fEnd) {
+		char c = *fPosition;
+		if (is_space(c))
+			break;
+
+		++fPosition;
+
+		if (c == '\\') {
+			// escaped char
+			if (fPosition == fEnd)
+				throw LexException("Backslash at end of file", fFilePosition);
+
+			// fetch the escaped char
+			c = *fPosition;
+			++fPosition;
+		} else if (c == '"') {
+			// quoted (sub)string, loop until we find the terminating quotes
+			bool foundEnd = false;
+			while (fPosition != fEnd) {
+				c = *fPosition;
+				++fPosition;
+
+				if (c == '"') {
+					foundEnd = true;
+					break;
+				}
+
+				if (c == '\\') {
+					// escaped char
+					if (fPosition == fEnd) {
+						// will throw after the loop
+						break;
+					}
+
+					c = *fPosition;
+					++fPosition;
+				}
+
+				token += c;
+			}
+
+			if (!foundEnd) {
+				throw LexException(
+					"Unterminated string literal",
+					fFilePosition
+				);
+			}
+
+			continue;
+		}
+
+		token += c;
+	}
+
+	fCurrentToken.SetTo(TOKEN_STRING, token);
+}
+
+} // namespace ham::parser
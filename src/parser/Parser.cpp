@@ -27,11 +27,11 @@
 #include "code/While.hpp"
 #include "data/RuleActions.hpp"
 #include "parser/ParseException.hpp"
+#include "util/MappedFile.hpp"
 
 #include <fstream>
 #include <iostream>
 #include <memory>
-#include <sstream>
 #include <stdlib.h>
 #include <string.h>
 
@@ -51,6 +51,8 @@ class ActionsFlagMap : public std::map<data::String, uint32_t>
 		(*this)["quietly"] = data::RuleActions::QUIETLY;
 		(*this)["piecemeal"] = data::RuleActions::PIECEMEAL;
 		(*this)["existing"] = data::RuleActions::EXISTING;
+		(*this)["response"] = data::RuleActions::RESPONSE;
+		(*this)["restat"] = data::RuleActions::RESTAT;
 		(*this)["maxline"] = data::RuleActions::MAX_LINE_FACTOR;
 	}
 };
@@ -172,48 +174,45 @@ Parser::Parser()
 {
 }
 
+code::Block*
+Parser::Parse(const char* start, const char* end)
+{
+	fLexer.Init(start, end);
+	return _ParseFile();
+}
+
 code::Block*
 Parser::Parse(const std::string& input)
 {
-	std::istringstream stream(input);
-	return Parse(stream);
+	return Parse(input.data(), input.data() + input.size());
 }
 
 code::Block*
 Parser::Parse(std::istream& input)
 {
-	bool skipWhiteSpace = (input.flags() & std::ios_base::skipws) != 0;
-	try {
-		std::noskipws(input);
-		code::Block* result =
-			Parse(InputIteratorType(input), InputIteratorType());
-		if (skipWhiteSpace)
-			std::skipws(input);
-		return result;
-	} catch (...) {
-		if (skipWhiteSpace)
-			std::skipws(input);
-		throw;
-	}
+	std::string data(
+		(std::istreambuf_iterator<char>(input)),
+		std::istreambuf_iterator<char>()
+	);
+	return Parse(data);
 }
 
 code::Block*
 Parser::Parse(const InputIteratorType& start, const InputIteratorType& end)
 {
-	fLexer.Init(start, end);
-	return _ParseFile();
+	return Parse(std::string(start, end));
 }
 
 code::Block*
 Parser::ParseFile(const char* fileName)
 {
-	std::ifstream input(fileName);
-	if (input.fail()) {
+	util::MappedFile file;
+	if (!file.Open(fileName)) {
 		_Throw((std::string("Failed to open file \"") + fileName + "\"").c_str()
 		);
 	}
 
-	return Parse(input);
+	return Parse(file.Data(), file.End());
 }
 
 void
@@ -36,6 +36,7 @@ class Parser
 	void SetFileName(const std::string& fileName) { fFileName = fileName; }
 	// used for exceptions only
 
+	code::Block* Parse(const char* start, const char* end);
 	code::Block* Parse(const std::string& input);
 	code::Block* Parse(std::istream& input);
 	code::Block*
@@ -45,7 +46,7 @@ class Parser
 	void Test(int argc, const char* const* argv);
 
   private:
-	typedef parser::Lexer<InputIteratorType> LexerType;
+	typedef parser::Lexer LexerType;
 
 	class NodeListContainer;
 	class ListenerNotifier;
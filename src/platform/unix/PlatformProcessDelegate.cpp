@@ -8,15 +8,23 @@
 #include "process/ChildInfo.hpp"
 
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+extern char** environ;
+
 namespace ham::process
 {
 
+// room for the other arguments and for variables added to the environment
+// later, e.g. MAKEFLAGS
+static const size_t kCommandLineHeadroom = 4096;
+
 PlatformProcessDelegate::PlatformProcessDelegate()
 	: fPid(-1)
 {
@@ -56,11 +64,12 @@ PlatformProcessDelegate::Launch(
 }
 
 /*static*/ bool
-PlatformProcessDelegate::WaitForChild(ChildInfo& _childInfo)
+PlatformProcessDelegate::WaitForChild(ChildInfo& _childInfo, bool wait)
 {
 	int status;
-	pid_t pid = wait(&status);
-	if (pid < 0)
+	struct rusage usage;
+	pid_t pid = wait4(-1, &status, wait ? 0 : WNOHANG, &usage);
+	if (pid <= 0)
 		return false;
 
 	if (WIFEXITED(status))
@@ -72,7 +81,37 @@ PlatformProcessDelegate::WaitForChild(ChildInfo& _childInfo)
 
 	_childInfo.fId = pid;
 	_childInfo.fExited = true;
+	// The maximum resident set size of the child and of the descendants it
+	// waited for, in kilobytes.
+	// TODO: Platform specific! macOS uses bytes.
+	_childInfo.fPeakMemory = (size_t)usage.ru_maxrss * 1024;
 	return true;
 }
 
+/*static*/ size_t
+PlatformProcessDelegate::MaxCommandLineLength()
+{
+	// The arguments share ARG_MAX with the environment.
+	long argMax = sysconf(_SC_ARG_MAX);
+	if (argMax <= 0)
+		argMax = _POSIX_ARG_MAX;
+
+	size_t environmentSize = 0;
+	for (char** variable = environ; *variable != nullptr; variable++)
+		environmentSize += strlen(*variable) + 1 + sizeof(char*);
+
+	size_t reserved = environmentSize + kCommandLineHeadroom;
+	size_t length = (size_t)argMax > reserved ? (size_t)argMax - reserved : 0;
+
+#ifdef __linux__
+	// Linux also limits the length of a single argument to MAX_ARG_STRLEN,
+	// i.e. 32 pages, including the terminating null.
+	size_t maxArgumentLength = (size_t)sysconf(_SC_PAGESIZE) * 32 - 1;
+	if (length > maxArgumentLength)
+		length = maxArgumentLength;
+#endif
+
+	return length;
+}
+
 } // namespace ham::process
@@ -32,7 +32,9 @@ class PlatformProcessDelegate
 
 	Id GetId() const { return fPid; }
 
-	static bool WaitForChild(ChildInfo& _childInfo);
+	static bool WaitForChild(ChildInfo& _childInfo, bool wait);
+
+	static size_t MaxCommandLineLength();
 
   private:
 	pid_t fPid;
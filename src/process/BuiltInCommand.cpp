@@ -0,0 +1,524 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "process/BuiltInCommand.hpp"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// TODO: Platform specific!
+
+namespace ham::process
+{
+
+typedef std::vector<std::string> Operands;
+
+struct Utility {
+	const char* name;
+	const char* options;
+	// the supported ones
+	const char* requiredOptions;
+	size_t minOperandCount;
+	size_t maxOperandCount;
+	bool (*execute)(const std::string& options, const Operands& operands);
+};
+
+static void
+print_error(const char* utility, const char* format, const std::string& path)
+{
+	int error = errno;
+	fprintf(stderr, "%s: ", utility);
+	fprintf(stderr, format, path.c_str());
+	fprintf(stderr, ": %s\n", strerror(error));
+}
+
+static bool
+is_directory(const std::string& path)
+{
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/**
+ * Returns the path of the entry named like \a path's leaf in \a directory.
+ */
+static std::string
+path_in_directory(const std::string& directory, const std::string& path)
+{
+	size_t end = path.find_last_not_of('/');
+	if (end == std::string::npos)
+		return directory;
+
+	size_t slash = path.rfind('/', end);
+	size_t start = slash == std::string::npos ? 0 : slash + 1;
+	return directory + "/" + path.substr(start, end + 1 - start);
+}
+
+static bool
+make_directory(const std::string& path, bool parents)
+{
+	if (parents) {
+		for (size_t slash = path.find('/', 1);
+			 slash != std::string::npos;
+			 slash = path.find('/', slash + 1)) {
+			std::string ancestor = path.substr(0, slash);
+			if (mkdir(ancestor.c_str(), 0777) != 0 && errno != EEXIST) {
+				print_error("mkdir", "cannot create directory '%s'", ancestor);
+				return false;
+			}
+		}
+	}
+
+	if (mkdir(path.c_str(), 0777) == 0)
+		return true;
+	if (parents && errno == EEXIST && is_directory(path))
+		return true;
+
+	print_error("mkdir", "cannot create directory '%s'", path);
+	return false;
+}
+
+static bool
+make_directories(const std::string& options, const Operands& operands)
+{
+	bool parents = options.find('p') != std::string::npos;
+	bool succeeded = true;
+	for (const std::string& path : operands) {
+		if (!make_directory(path, parents))
+			succeeded = false;
+	}
+
+	return succeeded;
+}
+
+static bool
+remove_files(const std::string& /*options*/, const Operands& operands)
+{
+	// Only "rm -f" is supported, which ignores missing files.
+	bool succeeded = true;
+	for (const std::string& path : operands) {
+		if (unlink(path.c_str()) != 0 && errno != ENOENT && errno != ENOTDIR) {
+			print_error("rm", "cannot remove '%s'", path);
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
+
+static bool
+copy_data(
+	int sourceFd,
+	const std::string& source,
+	int targetFd,
+	const std::string& target
+)
+{
+	char buffer[64 * 1024];
+	for (;;) {
+		ssize_t bytesRead = read(sourceFd, buffer, sizeof(buffer));
+		if (bytesRead < 0) {
+			if (errno == EINTR)
+				continue;
+			print_error("cp", "error reading '%s'", source);
+			return false;
+		}
+		if (bytesRead == 0)
+			return true;
+
+		const char* remainder = buffer;
+		while (bytesRead > 0) {
+			ssize_t bytesWritten = write(targetFd, remainder, bytesRead);
+			if (bytesWritten < 0) {
+				if (errno == EINTR)
+					continue;
+				print_error("cp", "error writing '%s'", target);
+				return false;
+			}
+
+			remainder += bytesWritten;
+			bytesRead -= bytesWritten;
+		}
+	}
+}
+
+static bool
+copy_file(const std::string& source, const std::string& target, bool force)
+{
+	int sourceFd = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+	if (sourceFd < 0) {
+		const char* format = errno == ENOENT
+			? "cannot stat '%s'"
+			: "cannot open '%s' for reading";
+		print_error("cp", format, source);
+		return false;
+	}
+
+	struct stat sourceStat;
+	if (fstat(sourceFd, &sourceStat) != 0) {
+		print_error("cp", "cannot stat '%s'", source);
+		close(sourceFd);
+		return false;
+	}
+
+	if (S_ISDIR(sourceStat.st_mode)) {
+		fprintf(
+			stderr,
+			"cp: -r not specified; omitting directory '%s'\n",
+			source.c_str()
+		);
+		close(sourceFd);
+		return false;
+	}
+
+	struct stat targetStat;
+	if (stat(target.c_str(), &targetStat) == 0
+		&& targetStat.st_dev == sourceStat.st_dev
+		&& targetStat.st_ino == sourceStat.st_ino) {
+		fprintf(
+			stderr,
+			"cp: '%s' and '%s' are the same file\n",
+			source.c_str(),
+			target.c_str()
+		);
+		close(sourceFd);
+		return false;
+	}
+
+	// Like cp, keep the permissions of an existing target and give a new one
+	// the source's.
+	int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+	mode_t mode = sourceStat.st_mode & 0777;
+	int targetFd = open(target.c_str(), flags, mode);
+	if (targetFd < 0 && force && errno != ENOENT
+		&& unlink(target.c_str()) == 0) {
+		targetFd = open(target.c_str(), flags, mode);
+	}
+	if (targetFd < 0) {
+		print_error("cp", "cannot create regular file '%s'", target);
+		close(sourceFd);
+		return false;
+	}
+
+	bool succeeded = copy_data(sourceFd, source, targetFd, target);
+	close(sourceFd);
+	if (close(targetFd) != 0 && succeeded) {
+		print_error("cp", "error writing '%s'", target);
+		succeeded = false;
+	}
+
+	return succeeded;
+}
+
+static bool
+copy_files(const std::string& options, const Operands& operands)
+{
+	bool force = options.find('f') != std::string::npos;
+	const std::string& target = operands.back();
+	if (!is_directory(target)) {
+		if (operands.size() > 2) {
+			fprintf(
+				stderr,
+				"cp: target '%s' is not a directory\n",
+				target.c_str()
+			);
+			return false;
+		}
+
+		return copy_file(operands[0], target, force);
+	}
+
+	bool succeeded = true;
+	for (size_t i = 0; i + 1 < operands.size(); i++) {
+		std::string path = path_in_directory(target, operands[i]);
+		if (!copy_file(operands[i], path, force))
+			succeeded = false;
+	}
+
+	return succeeded;
+}
+
+static bool
+touch_files(const std::string& /*options*/, const Operands& operands)
+{
+	bool succeeded = true;
+	for (const std::string& path : operands) {
+		// Create the file, if missing. Set the time in any case, so it works
+		// for directories, too.
+		int fd = open(
+			path.c_str(),
+			O_WRONLY | O_CREAT | O_NONBLOCK | O_NOCTTY | O_CLOEXEC,
+			0666
+		);
+		int openError = fd < 0 ? errno : 0;
+		if (fd >= 0)
+			close(fd);
+
+		if (utimensat(AT_FDCWD, path.c_str(), nullptr, 0) != 0) {
+			if (openError != 0)
+				errno = openError;
+			print_error("touch", "cannot touch '%s'", path);
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
+
+static bool
+link_file(const std::string& options, const Operands& operands)
+{
+	bool symbolic = options.find('s') != std::string::npos;
+	bool force = options.find('f') != std::string::npos;
+	const std::string& source = operands[0];
+	std::string target = operands[1];
+	if (is_directory(target))
+		target = path_in_directory(target, source);
+
+	if (force && unlink(target.c_str()) != 0 && errno != ENOENT) {
+		print_error("ln", "cannot remove '%s'", target);
+		return false;
+	}
+
+	if (symbolic) {
+		if (symlink(source.c_str(), target.c_str()) != 0) {
+			print_error("ln", "failed to create symbolic link '%s'", target);
+			return false;
+		}
+	} else if (link(source.c_str(), target.c_str()) != 0) {
+		print_error("ln", "failed to create hard link '%s'", target);
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+change_mode(const std::string& /*options*/, const Operands& operands)
+{
+	mode_t mode = strtoul(operands[0].c_str(), nullptr, 8);
+	bool succeeded = true;
+	for (size_t i = 1; i < operands.size(); i++) {
+		const std::string& path = operands[i];
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) {
+			print_error("chmod", "cannot access '%s'", path);
+			succeeded = false;
+			continue;
+		}
+
+		// Like chmod, don't clear the set-ID bits of directories.
+		mode_t newMode = mode;
+		if (S_ISDIR(st.st_mode))
+			newMode |= st.st_mode & (S_ISUID | S_ISGID);
+
+		if (chmod(path.c_str(), newMode) != 0) {
+			print_error("chmod", "changing permissions of '%s'", path);
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
+
+static const Utility kUtilities[] = {
+	{"mkdir", "p", "", 1, SIZE_MAX, &make_directories},
+	{"rm", "f", "f", 1, SIZE_MAX, &remove_files},
+	{"cp", "f", "", 2, SIZE_MAX, &copy_files},
+	{"touch", "", "", 1, SIZE_MAX, &touch_files},
+	{"ln", "sf", "", 2, 2, &link_file},
+	{"chmod", "", "", 2, SIZE_MAX, &change_mode},
+};
+
+/**
+ * Splits the \a arguments of a call into the options and the operands.
+ * Returns the utility called or null, if the call isn't supported.
+ */
+static const Utility*
+analyze_call(
+	const std::vector<std::string>& arguments,
+	std::string& _options,
+	Operands& _operands
+)
+{
+	const Utility* utility = nullptr;
+	for (const Utility& candidate : kUtilities) {
+		if (arguments[0] == candidate.name)
+			utility = &candidate;
+	}
+	if (utility == nullptr)
+		return nullptr;
+
+	size_t index = 1;
+	for (; index < arguments.size(); index++) {
+		const std::string& argument = arguments[index];
+		if (argument == "--") {
+			index++;
+			break;
+		}
+		if (argument.size() < 2 || argument[0] != '-')
+			break;
+
+		for (size_t i = 1; i < argument.size(); i++) {
+			if (strchr(utility->options, argument[i]) == nullptr)
+				return nullptr;
+		}
+		_options += argument.substr(1);
+	}
+
+	for (const char* option = utility->requiredOptions;
+		 *option != '\0';
+		 option++) {
+		if (_options.find(*option) == std::string::npos)
+			return nullptr;
+	}
+
+	_operands.assign(arguments.begin() + index, arguments.end());
+	if (_operands.size() < utility->minOperandCount
+		|| _operands.size() > utility->maxOperandCount) {
+		return nullptr;
+	}
+
+	// only numeric modes
+	if (utility->execute == &change_mode) {
+		const std::string& mode = _operands[0];
+		if (mode.empty() || mode.size() > 4
+			|| mode.find_first_not_of("01234567") != std::string::npos) {
+			return nullptr;
+		}
+	}
+
+	return utility;
+}
+
+/**
+ * Returns whether \a c means the same to the shell when unquoted.
+ */
+static bool
+is_plain_character(char c)
+{
+	return isalnum((unsigned char)c) || strchr("_-./+,:@%=", c) != nullptr;
+}
+
+BuiltInCommand::BuiltInCommand()
+	: fLines()
+{
+}
+
+/**
+ * Parses \a commandLine. Returns whether it can be executed without a shell.
+ */
+bool
+BuiltInCommand::Parse(const char* commandLine)
+{
+	fLines.clear();
+
+	Chain chain;
+	Arguments arguments;
+	std::string word;
+	bool inWord = false;
+	for (const char* c = commandLine;; c++) {
+		if (*c == '\'' || *c == '"') {
+			// Nothing may be expanded within double quotes.
+			const char* end = strchr(c + 1, *c);
+			if (end == nullptr
+				|| (*c == '"'
+					&& std::string(c + 1, end).find_first_of("$`\\")
+						!= std::string::npos)) {
+				fLines.clear();
+				return false;
+			}
+
+			word.append(c + 1, end);
+			inWord = true;
+			c = end;
+			continue;
+		}
+
+		if (*c != '\0' && is_plain_character(*c)) {
+			word += *c;
+			inWord = true;
+			continue;
+		}
+
+		if (inWord) {
+			arguments.push_back(word);
+			word.clear();
+			inWord = false;
+		}
+
+		if (*c == ' ' || *c == '\t')
+			continue;
+
+		if (*c == '&' && c[1] == '&' && !arguments.empty()) {
+			chain.push_back(arguments);
+			arguments.clear();
+			c++;
+			continue;
+		}
+
+		// Anything else but the end of a line is beyond us.
+		if ((*c != '\n' && *c != '\0')
+			|| (arguments.empty() && !chain.empty())) {
+			fLines.clear();
+			return false;
+		}
+
+		if (!arguments.empty()) {
+			chain.push_back(arguments);
+			arguments.clear();
+			fLines.push_back(chain);
+			chain.clear();
+		}
+
+		if (*c == '\0')
+			break;
+	}
+
+	for (const Chain& line : fLines) {
+		for (const Arguments& call : line) {
+			std::string options;
+			Operands operands;
+			if (analyze_call(call, options, operands) == nullptr) {
+				fLines.clear();
+				return false;
+			}
+		}
+	}
+
+	return !fLines.empty();
+}
+
+/**
+ * Executes the parsed command line. Like the shell, a failed call ends the
+ * chain it is part of, and the result of the last line is the exit status.
+ */
+int
+BuiltInCommand::Execute() const
+{
+	int exitCode = 0;
+	for (const Chain& line : fLines) {
+		exitCode = 0;
+		for (const Arguments& call : line) {
+			std::string options;
+			Operands operands;
+			const Utility* utility = analyze_call(call, options, operands);
+			if (!utility->execute(options, operands)) {
+				exitCode = 1;
+				break;
+			}
+		}
+	}
+
+	return exitCode;
+}
+
+} // namespace ham::process
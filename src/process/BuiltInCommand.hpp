@@ -0,0 +1,45 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_PROCESS_BUILT_IN_COMMAND_HPP
+#define HAM_PROCESS_BUILT_IN_COMMAND_HPP
+
+#include <string>
+#include <vector>
+
+namespace ham::process
+{
+
+/**
+ * A command line consisting of nothing but calls of simple file utilities --
+ * mkdir, rm -f, cp, touch, ln, and chmod with a numeric mode -- that can be
+ * executed without a shell.
+ *
+ * Parse() only accepts what a POSIX shell would execute the same way: one
+ * utility call per line or several chained with "&&", with words made of
+ * plain characters and quotes that don't contain anything to expand. Execute()
+ * performs the calls with system calls, reporting errors like the utilities
+ * would, and returns the exit status the shell would.
+ */
+class BuiltInCommand
+{
+  public:
+	BuiltInCommand();
+
+	bool Parse(const char* commandLine);
+
+	int Execute() const;
+
+  private:
+	typedef std::vector<std::string> Arguments;
+	typedef std::vector<Arguments> Chain;
+	// calls chained with "&&"
+
+  private:
+	std::vector<Chain> fLines;
+};
+
+} // namespace ham::process
+
+#endif // HAM_PROCESS_BUILT_IN_COMMAND_HPP
@@ -7,6 +7,8 @@
 
 #include "process/Process.hpp"
 
+#include <stddef.h>
+
 namespace ham::process
 {
 
@@ -16,6 +18,8 @@ class ChildInfo
 	Process::Id fId;
 	bool fExited;
 	int fExitCode;
+	size_t fPeakMemory;
+	// bytes, 0 if unknown
 };
 
 } // namespace ham::process
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "process/JobServer.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// TODO: Platform specific!
+
+namespace ham::process
+{
+
+/*static*/ const char* const JobServer::kMakeFlagsVariableName = "MAKEFLAGS";
+
+static const char* const kJobServerAuthOption = "--jobserver-auth=";
+static const char* const kJobServerOptions[] = {
+	kJobServerAuthOption,
+	"--jobserver-fds=", // before GNU make 4.2
+};
+static const char* const kFifoPrefix = "fifo:";
+
+static bool
+is_pipe(int fd)
+{
+	struct stat st;
+	return fd >= 0 && fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+/**
+ * Opens a non-blocking descriptor of its own for reading the pipe \a fd
+ * refers to. Returns -1, if that isn't possible.
+ */
+static int
+open_private_reader(int fd)
+{
+	// Opening the pipe via /dev/fd creates a new open file description on
+	// Linux, so making it non-blocking doesn't affect the other processes.
+	char path[32];
+	snprintf(path, sizeof(path), "/dev/fd/%d", fd);
+	int privateFd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (privateFd < 0)
+		return -1;
+
+	// Elsewhere the descriptor is merely duplicated and the flags are ignored.
+	if ((fcntl(privateFd, F_GETFL) & O_NONBLOCK) == 0) {
+		close(privateFd);
+		return -1;
+	}
+
+	return privateFd;
+}
+
+JobServer::JobServer()
+	: fReadFd(-1),
+	  fWriteFd(-1),
+	  fOwnedFds(),
+	  fReadFdIsPrivate(false),
+	  fIsServer(false),
+	  fHadMakeFlags(false),
+	  fOldMakeFlags(),
+	  fTokens()
+{
+}
+
+JobServer::~JobServer()
+{
+	ReleaseTokens();
+	_Unset();
+}
+
+/**
+ * Connects to the job server advertised in \a makeFlags, the value of the
+ * MAKEFLAGS environment variable. Returns false, if there is none or it
+ * cannot be used, e.g. because the parent make didn't pass the pipe on.
+ */
+bool
+JobServer::Connect(const char* makeFlags)
+{
+	_Unset();
+
+	std::string fifoPath;
+	int readFd;
+	int writeFd;
+	if (makeFlags == nullptr
+		|| !ParseMakeFlags(makeFlags, fifoPath, readFd, writeFd)) {
+		return false;
+	}
+
+	if (!fifoPath.empty()) {
+		int fd = open(fifoPath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+		if (!is_pipe(fd)) {
+			close(fd);
+			return false;
+		}
+
+		fReadFd = fd;
+		fWriteFd = fd;
+		fOwnedFds.push_back(fd);
+		fReadFdIsPrivate = true;
+		return true;
+	}
+
+	if (!is_pipe(readFd) || !is_pipe(writeFd))
+		return false;
+
+	fWriteFd = writeFd;
+	fReadFd = open_private_reader(readFd);
+	if (fReadFd >= 0) {
+		fOwnedFds.push_back(fReadFd);
+		fReadFdIsPrivate = true;
+	} else
+		fReadFd = readFd;
+
+	return true;
+}
+
+/**
+ * Creates a job server for \a jobCount jobs and advertises it in MAKEFLAGS to
+ * the processes started afterwards. The previous value of MAKEFLAGS is
+ * restored when the object is destroyed.
+ */
+bool
+JobServer::Create(size_t jobCount)
+{
+	_Unset();
+
+	int fds[2];
+	if (pipe(fds) != 0)
+		return false;
+
+	// the children inherit these
+	fReadFd = fds[0];
+	fWriteFd = fds[1];
+	fOwnedFds.push_back(fds[0]);
+	fOwnedFds.push_back(fds[1]);
+
+	for (size_t i = 1; i < jobCount; i++) {
+		char token = '+';
+		if (write(fWriteFd, &token, 1) != 1) {
+			_Unset();
+			return false;
+		}
+	}
+
+	int privateFd = open_private_reader(fds[0]);
+	if (privateFd >= 0) {
+		fReadFd = privateFd;
+		fOwnedFds.push_back(privateFd);
+		fReadFdIsPrivate = true;
+	}
+
+	const char* oldMakeFlags = getenv(kMakeFlagsVariableName);
+	fHadMakeFlags = oldMakeFlags != nullptr;
+	fOldMakeFlags = fHadMakeFlags ? oldMakeFlags : "";
+
+	// The new option comes last, so it overrides any the parent passed on.
+	char option[64];
+	snprintf(
+		option,
+		sizeof(option),
+		" -j%zu %s%d,%d",
+		jobCount,
+		kJobServerAuthOption,
+		fds[0],
+		fds[1]
+	);
+	setenv(kMakeFlagsVariableName, (fOldMakeFlags + option).c_str(), 1);
+	fIsServer = true;
+	return true;
+}
+
+/**
+ * Takes a token from the job server without waiting. Returns false, if there
+ * is none at the moment.
+ */
+bool
+JobServer::AcquireToken()
+{
+	if (!IsValid())
+		return false;
+
+	char token;
+	ssize_t bytesRead;
+	if (fReadFdIsPrivate) {
+		bytesRead = read(fReadFd, &token, 1);
+	} else {
+		// The descriptor is shared with other processes, so it is only made
+		// non-blocking for the read, after checking that there is a token.
+		// Another process may still take the token before us.
+		struct pollfd pollFd;
+		pollFd.fd = fReadFd;
+		pollFd.events = POLLIN;
+		pollFd.revents = 0;
+		if (poll(&pollFd, 1, 0) <= 0 || (pollFd.revents & POLLIN) == 0)
+			return false;
+
+		int flags = fcntl(fReadFd, F_GETFL);
+		if (flags < 0 || fcntl(fReadFd, F_SETFL, flags | O_NONBLOCK) != 0)
+			return false;
+		bytesRead = read(fReadFd, &token, 1);
+		fcntl(fReadFd, F_SETFL, flags);
+	}
+
+	if (bytesRead != 1)
+		return false;
+
+	fTokens.push_back(token);
+	return true;
+}
+
+/**
+ * Returns the token taken last to the job server.
+ */
+void
+JobServer::ReleaseToken()
+{
+	if (fTokens.empty())
+		return;
+
+	char token = fTokens.back();
+	fTokens.pop_back();
+	while (write(fWriteFd, &token, 1) < 0 && errno == EINTR)
+		;
+}
+
+void
+JobServer::ReleaseTokens()
+{
+	while (!fTokens.empty())
+		ReleaseToken();
+}
+
+/**
+ * Gets the job server from \a makeFlags. The last --jobserver-auth (or the
+ * older --jobserver-fds) option counts. Sets \a _fifoPath for a named pipe,
+ * \a _readFd and \a _writeFd otherwise. Returns false, if there is no job
+ * server or the option is malformed.
+ */
+/*static*/ bool
+JobServer::ParseMakeFlags(
+	const char* makeFlags,
+	std::string& _fifoPath,
+	int& _readFd,
+	int& _writeFd
+)
+{
+	std::string value;
+	bool found = false;
+	const char* word = makeFlags;
+	for (;;) {
+		while (*word == ' ' || *word == '\t')
+			word++;
+		if (*word == '\0')
+			break;
+
+		const char* wordEnd = word;
+		while (*wordEnd != '\0' && *wordEnd != ' ' && *wordEnd != '\t')
+			wordEnd++;
+
+		for (const char* option : kJobServerOptions) {
+			size_t optionLength = strlen(option);
+			if ((size_t)(wordEnd - word) >= optionLength
+				&& strncmp(word, option, optionLength) == 0) {
+				value.assign(word + optionLength, wordEnd);
+				found = true;
+			}
+		}
+
+		word = wordEnd;
+	}
+
+	if (!found)
+		return false;
+
+	size_t fifoPrefixLength = strlen(kFifoPrefix);
+	if (value.compare(0, fifoPrefixLength, kFifoPrefix) == 0) {
+		if (value.size() == fifoPrefixLength)
+			return false;
+		_fifoPath = value.substr(fifoPrefixLength);
+		return true;
+	}
+
+	int readFd;
+	int writeFd;
+	int length;
+	if (sscanf(value.c_str(), "%d,%d%n", &readFd, &writeFd, &length) != 2
+		|| (size_t)length != value.size() || readFd < 0 || writeFd < 0) {
+		return false;
+	}
+
+	_fifoPath.clear();
+	_readFd = readFd;
+	_writeFd = writeFd;
+	return true;
+}
+
+void
+JobServer::_Unset()
+{
+	if (fIsServer) {
+		if (fHadMakeFlags)
+			setenv(kMakeFlagsVariableName, fOldMakeFlags.c_str(), 1);
+		else
+			unsetenv(kMakeFlagsVariableName);
+	}
+
+	for (int fd : fOwnedFds)
+		close(fd);
+
+	fReadFd = -1;
+	fWriteFd = -1;
+	fOwnedFds.clear();
+	fReadFdIsPrivate = false;
+	fIsServer = false;
+	fHadMakeFlags = false;
+	fOldMakeFlags.clear();
+	fTokens.clear();
+}
+
+} // namespace ham::process
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_PROCESS_JOB_SERVER_HPP
+#define HAM_PROCESS_JOB_SERVER_HPP
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace ham::process
+{
+
+/**
+ * GNU make compatible job server.
+ *
+ * A job server is a pipe holding one token (a byte) per job that may run in
+ * addition to the one every process sharing the server may always run. A
+ * process takes a token before starting another job and puts it back when the
+ * job is done, so that all processes together never run more jobs than the
+ * top-level one was asked to.
+ *
+ * Connect() makes this object a client of the job server a parent make (or
+ * ham) advertises in MAKEFLAGS, either as a named pipe ("fifo:<path>") or as
+ * a pair of inherited file descriptors ("<read>,<write>"). Create() makes it
+ * the server: it creates a pipe with the tokens and advertises it to the child
+ * processes in MAKEFLAGS.
+ */
+class JobServer
+{
+  public:
+	static const char* const kMakeFlagsVariableName;
+
+  public:
+	JobServer();
+	~JobServer();
+
+	bool Connect(const char* makeFlags);
+	bool Create(size_t jobCount);
+
+	bool IsValid() const { return fWriteFd >= 0; }
+	bool IsServer() const { return fIsServer; }
+
+	bool AcquireToken();
+	void ReleaseToken();
+	void ReleaseTokens();
+
+	size_t TokenCount() const { return fTokens.size(); }
+
+	static bool ParseMakeFlags(
+		const char* makeFlags,
+		std::string& _fifoPath,
+		int& _readFd,
+		int& _writeFd
+	);
+
+  private:
+	void _Unset();
+
+  private:
+	int fReadFd;
+	int fWriteFd;
+	std::vector<int> fOwnedFds;
+	bool fReadFdIsPrivate;
+	bool fIsServer;
+	bool fHadMakeFlags;
+	std::string fOldMakeFlags;
+	std::vector<char> fTokens;
+};
+
+} // namespace ham::process
+
+#endif // HAM_PROCESS_JOB_SERVER_HPP
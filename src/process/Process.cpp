@@ -26,9 +26,19 @@ Process::Launch(
 }
 
 /*static*/ bool
-Process::WaitForChild(ChildInfo& _childInfo)
+Process::WaitForChild(ChildInfo& _childInfo, bool wait)
 {
-	return PlatformProcessDelegate::WaitForChild(_childInfo);
+	return PlatformProcessDelegate::WaitForChild(_childInfo, wait);
+}
+
+/**
+ * Returns the maximum length of a command line that can be passed to a shell
+ * as a single argument.
+ */
+/*static*/ size_t
+Process::MaxCommandLineLength()
+{
+	return PlatformProcessDelegate::MaxCommandLineLength();
 }
 
 } // namespace ham::process
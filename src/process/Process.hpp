@@ -32,7 +32,9 @@ class Process
 
 	Id GetId() const { return fPlatformDelegate.GetId(); }
 
-	static bool WaitForChild(ChildInfo& _childInfo);
+	static bool WaitForChild(ChildInfo& _childInfo, bool wait = true);
+
+	static size_t MaxCommandLineLength();
 
   private:
 	PlatformProcessDelegate fPlatformDelegate;
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "process/ShellWorker.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// TODO: Platform specific!
+
+namespace ham::process
+{
+
+// the descriptors the commands are read from, the exit statuses written to,
+// and the commands' standard input is taken from in the shell (cf. the script
+// in Execute())
+static const int kCommandFd = 0;
+static const int kStatusFd = 3;
+static const int kInputFd = 4;
+
+static bool
+create_pipe(int fds[2])
+{
+	if (pipe(fds) != 0)
+		return false;
+
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	return true;
+}
+
+ShellWorker::ShellWorker()
+	: fId(-1),
+	  fCommandFd(-1),
+	  fStatusFd(-1)
+{
+}
+
+ShellWorker::~ShellWorker() { Stop(); }
+
+/**
+ * Starts the worker using \a shell, which must be a POSIX shell.
+ */
+bool
+ShellWorker::Start(const char* shell)
+{
+	Stop();
+
+	int commandFds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, commandFds) != 0)
+		return false;
+	fcntl(commandFds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(commandFds[1], F_SETFD, FD_CLOEXEC);
+
+	int statusFds[2];
+	if (!create_pipe(statusFds)) {
+		close(commandFds[0]);
+		close(commandFds[1]);
+		return false;
+	}
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		fprintf(stderr, "Error: fork failed(): %s\n", strerror(errno));
+		close(commandFds[0]);
+		close(commandFds[1]);
+		close(statusFds[0]);
+		close(statusFds[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		// child process: move the descriptors out of the way first, so they
+		// can't overwrite each other
+		int input = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 10);
+		if (input < 0)
+			input = open("/dev/null", O_RDONLY | O_CLOEXEC);
+		int command = fcntl(commandFds[1], F_DUPFD_CLOEXEC, 10);
+		int status = fcntl(statusFds[1], F_DUPFD_CLOEXEC, 10);
+		if (command < 0 || status < 0 || dup2(command, kCommandFd) < 0
+			|| dup2(status, kStatusFd) < 0 || dup2(input, kInputFd) < 0) {
+			fprintf(stderr, "Error: dup2() failed: %s\n", strerror(errno));
+			_exit(1);
+		}
+
+		execl(shell, shell, (char*)nullptr);
+		fprintf(stderr, "Error: execl() failed: %s\n", strerror(errno));
+		_exit(1);
+	}
+
+	close(commandFds[1]);
+	close(statusFds[1]);
+	fId = pid;
+	fCommandFd = commandFds[0];
+	fStatusFd = statusFds[0];
+	return true;
+}
+
+/**
+ * Lets the worker exit after the command it is executing, if any, and waits
+ * for it.
+ */
+void
+ShellWorker::Stop()
+{
+	if (fId < 0)
+		return;
+
+	close(fCommandFd);
+	close(fStatusFd);
+	while (waitpid(fId, nullptr, 0) < 0 && errno == EINTR)
+		;
+
+	fId = -1;
+	fCommandFd = -1;
+	fStatusFd = -1;
+}
+
+/**
+ * Passes \a commandLine to the worker. Returns false, if the worker is gone.
+ */
+bool
+ShellWorker::Execute(const char* commandLine)
+{
+	// Quote the command for eval, which runs it like "sh -c" would.
+	std::string script = "( eval '";
+	for (const char* c = commandLine; *c != '\0'; c++) {
+		if (*c == '\'')
+			script += "'\\''";
+		else
+			script += *c;
+	}
+	script += "' ) <&4 3>&- 4>&-\necho $? >&3\n";
+
+	const char* remainder = script.data();
+	size_t remainderSize = script.size();
+	while (remainderSize > 0) {
+		ssize_t bytesWritten =
+			send(fCommandFd, remainder, remainderSize, MSG_NOSIGNAL);
+		if (bytesWritten < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		remainder += bytesWritten;
+		remainderSize -= bytesWritten;
+	}
+
+	return true;
+}
+
+/**
+ * Reads the exit code of the command the worker has finished. Returns false,
+ * if the worker has exited instead.
+ */
+bool
+ShellWorker::ReadExitCode(int& _exitCode)
+{
+	std::string line;
+	for (;;) {
+		char c;
+		ssize_t bytesRead = read(fStatusFd, &c, 1);
+		if (bytesRead < 0 && errno == EINTR)
+			continue;
+		if (bytesRead != 1)
+			return false;
+		if (c == '\n')
+			break;
+		line += c;
+	}
+
+	_exitCode = atoi(line.c_str());
+	return true;
+}
+
+/**
+ * Waits up to \a timeout milliseconds (-1 for no limit) for one of the \a
+ * count \a workers to finish its command or exit. Returns its index or -1.
+ * Also returns \a count, when \a otherFd, unless -1, has become readable.
+ */
+/*static*/ int
+ShellWorker::Wait(
+	ShellWorker* const* workers,
+	size_t count,
+	int otherFd,
+	int timeout
+)
+{
+	std::vector<pollfd> pollFds(count + 1);
+	for (size_t i = 0; i < count; i++) {
+		pollFds[i].fd = workers[i]->fStatusFd;
+		pollFds[i].events = POLLIN;
+		pollFds[i].revents = 0;
+	}
+
+	// poll() ignores negative descriptors
+	pollFds[count].fd = otherFd;
+	pollFds[count].events = POLLIN;
+	pollFds[count].revents = 0;
+
+	if (poll(pollFds.data(), count + 1, timeout) <= 0)
+		return -1;
+
+	for (size_t i = 0; i <= count; i++) {
+		if (pollFds[i].revents != 0)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+} // namespace ham::process
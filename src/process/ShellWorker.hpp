@@ -0,0 +1,58 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_PROCESS_SHELL_WORKER_HPP
+#define HAM_PROCESS_SHELL_WORKER_HPP
+
+#include "process/Process.hpp"
+
+#include <stddef.h>
+
+namespace ham::process
+{
+
+/**
+ * A long-lived shell that executes one command after the other, so that a
+ * command doesn't cost starting a shell.
+ *
+ * The shell reads a small script per command from a socket. The script runs
+ * the command in a subshell -- so changes to the directory, variables, etc.
+ * don't outlive it -- with the standard input of our process, and reports the
+ * exit status on a pipe. Wait() returns when one of a number of workers is
+ * done with its command.
+ */
+class ShellWorker
+{
+  public:
+	ShellWorker();
+	~ShellWorker();
+
+	ShellWorker(const ShellWorker&) = delete;
+	ShellWorker& operator=(const ShellWorker&) = delete;
+
+	bool Start(const char* shell);
+	void Stop();
+
+	bool IsRunning() const { return fId >= 0; }
+	Process::Id GetId() const { return fId; }
+
+	bool Execute(const char* commandLine);
+	bool ReadExitCode(int& _exitCode);
+
+	static int Wait(
+		ShellWorker* const* workers,
+		size_t count,
+		int otherFd,
+		int timeout
+	);
+
+  private:
+	Process::Id fId;
+	int fCommandFd;
+	int fStatusFd;
+};
+
+} // namespace ham::process
+
+#endif // HAM_PROCESS_SHELL_WORKER_HPP
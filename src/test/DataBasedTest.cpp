@@ -82,7 +82,35 @@ DataBasedTest::RunTestCase(
 	int index
 )
 {
+	if (!environment->JamExecutable().empty()) {
+		_RunTest(environment, fDataSets[index]);
+		return;
+	}
+
+	// Run the test with both the bytecode virtual machine and the
+	// interpreter, so they can't silently diverge, and once more with the
+	// target files prefetched by several threads and the commands run by shell
+	// workers or, if simple enough, by ourselves.
+	environment->SetBytecodeEnabled(true);
 	_RunTest(environment, fDataSets[index]);
+	try {
+		environment->SetBytecodeEnabled(false);
+		_RunTest(environment, fDataSets[index]);
+		environment->SetBytecodeEnabled(true);
+		environment->SetPrepareThreadCount(4);
+		environment->SetShellWorkers(true);
+		environment->SetBuiltInCommands(true);
+		_RunTest(environment, fDataSets[index]);
+	} catch (...) {
+		environment->SetBytecodeEnabled(true);
+		environment->SetPrepareThreadCount(1);
+		environment->SetShellWorkers(false);
+		environment->SetBuiltInCommands(false);
+		throw;
+	}
+	environment->SetPrepareThreadCount(1);
+	environment->SetShellWorkers(false);
+	environment->SetBuiltInCommands(false);
 }
 
 void
@@ -7,6 +7,7 @@
 
 #include "behavior/Compatibility.hpp"
 
+#include <cstddef>
 #include <string>
 
 namespace ham::test
@@ -17,7 +18,11 @@ class TestEnvironment
   public:
 	TestEnvironment()
 		: fCompatibility(behavior::COMPATIBILITY_HAM),
-		  fJamExecutable()
+		  fJamExecutable(),
+		  fBytecodeEnabled(true),
+		  fPrepareThreadCount(1),
+		  fShellWorkers(false),
+		  fBuiltInCommands(false)
 	{
 	}
 
@@ -35,9 +40,28 @@ class TestEnvironment
 		fJamExecutable = executable;
 	}
 
+	bool IsBytecodeEnabled() const { return fBytecodeEnabled; }
+	void SetBytecodeEnabled(bool enabled) { fBytecodeEnabled = enabled; }
+
+	size_t PrepareThreadCount() const { return fPrepareThreadCount; }
+	void SetPrepareThreadCount(size_t count) { fPrepareThreadCount = count; }
+
+	bool IsShellWorkers() const { return fShellWorkers; }
+	void SetShellWorkers(bool shellWorkers) { fShellWorkers = shellWorkers; }
+
+	bool IsBuiltInCommands() const { return fBuiltInCommands; }
+	void SetBuiltInCommands(bool builtInCommands)
+	{
+		fBuiltInCommands = builtInCommands;
+	}
+
   protected:
 	behavior::Compatibility fCompatibility;
 	std::string fJamExecutable;
+	bool fBytecodeEnabled;
+	size_t fPrepareThreadCount;
+	bool fShellWorkers;
+	bool fBuiltInCommands;
 };
 
 } // namespace ham::test
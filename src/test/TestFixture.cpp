@@ -107,6 +107,10 @@ void
 TestFixture::CodeExecuter::Execute(
 	const char* jamExecutable,
 	behavior::Compatibility compatibility,
+	bool bytecodeEnabled,
+	size_t prepareThreadCount,
+	bool shellWorkers,
+	bool builtInCommands,
 	const std::map<std::string, std::string>& code,
 	const std::map<std::string, int>& codeAge,
 	std::ostream& output,
@@ -169,8 +173,15 @@ TestFixture::CodeExecuter::Execute(
 				break;
 		}
 	} else {
+		make::Options options;
+		options.SetBytecode(bytecodeEnabled);
+		options.SetPrepareThreadCount(prepareThreadCount);
+		options.SetShellWorkers(shellWorkers);
+		options.SetBuiltInCommands(builtInCommands);
+
 		make::Processor processor;
 		processor.SetCompatibility(compatibility);
+		processor.SetOptions(options);
 		processor.SetOutput(output);
 		processor.SetErrorOutput(errorOutput);
 		processor.ProcessRuleset();
@@ -212,6 +223,10 @@ TestFixture::CodeExecuter::Execute(
 	return Execute(
 		jamExecutable.empty() ? nullptr : jamExecutable.c_str(),
 		environment->GetCompatibility(),
+		environment->IsBytecodeEnabled(),
+		environment->PrepareThreadCount(),
+		environment->IsShellWorkers(),
+		environment->IsBuiltInCommands(),
 		code,
 		codeAge,
 		output,
@@ -111,6 +111,10 @@ class TestFixture::CodeExecuter
 	void Execute(
 		const char* jamExecutable,
 		behavior::Compatibility compatibility,
+		bool bytecodeEnabled,
+		size_t prepareThreadCount,
+		bool shellWorkers,
+		bool builtInCommands,
 		const std::map<std::string, std::string>& code,
 		const std::map<std::string, int>& codeAge,
 		std::ostream& output,
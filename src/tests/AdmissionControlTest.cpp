@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/AdmissionControlTest.hpp"
+
+#include "data/RuleActions.hpp"
+#include "make/AdmissionControl.hpp"
+#include "make/Command.hpp"
+#include "make/Options.hpp"
+
+namespace ham::tests
+{
+
+using make::AdmissionControl;
+using make::Command;
+
+static const size_t kMegaByte = 1024 * 1024;
+
+static Command*
+create_command(const char* ruleName)
+{
+	data::RuleActions* actions =
+		new data::RuleActions(ruleName, data::StringList(), "true", 0);
+	data::RuleActionsCall* actionsCall = new data::RuleActionsCall(
+		actions,
+		data::TargetList(),
+		data::TargetList()
+	);
+	actions->ReleaseReference();
+	Command* command = new Command(actionsCall, "true", data::StringList());
+	actionsCall->ReleaseReference();
+	return command;
+}
+
+void
+AdmissionControlTest::MemoryBudget()
+{
+	make::Options options;
+	options.SetMemoryBudget(100 * kMegaByte);
+	AdmissionControl admissionControl(options);
+	HAM_TEST_EQUAL(admissionControl.MemoryBudget(), 100 * kMegaByte)
+
+	// the first command is launched in any event
+	HAM_TEST_VERIFY(admissionControl.CanLaunch(200 * kMegaByte, 0))
+
+	HAM_TEST_VERIFY(admissionControl.CanLaunch(60 * kMegaByte, 0))
+	admissionControl.CommandLaunched(60 * kMegaByte);
+	HAM_TEST_VERIFY(!admissionControl.CanLaunch(60 * kMegaByte, 1))
+	HAM_TEST_VERIFY(admissionControl.CanLaunch(40 * kMegaByte, 1))
+	HAM_TEST_VERIFY(admissionControl.CanLaunch(0, 1))
+	admissionControl.CommandLaunched(40 * kMegaByte);
+	HAM_TEST_VERIFY(!admissionControl.CanLaunch(1 * kMegaByte, 2))
+	HAM_TEST_EQUAL(admissionControl.ReservedMemory(), 100 * kMegaByte)
+
+	Command* command = create_command("Link");
+	admissionControl.CommandFinished(command, 60 * kMegaByte, 0);
+	HAM_TEST_EQUAL(admissionControl.ReservedMemory(), 40 * kMegaByte)
+	HAM_TEST_VERIFY(admissionControl.CanLaunch(60 * kMegaByte, 1))
+	command->ReleaseReference();
+}
+
+void
+AdmissionControlTest::EstimateMemory()
+{
+	make::Options options;
+	options.SetMemoryBudget(100 * kMegaByte);
+	AdmissionControl admissionControl(options);
+
+	Command* link = create_command("Link");
+	Command* otherLink = create_command("Link");
+	Command* compile = create_command("Cc");
+
+	// nothing known yet
+	HAM_TEST_EQUAL(admissionControl.EstimateMemory(link), 0u)
+
+	// learned from the peak memory of the same actions
+	admissionControl.CommandLaunched(0);
+	admissionControl.CommandFinished(link, 0, 30 * kMegaByte);
+	HAM_TEST_EQUAL(admissionControl.EstimateMemory(otherLink), 30 * kMegaByte)
+	admissionControl.CommandFinished(link, 0, 20 * kMegaByte);
+	HAM_TEST_EQUAL(admissionControl.EstimateMemory(otherLink), 30 * kMegaByte)
+	HAM_TEST_EQUAL(admissionControl.EstimateMemory(compile), 0u)
+
+	// declared via JOBMEMORY
+	otherLink->SetMemoryEstimate(5 * kMegaByte);
+	HAM_TEST_EQUAL(admissionControl.EstimateMemory(otherLink), 5 * kMegaByte)
+
+	link->ReleaseReference();
+	otherLink->ReleaseReference();
+	compile->ReleaseReference();
+}
+
+} // namespace ham::tests
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_ADMISSION_CONTROL_TEST_HPP
+#define HAM_TESTS_ADMISSION_CONTROL_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class AdmissionControlTest : public test::TestFixture
+{
+  public:
+	void MemoryBudget();
+	void EstimateMemory();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(AdmissionControlTest, 2, MemoryBudget, EstimateMemory)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_ADMISSION_CONTROL_TEST_HPP
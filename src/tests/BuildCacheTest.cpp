@@ -0,0 +1,187 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/BuildCacheTest.hpp"
+
+#include "code/Block.hpp"
+#include "data/Path.hpp"
+#include "make/BuildCache.hpp"
+#include "parser/Parser.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ham::tests
+{
+
+using make::BuildCache;
+using make::TargetPrefetcher;
+
+static const char* const kPattern = "^#include \"(.*)\"";
+
+/**
+ * Has a build with \a prefetcher and the parsed file \a jamfile, working in
+ * \a directory, report to \a cache.
+ */
+static bool
+report(
+	BuildCache& cache,
+	const TargetPrefetcher& prefetcher,
+	const std::string& jamfile,
+	const std::string& directory
+)
+{
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+		return false;
+
+	BuildCache buildCache;
+	parser::Parser parser;
+	util::Reference<code::Block> block(parser.Parse("x = 1 ;"), true);
+	buildCache.ParsedFiles().Add(jamfile.c_str(), block.Get());
+	buildCache.SetReportFd(fds[1]);
+	std::thread build([&]() {
+		buildCache.TargetsPrepared(prefetcher, directory);
+		close(fds[1]);
+	});
+
+	bool received = cache.ReceiveReport(fds[0]);
+	build.join();
+	close(fds[0]);
+	return received;
+}
+
+static bool
+has_status(const BuildCache& cache, const std::string& path)
+{
+	return cache.Files().FileStatuses().Statuses().count(path) > 0;
+}
+
+static bool
+has_scan(const BuildCache& cache, const std::string& path)
+{
+	return cache.Files().ScanResults().count(
+			   TargetPrefetcher::ScanKey(path, kPattern)
+		   )
+		> 0;
+}
+
+void
+BuildCacheTest::Report()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string source = MakePath(directory.c_str(), "a.c");
+	std::string missing = MakePath(directory.c_str(), "b.c");
+	std::string jamfile = MakePath(directory.c_str(), "Jamfile");
+	CreateFile(source.c_str(), "#include \"a.h\"\n");
+	CreateFile(jamfile.c_str(), "x = 2 ;\n");
+
+	// a scan and statuses, one with a path relative to the directory
+	TargetPrefetcher prefetcher;
+	std::vector<std::string> headers;
+	HAM_TEST_VERIFY(
+		prefetcher.ScanForHeaders(source.c_str(), kPattern, headers)
+	)
+	data::FileStatus status;
+	HAM_TEST_VERIFY(prefetcher.FileStatuses().GetFileStatus(
+		source.c_str(),
+		status
+	))
+	data::Path::GetFileStatus(missing.c_str(), status);
+	prefetcher.AddFileStatus("b.c", status);
+
+	BuildCache cache;
+	HAM_TEST_VERIFY(cache.Init())
+	HAM_TEST_VERIFY(report(cache, prefetcher, jamfile, directory))
+
+	HAM_TEST_VERIFY(has_status(cache, source))
+	HAM_TEST_VERIFY(has_status(cache, missing))
+	HAM_TEST_VERIFY(
+		!cache.Files().FileStatuses().Statuses().at(missing).Exists()
+	)
+	HAM_TEST_VERIFY(has_scan(cache, source))
+	const TargetPrefetcher::ScanResult& result =
+		cache.Files().ScanResults().at(TargetPrefetcher::ScanKey(
+			source,
+			kPattern
+		));
+	HAM_TEST_VERIFY(result.fOpened)
+	HAM_TEST_EQUAL(result.fHeaders, std::vector<std::string>{"a.h"})
+
+	// The daemon parses the file itself, the build's code may be outdated.
+	code::Block* block = cache.ParsedFiles().Lookup(jamfile.c_str());
+	HAM_TEST_VERIFY(block != nullptr)
+	HAM_TEST_VERIFY(cache.ParsedFiles().AddedPaths().empty())
+
+	// A status that doesn't match the file anymore is dropped.
+	TargetPrefetcher stalePrefetcher;
+	stalePrefetcher.AddFileStatus("c.c", status);
+	CreateFile(MakePath(directory.c_str(), "c.c").c_str(), "");
+	HAM_TEST_VERIFY(report(cache, stalePrefetcher, jamfile, directory))
+	HAM_TEST_VERIFY(!has_status(cache, MakePath(directory.c_str(), "c.c")))
+}
+
+void
+BuildCacheTest::Invalidation()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string subDirectory = MakePath(directory.c_str(), "sub");
+	std::string source = MakePath(subDirectory.c_str(), "a.c");
+	std::string missing = MakePath(directory.c_str(), "b.c");
+	std::string jamfile = MakePath(directory.c_str(), "Jamfile");
+	CreateFile(source.c_str(), "#include \"a.h\"\n");
+	CreateFile(jamfile.c_str(), "x = 2 ;\n");
+
+	TargetPrefetcher prefetcher;
+	std::vector<std::string> headers;
+	HAM_TEST_VERIFY(
+		prefetcher.ScanForHeaders(source.c_str(), kPattern, headers)
+	)
+	data::FileStatus status;
+	prefetcher.FileStatuses().GetFileStatus(source.c_str(), status);
+	prefetcher.FileStatuses().GetFileStatus(missing.c_str(), status);
+	prefetcher.FileStatuses().GetFileStatus(subDirectory.c_str(), status);
+
+	BuildCache cache;
+	HAM_TEST_VERIFY(cache.Init())
+	HAM_TEST_VERIFY(report(cache, prefetcher, jamfile, directory))
+	HAM_TEST_VERIFY(has_status(cache, source))
+	HAM_TEST_VERIFY(has_status(cache, missing))
+	HAM_TEST_VERIFY(has_status(cache, subDirectory))
+
+	// nothing has changed
+	cache.ProcessEvents();
+	HAM_TEST_VERIFY(has_status(cache, source))
+	HAM_TEST_VERIFY(has_scan(cache, source))
+	HAM_TEST_VERIFY(cache.ParsedFiles().Lookup(jamfile.c_str()) != nullptr)
+
+	// creating a missing file
+	CreateFile(missing.c_str(), "");
+	cache.ProcessEvents();
+	HAM_TEST_VERIFY(!has_status(cache, missing))
+	HAM_TEST_VERIFY(has_status(cache, source))
+
+	// changing a Jamfile
+	CreateFile(jamfile.c_str(), "x = 3 ;\n");
+	cache.ProcessEvents();
+	HAM_TEST_VERIFY(cache.ParsedFiles().Lookup(jamfile.c_str()) == nullptr)
+	HAM_TEST_VERIFY(has_status(cache, source))
+
+	// moving a directory away invalidates everything below it
+	std::string moved = MakePath(directory.c_str(), "moved");
+	HAM_TEST_VERIFY(rename(subDirectory.c_str(), moved.c_str()) == 0)
+	cache.ProcessEvents();
+	HAM_TEST_VERIFY(!has_status(cache, subDirectory))
+	HAM_TEST_VERIFY(!has_status(cache, source))
+	HAM_TEST_VERIFY(!has_scan(cache, source))
+}
+
+} // namespace ham::tests
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_BUILD_CACHE_TEST_HPP
+#define HAM_TESTS_BUILD_CACHE_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class BuildCacheTest : public test::TestFixture
+{
+  public:
+	void Report();
+	void Invalidation();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(BuildCacheTest, 2, Report, Invalidation)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_BUILD_CACHE_TEST_HPP
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/BuiltInCommandTest.hpp"
+
+#include "process/BuiltInCommand.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ham::tests
+{
+
+using process::BuiltInCommand;
+
+static std::string
+read_file(const std::string& path)
+{
+	std::ifstream file(path);
+	std::stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+static std::string
+read_link(const std::string& path)
+{
+	char buffer[256];
+	ssize_t length = readlink(path.c_str(), buffer, sizeof(buffer));
+	return length >= 0 ? std::string(buffer, length) : std::string();
+}
+
+void
+BuiltInCommandTest::Parse()
+{
+	struct TestData {
+		const char* commandLine;
+		bool builtIn;
+	};
+
+	const TestData testData[] = {
+		{"mkdir a", true},
+		{"\n\tmkdir -p a/b \n\n", true},
+		{"mkdir -m 755 a", false},
+		{"rm -f a b", true},
+		{"rm -f", false},
+		{"rm a", false},
+		{"rm -rf a", false},
+		{"cp -f \"a b\" 'c'", true},
+		{"cp a", false},
+		{"cp -r a b", false},
+		{"touch a && touch b", true},
+		{"touch a&&touch b\ntouch c", true},
+		{"ln -s a b", true},
+		{"ln -sf -- a b", true},
+		{"ln -s a b c", false},
+		{"chmod 644 a", true},
+		{"chmod u+x a", false},
+		{"chmod -x a", false},
+		{"touch 'x$a'", true},
+		{"touch $HOME/a", false},
+		{"touch \"$a\"", false},
+		{"touch \"`a`\"", false},
+		{"touch a\\ b", false},
+		{"touch 'a", false},
+		{"touch a*", false},
+		{"touch ~/a", false},
+		{"touch a; touch b", false},
+		{"touch a | cat", false},
+		{"touch a > b", false},
+		{"touch a &", false},
+		{"touch a &&", false},
+		{"touch a &&\ntouch b", false},
+		{"&& touch a", false},
+		{"A=b touch a", false},
+		{"echo a", false},
+		{"", false},
+		{"\n\t\n", false},
+	};
+
+	for (size_t i = 0; i < sizeof(testData) / sizeof(testData[0]); i++) {
+		BuiltInCommand command;
+		HAM_TEST_ADD_INFO(
+			HAM_TEST_EQUAL(
+				command.Parse(testData[i].commandLine),
+				testData[i].builtIn
+			),
+			"command line: \"%s\"",
+			testData[i].commandLine
+		)
+	}
+}
+
+void
+BuiltInCommandTest::Execute()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory =
+		MakePath(temporaryDirectoryCreator.Create(false), "a");
+	std::string quotedDirectory = "'" + directory + "'";
+
+	struct TestData {
+		const char* commandLine;
+		int exitCode;
+	};
+
+	const TestData testData[] = {
+		{"mkdir -p %/b/c", 0},
+		{"mkdir %", 1},
+		{"touch %/f", 0},
+		{"cp -f %/f %/g", 0},
+		{"chmod 600 %/g", 0},
+		{"ln -s f %/l", 0},
+		{"cp %/f %/g %/b", 0},
+		{"rm -f %/g %/missing", 0},
+		{"cp %/missing %/x", 1},
+		{"cp %/missing %/x && touch %/y", 1},
+		{"cp %/missing %/x\ntouch %/z", 0},
+		{"touch %/z\ncp %/missing %/x", 1},
+		{"ln -s f %/l", 1},
+		{"rm -f %/l && ln -s g %/l", 0},
+		{"rm -f %/b", 1},
+	};
+
+	CreateDirectory(directory.c_str());
+	CreateFile((directory + "/f").c_str(), "content");
+	for (size_t i = 0; i < sizeof(testData) / sizeof(testData[0]); i++) {
+		std::string commandLine = testData[i].commandLine;
+		for (size_t index = commandLine.find('%');
+			 index != std::string::npos;
+			 index = commandLine.find('%', index + quotedDirectory.size())) {
+			commandLine.replace(index, 1, quotedDirectory);
+		}
+
+		BuiltInCommand command;
+		HAM_TEST_ADD_INFO(
+			HAM_TEST_VERIFY(command.Parse(commandLine.c_str()))
+			HAM_TEST_EQUAL(command.Execute(), testData[i].exitCode),
+			"command line: \"%s\"",
+			commandLine.c_str()
+		)
+	}
+
+	struct stat st;
+	HAM_TEST_VERIFY(stat((directory + "/b/c").c_str(), &st) == 0)
+	HAM_TEST_VERIFY(S_ISDIR(st.st_mode))
+	HAM_TEST_VERIFY(FileExists(directory + "/b/f"))
+	HAM_TEST_EQUAL(read_file(directory + "/b/g"), std::string("content"))
+	HAM_TEST_VERIFY(stat((directory + "/b/g").c_str(), &st) == 0)
+	HAM_TEST_EQUAL(st.st_mode & 0777, 0600u)
+	HAM_TEST_VERIFY(!FileExists(directory + "/g"))
+	HAM_TEST_VERIFY(!FileExists(directory + "/x"))
+	HAM_TEST_VERIFY(!FileExists(directory + "/y"))
+	HAM_TEST_VERIFY(FileExists(directory + "/z"))
+	HAM_TEST_EQUAL(read_link(directory + "/l"), std::string("g"))
+}
+
+} // namespace ham::tests
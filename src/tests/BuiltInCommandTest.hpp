@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_BUILT_IN_COMMAND_TEST_HPP
+#define HAM_TESTS_BUILT_IN_COMMAND_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class BuiltInCommandTest : public test::TestFixture
+{
+  public:
+	void Parse();
+	void Execute();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(BuiltInCommandTest, 2, Parse, Execute)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_BUILT_IN_COMMAND_TEST_HPP
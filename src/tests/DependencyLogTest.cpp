@@ -0,0 +1,313 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/DependencyLogTest.hpp"
+
+#include "data/Path.hpp"
+#include "make/DependencyLog.hpp"
+#include "make/Options.hpp"
+#include "make/Processor.hpp"
+
+#include <utime.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ham::tests
+{
+
+using make::DependencyLog;
+
+typedef std::vector<std::string> PathList;
+
+static const data::Time kSourceTime(1000, 5);
+
+static void
+build(const char* logFile)
+{
+	make::Options options;
+	options.SetDependencyLogFile(logFile);
+
+	std::stringstream output;
+	make::Processor processor;
+	processor.SetOptions(options);
+	processor.SetOutput(output);
+	processor.SetErrorOutput(output);
+	processor.ProcessRuleset();
+	processor.SetPrimaryTargets(StringList().Append(String("all")));
+	processor.PrepareTargets();
+	processor.BuildTargets();
+}
+
+static size_t
+line_count(const char* fileName)
+{
+	std::ifstream file(fileName);
+	std::string line;
+	size_t count = 0;
+	while (std::getline(file, line))
+		count++;
+	return count;
+}
+
+static void
+set_age(const char* fileName, int age)
+{
+	struct utimbuf times;
+	times.actime = times.modtime = (time_t)data::Time::Now().Seconds() - age;
+	utime(fileName, &times);
+}
+
+static bool
+parse(const char* depfile, PathList& _prerequisites)
+{
+	return DependencyLog::ParseDepfile(
+		depfile,
+		strlen(depfile),
+		_prerequisites
+	);
+}
+
+void
+DependencyLogTest::ParseDepfile()
+{
+	PathList prerequisites;
+
+	// what GCC writes with -MD -MP
+	HAM_TEST_VERIFY(parse(
+		"obj/foo.o: src/foo.c /usr/include/stdio.h \\\n"
+		" include/foo.h\n"
+		"/usr/include/stdio.h:\n"
+		"include/foo.h:\n",
+		prerequisites
+	))
+	HAM_TEST_EQUAL(
+		prerequisites,
+		PathList({"src/foo.c", "/usr/include/stdio.h", "include/foo.h"})
+	)
+
+	// escapes, CRLF line ends, duplicates, several targets
+	HAM_TEST_VERIFY(parse(
+		"foo.o foo.d : my\\ file.c a$$b.h \\\r\n"
+		"\tC:\\include\\c\\#.h my\\ file.c\r\n",
+		prerequisites
+	))
+	HAM_TEST_EQUAL(
+		prerequisites,
+		PathList({"my file.c", "a$b.h", "C:\\include\\c#.h"})
+	)
+
+	// no rules at all
+	HAM_TEST_VERIFY(parse("", prerequisites))
+	HAM_TEST_VERIFY(prerequisites.empty())
+	HAM_TEST_VERIFY(parse("foo.o:", prerequisites))
+	HAM_TEST_VERIFY(prerequisites.empty())
+
+	// not a depfile
+	HAM_TEST_VERIFY(!parse("foo.o foo.c\n", prerequisites))
+	HAM_TEST_VERIFY(!parse(": foo.c\n", prerequisites))
+	HAM_TEST_VERIFY(!parse("foo.o: foo.c: bar.c\n", prerequisites))
+}
+
+void
+DependencyLogTest::RecordAndLookup()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string logFile = MakePath(directory.c_str(), "log");
+
+	PathList headers;
+	{
+		DependencyLog log;
+		HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+		HAM_TEST_EQUAL(log.EntryCount(), 0u)
+		HAM_TEST_VERIFY(!log.Lookup("foo.c", kSourceTime, headers))
+
+		HAM_TEST_VERIFY(log.Record("foo.c", kSourceTime, {"/a.h", "/b.h"}))
+		HAM_TEST_VERIFY(log.Record("bar.c", kSourceTime, {"/b.h"}))
+		HAM_TEST_VERIFY(log.Record("baz.c", kSourceTime, {}))
+		HAM_TEST_VERIFY(log.Lookup("foo.c", kSourceTime, headers))
+		HAM_TEST_EQUAL(headers, PathList({"/a.h", "/b.h"}))
+	}
+
+	// the entries are read back
+	DependencyLog log;
+	HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+	HAM_TEST_EQUAL(log.EntryCount(), 3u)
+	HAM_TEST_VERIFY(log.Lookup("foo.c", kSourceTime, headers))
+	HAM_TEST_EQUAL(headers, PathList({"/a.h", "/b.h"}))
+	HAM_TEST_VERIFY(log.Lookup("bar.c", kSourceTime, headers))
+	HAM_TEST_EQUAL(headers, PathList({"/b.h"}))
+	HAM_TEST_VERIFY(log.HasEntry("baz.c", kSourceTime))
+	HAM_TEST_VERIFY(log.Lookup("baz.c", kSourceTime, headers))
+	HAM_TEST_VERIFY(headers.empty())
+
+	// only for the time the source had
+	HAM_TEST_VERIFY(!log.HasEntry("foo.c", data::Time(1000, 6)))
+
+	// paths are compared normalized
+	HAM_TEST_VERIFY(log.HasEntry("./foo.c", kSourceTime))
+	HAM_TEST_VERIFY(log.HasEntry("x/../bar.c", kSourceTime))
+
+	// a new entry replaces the old one
+	data::Time newTime(2000, 0);
+	HAM_TEST_VERIFY(log.Record("foo.c", newTime, {"/c.h"}))
+	log.Close();
+	HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+	HAM_TEST_EQUAL(log.EntryCount(), 3u)
+	HAM_TEST_VERIFY(!log.HasEntry("foo.c", kSourceTime))
+	HAM_TEST_VERIFY(log.Lookup("foo.c", newTime, headers))
+	HAM_TEST_EQUAL(headers, PathList({"/c.h"}))
+
+	// another compile of the unchanged source adds its headers
+	HAM_TEST_VERIFY(log.Record("foo.c", newTime, {"/d.h", "/c.h"}))
+	log.Close();
+	HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+	HAM_TEST_VERIFY(log.Lookup("foo.c", newTime, headers))
+	HAM_TEST_EQUAL(headers, PathList({"/c.h", "/d.h"}))
+}
+
+void
+DependencyLogTest::DamagedLog()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string logFile = MakePath(directory.c_str(), "log");
+
+	data::Time newTime(2000, 0);
+	size_t firstSize;
+	{
+		DependencyLog log;
+		HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+		HAM_TEST_VERIFY(log.Record("foo.c", kSourceTime, {"/a.h"}))
+		firstSize = std::filesystem::file_size(logFile);
+		HAM_TEST_VERIFY(log.Record("foo.c", newTime, {"/a.h"}))
+	}
+
+	// a truncated last record is dropped, the records before it are kept
+	std::filesystem::resize_file(
+		logFile,
+		std::filesystem::file_size(logFile) - 2
+	);
+	PathList headers;
+	{
+		DependencyLog log;
+		HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+		HAM_TEST_EQUAL(log.EntryCount(), 1u)
+		HAM_TEST_VERIFY(!log.HasEntry("foo.c", newTime))
+		HAM_TEST_VERIFY(log.Lookup("foo.c", kSourceTime, headers))
+		HAM_TEST_EQUAL(headers, PathList({"/a.h"}))
+		HAM_TEST_EQUAL(std::filesystem::file_size(logFile), firstSize)
+
+		// and recording continues after them
+		HAM_TEST_VERIFY(log.Record("bar.c", kSourceTime, {"/b.h"}))
+	}
+	{
+		DependencyLog log;
+		HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+		HAM_TEST_EQUAL(log.EntryCount(), 2u)
+		HAM_TEST_VERIFY(log.Lookup("bar.c", kSourceTime, headers))
+		HAM_TEST_EQUAL(headers, PathList({"/b.h"}))
+	}
+
+	// a file that isn't a log is started anew
+	CreateFile(logFile.c_str(), "foo.o: foo.c\n");
+	DependencyLog log;
+	HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+	HAM_TEST_EQUAL(log.EntryCount(), 0u)
+	HAM_TEST_VERIFY(log.Record("foo.c", kSourceTime, {"/a.h"}))
+}
+
+void
+DependencyLogTest::Compaction()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string logFile = MakePath(directory.c_str(), "log");
+
+	size_t singleSize;
+	{
+		DependencyLog log;
+		HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+		HAM_TEST_VERIFY(log.Record("foo.c", kSourceTime, {"/a.h"}))
+		singleSize = std::filesystem::file_size(logFile);
+
+		// recording the same again doesn't grow the file
+		HAM_TEST_VERIFY(log.Record("foo.c", kSourceTime, {"/a.h"}))
+		HAM_TEST_EQUAL(std::filesystem::file_size(logFile), singleSize)
+
+		for (uint32_t i = 1; i <= 2000; i++)
+			HAM_TEST_VERIFY(log.Record("foo.c", data::Time(i, 0), {"/a.h"}))
+		HAM_TEST_VERIFY(log.Record("foo.c", kSourceTime, {"/a.h"}))
+		HAM_TEST_VERIFY(std::filesystem::file_size(logFile) > singleSize)
+	}
+
+	// superseded records are dropped when opening
+	DependencyLog log;
+	HAM_TEST_VERIFY(log.Open(logFile.c_str()))
+	HAM_TEST_EQUAL(std::filesystem::file_size(logFile), singleSize)
+	PathList headers;
+	HAM_TEST_VERIFY(log.Lookup("foo.c", kSourceTime, headers))
+	HAM_TEST_EQUAL(headers, PathList({"/a.h"}))
+}
+
+void
+DependencyLogTest::SourceCompiledTwice()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	temporaryDirectoryCreator.Create(true);
+
+	// The "compiler" includes a different header for each object, like one
+	// that is passed different defines.
+	CreateFile(
+		"Jamfile",
+		"actions Cc\n"
+		"{\n"
+		"	echo \"$(<): $(>) $(HEADER)\" > $(DEPFILE)\n"
+		"	echo built >> $(<)\n"
+		"}\n"
+		"rule Obj\n"
+		"{\n"
+		"	Depends all : $(1) ;\n"
+		"	Depends $(1) : $(2) ;\n"
+		"	DEPFILE on $(1) = $(1:S=.d) ;\n"
+		"	HEADER on $(1) = $(3) ;\n"
+		"	Cc $(1) : $(2) ;\n"
+		"}\n"
+		"Obj a.o : f.c : a.h ;\n"
+		"Obj b.o : f.c : b.h ;\n"
+	);
+	CreateFile("f.c", "");
+	CreateFile("a.h", "");
+	CreateFile("b.h", "");
+	set_age("f.c", 100);
+	set_age("a.h", 100);
+	set_age("b.h", 100);
+
+	build("log");
+	HAM_TEST_EQUAL(line_count("a.o"), 1u)
+	HAM_TEST_EQUAL(line_count("b.o"), 1u)
+
+	// the headers of both compiles are logged
+	DependencyLog log;
+	HAM_TEST_VERIFY(log.Open("log"))
+	PathList headers;
+	data::FileStatus status;
+	HAM_TEST_VERIFY(data::Path::GetFileStatus("f.c", status))
+	HAM_TEST_VERIFY(log.Lookup("f.c", status.LastModifiedTime(), headers))
+	HAM_TEST_EQUAL(headers.size(), 2u)
+	log.Close();
+
+	// a.o depends on a.h, though b.o was compiled last
+	set_age("a.h", -100);
+	build("log");
+	HAM_TEST_EQUAL(line_count("a.o"), 2u)
+}
+
+} // namespace ham::tests
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_DEPENDENCY_LOG_TEST_HPP
+#define HAM_TESTS_DEPENDENCY_LOG_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class DependencyLogTest : public test::TestFixture
+{
+  public:
+	void ParseDepfile();
+	void RecordAndLookup();
+	void DamagedLog();
+	void Compaction();
+	void SourceCompiledTwice();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(
+		DependencyLogTest,
+		5,
+		ParseDepfile,
+		RecordAndLookup,
+		DamagedLog,
+		Compaction,
+		SourceCompiledTwice
+	)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_DEPENDENCY_LOG_TEST_HPP
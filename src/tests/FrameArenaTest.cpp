@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/FrameArenaTest.hpp"
+
+#include "util/FrameArena.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ham::tests
+{
+
+using util::FrameArena;
+
+void
+FrameArenaTest::Allocate()
+{
+	FrameArena arena;
+	FrameArena::Frame frame(arena);
+
+	// allocations are aligned and don't overlap
+	const size_t alignments[] = {1, 2, 4, 8, 16, 32, 64};
+	std::vector<char*> blocks;
+	for (size_t alignment : alignments) {
+		char* block = static_cast<char*>(arena.allocate(3, alignment));
+		HAM_TEST_EQUAL(reinterpret_cast<uintptr_t>(block) % alignment, 0u)
+		memset(block, (int)blocks.size(), 3);
+		blocks.push_back(block);
+	}
+
+	for (size_t i = 0; i < blocks.size(); i++) {
+		for (size_t k = 0; k < 3; k++)
+			HAM_TEST_EQUAL((int)blocks[i][k], (int)i)
+	}
+
+	// containers can use the arena
+	std::pmr::vector<int> vector(&arena);
+	for (int i = 0; i < 10000; i++)
+		vector.push_back(i);
+	for (int i = 0; i < 10000; i++)
+		HAM_TEST_EQUAL(vector[i], i)
+}
+
+void
+FrameArenaTest::Frames()
+{
+	FrameArena arena;
+	FrameArena::Frame frame(arena);
+	void* outer = arena.allocate(16);
+
+	void* inner;
+	{
+		FrameArena::Frame innerFrame(arena);
+		inner = arena.allocate(16);
+		HAM_TEST_VERIFY(inner != outer)
+
+		void* innermost;
+		{
+			FrameArena::Frame innermostFrame(arena);
+			innermost = arena.allocate(100);
+		}
+
+		// the innermost frame's memory is reused
+		{
+			FrameArena::Frame innermostFrame(arena);
+			HAM_TEST_VERIFY(arena.allocate(16) == innermost)
+		}
+	}
+
+	// the inner frame's memory is reused
+	{
+		FrameArena::Frame innerFrame(arena);
+		HAM_TEST_VERIFY(arena.allocate(16) == inner)
+	}
+}
+
+void
+FrameArenaTest::LargeAllocations()
+{
+	FrameArena arena;
+	FrameArena::Frame frame(arena);
+
+	// Allocate more than a chunk in several frames, so allocations span
+	// chunks and existing chunks that are too small have to be replaced.
+	const size_t sizes[] = {100, 100 * 1024, 10, 1024 * 1024, 64 * 1024};
+	for (int round = 0; round < 2; round++) {
+		FrameArena::Frame roundFrame(arena);
+		std::vector<char*> blocks;
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			char* block = static_cast<char*>(arena.allocate(sizes[i]));
+			memset(block, (int)i, sizes[i]);
+			blocks.push_back(block);
+		}
+
+		for (size_t i = 0; i < blocks.size(); i++) {
+			HAM_TEST_EQUAL((int)blocks[i][0], (int)i)
+			HAM_TEST_EQUAL((int)blocks[i][sizes[i] - 1], (int)i)
+		}
+	}
+}
+
+} // namespace ham::tests
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_FRAME_ARENA_TEST_HPP
+#define HAM_TESTS_FRAME_ARENA_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class FrameArenaTest : public test::TestFixture
+{
+  public:
+	void Allocate();
+	void Frames();
+	void LargeAllocations();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(FrameArenaTest, 3, Allocate, Frames, LargeAllocations)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_FRAME_ARENA_TEST_HPP
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/IncludeCacheTest.hpp"
+
+#include "code/Block.hpp"
+#include "code/BuiltInRules.hpp"
+#include "code/EvaluationContext.hpp"
+#include "code/IncludeCache.hpp"
+#include "data/Path.hpp"
+#include "data/TargetPool.hpp"
+#include "data/VariableDomain.hpp"
+#include "parser/Parser.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace ham::tests
+{
+
+using code::IncludeCache;
+
+static const char* const kIdentity = "test";
+
+static const char* const kIncludedCode = "Y = $(X) b ;\n"
+										 "X += c ;\n"
+										 "Echo in $(Y) ;\n"
+										 "DEPENDS t : u ;\n"
+										 "NOTFILE t ;\n"
+										 "V on t += $(X) ;\n"
+										 "W = [ on t return $(V) ] ;\n"
+										 "Build t : u ;\n";
+
+namespace
+{
+
+/**
+ * A context with the built-in rules and a Build action, which evaluates code
+ * with the include cache \a cache and captures the output.
+ */
+struct Evaluation {
+	Evaluation(IncludeCache* cache)
+		: fGlobalVariables(),
+		  fTargets(),
+		  fContext(fGlobalVariables, fTargets),
+		  fOutput()
+	{
+		code::BuiltInRules::RegisterRules(fContext.Rules());
+		fContext.SetOutput(fOutput);
+		fContext.SetErrorOutput(fOutput);
+		fContext.SetEvaluatedIncludes(cache);
+		Evaluate("actions Build { touch $(1) }\n");
+	}
+
+	void Evaluate(const std::string& code)
+	{
+		util::Reference<code::Block> block(
+			parser::Parser().Parse(code),
+			true
+		);
+		block->Evaluate(fContext);
+	}
+
+	StringList Variable(const char* name) const
+	{
+		const StringList* value = fGlobalVariables.Lookup(name);
+		return value != nullptr ? *value : StringList();
+	}
+
+	data::VariableDomain fGlobalVariables;
+	data::TargetPool fTargets;
+	code::EvaluationContext fContext;
+	std::stringstream fOutput;
+};
+
+} // namespace
+
+/**
+ * Returns the code that sets X to \a value and includes the file at \a path.
+ */
+static std::string
+include_code(const std::string& path, const char* value = "a")
+{
+	return std::string("X = ") + value + " ;\ninclude " + path + " ;\n";
+}
+
+/**
+ * Returns whether \a cache repeats the file at \a path for \a evaluation.
+ */
+static bool
+replay(IncludeCache& cache, Evaluation& evaluation, const std::string& path)
+{
+	data::FileStatus status;
+	data::Path::GetFileStatus(path.c_str(), status);
+	return cache.Replay(evaluation.fContext, path.c_str(), status);
+}
+
+/**
+ * Moves the modification time of the file at \a path a second further.
+ */
+static void
+touch(const std::string& path)
+{
+	std::filesystem::last_write_time(
+		path,
+		std::filesystem::last_write_time(path) + std::chrono::seconds(1)
+	);
+}
+
+/**
+ * Records including the file at \a path with \a code, which sees a local
+ * variable l. Then changes the file without changing its status and returns
+ * whether including it again repeats the recorded code.
+ */
+static bool
+is_repeated(
+	const std::string& path,
+	const std::string& cacheFile,
+	const char* code
+)
+{
+	std::string includingCode = "local l ;\n" + include_code(path);
+	test::TestFixture::CreateFile(path.c_str(), code);
+
+	IncludeCache recordingCache;
+	Evaluation recording(&recordingCache);
+	recording.Evaluate(includingCode);
+	HAM_TEST_VERIFY(recordingCache.Save(cacheFile.c_str(), kIdentity))
+
+	std::filesystem::file_time_type time =
+		std::filesystem::last_write_time(path);
+	test::TestFixture::CreateFile(
+		path.c_str(),
+		(std::string(code) + "Y = evaluated ;\n").c_str()
+	);
+	std::filesystem::last_write_time(path, time);
+
+	IncludeCache cache;
+	HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+	Evaluation evaluation(&cache);
+	evaluation.Evaluate(includingCode);
+	return evaluation.Variable("Y") != test::TestFixture::MakeStringList(
+			   "evaluated"
+		   );
+}
+
+void
+IncludeCacheTest::Replay()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string path = MakePath(directory.c_str(), "included");
+	std::string cacheFile = MakePath(directory.c_str(), "cache");
+	CreateFile(path.c_str(), kIncludedCode);
+
+	IncludeCache recordingCache;
+	Evaluation recording(&recordingCache);
+	recording.Evaluate(include_code(path));
+	HAM_TEST_VERIFY(recordingCache.Save(cacheFile.c_str(), kIdentity))
+
+	HAM_TEST_EQUAL(recording.fOutput.str(), std::string("in a b\n"))
+	HAM_TEST_EQUAL(recording.Variable("X"), MakeStringList("a", "c"))
+	HAM_TEST_EQUAL(recording.Variable("W"), MakeStringList("a", "c"))
+
+	// Repeating the file must leave the same variables, targets and output.
+	IncludeCache cache;
+	HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+	Evaluation replaying(&cache);
+	replaying.Evaluate("X = a ;\n");
+	HAM_TEST_VERIFY(replay(cache, replaying, path))
+
+	HAM_TEST_EQUAL(replaying.fOutput.str(), recording.fOutput.str())
+	for (const char* name : {"X", "Y", "W"})
+		HAM_TEST_EQUAL(replaying.Variable(name), recording.Variable(name))
+
+	data::Target* target = replaying.fTargets.Lookup("t");
+	HAM_TEST_VERIFY(target != nullptr)
+	HAM_TEST_VERIFY(target->IsNotAFile())
+	HAM_TEST_EQUAL(target->Dependencies().Size(), 1u)
+	HAM_TEST_EQUAL(target->ActionsCalls().size(), 1u)
+	HAM_TEST_VERIFY(target->Variables() != nullptr)
+	HAM_TEST_EQUAL(
+		*target->Variables()->Lookup("V"),
+		MakeStringList("a", "c")
+	)
+	HAM_TEST_VERIFY(replaying.fTargets.Lookup("u") != nullptr)
+
+	// an include statement repeats the file as well
+	IncludeCache includingCache;
+	HAM_TEST_VERIFY(includingCache.Load(cacheFile.c_str(), kIdentity))
+	Evaluation including(&includingCache);
+	including.Evaluate(include_code(path));
+	HAM_TEST_EQUAL(including.fOutput.str(), recording.fOutput.str())
+	HAM_TEST_EQUAL(including.Variable("Y"), recording.Variable("Y"))
+}
+
+void
+IncludeCacheTest::Invalidation()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string path = MakePath(directory.c_str(), "included");
+	std::string cacheFile = MakePath(directory.c_str(), "cache");
+	CreateFile(path.c_str(), kIncludedCode);
+
+	IncludeCache recordingCache;
+	Evaluation recording(&recordingCache);
+	recording.Evaluate(include_code(path));
+	HAM_TEST_VERIFY(recordingCache.Save(cacheFile.c_str(), kIdentity))
+
+	// a global variable read by the file has changed
+	{
+		IncludeCache cache;
+		HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+		Evaluation evaluation(&cache);
+		evaluation.Evaluate("X = z ;\n");
+		HAM_TEST_VERIFY(!replay(cache, evaluation, path))
+	}
+
+	// a target read by the file has changed
+	{
+		IncludeCache cache;
+		HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+		Evaluation evaluation(&cache);
+		evaluation.Evaluate("X = a ;\nV on t = z ;\n");
+		HAM_TEST_VERIFY(!replay(cache, evaluation, path))
+	}
+
+	// a rule called by the file has been redefined
+	{
+		IncludeCache cache;
+		HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+		Evaluation evaluation(&cache);
+		evaluation.Evaluate("X = a ;\nactions Build { cp $(2) $(1) }\n");
+		HAM_TEST_VERIFY(!replay(cache, evaluation, path))
+	}
+
+	// the file has changed and is evaluated again
+	CreateFile(path.c_str(), "Y = changed ;\n");
+	touch(path);
+	IncludeCache cache;
+	HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+	Evaluation evaluation(&cache);
+	evaluation.Evaluate("X = a ;\n");
+	HAM_TEST_VERIFY(!replay(cache, evaluation, path))
+	evaluation.Evaluate(include_code(path));
+	HAM_TEST_EQUAL(evaluation.Variable("Y"), MakeStringList("changed"))
+	HAM_TEST_EQUAL(evaluation.fOutput.str(), std::string())
+}
+
+void
+IncludeCacheTest::Untrackable()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string path = MakePath(directory.c_str(), "included");
+	std::string cacheFile = MakePath(directory.c_str(), "cache");
+
+	// files that define rules or call rules with other effects aren't
+	// recorded
+	const char* const untrackableCodes[] = {
+		"rule R { }\n",
+		"actions A { }\n",
+		"Y = [ GLOB . : * ] ;\n",
+		"Unknown x ;\n",
+	};
+	for (const char* code : untrackableCodes) {
+		HAM_TEST_ADD_INFO(
+			HAM_TEST_VERIFY(!is_repeated(path, cacheFile, code)),
+			"code: \"%s\"",
+			code
+		)
+	}
+
+	// a file's own local variables don't keep it from being recorded, nor do
+	// those of the including code
+	HAM_TEST_VERIFY(is_repeated(
+		path,
+		cacheFile,
+		"local l = x ;\nfor l in y { }\nZ = $(l) ;\n"
+	))
+	HAM_TEST_VERIFY(is_repeated(path, cacheFile, "l = x ;\n"))
+	HAM_TEST_VERIFY(is_repeated(path, cacheFile, "for l in x y { }\n"))
+
+	IncludeCache cache;
+	HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+	Evaluation evaluation(&cache);
+	evaluation.Evaluate("local l ;\n" + include_code(path) + "Z = $(l) ;\n");
+	HAM_TEST_EQUAL(evaluation.Variable("Y"), StringList())
+	HAM_TEST_EQUAL(evaluation.Variable("Z"), MakeStringList("y"))
+}
+
+void
+IncludeCacheTest::Load()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string directory = temporaryDirectoryCreator.Create(false);
+	std::string path = MakePath(directory.c_str(), "included");
+	std::string cacheFile = MakePath(directory.c_str(), "cache");
+	CreateFile(path.c_str(), kIncludedCode);
+
+	IncludeCache cache;
+	HAM_TEST_VERIFY(!cache.Load(cacheFile.c_str(), kIdentity))
+
+	IncludeCache recordingCache;
+	Evaluation recording(&recordingCache);
+	recording.Evaluate(include_code(path));
+	HAM_TEST_VERIFY(recordingCache.Save(cacheFile.c_str(), kIdentity))
+	HAM_TEST_VERIFY(cache.Load(cacheFile.c_str(), kIdentity))
+
+	// records saved for something else are ignored
+	HAM_TEST_VERIFY(!cache.Load(cacheFile.c_str(), "other"))
+	Evaluation evaluation(&cache);
+	evaluation.Evaluate("X = a ;\n");
+	HAM_TEST_VERIFY(!replay(cache, evaluation, path))
+
+	// so are damaged ones
+	std::string content;
+	{
+		std::stringstream stream;
+		stream << std::ifstream(cacheFile).rdbuf();
+		content = stream.str();
+	}
+	for (size_t size : {size_t(3), content.size() / 2, content.size() - 1}) {
+		std::ofstream(cacheFile, std::ios::binary | std::ios::trunc)
+			.write(content.data(), size);
+		HAM_TEST_ADD_INFO(
+			HAM_TEST_VERIFY(!cache.Load(cacheFile.c_str(), kIdentity)),
+			"size: %zu",
+			size
+		)
+	}
+}
+
+} // namespace ham::tests
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_INCLUDE_CACHE_TEST_HPP
+#define HAM_TESTS_INCLUDE_CACHE_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class IncludeCacheTest : public test::TestFixture
+{
+  public:
+	void Replay();
+	void Invalidation();
+	void Untrackable();
+	void Load();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(
+		IncludeCacheTest,
+		4,
+		Replay,
+		Invalidation,
+		Untrackable,
+		Load
+	)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_INCLUDE_CACHE_TEST_HPP
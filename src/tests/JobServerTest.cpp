@@ -0,0 +1,159 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/JobServerTest.hpp"
+
+#include "process/JobServer.hpp"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ham::tests
+{
+
+using process::JobServer;
+
+void
+JobServerTest::ParseMakeFlags()
+{
+	struct TestData {
+		const char* makeFlags;
+		bool found;
+		const char* fifoPath;
+		int readFd;
+		int writeFd;
+	};
+
+	const TestData testData[] = {
+		{"", false, "", -1, -1},
+		{"k -j4", false, "", -1, -1},
+		{" -j4 --jobserver-auth=3,4", true, "", 3, 4},
+		{"-j --jobserver-fds=5,6 -j", true, "", 5, 6},
+		{"--jobserver-auth=fifo:/tmp/GMfifo1", true, "/tmp/GMfifo1", -1, -1},
+		{"--jobserver-auth=3,4 --jobserver-auth=7,8", true, "", 7, 8},
+		{"--jobserver-auth=3,4 --jobserver-auth=fifo:x", true, "x", -1, -1},
+		{"--jobserver-auth=fifo:", false, "", -1, -1},
+		{"--jobserver-auth=3", false, "", -1, -1},
+		{"--jobserver-auth=3,4x", false, "", -1, -1},
+		{"--jobserver-auth=-2,-2", false, "", -1, -1},
+		{"--jobserver-authx=3,4", false, "", -1, -1},
+	};
+
+	for (size_t i = 0; i < sizeof(testData) / sizeof(testData[0]); i++) {
+		std::string fifoPath;
+		int readFd = -1;
+		int writeFd = -1;
+		bool found = JobServer::ParseMakeFlags(
+			testData[i].makeFlags,
+			fifoPath,
+			readFd,
+			writeFd
+		);
+		HAM_TEST_ADD_INFO(
+			HAM_TEST_EQUAL(found, testData[i].found)
+			if (found) {
+				HAM_TEST_EQUAL(fifoPath, testData[i].fifoPath)
+				if (fifoPath.empty()) {
+					HAM_TEST_EQUAL(readFd, testData[i].readFd)
+					HAM_TEST_EQUAL(writeFd, testData[i].writeFd)
+				}
+			},
+			"makeFlags: \"%s\"",
+			testData[i].makeFlags
+		)
+	}
+}
+
+void
+JobServerTest::Pipe()
+{
+	const char* oldMakeFlags = getenv(JobServer::kMakeFlagsVariableName);
+	std::string oldMakeFlagsValue = oldMakeFlags != nullptr ? oldMakeFlags : "";
+
+	{
+		// the server advertises itself in MAKEFLAGS
+		JobServer server;
+		HAM_TEST_VERIFY(server.Create(3))
+		HAM_TEST_VERIFY(server.IsServer())
+		const char* makeFlags = getenv(JobServer::kMakeFlagsVariableName);
+		HAM_TEST_VERIFY(makeFlags != nullptr)
+
+		// a client finds the 2 tokens for the jobs beyond the first one
+		JobServer client;
+		HAM_TEST_VERIFY(client.Connect(makeFlags))
+		HAM_TEST_VERIFY(!client.IsServer())
+		HAM_TEST_VERIFY(client.AcquireToken())
+		HAM_TEST_VERIFY(client.AcquireToken())
+		HAM_TEST_VERIFY(!client.AcquireToken())
+		HAM_TEST_EQUAL(client.TokenCount(), 2u)
+
+		// the server gets a token once the client returns it
+		HAM_TEST_VERIFY(!server.AcquireToken())
+		client.ReleaseToken();
+		HAM_TEST_EQUAL(client.TokenCount(), 1u)
+		HAM_TEST_VERIFY(server.AcquireToken())
+		HAM_TEST_VERIFY(!server.AcquireToken())
+		server.ReleaseTokens();
+		client.ReleaseTokens();
+		HAM_TEST_EQUAL(client.TokenCount(), 0u)
+		HAM_TEST_VERIFY(client.AcquireToken())
+		HAM_TEST_VERIFY(client.AcquireToken())
+		HAM_TEST_VERIFY(!client.AcquireToken())
+	}
+
+	// MAKEFLAGS is restored
+	const char* makeFlags = getenv(JobServer::kMakeFlagsVariableName);
+	HAM_TEST_EQUAL(makeFlags != nullptr, oldMakeFlags != nullptr)
+	if (makeFlags != nullptr)
+		HAM_TEST_EQUAL(std::string(makeFlags), oldMakeFlagsValue)
+
+	// closed descriptors are no job server
+	int fds[2];
+	HAM_TEST_VERIFY(pipe(fds) == 0)
+	close(fds[0]);
+	close(fds[1]);
+	std::string closedMakeFlags = "--jobserver-auth="
+		+ std::to_string(fds[0]) + "," + std::to_string(fds[1]);
+	JobServer client;
+	HAM_TEST_VERIFY(!client.Connect(closedMakeFlags.c_str()))
+	HAM_TEST_VERIFY(!client.IsValid())
+}
+
+void
+JobServerTest::Fifo()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string fifoPath =
+		MakePath(temporaryDirectoryCreator.Create(false), "fifo");
+	HAM_TEST_VERIFY(mkfifo(fifoPath.c_str(), 0600) == 0)
+	int fd = open(fifoPath.c_str(), O_RDWR | O_NONBLOCK);
+	HAM_TEST_VERIFY(fd >= 0)
+	HAM_TEST_EQUAL(write(fd, "+-", 2), 2)
+
+	std::string makeFlags = "-j3 --jobserver-auth=fifo:" + fifoPath;
+	{
+		JobServer client;
+		HAM_TEST_VERIFY(client.Connect(makeFlags.c_str()))
+		HAM_TEST_VERIFY(client.AcquireToken())
+		HAM_TEST_VERIFY(client.AcquireToken())
+		HAM_TEST_VERIFY(!client.AcquireToken())
+		HAM_TEST_EQUAL(client.TokenCount(), 2u)
+	}
+
+	// the client has returned the very same tokens
+	char tokens[3];
+	HAM_TEST_EQUAL(read(fd, tokens, sizeof(tokens)), 2)
+	HAM_TEST_VERIFY((tokens[0] == '+' && tokens[1] == '-')
+		|| (tokens[0] == '-' && tokens[1] == '+'))
+	close(fd);
+
+	JobServer client;
+	std::string missingMakeFlags = "--jobserver-auth=fifo:" + fifoPath + "x";
+	HAM_TEST_VERIFY(!client.Connect(missingMakeFlags.c_str()))
+}
+
+} // namespace ham::tests
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_JOB_SERVER_TEST_HPP
+#define HAM_TESTS_JOB_SERVER_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class JobServerTest : public test::TestFixture
+{
+  public:
+	void ParseMakeFlags();
+	void Pipe();
+	void Fifo();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(JobServerTest, 3, ParseMakeFlags, Pipe, Fifo)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_JOB_SERVER_TEST_HPP
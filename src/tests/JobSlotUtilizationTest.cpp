@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/JobSlotUtilizationTest.hpp"
+
+#include "make/JobSlotUtilization.hpp"
+
+#include <sstream>
+#include <string>
+
+namespace ham::tests
+{
+
+using make::JobSlotUtilization;
+
+static const int64_t kMillisecond = 1000000;
+// in nanoseconds
+
+void
+JobSlotUtilizationTest::IdleReasons()
+{
+	JobSlotUtilization::Clock::time_point start =
+		JobSlotUtilization::Clock::now();
+	auto at = [start](int milliseconds) {
+		return start + std::chrono::milliseconds(milliseconds);
+	};
+
+	JobSlotUtilization utilization(2, start);
+
+	// 0-10: the main thread expands the first command
+	utilization.AddCommandExpansionTime(std::chrono::milliseconds(10));
+	utilization.SlotBusy(0, at(10));
+
+	// 10-30: it waits with a ready target it may not start
+	utilization.MainThreadWaiting(JobSlotUtilization::IDLE_THROTTLED, at(10));
+	utilization.SlotIdle(0, at(30));
+	utilization.MainThreadBusy(at(30));
+
+	// 30-35: it starts two commands
+	utilization.SlotBusy(0, at(32));
+	utilization.SlotBusy(1, at(35));
+
+	// 35-50: it waits without ready targets
+	utilization.MainThreadWaiting(
+		JobSlotUtilization::IDLE_NO_READY_TARGETS,
+		at(35)
+	);
+	utilization.SlotIdle(1, at(40));
+	utilization.SlotIdle(0, at(50));
+	utilization.MainThreadBusy(at(50));
+	utilization.Finish(at(60));
+
+	HAM_TEST_EQUAL(utilization.CommandCount(0), 2u)
+	HAM_TEST_EQUAL(utilization.CommandCount(1), 1u)
+
+	HAM_TEST_EQUAL(utilization.BusyTime(0), 38 * kMillisecond)
+	HAM_TEST_EQUAL(
+		utilization.IdleTime(0, JobSlotUtilization::IDLE_MAIN_THREAD_BUSY),
+		22 * kMillisecond
+	)
+	HAM_TEST_EQUAL(
+		utilization.IdleTime(0, JobSlotUtilization::IDLE_THROTTLED),
+		0
+	)
+
+	HAM_TEST_EQUAL(utilization.BusyTime(1), 5 * kMillisecond)
+	HAM_TEST_EQUAL(
+		utilization.IdleTime(1, JobSlotUtilization::IDLE_MAIN_THREAD_BUSY),
+		25 * kMillisecond
+	)
+	HAM_TEST_EQUAL(
+		utilization.IdleTime(1, JobSlotUtilization::IDLE_THROTTLED),
+		20 * kMillisecond
+	)
+	HAM_TEST_EQUAL(
+		utilization.IdleTime(1, JobSlotUtilization::IDLE_NO_READY_TARGETS),
+		10 * kMillisecond
+	)
+}
+
+void
+JobSlotUtilizationTest::Summary()
+{
+	JobSlotUtilization::Clock::time_point start =
+		JobSlotUtilization::Clock::now();
+	JobSlotUtilization utilization(1, start);
+	utilization.SlotBusy(0, start);
+	utilization.MainThreadWaiting(
+		JobSlotUtilization::IDLE_NO_READY_TARGETS,
+		start
+	);
+	utilization.SlotIdle(0, start + std::chrono::milliseconds(750));
+	utilization.Finish(start + std::chrono::milliseconds(1000));
+
+	std::stringstream output;
+	utilization.PrintSummary(output);
+	std::string summary = output.str();
+
+	HAM_TEST_ADD_INFO(
+		HAM_TEST_VERIFY(
+			summary.find(
+				"1 job slot(s) over 1.000 s, 75.0% busy\n"
+				"idle: 25.0% for lack of ready targets, 0.0% throttled, 0.0% "
+				"with the main thread busy\n"
+				"main thread: 0.000 s expanding commands, 0.000 s otherwise "
+				"busy, 1.000 s waiting for commands\n"
+			)
+			!= std::string::npos
+		)
+		HAM_TEST_VERIFY(
+			summary.find(
+				"     1         1    75.0%     25.0%       0.0%       0.0%\n"
+			)
+			!= std::string::npos
+		),
+		"summary:\n%s",
+		summary.c_str()
+	)
+}
+
+} // namespace ham::tests
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_JOB_SLOT_UTILIZATION_TEST_HPP
+#define HAM_TESTS_JOB_SLOT_UTILIZATION_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class JobSlotUtilizationTest : public test::TestFixture
+{
+  public:
+	void IdleReasons();
+	void Summary();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(JobSlotUtilizationTest, 2, IdleReasons, Summary)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_JOB_SLOT_UTILIZATION_TEST_HPP
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/MetricsTest.hpp"
+
+#include "util/Metrics.hpp"
+#include "util/MetricsServer.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ham::tests
+{
+
+using util::Counter;
+using util::Gauge;
+using util::Metric;
+
+static std::string
+write_metrics()
+{
+	std::stringstream output;
+	Metric::WriteAll(output);
+	return output.str();
+}
+
+void
+MetricsTest::Write()
+{
+	Counter hits("test_hits", "Hits.", "cache=\"a\"");
+	Gauge duration("test_duration_seconds", "Duration.", nullptr, 1e-9);
+	Counter otherHits("test_hits", "Hits.", "cache=\"b\"");
+
+	hits.Increment();
+	hits.Increment(2);
+	otherHits.Increment();
+	duration.Set(1500000000);
+	duration.Add(-250000000);
+	HAM_TEST_EQUAL(hits.Value(), 3)
+	HAM_TEST_EQUAL(duration.Value(), 1250000000)
+
+	std::string output = write_metrics();
+	HAM_TEST_ADD_INFO(
+		HAM_TEST_VERIFY(
+			output.find(
+				"# TYPE test_hits counter\n"
+				"# HELP test_hits Hits.\n"
+				"test_hits_total{cache=\"a\"} 3\n"
+				"test_hits_total{cache=\"b\"} 1\n"
+			)
+			!= std::string::npos
+		),
+		"output:\n%s",
+		output.c_str()
+	)
+	HAM_TEST_ADD_INFO(
+		HAM_TEST_VERIFY(
+			output.find(
+				"# TYPE test_duration_seconds gauge\n"
+				"# HELP test_duration_seconds Duration.\n"
+				"test_duration_seconds 1.250000\n"
+			)
+			!= std::string::npos
+		),
+		"output:\n%s",
+		output.c_str()
+	)
+	HAM_TEST_VERIFY(output.size() >= 6)
+	HAM_TEST_EQUAL(output.substr(output.size() - 6), std::string("# EOF\n"))
+
+	// a Timer sets its gauge when it goes out of scope
+	{
+		Gauge::Timer timer(duration);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+	HAM_TEST_VERIFY(duration.Value() >= 2000000)
+	HAM_TEST_VERIFY(duration.Value() < 1250000000)
+}
+
+void
+MetricsTest::Threads()
+{
+	Counter counter("test_thread_increments", "Increments.");
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; i++) {
+		threads.emplace_back([&counter] {
+			for (int k = 0; k < 10000; k++)
+				counter.Increment();
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	HAM_TEST_EQUAL(counter.Value(), 40000)
+}
+
+void
+MetricsTest::Server()
+{
+	TemporaryDirectoryCreator temporaryDirectoryCreator;
+	std::string path =
+		MakePath(temporaryDirectoryCreator.Create(false), "metrics.sock");
+
+	Counter counter("test_served", "Served.");
+	counter.Increment(7);
+
+	util::MetricsServer server;
+	HAM_TEST_VERIFY(server.Start(path.c_str()))
+
+	// two scrapes in a row
+	for (int i = 0; i < 2; i++) {
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		HAM_TEST_VERIFY(fd >= 0)
+		struct sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strcpy(address.sun_path, path.c_str());
+		HAM_TEST_VERIFY(
+			connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0
+		)
+
+		const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+		HAM_TEST_VERIFY(
+			write(fd, request, sizeof(request) - 1)
+			== (ssize_t)sizeof(request) - 1
+		)
+
+		std::string response;
+		char buffer[4096];
+		ssize_t bytesRead;
+		while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
+			response.append(buffer, bytesRead);
+		close(fd);
+
+		HAM_TEST_ADD_INFO(
+			HAM_TEST_VERIFY(response.starts_with("HTTP/1.0 200 OK\r\n"))
+			HAM_TEST_VERIFY(
+				response.find("Content-Type: application/openmetrics-text;")
+				!= std::string::npos
+			)
+			HAM_TEST_VERIFY(
+				response.find("\r\n\r\n# TYPE ") != std::string::npos
+			)
+			HAM_TEST_VERIFY(
+				response.find("test_served_total 7\n") != std::string::npos
+			)
+			HAM_TEST_VERIFY(response.ends_with("# EOF\n")),
+			"response:\n%s",
+			response.c_str()
+		)
+	}
+
+	server.Stop();
+	HAM_TEST_VERIFY(access(path.c_str(), F_OK) != 0)
+}
+
+} // namespace ham::tests
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_METRICS_TEST_HPP
+#define HAM_TESTS_METRICS_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class MetricsTest : public test::TestFixture
+{
+  public:
+	void Write();
+	void Threads();
+	void Server();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(MetricsTest, 3, Write, Threads, Server)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_METRICS_TEST_HPP
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/RuleProfilerTest.hpp"
+
+#include "code/Block.hpp"
+#include "code/BuiltInRules.hpp"
+#include "code/EvaluationContext.hpp"
+#include "code/RuleProfiler.hpp"
+#include "data/TargetPool.hpp"
+#include "data/VariableDomain.hpp"
+#include "parser/Parser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+namespace ham::tests
+{
+
+using code::RuleProfiler;
+
+struct ReportLine {
+	size_t calls;
+	double inclusiveTime;
+	double selfTime;
+	size_t inclusiveAllocations;
+	size_t selfAllocations;
+};
+
+/**
+ * Finds the report line of \a rule and parses its numbers.
+ */
+static bool
+find_report_line(
+	const std::string& report,
+	const std::string& rule,
+	ReportLine& _line
+)
+{
+	std::istringstream input(report);
+	std::string line;
+	while (std::getline(input, line)) {
+		if (line.size() < rule.size() + 2
+			|| line.compare(line.size() - rule.size() - 2, std::string::npos,
+				   "  " + rule)
+				!= 0) {
+			continue;
+		}
+
+		return sscanf(
+				   line.c_str(),
+				   "%zu %lf %lf %zu %zu",
+				   &_line.calls,
+				   &_line.inclusiveTime,
+				   &_line.selfTime,
+				   &_line.inclusiveAllocations,
+				   &_line.selfAllocations
+			   )
+			== 5;
+	}
+
+	return false;
+}
+
+void
+RuleProfilerTest::Calls()
+{
+	data::VariableDomain globalVariables;
+	data::TargetPool targets;
+	code::EvaluationContext context(globalVariables, targets);
+	code::BuiltInRules::RegisterRules(context.Rules());
+	RuleProfiler profiler;
+	context.SetProfiler(&profiler);
+
+	util::Reference<code::Block> block(
+		parser::Parser().Parse(std::string(
+			"rule Inner { }\n"
+			"rule Outer { Inner ; Inner ; }\n"
+			"rule Recurse { if $(1) { Recurse $(1[2-]) ; } }\n"
+			"Outer ; Outer ;\n"
+			"Recurse a b c ;\n"
+		)),
+		true
+	);
+	block->Evaluate(context);
+
+	std::stringstream output;
+	profiler.PrintReport(output);
+	std::string report = output.str();
+
+	ReportLine line;
+	HAM_TEST_ADD_INFO(
+		HAM_TEST_VERIFY(find_report_line(report, "Outer", line))
+		HAM_TEST_EQUAL(line.calls, 2u)
+		HAM_TEST_VERIFY(find_report_line(report, "Inner", line))
+		HAM_TEST_EQUAL(line.calls, 4u)
+		HAM_TEST_VERIFY(find_report_line(report, "Recurse", line))
+		HAM_TEST_EQUAL(line.calls, 4u)
+		HAM_TEST_VERIFY(line.inclusiveTime >= line.selfTime),
+		"report:\n%s",
+		report.c_str()
+	)
+}
+
+// Passing the memory through a volatile keeps the allocation from being
+// optimized away.
+static void* volatile sAllocation;
+
+static void
+allocate()
+{
+	sAllocation = new int;
+	delete (int*)sAllocation;
+}
+
+void
+RuleProfilerTest::Allocations()
+{
+	RuleProfiler profiler;
+
+	// the names are allocated up front, so they aren't counted
+	String a("A");
+	String b("B");
+
+	// a rule allocating once and calling itself, and another one
+	profiler.BeginCall(a);
+	allocate();
+	profiler.BeginCall(a);
+	allocate();
+	profiler.BeginCall(b);
+	allocate();
+	allocate();
+	profiler.EndCall();
+	profiler.EndCall();
+	profiler.EndCall();
+
+	std::stringstream output;
+	profiler.PrintReport(output);
+	std::string report = output.str();
+
+	ReportLine line;
+	HAM_TEST_ADD_INFO(
+		HAM_TEST_VERIFY(find_report_line(report, "A", line))
+		HAM_TEST_EQUAL(line.calls, 2u)
+		HAM_TEST_EQUAL(line.inclusiveAllocations, 4u)
+		HAM_TEST_EQUAL(line.selfAllocations, 2u)
+		HAM_TEST_VERIFY(find_report_line(report, "B", line))
+		HAM_TEST_EQUAL(line.calls, 1u)
+		HAM_TEST_EQUAL(line.inclusiveAllocations, 2u)
+		HAM_TEST_EQUAL(line.selfAllocations, 2u),
+		"report:\n%s",
+		report.c_str()
+	)
+}
+
+void
+RuleProfilerTest::StringAllocations()
+{
+	data::VariableDomain globalVariables;
+	data::TargetPool targets;
+	code::EvaluationContext context(globalVariables, targets);
+	code::BuiltInRules::RegisterRules(context.Rules());
+	RuleProfiler profiler;
+	context.SetProfiler(&profiler);
+
+	// Every concatenation creates a new string, which String allocates
+	// directly, not via operator new.
+	util::Reference<code::Block> block(
+		parser::Parser().Parse(std::string(
+			"rule Concat {\n"
+			"	local result = start ;\n"
+			"	for letter in a b c d e f g h i j k l m\n"
+			"		n o p q r s t u v w x y z {\n"
+			"		result = $(result)-$(letter)-a-long-suffix ;\n"
+			"	}\n"
+			"	return $(result) ;\n"
+			"}\n"
+			"Concat ;\n"
+		)),
+		true
+	);
+	block->Evaluate(context);
+
+	std::stringstream output;
+	profiler.PrintReport(output);
+	std::string report = output.str();
+
+	ReportLine line;
+	HAM_TEST_ADD_INFO(
+		HAM_TEST_VERIFY(find_report_line(report, "Concat", line))
+		HAM_TEST_VERIFY(line.selfAllocations >= 26),
+		"report:\n%s",
+		report.c_str()
+	)
+}
+
+void
+RuleProfilerTest::CollapsedStacks()
+{
+	RuleProfiler profiler;
+
+	profiler.BeginCall("A");
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	profiler.BeginCall("B");
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	profiler.EndCall();
+	profiler.EndCall();
+
+	std::stringstream output;
+	profiler.WriteCollapsedStacks(output);
+
+	std::string stack;
+	long microseconds;
+	HAM_TEST_VERIFY(output >> stack >> microseconds)
+	HAM_TEST_EQUAL(stack, std::string("A"))
+	HAM_TEST_VERIFY(microseconds >= 2000)
+	HAM_TEST_VERIFY(output >> stack >> microseconds)
+	HAM_TEST_EQUAL(stack, std::string("A;B"))
+	HAM_TEST_VERIFY(microseconds >= 2000)
+	HAM_TEST_VERIFY(!(output >> stack))
+}
+
+} // namespace ham::tests
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_RULE_PROFILER_TEST_HPP
+#define HAM_TESTS_RULE_PROFILER_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class RuleProfilerTest : public test::TestFixture
+{
+  public:
+	void Calls();
+	void Allocations();
+	void StringAllocations();
+	void CollapsedStacks();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(
+		RuleProfilerTest,
+		4,
+		Calls,
+		Allocations,
+		StringAllocations,
+		CollapsedStacks
+	)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_RULE_PROFILER_TEST_HPP
@@ -6,6 +6,7 @@
 #include "tests/StringListTest.hpp"
 
 #include "data/StringList.hpp"
+#include "data/StringListProduct.hpp"
 
 #include <numeric>
 #include <string>
@@ -671,6 +672,44 @@ StringListTest::Multiply()
 	}
 }
 
+void
+StringListTest::Product()
+{
+	using data::StringListProduct;
+
+	const TestListList testData[] = {
+		TestListList(),
+		TestListList() + TestList(),
+		TestListList() + (TestList() + ""),
+		TestListList() + (TestList() + "foo"),
+		TestListList() + (TestList() + "-I") + (TestList() + "a" + "bb" + "ccc"),
+		TestListList() + (TestList() + "a" + "b") + TestList()
+			+ (TestList() + "x"),
+		TestListList() + (TestList() + "a" + "b" + "c")
+			+ (TestList() + "x" + "" + "y") + (TestList() + "1" + "2"),
+	};
+
+	for (size_t i = 0; i < sizeof(testData) / sizeof(testData[0]); i++) {
+		StringListList listList = MakeStringListList(testData[i]);
+		StringList expected = StringList::Multiply(listList);
+		StringListProduct product(listList);
+
+		HAM_TEST_EQUAL(product.Size(), expected.Size())
+		HAM_TEST_EQUAL(product.IsEmpty(), expected.IsEmpty())
+		HAM_TEST_EQUAL(product.ToStringList(), expected)
+
+		for (size_t k = 0; k < expected.Size(); k++)
+			HAM_TEST_EQUAL(product.ElementAt(k), expected.ElementAt(k))
+		HAM_TEST_EQUAL(product.ElementAt(expected.Size()), String())
+
+		HAM_TEST_EQUAL(
+			product.Join(StringPart(" ")),
+			expected.Join(StringPart(" "))
+		)
+		HAM_TEST_EQUAL(product.Join(StringPart()), expected.Join())
+	}
+}
+
 void
 StringListTest::Iteration()
 {
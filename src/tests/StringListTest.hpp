@@ -26,12 +26,13 @@ class StringListTest : public test::TestFixture
 	void Join();
 	void JoinWithSeparator();
 	void Multiply();
+	void Product();
 	void Iteration();
 
 	// declare tests
 	HAM_ADD_TEST_CASES(
 		StringListTest,
-		14,
+		15,
 		Constructor,
 		ElementAccess,
 		IsTrue,
@@ -45,6 +46,7 @@ class StringListTest : public test::TestFixture
 		Join,
 		JoinWithSeparator,
 		Multiply,
+		Product,
 		Iteration
 	)
 };
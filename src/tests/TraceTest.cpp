@@ -0,0 +1,147 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "tests/TraceTest.hpp"
+
+#include "util/Trace.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace ham::tests
+{
+
+using util::Trace;
+
+static size_t
+count_occurrences(const std::string& string, const std::string& pattern)
+{
+	size_t count = 0;
+	for (size_t index = string.find(pattern); index != std::string::npos;
+		 index = string.find(pattern, index + 1)) {
+		count++;
+	}
+	return count;
+}
+
+static std::string
+write_trace(const Trace& trace)
+{
+	std::stringstream output;
+	trace.Write(output);
+	return output.str();
+}
+
+void
+TraceTest::Spans()
+{
+	// without an active trace spans aren't recorded anywhere
+	HAM_TEST_VERIFY(Trace::Active() == nullptr)
+	{
+		Trace::Span span("Nothing");
+	}
+
+	Trace trace;
+	Trace::SetActive(&trace);
+	trace.NameThread("main");
+	{
+		Trace::Span span("Include", "file", "dir/\"quoted\"\\Jamfile");
+	}
+
+	Trace::Clock::time_point start = Trace::Clock::now();
+	trace.AddSpan(
+		"Cc",
+		start,
+		start + std::chrono::microseconds(1500),
+		"targets",
+		"a.o",
+		1
+	);
+
+	std::string output = write_trace(trace);
+	HAM_TEST_ADD_INFO(
+		HAM_TEST_EQUAL(count_occurrences(output, "\"ph\":\"X\""), 2u),
+		"output: %s",
+		output.c_str()
+	)
+	HAM_TEST_VERIFY(output.find("\"traceEvents\":[") != std::string::npos)
+	HAM_TEST_VERIFY(
+		output.find("\"args\":{\"name\":\"main\"}") != std::string::npos
+	)
+	HAM_TEST_VERIFY(
+		output.find("\"file\":\"dir/\\\"quoted\\\"\\\\Jamfile\"")
+		!= std::string::npos
+	)
+	HAM_TEST_VERIFY(output.find("\"Nothing\"") == std::string::npos)
+
+	// commands go to the lanes of their job slots
+	HAM_TEST_VERIFY(
+		output.find("\"dur\":1500.000,\"pid\":2,\"tid\":2") != std::string::npos
+	)
+	HAM_TEST_VERIFY(
+		output.find("\"args\":{\"name\":\"job slot 2\"}") != std::string::npos
+	)
+
+	Trace::SetActive(nullptr);
+}
+
+void
+TraceTest::Threads()
+{
+	Trace trace;
+	Trace::SetActive(&trace);
+	trace.NameThread("main");
+	{
+		Trace::Span span("Main");
+	}
+
+	std::thread thread([]() {
+		Trace::Active()->NameThread("worker");
+		Trace::Span span("Worker");
+	});
+	thread.join();
+
+	std::string output = write_trace(trace);
+	HAM_TEST_VERIFY(
+		output.find("\"name\":\"Main\",\"ph\":\"X\"") != std::string::npos
+	)
+	HAM_TEST_VERIFY(
+		output.find("\"pid\":1,\"tid\":2,\"args\":{\"name\":\"worker\"}")
+		!= std::string::npos
+	)
+	HAM_TEST_VERIFY(output.find("\"pid\":1,\"tid\":2}") != std::string::npos)
+
+	Trace::SetActive(nullptr);
+
+	// a new trace doesn't use the threads' buffers of an old one
+	Trace otherTrace;
+	Trace::SetActive(&otherTrace);
+	{
+		Trace::Span span("Other");
+	}
+	output = write_trace(otherTrace);
+	HAM_TEST_EQUAL(count_occurrences(output, "\"ph\":\"X\""), 1u)
+	HAM_TEST_VERIFY(output.find("\"Main\"") == std::string::npos)
+
+	Trace::SetActive(nullptr);
+}
+
+void
+TraceTest::ManyEvents()
+{
+	// more events than fit into a buffer chunk
+	Trace trace;
+	Trace::SetActive(&trace);
+	for (int i = 0; i < 1000; i++)
+		Trace::Span span("Event");
+	Trace::SetActive(nullptr);
+
+	std::string output = write_trace(trace);
+	HAM_TEST_EQUAL(count_occurrences(output, "\"name\":\"Event\""), 1000u)
+	HAM_TEST_VERIFY(output.compare(output.size() - 2, 2, "}\n") == 0)
+}
+
+} // namespace ham::tests
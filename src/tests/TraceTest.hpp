@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_TESTS_TRACE_TEST_HPP
+#define HAM_TESTS_TRACE_TEST_HPP
+
+#include "test/TestFixture.hpp"
+
+namespace ham::tests
+{
+
+class TraceTest : public test::TestFixture
+{
+  public:
+	void Spans();
+	void Threads();
+	void ManyEvents();
+
+	// declare tests
+	HAM_ADD_TEST_CASES(TraceTest, 3, Spans, Threads, ManyEvents)
+};
+
+} // namespace ham::tests
+
+#endif // HAM_TESTS_TRACE_TEST_HPP
@@ -8,14 +8,25 @@
 #include "test/RunnableTest.hpp"
 #include "test/TestRunner.hpp"
 #include "test/TestSuite.hpp"
+#include "tests/AdmissionControlTest.hpp"
+#include "tests/BuildCacheTest.hpp"
+#include "tests/BuiltInCommandTest.hpp"
+#include "tests/DependencyLogTest.hpp"
+#include "tests/FrameArenaTest.hpp"
+#include "tests/IncludeCacheTest.hpp"
+#include "tests/JobServerTest.hpp"
+#include "tests/JobSlotUtilizationTest.hpp"
+#include "tests/MetricsTest.hpp"
 #include "tests/PathTest.hpp"
 #include "tests/RegExpTest.hpp"
+#include "tests/RuleProfilerTest.hpp"
 #include "tests/RulesetTest.hpp"
 #include "tests/StringListTest.hpp"
 #include "tests/StringPartTest.hpp"
 #include "tests/StringTest.hpp"
 #include "tests/TargetBinderTest.hpp"
 #include "tests/TimeTest.hpp"
+#include "tests/TraceTest.hpp"
 #include "tests/VariableExpansionTest.hpp"
 
 #include <dirent.h>
@@ -141,6 +152,10 @@ add_data_based_tests_recursive(
 		if (name[0] == '.')
 			continue;
 
+		// benchmark scripts aren't test data
+		if (name == "benchmarks")
+			continue;
+
 		std::string path = directory + '/' + name;
 		struct stat st;
 		if (stat(path.c_str(), &st) != 0)
@@ -197,6 +212,8 @@ main(int argc, const char* const* argv)
 	test::TestSuite testSuite;
 	test::TestSuiteBuilder(testSuite)
 		.AddSuite("Data")
+		.Add<FrameArenaTest>()
+		.Add<MetricsTest>()
 		.Add<PathTest>()
 		.Add<RegExpTest>()
 		.Add<RulesetTest>()
@@ -205,9 +222,20 @@ main(int argc, const char* const* argv)
 		.Add<StringTest>()
 		.Add<TargetBinderTest>()
 		.Add<TimeTest>()
+		.Add<TraceTest>()
 		.End()
 		.AddSuite("Code")
+		.Add<IncludeCacheTest>()
+		.Add<RuleProfilerTest>()
 		.Add<VariableExpansionTest>()
+		.End()
+		.AddSuite("Process")
+		.Add<AdmissionControlTest>()
+		.Add<BuildCacheTest>()
+		.Add<BuiltInCommandTest>()
+		.Add<DependencyLogTest>()
+		.Add<JobServerTest>()
+		.Add<JobSlotUtilizationTest>()
 		.End();
 
 	// parse arguments
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "util/AllocationCount.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// The other forms of operator new and delete end up here, too. The
+// replacement is always active; apart from counting the allocation it does
+// what the default one does, so it costs a thread-local increment per
+// allocation.
+void*
+operator new(std::size_t size)
+{
+	ham::util::CountAllocation();
+
+	if (size == 0)
+		size = 1;
+
+	for (;;) {
+		if (void* address = malloc(size))
+			return address;
+
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void
+operator delete(void* address) noexcept
+{
+	free(address);
+}
+
+void
+operator delete(void* address, std::size_t) noexcept
+{
+	free(address);
+}
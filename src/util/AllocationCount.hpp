@@ -0,0 +1,38 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_UTIL_ALLOCATION_COUNT_HPP
+#define HAM_UTIL_ALLOCATION_COUNT_HPP
+
+#include <cstddef>
+
+namespace ham::util
+{
+
+inline thread_local size_t sAllocationCount = 0;
+
+/**
+ * Counts a heap allocation of the calling thread. The global operator new,
+ * which is replaced to that end, and the allocators of String and StringList,
+ * which call malloc() directly, call it. The cost is a thread-local increment
+ * per allocation, which is always paid, not only when profiling.
+ */
+inline void
+CountAllocation()
+{
+	sAllocationCount++;
+}
+
+/**
+ * Returns the number of heap allocations the calling thread has done so far.
+ */
+inline size_t
+AllocationCount()
+{
+	return sAllocationCount;
+}
+
+} // namespace ham::util
+
+#endif // HAM_UTIL_ALLOCATION_COUNT_HPP
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "util/FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace ham::util
+{
+
+FrameArena::FrameArena()
+	: fChunks(),
+	  fPosition{0, 0},
+	  fFrameStart{0, 0}
+{
+}
+
+FrameArena::~FrameArena() {}
+
+void*
+FrameArena::do_allocate(size_t size, size_t alignment)
+{
+	for (;;) {
+		if (fPosition.fChunk < fChunks.size()) {
+			Chunk& chunk = fChunks[fPosition.fChunk];
+			uintptr_t base = reinterpret_cast<uintptr_t>(chunk.fData.get());
+			uintptr_t address = (base + fPosition.fOffset + alignment - 1)
+				& ~uintptr_t(alignment - 1);
+			size_t offset = address - base;
+			if (offset <= chunk.fSize && size <= chunk.fSize - offset) {
+				fPosition.fOffset = offset + size;
+				return chunk.fData.get() + offset;
+			}
+
+			// doesn't fit -- continue with the next chunk
+			fPosition.fChunk++;
+			fPosition.fOffset = 0;
+		}
+
+		_UseChunk(fPosition.fChunk, size + alignment);
+	}
+}
+
+void
+FrameArena::do_deallocate(void* address, size_t size, size_t)
+{
+	// Memory is released when the frame it was allocated in ends. A container
+	// freeing memory elsewhere has grown in a nested frame or outlived the
+	// frame of its memory, which is or will be overwritten.
+	if (!_IsInInnermostFrame(address, size)) {
+		fprintf(
+			stderr,
+			"FrameArena: freeing memory outside of the innermost frame; a "
+			"container has grown in a nested frame or outlived its frame\n"
+		);
+		abort();
+	}
+}
+
+bool
+FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+/**
+ * Makes sure chunk \a index exists and has at least \a minSize bytes. Since
+ * frames are strictly nested, all chunks after the current one are unused and
+ * an existing chunk that is too small can simply be replaced.
+ */
+void
+FrameArena::_UseChunk(size_t index, size_t minSize)
+{
+	if (index < fChunks.size() && fChunks[index].fSize >= minSize)
+		return;
+
+	size_t size = std::max(kChunkSize, minSize);
+	Chunk chunk{std::make_unique<std::byte[]>(size), size};
+	if (index < fChunks.size())
+		fChunks[index] = std::move(chunk);
+	else
+		fChunks.push_back(std::move(chunk));
+}
+
+/**
+ * Returns whether the \a size bytes at \a address have been allocated since
+ * the innermost frame was created and haven't been released yet.
+ */
+bool
+FrameArena::_IsInInnermostFrame(const void* address, size_t size) const
+{
+	const std::byte* start = static_cast<const std::byte*>(address);
+	for (size_t i = fFrameStart.fChunk;
+		 i <= fPosition.fChunk && i < fChunks.size();
+		 i++) {
+		const std::byte* data = fChunks[i].fData.get();
+		if (start < data || start >= data + fChunks[i].fSize)
+			continue;
+
+		size_t offset = start - data;
+		return (i > fFrameStart.fChunk || offset >= fFrameStart.fOffset)
+			&& (i < fPosition.fChunk || offset + size <= fPosition.fOffset);
+	}
+
+	return false;
+}
+
+} // namespace ham::util
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_UTIL_FRAME_ARENA_HPP
+#define HAM_UTIL_FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace ham::util
+{
+
+/**
+ * Bump allocator for temporaries with strictly nested lifetimes, like the
+ * arguments and variable domains of a rule call.
+ *
+ * Memory is handed out by advancing a position through a list of chunks;
+ * deallocation is a no-op. A Frame records the position when it is created and
+ * rewinds to it when it is destroyed, releasing everything allocated while it
+ * was the innermost frame at once. The chunks are kept for reuse, so in the
+ * steady state no heap allocations are done at all.
+ *
+ * A container using the arena must be created after and destroyed before the
+ * innermost frame, and may only grow while no nested frame exists. Freeing
+ * memory that doesn't lie between the start of the innermost frame and the
+ * current position, which is what growing or destroying a container that
+ * breaks this rule does, aborts the program. Anything
+ * that outlives the frame must be copied out. For the interpreter's
+ * temporaries that is cheap: they hold StringLists, whose data is reference
+ * counted and allocated independently of the containing container, so rule
+ * results and values assigned to outer variables simply keep a reference.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+  public:
+	class Frame;
+
+  public:
+	FrameArena();
+	~FrameArena() override;
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+  private:
+	struct Chunk {
+		std::unique_ptr<std::byte[]> fData;
+		size_t fSize;
+	};
+
+	struct Position {
+		size_t fChunk;
+		size_t fOffset;
+	};
+
+	static constexpr size_t kChunkSize = 64 * 1024;
+
+  private:
+	void* do_allocate(size_t size, size_t alignment) override;
+	void do_deallocate(void* address, size_t size, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other
+	) const noexcept override;
+
+	void _UseChunk(size_t index, size_t minSize);
+	bool _IsInInnermostFrame(const void* address, size_t size) const;
+
+  private:
+	std::vector<Chunk> fChunks;
+	Position fPosition;
+	Position fFrameStart;
+	// the position the innermost frame was created at
+};
+
+/**
+ * Scope guard releasing everything allocated from the arena during its
+ * lifetime. Frames must be strictly nested, so they are only ever created on
+ * the stack.
+ */
+class FrameArena::Frame
+{
+  public:
+	Frame(FrameArena& arena)
+		: fArena(arena),
+		  fPosition(arena.fPosition),
+		  fOuterFrameStart(arena.fFrameStart)
+	{
+		arena.fFrameStart = fPosition;
+	}
+
+	~Frame()
+	{
+		fArena.fPosition = fPosition;
+		fArena.fFrameStart = fOuterFrameStart;
+	}
+
+	Frame(const Frame&) = delete;
+	Frame& operator=(const Frame&) = delete;
+
+  private:
+	FrameArena& fArena;
+	Position fPosition;
+	Position fOuterFrameStart;
+};
+
+} // namespace ham::util
+
+#endif // HAM_UTIL_FRAME_ARENA_HPP
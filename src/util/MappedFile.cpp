@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "util/MappedFile.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ham::util
+{
+
+MappedFile::MappedFile()
+	: fData(""),
+	  fSize(0),
+	  fMapped(false),
+	  fBuffer(),
+	  fStatus()
+{
+}
+
+MappedFile::~MappedFile() { Close(); }
+
+bool
+MappedFile::Open(const char* path)
+{
+	Close();
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	if (fstat(fd, &fStatus) != 0) {
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+
+	// mapping an empty file fails, but there is nothing to read anyway
+	if (S_ISREG(fStatus.st_mode) && fStatus.st_size == 0) {
+		close(fd);
+		return true;
+	}
+
+	if (S_ISREG(fStatus.st_mode)) {
+		void* data =
+			mmap(nullptr, fStatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			close(fd);
+			fData = (const char*)data;
+			fSize = fStatus.st_size;
+			fMapped = true;
+			return true;
+		}
+	}
+
+	bool result = _Read(fd);
+	int error = errno;
+	close(fd);
+	errno = error;
+	return result;
+}
+
+void
+MappedFile::Close()
+{
+	if (fMapped)
+		munmap((void*)fData, fSize);
+
+	fData = "";
+	fSize = 0;
+	fMapped = false;
+	fBuffer.clear();
+}
+
+bool
+MappedFile::_Read(int fd)
+{
+	char buffer[64 * 1024];
+	for (;;) {
+		ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+		if (bytesRead == 0)
+			break;
+
+		if (bytesRead < 0) {
+			if (errno == EINTR)
+				continue;
+			fBuffer.clear();
+			return false;
+		}
+
+		fBuffer.append(buffer, bytesRead);
+	}
+
+	fData = fBuffer.data();
+	fSize = fBuffer.size();
+	return true;
+}
+
+} // namespace ham::util
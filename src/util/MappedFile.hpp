@@ -0,0 +1,55 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_UTIL_MAPPED_FILE_HPP
+#define HAM_UTIL_MAPPED_FILE_HPP
+
+#include <stddef.h>
+#include <string>
+#include <sys/stat.h>
+
+namespace ham::util
+{
+
+/**
+ * Read-only view of a file's complete contents. Regular files are mapped into
+ * memory; anything that cannot be mapped, like a pipe or a device, is read
+ * into a buffer instead.
+ */
+class MappedFile
+{
+  public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* path);
+	// returns false and leaves errno set, if the file cannot be read
+	void Close();
+
+	const char* Data() const { return fData; }
+
+	const char* End() const { return fData + fSize; }
+
+	size_t Size() const { return fSize; }
+
+	const struct stat& Status() const { return fStatus; }
+	// of the opened file
+
+  private:
+	bool _Read(int fd);
+
+  private:
+	const char* fData;
+	size_t fSize;
+	bool fMapped;
+	std::string fBuffer;
+	struct stat fStatus;
+};
+
+} // namespace ham::util
+
+#endif // HAM_UTIL_MAPPED_FILE_HPP
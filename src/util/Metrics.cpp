@@ -0,0 +1,138 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "util/Metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace ham::util
+{
+
+namespace
+{
+
+struct Registry {
+	std::mutex fLock;
+	std::vector<Metric*> fMetrics;
+	// in the order of registration
+};
+
+} // namespace
+
+// Constructed by the first metric, so it outlives all static metrics.
+static Registry&
+metric_registry()
+{
+	static Registry sRegistry;
+	return sRegistry;
+}
+
+Metric::Metric(
+	Type type,
+	const char* name,
+	const char* help,
+	const char* labels,
+	double scale
+)
+	: fValue(0),
+	  fType(type),
+	  fName(name),
+	  fHelp(help),
+	  fLabels(labels),
+	  fScale(scale)
+{
+	Registry& registry = metric_registry();
+	std::lock_guard<std::mutex> lock(registry.fLock);
+	registry.fMetrics.push_back(this);
+}
+
+Metric::~Metric()
+{
+	Registry& registry = metric_registry();
+	std::lock_guard<std::mutex> lock(registry.fLock);
+	registry.fMetrics.erase(
+		std::find(registry.fMetrics.begin(), registry.fMetrics.end(), this)
+	);
+}
+
+/**
+ * Writes the metrics in the OpenMetrics text format. Every family is
+ * introduced by its type and help text, counter samples get the "_total"
+ * suffix, and the output ends with "# EOF".
+ */
+/*static*/ void
+Metric::WriteAll(std::ostream& output)
+{
+	Registry& registry = metric_registry();
+	std::lock_guard<std::mutex> lock(registry.fLock);
+
+	std::vector<Metric*>& metrics = registry.fMetrics;
+	std::vector<bool> written(metrics.size(), false);
+	for (size_t i = 0; i < metrics.size(); i++) {
+		if (written[i])
+			continue;
+
+		const Metric* family = metrics[i];
+		output << "# TYPE " << family->fName << ' '
+			   << (family->fType == COUNTER ? "counter" : "gauge") << '\n'
+			   << "# HELP " << family->fName << ' ' << family->fHelp << '\n';
+
+		for (size_t k = i; k < metrics.size(); k++) {
+			if (!written[k] && strcmp(metrics[k]->fName, family->fName) == 0) {
+				metrics[k]->_Write(output);
+				written[k] = true;
+			}
+		}
+	}
+
+	output << "# EOF\n";
+}
+
+/*static*/ bool
+Metric::WriteAllToFile(const char* path)
+{
+	std::ofstream output(path);
+	if (!output)
+		return false;
+
+	WriteAll(output);
+	output.close();
+	return !output.fail();
+}
+
+/*static*/ void
+Metric::ResetAll()
+{
+	Registry& registry = metric_registry();
+	std::lock_guard<std::mutex> lock(registry.fLock);
+	for (Metric* metric : registry.fMetrics)
+		metric->fValue.store(0, std::memory_order_relaxed);
+}
+
+void
+Metric::_Write(std::ostream& output) const
+{
+	output << fName;
+	if (fType == COUNTER)
+		output << "_total";
+	if (fLabels != nullptr)
+		output << '{' << fLabels << '}';
+
+	int64_t value = Value();
+	if (fScale == 1) {
+		output << ' ' << value << '\n';
+	} else {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%.6f", value * fScale);
+		output << ' ' << buffer << '\n';
+	}
+}
+
+} // namespace ham::util
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_UTIL_METRICS_HPP
+#define HAM_UTIL_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace ham::util
+{
+
+/**
+ * A value for monitoring builds, exported in the OpenMetrics text format.
+ *
+ * Metrics are meant to be static objects of the modules they measure. They
+ * register themselves on construction, and updating one is a relaxed atomic
+ * operation, so they are always on. Metrics with the same name form a family
+ * and must differ in their labels, e.g. `phase="BuildTargets"`. A scale
+ * converts the stored integer to the exported value, e.g. 1e-9 for durations
+ * counted in nanoseconds and exported in seconds.
+ */
+class Metric
+{
+  public:
+	enum Type {
+		COUNTER,
+		GAUGE
+	};
+
+  public:
+	Metric(
+		Type type,
+		const char* name,
+		const char* help,
+		const char* labels,
+		double scale
+	);
+	~Metric();
+
+	Metric(const Metric&) = delete;
+	Metric& operator=(const Metric&) = delete;
+
+	Type GetType() const { return fType; }
+	const char* Name() const { return fName; }
+	int64_t Value() const { return fValue.load(std::memory_order_relaxed); }
+
+	static void WriteAll(std::ostream& output);
+	static bool WriteAllToFile(const char* path);
+	// all registered metrics, grouped into families
+	static void ResetAll();
+	// e.g. in a process forked to do a build of its own
+
+  protected:
+	std::atomic<int64_t> fValue;
+
+  private:
+	void _Write(std::ostream& output) const;
+
+  private:
+	Type fType;
+	const char* fName;
+	const char* fHelp;
+	const char* fLabels;
+	double fScale;
+};
+
+/**
+ * A metric that only ever increases.
+ */
+class Counter : public Metric
+{
+  public:
+	Counter(
+		const char* name,
+		const char* help,
+		const char* labels = nullptr,
+		double scale = 1
+	)
+		: Metric(COUNTER, name, help, labels, scale)
+	{
+	}
+
+	void Increment(int64_t count = 1)
+	{
+		fValue.fetch_add(count, std::memory_order_relaxed);
+	}
+};
+
+/**
+ * A metric that can go up and down.
+ */
+class Gauge : public Metric
+{
+  public:
+	class Timer;
+
+  public:
+	Gauge(
+		const char* name,
+		const char* help,
+		const char* labels = nullptr,
+		double scale = 1
+	)
+		: Metric(GAUGE, name, help, labels, scale)
+	{
+	}
+
+	void Set(int64_t value) { fValue.store(value, std::memory_order_relaxed); }
+
+	void Add(int64_t value)
+	{
+		fValue.fetch_add(value, std::memory_order_relaxed);
+	}
+};
+
+/**
+ * Scope guard setting a gauge to the nanoseconds from its creation to its
+ * destruction.
+ */
+class Gauge::Timer
+{
+  public:
+	Timer(Gauge& gauge)
+		: fGauge(gauge),
+		  fStart(std::chrono::steady_clock::now())
+	{
+	}
+
+	~Timer()
+	{
+		auto duration = std::chrono::steady_clock::now() - fStart;
+		fGauge.Set(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+				.count()
+		);
+	}
+
+	Timer(const Timer&) = delete;
+	Timer& operator=(const Timer&) = delete;
+
+  private:
+	Gauge& fGauge;
+	std::chrono::steady_clock::time_point fStart;
+};
+
+} // namespace ham::util
+
+#endif // HAM_UTIL_METRICS_HPP
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "util/MetricsServer.hpp"
+
+#include "util/Metrics.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <sstream>
+
+// TODO: Platform specific!
+
+namespace ham::util
+{
+
+static const int kRequestTimeout = 1000;
+// milliseconds to wait for a client's request
+
+MetricsServer::MetricsServer()
+	: fPath(),
+	  fSocket(-1),
+	  fWakePipe{-1, -1},
+	  fThread()
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+	Stop();
+}
+
+/**
+ * Starts serving on a new socket at \a path. A socket left behind at the path
+ * by an earlier run is replaced. Returns false, if the socket can't be
+ * created.
+ */
+bool
+MetricsServer::Start(const char* path)
+{
+	struct sockaddr_un address;
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	struct stat st;
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	fSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fSocket < 0)
+		return false;
+
+	if (bind(fSocket, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		int error = errno;
+		close(fSocket);
+		fSocket = -1;
+		errno = error;
+		return false;
+	}
+
+	if (listen(fSocket, 8) != 0 || pipe2(fWakePipe, O_CLOEXEC) != 0) {
+		// the socket file exists now
+		int error = errno;
+		close(fSocket);
+		fSocket = -1;
+		fWakePipe[0] = fWakePipe[1] = -1;
+		unlink(path);
+		errno = error;
+		return false;
+	}
+
+	fPath = path;
+	fThread = std::thread(&MetricsServer::_Serve, this);
+	return true;
+}
+
+void
+MetricsServer::Stop()
+{
+	if (fSocket < 0)
+		return;
+
+	char byte = 0;
+	while (write(fWakePipe[1], &byte, 1) < 0 && errno == EINTR)
+		;
+	fThread.join();
+
+	close(fSocket);
+	close(fWakePipe[0]);
+	close(fWakePipe[1]);
+	fSocket = fWakePipe[0] = fWakePipe[1] = -1;
+	unlink(fPath.c_str());
+}
+
+void
+MetricsServer::_Serve()
+{
+	for (;;) {
+		struct pollfd fds[2] = {
+			{fSocket, POLLIN, 0},
+			{fWakePipe[0], POLLIN, 0}
+		};
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+
+		if (fds[1].revents != 0)
+			return;
+
+		if ((fds[0].revents & POLLIN) != 0) {
+			int fd = accept4(fSocket, nullptr, nullptr, SOCK_CLOEXEC);
+			if (fd >= 0) {
+				_Answer(fd);
+				close(fd);
+			}
+		}
+	}
+}
+
+/**
+ * Reads what the client has sent of its request -- which doesn't matter --
+ * and responds with the metrics.
+ */
+void
+MetricsServer::_Answer(int fd)
+{
+	// don't let a client that doesn't read hold up the build's end
+	struct timeval timeout = {kRequestTimeout / 1000, 0};
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	struct pollfd request = {fd, POLLIN, 0};
+	if (poll(&request, 1, kRequestTimeout) > 0) {
+		char buffer[1024];
+		while (recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT) > 0)
+			;
+	}
+
+	std::ostringstream body;
+	Metric::WriteAll(body);
+	std::string bodyString = body.str();
+
+	std::string response =
+		"HTTP/1.0 200 OK\r\n"
+		"Content-Type: application/openmetrics-text; version=1.0.0; "
+		"charset=utf-8\r\n"
+		"Content-Length: "
+		+ std::to_string(bodyString.size()) + "\r\n\r\n" + bodyString;
+
+	const char* remainder = response.data();
+	size_t remainderSize = response.size();
+	while (remainderSize > 0) {
+		ssize_t written = send(fd, remainder, remainderSize, MSG_NOSIGNAL);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		remainder += written;
+		remainderSize -= written;
+	}
+}
+
+} // namespace ham::util
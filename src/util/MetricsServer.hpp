@@ -0,0 +1,48 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_UTIL_METRICS_SERVER_HPP
+#define HAM_UTIL_METRICS_SERVER_HPP
+
+#include <string>
+#include <thread>
+
+namespace ham::util
+{
+
+/**
+ * Serves the metrics on a Unix domain socket while the build runs, so that a
+ * Prometheus compatible scraper (or `curl --unix-socket`) can watch it.
+ *
+ * A thread of its own answers every connection with a minimal HTTP response
+ * carrying the current metrics, whatever was requested. Stop() -- or the
+ * destructor -- ends the thread and removes the socket.
+ */
+class MetricsServer
+{
+  public:
+	MetricsServer();
+	~MetricsServer();
+
+	MetricsServer(const MetricsServer&) = delete;
+	MetricsServer& operator=(const MetricsServer&) = delete;
+
+	bool Start(const char* path);
+	void Stop();
+
+  private:
+	void _Serve();
+	void _Answer(int fd);
+
+  private:
+	std::string fPath;
+	int fSocket;
+	int fWakePipe[2];
+	// written to by Stop() to wake the thread up
+	std::thread fThread;
+};
+
+} // namespace ham::util
+
+#endif // HAM_UTIL_METRICS_SERVER_HPP
@@ -64,7 +64,7 @@ OptionIterator::Next(std::string& argument)
 	if (!HasNext())
 		return '\0';
 
-	char option = fCurrentOption->fShortOption;
+	int option = fCurrentOption->fShortOption;
 	argument = fOptionArgument != nullptr ? fOptionArgument : "";
 
 	_FindNext();
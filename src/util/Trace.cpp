@@ -0,0 +1,259 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "util/Trace.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <set>
+
+namespace ham::util
+{
+
+/*static*/ Trace* Trace::sActive = nullptr;
+/*static*/ std::atomic<uint64_t> Trace::sNextId(1);
+/*static*/ thread_local uint64_t Trace::sThreadTraceId = 0;
+/*static*/ thread_local Trace::Buffer* Trace::sThreadBuffer = nullptr;
+
+static void
+write_string(std::ostream& output, const std::string& string)
+{
+	output << '"';
+	for (char c : string) {
+		switch (c) {
+			case '"':
+				output << "\\\"";
+				break;
+			case '\\':
+				output << "\\\\";
+				break;
+			case '\n':
+				output << "\\n";
+				break;
+			case '\t':
+				output << "\\t";
+				break;
+			default:
+				if ((unsigned char)c < 0x20) {
+					output << "\\u" << std::hex << std::setw(4)
+						   << std::setfill('0') << (int)c << std::dec;
+				} else {
+					output << c;
+				}
+				break;
+		}
+	}
+	output << '"';
+}
+
+// The trace event format counts in microseconds.
+static void
+write_microseconds(std::ostream& output, int64_t nanoseconds)
+{
+	output << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0')
+		   << nanoseconds % 1000;
+}
+
+static void
+write_name_event(
+	std::ostream& output,
+	const char* type,
+	int process,
+	int thread,
+	const std::string& name
+)
+{
+	output << ",\n{\"name\":\"" << type << "\",\"ph\":\"M\",\"pid\":"
+		   << process << ",\"tid\":" << thread << ",\"args\":{\"name\":";
+	write_string(output, name);
+	output << "}}";
+}
+
+Trace::Chunk::Chunk()
+	: fEvents(),
+	  fCount(0),
+	  fNext(nullptr)
+{
+}
+
+Trace::Trace()
+	: fId(sNextId++),
+	  fStart(Clock::now()),
+	  fLock(),
+	  fBuffers()
+{
+}
+
+Trace::~Trace()
+{
+	if (sActive == this)
+		sActive = nullptr;
+
+	for (Buffer* buffer : fBuffers) {
+		Chunk* chunk = buffer->fFirst;
+		while (chunk != nullptr) {
+			Chunk* next = chunk->fNext.load(std::memory_order_relaxed);
+			delete chunk;
+			chunk = next;
+		}
+		delete buffer;
+	}
+}
+
+/**
+ * Records a span from \a start to \a end on the calling thread's lane or, if
+ * given, on the lane of job slot \a jobSlot. \a argumentName and \a argument
+ * optionally add a detail, like the file a span is about.
+ */
+void
+Trace::AddSpan(
+	const char* name,
+	Clock::time_point start,
+	Clock::time_point end,
+	const char* argumentName,
+	const char* argument,
+	int jobSlot
+)
+{
+	Buffer* buffer = _ThreadBuffer(nullptr);
+	Chunk* chunk = buffer->fLast;
+	size_t count = chunk->fCount.load(std::memory_order_relaxed);
+	if (count == Chunk::kSize) {
+		Chunk* next = new Chunk;
+		chunk->fNext.store(next, std::memory_order_release);
+		buffer->fLast = chunk = next;
+		count = 0;
+	}
+
+	Event& event = chunk->fEvents[count];
+	event.fName = name;
+	event.fArgumentName = argument != nullptr ? argumentName : nullptr;
+	if (argument != nullptr)
+		event.fArgument = argument;
+	event.fStart =
+		std::chrono::duration_cast<std::chrono::nanoseconds>(start - fStart)
+			.count();
+	event.fDuration =
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+			.count();
+	event.fJobSlot = jobSlot;
+
+	chunk->fCount.store(count + 1, std::memory_order_release);
+}
+
+/**
+ * Gives the calling thread's lane a name. Only works before the thread has
+ * recorded anything.
+ */
+void
+Trace::NameThread(const char* name)
+{
+	_ThreadBuffer(name);
+}
+
+void
+Trace::Write(std::ostream& output) const
+{
+	std::lock_guard<std::mutex> lock(fLock);
+
+	// every event but this first one is preceded by a comma
+	output << "{\"traceEvents\":[\n"
+			  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+			  "\"args\":{\"name\":\"ham\"}}";
+
+	std::set<int> jobSlots;
+	for (const Buffer* buffer : fBuffers) {
+		if (!buffer->fThreadName.empty()) {
+			write_name_event(
+				output,
+				"thread_name",
+				1,
+				buffer->fThread,
+				buffer->fThreadName
+			);
+		}
+
+		for (const Chunk* chunk = buffer->fFirst; chunk != nullptr;
+			 chunk = chunk->fNext.load(std::memory_order_acquire)) {
+			size_t count = chunk->fCount.load(std::memory_order_acquire);
+			for (size_t i = 0; i < count; i++) {
+				const Event& event = chunk->fEvents[i];
+				output << ",\n{\"name\":";
+				write_string(output, event.fName);
+				output << ",\"ph\":\"X\",\"ts\":";
+				write_microseconds(output, event.fStart);
+				output << ",\"dur\":";
+				write_microseconds(output, event.fDuration);
+				if (event.fJobSlot >= 0) {
+					output << ",\"pid\":2,\"tid\":" << event.fJobSlot + 1;
+					jobSlots.insert(event.fJobSlot);
+				} else {
+					output << ",\"pid\":1,\"tid\":" << buffer->fThread;
+				}
+				if (event.fArgumentName != nullptr) {
+					output << ",\"args\":{\"" << event.fArgumentName
+						   << "\":";
+					write_string(output, event.fArgument);
+					output << "}";
+				}
+				output << "}";
+			}
+		}
+	}
+
+	if (!jobSlots.empty()) {
+		write_name_event(output, "process_name", 2, 0, "commands");
+		for (int jobSlot : jobSlots) {
+			write_name_event(
+				output,
+				"thread_name",
+				2,
+				jobSlot + 1,
+				"job slot " + std::to_string(jobSlot + 1)
+			);
+		}
+	}
+
+	output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+bool
+Trace::WriteFile(const char* path) const
+{
+	std::ofstream output(path);
+	if (!output)
+		return false;
+
+	Write(output);
+	output.close();
+	return !output.fail();
+}
+
+/**
+ * Returns the calling thread's buffer, registering a new one named
+ * \a threadName, if the thread doesn't have one yet.
+ */
+Trace::Buffer*
+Trace::_ThreadBuffer(const char* threadName)
+{
+	if (sThreadTraceId == fId)
+		return sThreadBuffer;
+
+	Buffer* buffer = new Buffer;
+	buffer->fThreadName = threadName != nullptr ? threadName : "";
+	buffer->fFirst = buffer->fLast = new Chunk;
+
+	{
+		std::lock_guard<std::mutex> lock(fLock);
+		buffer->fThread = (int)fBuffers.size() + 1;
+		fBuffers.push_back(buffer);
+	}
+
+	sThreadTraceId = fId;
+	sThreadBuffer = buffer;
+	return buffer;
+}
+
+} // namespace ham::util
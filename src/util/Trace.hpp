@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026, Dominic Martinez, dom@dominicm.dev.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HAM_UTIL_TRACE_HPP
+#define HAM_UTIL_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ham::util
+{
+
+/**
+ * Records spans of wall time -- parsing, evaluation, preparing the targets,
+ * running the commands -- and writes them as a Chrome trace event file, which
+ * chrome://tracing and Perfetto can display.
+ *
+ * Recording is meant to be cheap enough to be left on: every thread appends to
+ * a buffer of its own, made of fixed-size chunks that are never moved, so no
+ * locking is needed. Only a thread's first event registers its buffer with the
+ * trace. A chunk's event count is published atomically, so Write() may even
+ * run while other threads are still recording; it just doesn't see their
+ * latest events.
+ *
+ * Spans are shown on the lane of the thread that recorded them, unless a job
+ * slot lane is given. The commands are recorded that way, so that each job
+ * slot gets a lane of its own and the gaps between commands show.
+ */
+class Trace
+{
+  public:
+	typedef std::chrono::steady_clock Clock;
+
+	class Span;
+
+  public:
+	Trace();
+	~Trace();
+
+	Trace(const Trace&) = delete;
+	Trace& operator=(const Trace&) = delete;
+
+	static Trace* Active() { return sActive; }
+	static void SetActive(Trace* trace) { sActive = trace; }
+	// the trace Span and the other users record to, if any
+
+	void AddSpan(
+		const char* name,
+		Clock::time_point start,
+		Clock::time_point end,
+		const char* argumentName = nullptr,
+		const char* argument = nullptr,
+		int jobSlot = -1
+	);
+	void NameThread(const char* name);
+
+	void Write(std::ostream& output) const;
+	bool WriteFile(const char* path) const;
+
+  private:
+	struct Event {
+		std::string fName;
+		const char* fArgumentName;
+		std::string fArgument;
+		int64_t fStart;
+		// nanoseconds since the trace was started
+		int64_t fDuration;
+		int fJobSlot;
+	};
+
+	struct Chunk {
+		static constexpr size_t kSize = 256;
+
+		Event fEvents[kSize];
+		std::atomic<size_t> fCount;
+		std::atomic<Chunk*> fNext;
+
+		Chunk();
+	};
+
+	struct Buffer {
+		int fThread;
+		std::string fThreadName;
+		Chunk* fFirst;
+		Chunk* fLast;
+		// only used by the owning thread
+	};
+
+  private:
+	Buffer* _ThreadBuffer(const char* threadName);
+
+  private:
+	static Trace* sActive;
+	static std::atomic<uint64_t> sNextId;
+	static thread_local uint64_t sThreadTraceId;
+	static thread_local Buffer* sThreadBuffer;
+	// the calling thread's buffer, if it belongs to the trace sThreadTraceId
+
+	uint64_t fId;
+	// identifies the trace in the threads' buffer caches
+	Clock::time_point fStart;
+	mutable std::mutex fLock;
+	std::vector<Buffer*> fBuffers;
+	// guarded by fLock
+};
+
+/**
+ * Scope guard recording a span from its creation to its destruction with the
+ * active trace, if there is one. Without a trace it costs a pointer check.
+ * The name and argument must stay valid until the span is destroyed.
+ */
+class Trace::Span
+{
+  public:
+	Span(
+		const char* name,
+		const char* argumentName = nullptr,
+		const char* argument = nullptr
+	)
+		: fTrace(Trace::Active()),
+		  fName(name),
+		  fArgumentName(argumentName),
+		  fArgument(argument),
+		  fStart()
+	{
+		if (fTrace != nullptr)
+			fStart = Clock::now();
+	}
+
+	~Span()
+	{
+		if (fTrace != nullptr) {
+			fTrace->AddSpan(
+				fName,
+				fStart,
+				Clock::now(),
+				fArgumentName,
+				fArgument
+			);
+		}
+	}
+
+	Span(const Span&) = delete;
+	Span& operator=(const Span&) = delete;
+
+  private:
+	Trace* fTrace;
+	const char* fName;
+	const char* fArgumentName;
+	const char* fArgument;
+	Clock::time_point fStart;
+};
+
+} // namespace ham::util
+
+#endif // HAM_UTIL_TRACE_HPP